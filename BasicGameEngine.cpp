@@ -12,17 +12,39 @@
 #include "stdafx.h"
 #include "BasicGameEngine.h"
 #include <string.h>
+#include <cfloat>
 #include "ObjLoader.h"
 #include "WICTextureLoader12.h"
+#include "SupercompressedTexture.h"
+
+namespace
+{
+    // Materials of the static scene and of the props; each selects its
+    // precompiled pixel shader variant. Only these variants are compiled, and
+    // the first is the one the others fall back to.
+    constexpr ShaderPermutationKey ScenePermutation(ShaderFeature::Shadowed);
+    constexpr ShaderPermutationKey PropPermutation = ShaderFeature::Shadowed | ShaderFeature::Metal;
+    constexpr ShaderPermutationKey MaterialPermutations[] = { ScenePermutation, PropPermutation };
+}
 
 BasicGameEngine::BasicGameEngine(UINT width, UINT height, std::wstring name) :
     DXSample(width, height, name),
     m_frameIndex(0),
-    m_pCbvDataBegin(nullptr),
     m_viewport(0.0f, 0.0f, static_cast<float>(width), static_cast<float>(height)),
     m_scissorRect(0, 0, static_cast<LONG>(width), static_cast<LONG>(height)),
     m_rtvDescriptorSize(0),
-    m_constantBufferData{}
+    m_constantBufferData{},
+    m_sceneConstantsOffset(0),
+    m_albedoSlot(0),
+    m_cullFrustum{},
+    m_shadowConstantsOffsets{},
+    m_lightsOffset(0),
+    m_lightClustersOffset(0),
+    m_lightIndicesOffset(0),
+    m_renderWidth(width),
+    m_renderHeight(height),
+    m_framePacer(m_fenceQueue, FrameCount),
+    m_geometryUploader(m_copyQueue, GeometryStagingSize)
 {
 }
 
@@ -32,7 +54,19 @@ void BasicGameEngine::OnInit()
     loadObjects();
     LoadPipelineAssets();
 
-    loadTextureFromFile(new Texture(L"./Textures/white-brick.png"));
+    sometexture = new Texture(L"./Textures/white-brick.png");
+    loadTextureFromFile(sometexture);
+    recordSceneBundle();
+    loadIndirectObjects();
+    loadOccluders();
+    loadSceneLights();
+    loadProps();
+
+    // Recording the bundle waited for the pipelines it uses; keep whatever
+    // was compiled for the next start.
+    m_pipelineCache.Save();
+    const D3D12PipelineCache::Stats pipelineStats = m_pipelineCache.GetStats();
+    _RPT3(0, "Pipelines: %u requested, %u compiled, %u from library\n", pipelineStats.requested, pipelineStats.compiled, pipelineStats.loadedFromLibrary);
 }
 
 // Load the rendering pipeline dependencies.
@@ -87,6 +121,9 @@ void BasicGameEngine::LoadPipeline()
     queueDesc.Type = D3D12_COMMAND_LIST_TYPE_DIRECT;
 
     ThrowIfFailed(m_device->CreateCommandQueue(&queueDesc, IID_PPV_ARGS(&m_commandQueue)));
+    m_fenceQueue.Initialize(m_device.Get(), m_commandQueue.Get());
+    m_gpuTimer.Initialize(m_device.Get(), m_commandQueue.Get(), FrameCount);
+    m_copyQueue.Initialize(m_device.Get(), GeometryStagingSize);
 
     // Describe and create the swap chain.
     DXGI_SWAP_CHAIN_DESC1 swapChainDesc = {};
@@ -116,24 +153,19 @@ void BasicGameEngine::LoadPipeline()
 
     // Create descriptor heaps.
     {
-        // Describe and create a render target view (RTV) descriptor heap.
+        // Describe and create a render target view (RTV) descriptor heap: one
+        // per back buffer, then the scene color target's.
         D3D12_DESCRIPTOR_HEAP_DESC rtvHeapDesc = {};
-        rtvHeapDesc.NumDescriptors = FrameCount;
+        rtvHeapDesc.NumDescriptors = FrameCount + 1;
         rtvHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_RTV;
         rtvHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
         ThrowIfFailed(m_device->CreateDescriptorHeap(&rtvHeapDesc, IID_PPV_ARGS(&m_rtvHeap)));
 
         m_rtvDescriptorSize = m_device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
 
-        // Describe and create a constant buffer view (CBV) descriptor heap.
-        // Flags indicate that this descriptor heap can be bound to the pipeline 
-        // and that descriptors contained in it can be referenced by a root table.
-        D3D12_DESCRIPTOR_HEAP_DESC cbvHeapDesc = {};
-        cbvHeapDesc.NumDescriptors = 2;
-        cbvHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
-        cbvHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
-        ThrowIfFailed(m_device->CreateDescriptorHeap(&cbvHeapDesc, IID_PPV_ARGS(&m_cbvHeap)));
-        m_cbvHeapDescriptorSize = m_device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+        // The shader-visible heap holding every SRV, indexed by slot from shaders.
+        // The per-frame constant buffers are bound as root CBVs and need no descriptors.
+        m_descriptorHeap.Initialize(m_device.Get(), PersistentDescriptorCount, TransientDescriptorsPerFrame, FrameCount);
     }
 
     // Create frame resources.
@@ -155,7 +187,7 @@ void BasicGameEngine::LoadPipeline()
 // Load the sample assets.
 void BasicGameEngine::LoadPipelineAssets()
 {
-    // Create a root signature consisting of a descriptor table with a single CBV.
+    // Create a root signature consisting of a root CBV, texture slot constants, the bindless SRV table and the instance buffer.
     {
         D3D12_FEATURE_DATA_ROOT_SIGNATURE featureData = {};
 
@@ -168,13 +200,33 @@ void BasicGameEngine::LoadPipelineAssets()
         }
 
         CD3DX12_DESCRIPTOR_RANGE1 ranges[2];
-        CD3DX12_ROOT_PARAMETER1 rootParameters[2];
-
-        ranges[0].Init(D3D12_DESCRIPTOR_RANGE_TYPE_CBV, 1, 0, 0, D3D12_DESCRIPTOR_RANGE_FLAG_DATA_STATIC);
-        rootParameters[0].InitAsDescriptorTable(1, &ranges[0], D3D12_SHADER_VISIBILITY_VERTEX);
-
-        ranges[1].Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 0);
-        rootParameters[1].InitAsDescriptorTable(1, &ranges[1], D3D12_SHADER_VISIBILITY_PIXEL);
+        CD3DX12_ROOT_PARAMETER1 rootParameters[4 + MaxShaderBufferSlots];
+
+        // The CBV points into the upload ring, so it is set per frame rather than through a table.
+        // The pixel shader reads the shadow cascades from it too.
+        rootParameters[0].InitAsConstantBufferView(0, 0, D3D12_ROOT_DESCRIPTOR_FLAG_DATA_STATIC_WHILE_SET_AT_EXECUTE, D3D12_SHADER_VISIBILITY_ALL);
+
+        // Bindless slots of the draw's textures (albedo, normal map, shadow map).
+        rootParameters[1].InitAsConstants(MaxTextureSlots, 1, 0, D3D12_SHADER_VISIBILITY_PIXEL);
+
+        // The whole descriptor heap as one unbounded SRV array (t0, space1). Most
+        // slots are unused at any time, so the descriptors are volatile. The
+        // same descriptors are mapped again at t0, space3 for texture arrays.
+        ranges[0].Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, UINT_MAX, 0, 1,
+            D3D12_DESCRIPTOR_RANGE_FLAG_DESCRIPTORS_VOLATILE | D3D12_DESCRIPTOR_RANGE_FLAG_DATA_STATIC_WHILE_SET_AT_EXECUTE, 0);
+        ranges[1].Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, UINT_MAX, 0, 3,
+            D3D12_DESCRIPTOR_RANGE_FLAG_DESCRIPTORS_VOLATILE | D3D12_DESCRIPTOR_RANGE_FLAG_DATA_STATIC_WHILE_SET_AT_EXECUTE, 0);
+        rootParameters[2].InitAsDescriptorTable(_countof(ranges), ranges, D3D12_SHADER_VISIBILITY_PIXEL);
+
+        // Per-instance data (t0, space2). Each instanced draw points it at its own records.
+        rootParameters[3].InitAsShaderResourceView(0, 2, D3D12_ROOT_DESCRIPTOR_FLAG_DATA_STATIC_WHILE_SET_AT_EXECUTE, D3D12_SHADER_VISIBILITY_VERTEX);
+
+        // Shader buffers (t0 to t2, space4): the clustered lights, their
+        // clusters and the light index list, all in the upload ring.
+        for (UINT i = 0; i < MaxShaderBufferSlots; i++)
+        {
+            rootParameters[4 + i].InitAsShaderResourceView(i, 4, D3D12_ROOT_DESCRIPTOR_FLAG_DATA_STATIC_WHILE_SET_AT_EXECUTE, D3D12_SHADER_VISIBILITY_PIXEL);
+        }
 
         // Allow input layout and deny uneccessary access to certain pipeline stages.
         D3D12_ROOT_SIGNATURE_FLAGS rootSignatureFlags =
@@ -198,20 +250,37 @@ void BasicGameEngine::LoadPipelineAssets()
         sampler.RegisterSpace = 0;
         sampler.ShaderVisibility = D3D12_SHADER_VISIBILITY_PIXEL;
 
+        D3D12_STATIC_SAMPLER_DESC samplers[2] = { sampler, sampler };
+        samplers[1].Filter = D3D12_FILTER_COMPARISON_MIN_MAG_LINEAR_MIP_POINT;
+        samplers[1].AddressU = D3D12_TEXTURE_ADDRESS_MODE_BORDER;
+        samplers[1].AddressV = D3D12_TEXTURE_ADDRESS_MODE_BORDER;
+        samplers[1].AddressW = D3D12_TEXTURE_ADDRESS_MODE_BORDER;
+        samplers[1].BorderColor = D3D12_STATIC_BORDER_COLOR_OPAQUE_WHITE;
+        samplers[1].ComparisonFunc = D3D12_COMPARISON_FUNC_LESS_EQUAL;
+        samplers[1].ShaderRegister = 1;
+
         CD3DX12_VERSIONED_ROOT_SIGNATURE_DESC rootSignatureDesc;
-        rootSignatureDesc.Init_1_1(_countof(rootParameters), rootParameters, 1, &sampler, rootSignatureFlags);
+        rootSignatureDesc.Init_1_1(_countof(rootParameters), rootParameters, _countof(samplers), samplers, rootSignatureFlags);
 
         ComPtr<ID3DBlob> signature;
         ComPtr<ID3DBlob> error;
         ThrowIfFailed(D3DX12SerializeVersionedRootSignature(&rootSignatureDesc, featureData.HighestVersion, &signature, &error));
         ThrowIfFailed(m_device->CreateRootSignature(0, signature->GetBufferPointer(), signature->GetBufferSize(), IID_PPV_ARGS(&m_rootSignature)));
+
+        // Pipelines compile on worker threads while the rest of the scene loads.
+        m_pipelineCache.Initialize(m_device.Get(), GetAssetFullPath(L"PipelineCache.bin"));
+        m_pipelineCache.AddRootSignature(m_rootSignature.Get(), signature.Get());
     }
 
+    // Frames are recorded through the render backend, and pipelines are
+    // created through it. The engine's own resources are imported so the
+    // draw list only deals in handles.
+    m_renderDevice.Initialize(m_device.Get(), m_commandQueue.Get(), &m_fenceQueue, m_rootSignature.Get(), &m_descriptorHeap, FrameCount);
+    m_renderDevice.SetUploader(&m_copyQueue, &m_geometryUploader);
+    m_renderDevice.SetPipelineCache(&m_pipelineCache);
+
     // Create the pipeline state, which includes compiling and loading shaders.
     {
-        ComPtr<ID3DBlob> vertexShader;
-        ComPtr<ID3DBlob> pixelShader;
-
 #if defined(_DEBUG)
         // Enable better shader debugging with the graphics debugging tools.
         UINT compileFlags = D3DCOMPILE_DEBUG | D3DCOMPILE_SKIP_OPTIMIZATION;
@@ -219,37 +288,35 @@ void BasicGameEngine::LoadPipelineAssets()
         UINT compileFlags = 0;
 #endif
 
-        ThrowIfFailed(D3DCompileFromFile(GetAssetFullPath(L"shaders.hlsl").c_str(), nullptr, nullptr, "VSMain", "vs_5_0", compileFlags, 0, &vertexShader, nullptr));
-        ThrowIfFailed(D3DCompileFromFile(GetAssetFullPath(L"shaders.hlsl").c_str(), nullptr, nullptr, "PSSimpleAlbedo", "ps_5_0", compileFlags, 0, &pixelShader, nullptr));
-
-        // Define the vertex input layout.
-        D3D12_INPUT_ELEMENT_DESC inputElementDescs[] =
+        // Bytecode comes from the shader cache unless shaders.hlsl, its
+        // includes or the flags changed since the last run.
+        const auto shaderStart = std::chrono::high_resolution_clock::now();
+        m_shaderCompiler.Initialize(GetAssetFullPath(L"ShaderCache.bin"));
+        const std::wstring shaderPath = GetAssetFullPath(L"shaders.hlsl");
+        const std::vector<uint8_t>& vertexShader = m_shaderCompiler.Compile(shaderPath, "VSMain", "vs_5_1", compileFlags);
+        const std::vector<uint8_t>& depthVertexShader = m_shaderCompiler.Compile(shaderPath, "VSDepth", "vs_5_1", compileFlags);
+
+        // Every material's permutation is compiled up front, so picking a
+        // variant at draw time never compiles anything.
+        const std::vector<uint8_t>* pixelShaders[ShaderPermutationKey::PermutationCount] = {};
+        for (ShaderPermutationKey permutation : MaterialPermutations)
         {
-            { "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
-            { "NORMAL", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, 12, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
-            { "UV", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, 24, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 }
-        };
-
-        D3D12_RASTERIZER_DESC rasterizerDesc;
-        ZeroMemory(&rasterizerDesc, sizeof(rasterizerDesc));
-        rasterizerDesc.FillMode = D3D12_FILL_MODE_SOLID;
-        rasterizerDesc.CullMode = D3D12_CULL_MODE_NONE;
-        rasterizerDesc.FrontCounterClockwise = FALSE;
-        rasterizerDesc.DepthBias = D3D12_DEFAULT_DEPTH_BIAS;
-        rasterizerDesc.DepthBiasClamp = D3D12_DEFAULT_DEPTH_BIAS_CLAMP;
-        rasterizerDesc.SlopeScaledDepthBias = D3D12_DEFAULT_SLOPE_SCALED_DEPTH_BIAS;
-        rasterizerDesc.DepthClipEnable = TRUE;
-        rasterizerDesc.MultisampleEnable = FALSE;
-        rasterizerDesc.AntialiasedLineEnable = FALSE;
-        rasterizerDesc.ForcedSampleCount = 0;
-        rasterizerDesc.ConservativeRaster = D3D12_CONSERVATIVE_RASTERIZATION_MODE_OFF;
-
-        D3D12_DEPTH_STENCIL_DESC depthStencilDesc;
-        ZeroMemory(&depthStencilDesc, sizeof(depthStencilDesc));
-        depthStencilDesc.DepthEnable = TRUE;
-        depthStencilDesc.DepthWriteMask = D3D12_DEPTH_WRITE_MASK_ALL;
-        depthStencilDesc.DepthFunc = D3D12_COMPARISON_FUNC_LESS;
-        depthStencilDesc.StencilEnable = FALSE;
+            pixelShaders[permutation.Index()] = &m_shaderCompiler.Compile(shaderPath, "PSMain", "ps_5_1", compileFlags, permutation.Defines());
+        }
+
+        // The scene is also drawn as clusters culled on the GPU; the command
+        // signature sets the albedo slot, the first texture slot constant.
+        const UINT clusterCount = static_cast<UINT>((m_vertices.size() + IndirectClusterVertices - 1) / IndirectClusterVertices);
+        m_indirectDraw.Initialize(m_device.Get(), m_shaderCompiler, GetAssetFullPath(L"IndirectCull.hlsl"), compileFlags,
+            m_rootSignature.Get(), 1, clusterCount);
+        const std::wstring upscalePath = GetAssetFullPath(L"Upscale.hlsl");
+        const std::vector<uint8_t>& upscaleVertexShader = m_shaderCompiler.Compile(upscalePath, "VSMain", "vs_5_1", compileFlags);
+        const std::vector<uint8_t>& upscalePixelShader = m_shaderCompiler.Compile(upscalePath, "PSMain", "ps_5_1", compileFlags);
+        m_shaderCompiler.Save();
+
+        const std::chrono::duration<double, std::milli> shaderTime = std::chrono::high_resolution_clock::now() - shaderStart;
+        const ShaderCache::Stats& shaderStats = m_shaderCompiler.GetStats();
+        _RPT3(0, "Shaders: %.2f ms, %s start (%u compiled)\n", shaderTime.count(), shaderStats.compiled ? "cold" : "warm", shaderStats.compiled);
 
         // create a depth stencil descriptor heap so we can get a pointer to the depth stencil buffer
         D3D12_DESCRIPTOR_HEAP_DESC dsvHeapDesc = {};
@@ -258,145 +325,155 @@ void BasicGameEngine::LoadPipelineAssets()
         dsvHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
         ThrowIfFailed(m_device->CreateDescriptorHeap(&dsvHeapDesc, IID_PPV_ARGS(m_dsvHeap.GetAddressOf())));
 
-        D3D12_RESOURCE_DESC depthStencilResourceDesc;
-        depthStencilResourceDesc.Dimension =
-            D3D12_RESOURCE_DIMENSION_TEXTURE2D;
-        depthStencilResourceDesc.Alignment = 0;
-        depthStencilResourceDesc.Width = 1280;
-        depthStencilResourceDesc.Height = 720;
-        depthStencilResourceDesc.DepthOrArraySize = 1;
-        depthStencilResourceDesc.MipLevels = 1;
-        depthStencilResourceDesc.Format = DXGI_FORMAT_D32_FLOAT;
-        depthStencilResourceDesc.SampleDesc.Count = 1;
-        depthStencilResourceDesc.SampleDesc.Quality = 0;
-        depthStencilResourceDesc.Layout =
-            D3D12_TEXTURE_LAYOUT_UNKNOWN;
-        depthStencilResourceDesc.Flags =
-            D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL;
-
-        D3D12_CLEAR_VALUE optClear;
-        optClear.Format = DXGI_FORMAT_D32_FLOAT;
-        optClear.DepthStencil.Depth = 1.0f;
-        ThrowIfFailed(m_device->CreateCommittedResource(
-            &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
-            D3D12_HEAP_FLAG_NONE,
-            &depthStencilResourceDesc,
-            D3D12_RESOURCE_STATE_COMMON,
-            &optClear,
-            IID_PPV_ARGS(m_depthStencilBuffer.GetAddressOf())));
-
-        // Describe and create the graphics pipeline state object (PSO).
-        D3D12_GRAPHICS_PIPELINE_STATE_DESC psoDesc = {};
-        psoDesc.InputLayout = { inputElementDescs, _countof(inputElementDescs) };
-        psoDesc.pRootSignature = m_rootSignature.Get();
-        psoDesc.VS = CD3DX12_SHADER_BYTECODE(vertexShader.Get());
-        psoDesc.PS = CD3DX12_SHADER_BYTECODE(pixelShader.Get());
-        psoDesc.RasterizerState = rasterizerDesc;
-        psoDesc.BlendState = CD3DX12_BLEND_DESC(D3D12_DEFAULT);
-        psoDesc.DepthStencilState = depthStencilDesc;
-        psoDesc.SampleMask = UINT_MAX;
-        psoDesc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
-        psoDesc.NumRenderTargets = 1;
-        psoDesc.RTVFormats[0] = DXGI_FORMAT_R8G8B8A8_UNORM;
-        psoDesc.SampleDesc.Count = 1;
-
-        ThrowIfFailed(m_device->CreateGraphicsPipelineState(&psoDesc, IID_PPV_ARGS(&m_pipelineState)));
+        // The depth buffer itself is a frame graph transient; see PopulateCommandList.
+
+        // The backend's pipelines use the engine's root signature and Vertex
+        // layout, and request their states from the pipeline cache. The
+        // scene's own permutation is waited for; the other materials' compile
+        // in the background and draw with it until they are ready.
+        const uint32_t base = ScenePermutation.Index();
+        PipelineDesc sceneDesc;
+        sceneDesc.vertexShader = { vertexShader.data(), vertexShader.size() };
+        sceneDesc.pixelShader = { pixelShaders[base]->data(), pixelShaders[base]->size() };
+        m_scenePipelines[base] = m_renderDevice.CreatePipeline(sceneDesc);
+
+        // After a depth prepass the depth buffer already holds the nearest
+        // surface, so shading only passes where depth is equal and writes
+        // nothing. Their fallback needs the same test: with the scene's, the
+        // prepass depth would hide everything.
+        PipelineDesc equalDesc = sceneDesc;
+        equalDesc.depthFunc = CompareFunc::Equal;
+        equalDesc.depthWrite = false;
+        m_sceneEqualPipelines[base] = m_renderDevice.CreatePipeline(equalDesc);
+        m_renderDevice.WaitForPipeline(m_scenePipelines[base]);
+        m_renderDevice.WaitForPipeline(m_sceneEqualPipelines[base]);
+
+        sceneDesc.fallback = m_scenePipelines[base];
+        equalDesc.fallback = m_sceneEqualPipelines[base];
+        for (ShaderPermutationKey permutation : MaterialPermutations)
+        {
+            const uint32_t i = permutation.Index();
+            if (i == base)
+            {
+                continue;
+            }
+            sceneDesc.pixelShader = { pixelShaders[i]->data(), pixelShaders[i]->size() };
+            m_scenePipelines[i] = m_renderDevice.CreatePipeline(sceneDesc);
+            equalDesc.pixelShader = sceneDesc.pixelShader;
+            m_sceneEqualPipelines[i] = m_renderDevice.CreatePipeline(equalDesc);
+        }
+
+        // The prepass itself reads positions only and has no pixel shader or
+        // render target.
+        PipelineDesc depthDesc;
+        depthDesc.vertexShader = { depthVertexShader.data(), depthVertexShader.size() };
+        depthDesc.vertexInput = VertexInput::PositionOnly;
+        depthDesc.renderTargetCount = 0;
+        m_depthPrepassPipeline = m_renderDevice.CreatePipeline(depthDesc);
+
+        // Shadow cascades only cover their slice's bounding sphere in depth.
+        // Casters between it and the light are clamped to the near plane
+        // rather than clipped, so they still write depth. The bias keeps lit
+        // surfaces from shadowing themselves.
+        PipelineDesc shadowDesc = depthDesc;
+        shadowDesc.depthClip = false;
+        shadowDesc.depthBias = 1000;
+        shadowDesc.slopeScaledDepthBias = 1.0f;
+        shadowDesc.depthFormat = DepthFormat::D24S8;
+        m_shadowCasterPipeline = m_renderDevice.CreatePipeline(shadowDesc);
+
+        // The upscale draws a fullscreen triangle from SV_VertexID, with no
+        // vertex input or depth.
+        PipelineDesc upscaleDesc;
+        upscaleDesc.vertexShader = { upscaleVertexShader.data(), upscaleVertexShader.size() };
+        upscaleDesc.pixelShader = { upscalePixelShader.data(), upscalePixelShader.size() };
+        upscaleDesc.vertexInput = VertexInput::None;
+        upscaleDesc.depthTest = false;
+        upscaleDesc.depthWrite = false;
+        upscaleDesc.depthFormat = DepthFormat::None;
+        m_upscalePipeline = m_renderDevice.CreatePipeline(upscaleDesc);
     }
 
     // Create the command list.
-    ThrowIfFailed(m_device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, m_commandAllocator.Get(), m_pipelineState.Get(), IID_PPV_ARGS(&m_commandList)));
+    ThrowIfFailed(m_device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, m_commandAllocator.Get(), nullptr, IID_PPV_ARGS(&m_commandList)));
+
+    m_shadowCommands = m_renderDevice.CreateD3D12CommandList();
+    m_sceneCommands = m_renderDevice.CreateD3D12CommandList();
+    m_sceneBundle = m_renderDevice.CreateD3D12Bundle();
+    m_drawRecorder.reset(new ParallelDrawRecorder(m_renderDevice, JobSystem::Get().ThreadCount()));
+    m_presentCommands = m_renderDevice.CreateD3D12CommandList();
+    m_sceneDraw.pipeline = m_scenePipelines[ScenePermutation.Index()];
+
+    m_shadowMap.reset(new ShadowMap(m_device.Get(), ShadowMapSize, ShadowMapSize, ShadowCascadeCount));
+    m_shadowMap->BuildDescriptors(m_descriptorHeap);
+    m_shadowTexture = m_renderDevice.ImportTexture(m_shadowMap->Resource(), m_shadowMap->SrvSlot());
 
     // Command lists are created in the recording state, but there is nothing
     // to record yet. The main loop expects it to be closed, so close it now.
 //    ThrowIfFailed(m_commandList->Close());
 
-    // Create the vertex buffer.
+    // Create the vertex buffer in a DEFAULT heap and fill it on the copy queue.
     {
-
         const UINT vertexBufferSize = m_vertices.size() * sizeof(Vertex);
 
-        // Note: using upload heaps to transfer static data like vert buffers is not 
-        // recommended. Every time the GPU needs it, the upload heap will be marshalled 
-        // over. Please read up on Default Heap usage. An upload heap is used here for 
-        // code simplicity and because there are very few verts to actually transfer.
+        // Buffers created in COMMON are promoted to COPY_DEST on the copy queue
+        // and to VERTEX_AND_CONSTANT_BUFFER on first use by the direct queue,
+        // so no transition barriers are needed.
         ThrowIfFailed(m_device->CreateCommittedResource(
-            &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
+            &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
             D3D12_HEAP_FLAG_NONE,
             &CD3DX12_RESOURCE_DESC::Buffer(vertexBufferSize),
-            D3D12_RESOURCE_STATE_GENERIC_READ,
+            D3D12_RESOURCE_STATE_COMMON,
             nullptr,
             IID_PPV_ARGS(&m_vertexBuffer)));
 
-        // Copy the triangle data to the vertex buffer.
-        UINT8* pVertexDataBegin;
-        CD3DX12_RANGE readRange(0, 0);        // We do not intend to read from this resource on the CPU.
-        ThrowIfFailed(m_vertexBuffer->Map(0, &readRange, reinterpret_cast<void**>(&pVertexDataBegin)));
-        memcpy(pVertexDataBegin, m_vertices.data(), vertexBufferSize);
-        m_vertexBuffer->Unmap(0, nullptr);
-
-        // Initialize the vertex buffer view.
-        m_vertexBufferView.BufferLocation = m_vertexBuffer->GetGPUVirtualAddress();
-        m_vertexBufferView.StrideInBytes = sizeof(Vertex);
-        m_vertexBufferView.SizeInBytes = vertexBufferSize;
-    }
-
-    // Create the constant buffer.
-    {
-        const UINT constantBufferSize = sizeof(SceneConstantBuffer);    // CB size is required to be 256-byte aligned.
-
-        ThrowIfFailed(m_device->CreateCommittedResource(
-            &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
-            D3D12_HEAP_FLAG_NONE,
-            &CD3DX12_RESOURCE_DESC::Buffer(constantBufferSize),
-            D3D12_RESOURCE_STATE_GENERIC_READ,
-            nullptr,
-            IID_PPV_ARGS(&m_constantBuffer)));
-
-        // Describe and create a constant buffer view.
-        D3D12_CONSTANT_BUFFER_VIEW_DESC cbvDesc = {};
-        cbvDesc.BufferLocation = m_constantBuffer->GetGPUVirtualAddress();
-        cbvDesc.SizeInBytes = constantBufferSize;
-        m_device->CreateConstantBufferView(&cbvDesc, m_cbvHeap->GetCPUDescriptorHandleForHeapStart());
-
-        // Map and initialize the constant buffer. We don't unmap this until the
-        // app closes. Keeping things mapped for the lifetime of the resource is okay.
-        CD3DX12_RANGE readRange(0, 0);        // We do not intend to read from this resource on the CPU.
-        ThrowIfFailed(m_constantBuffer->Map(0, &readRange, reinterpret_cast<void**>(&m_pCbvDataBegin)));
-        memcpy(m_pCbvDataBegin, &m_constantBufferData, sizeof(m_constantBufferData));
+        const uint32_t destination = m_copyQueue.AddDestination(m_vertexBuffer.Get());
+        m_geometryUploader.Upload(destination, 0, m_vertices.data(), vertexBufferSize);
+
+        // The direct queue waits on the GPU for the copies, so the CPU can carry
+        // on creating resources while the geometry is streamed in.
+        m_copyQueue.GpuWait(m_commandQueue.Get(), m_geometryUploader.Flush());
+
+        m_sceneDraw.vertexBuffer = m_renderDevice.ImportBuffer(m_vertexBuffer.Get());
+        m_sceneDraw.vertexStride = sizeof(Vertex);
+        m_sceneDraw.vertexCount = static_cast<uint32_t>(m_vertices.size());
+
+        // The scene is not instanced; it reads a single identity instance.
+        InstanceData identity = {};
+        identity.world[0][0] = 1.0f;
+        identity.world[1][1] = 1.0f;
+        identity.world[2][2] = 1.0f;
+        identity.material = InstanceData::DrawMaterial;
+        BufferDesc instanceDesc;
+        instanceDesc.size = sizeof(identity);
+        m_sceneDraw.instanceBuffer = m_renderDevice.CreateBuffer(instanceDesc, &identity);
+
+        // The props have their own vertex buffer, filled through the backend.
+        BufferDesc propDesc;
+        propDesc.size = m_propVertices.size() * sizeof(Vertex);
+        m_propDraw.pipeline = m_scenePipelines[PropPermutation.Index()];
+        m_propDraw.vertexBuffer = m_renderDevice.CreateBuffer(propDesc, m_propVertices.data());
+        m_propDraw.vertexStride = sizeof(Vertex);
+        m_propDraw.vertexCount = static_cast<uint32_t>(m_propVertices.size());
     }
 
-    CD3DX12_CPU_DESCRIPTOR_HANDLE dsvHandle(m_dsvHeap->GetCPUDescriptorHandleForHeapStart());
-    m_device->CreateDepthStencilView(m_depthStencilBuffer.Get(), nullptr, dsvHandle);
-
-    m_commandList->ResourceBarrier(
-        1,
-        &CD3DX12_RESOURCE_BARRIER::Transition(
-            m_depthStencilBuffer.Get(),
-            D3D12_RESOURCE_STATE_COMMON,
-            D3D12_RESOURCE_STATE_DEPTH_WRITE));
-
-    // Create synchronization objects and wait until assets have been uploaded to the GPU.
-    {
-        ThrowIfFailed(m_device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&m_fence)));
-        m_fenceValue = 1;
+    // Create the upload ring that per-frame constants are suballocated from.
+    // Space is handed back as each frame's fence completes, so OnUpdate never
+    // writes to data the GPU may still be reading.
+    m_uploadRing.Initialize(m_device.Get(), UploadRingSize);
+    m_uploadRingHandle = m_renderDevice.ImportBuffer(m_uploadRing.Resource());
 
-        // Create an event handle to use for frame synchronization.
-        m_fenceEvent = CreateEvent(nullptr, FALSE, FALSE, nullptr);
-        if (m_fenceEvent == nullptr)
-        {
-            ThrowIfFailed(HRESULT_FROM_WIN32(GetLastError()));
-        }
+    m_frameGraphResources.Initialize(m_device.Get());
 
-        // Wait for the command list to execute; we are reusing the same command 
-        // list in our main loop but for now, we just want to wait for setup to 
-        // complete before continuing.
-        WaitForPreviousFrame();
-    }
+    // Wait for the command list to execute; we are reusing the same command 
+    // list in our main loop but for now, we just want to wait for setup to 
+    // complete before continuing.
+    WaitForGpu();
 }
 
 void BasicGameEngine::loadObjects()  {
-//    ObjLoader::loadObj("./Models/teapot.obj", m_vertices);
     ObjLoader::loadObj("./Models/sponza.obj", m_vertices);
+    ObjLoader::loadObj("./Models/teapot.obj", m_propVertices);
 }
 
 // Update frame-based values.
@@ -408,7 +485,228 @@ void BasicGameEngine::OnUpdate()
     const float offsetBounds = 1.25;
     m_constantBufferData.PV = XMMatrixMultiply( *(m_camera.viewMatrix()), m_projectionMatrix );
     m_constantBufferData.eye = { XMVectorGetX(m_camera.eye), XMVectorGetY(m_camera.eye), XMVectorGetZ(m_camera.eye) };
-    memcpy(m_pCbvDataBegin, &m_constantBufferData, sizeof(m_constantBufferData));
+
+    XMFLOAT4X4 viewProjection;
+    XMStoreFloat4x4(&viewProjection, m_constantBufferData.PV);
+    m_cullFrustum = Frustum::FromViewProjection(viewProjection.m);
+
+    // Reclaim ring space from frames the GPU has finished, then write this
+    // frame's constants into fresh space.
+    m_uploadRing.Retire(m_framePacer.CompletedFenceValue());
+    m_descriptorHeap.BeginFrame(m_frameIndex, m_framePacer.CurrentFenceValue(), m_framePacer.CompletedFenceValue());
+    updateShadowCascades();
+    updateClusteredLights();
+    updateRenderScale();
+    UploadRingBuffer::Allocation constants = m_uploadRing.Allocate(sizeof(SceneConstantBuffer));
+    memcpy(constants.cpuAddress, &m_constantBufferData, sizeof(m_constantBufferData));
+    m_sceneConstantsOffset = constants.offset;
+
+    // The scene's draws are submitted afresh every frame and recorded across
+    // threads by m_drawRecorder.
+    m_sceneDraws.Reset();
+
+    // The props are placed afresh every frame, like any other instances.
+    if (m_props)
+    {
+        DrawItem prop = m_propDraw;
+        prop.albedo = m_sceneDraw.albedo;
+        for (const InstanceData& instance : m_propInstances)
+        {
+            m_instances.Add(prop, instance);
+        }
+    }
+
+    // Instances placed since the last frame are grouped into instanced draws,
+    // with their data in the upload ring.
+    if (m_instances.InstanceCount() > 0)
+    {
+        UploadRingBuffer::Allocation instanceData = m_uploadRing.Allocate(m_instances.DataSize(), sizeof(InstanceData));
+        m_instancedDraws.clear();
+        m_instances.Build(m_uploadRingHandle, instanceData.offset, instanceData.cpuAddress, m_instancedDraws);
+        for (const DrawItem& draw : m_instancedDraws)
+        {
+            m_sceneDraws.Submit(DrawSortKey::ForItem(0, draw, 0), draw);
+        }
+    }
+    m_instances.Reset();
+
+    // With the prepass or occlusion culling, the scene is drawn as its
+    // visible clusters, nearest first. With the prepass they are drawn depth
+    // only, then shaded with EQUAL; the pass field of the key puts every
+    // depth draw before every shaded one.
+    m_occlusionCulledDraws = 0;
+    m_occlusionCulledTriangles = 0;
+    if (m_depthPrepass || m_occlusionCulling)
+    {
+        if (m_occlusionCulling)
+        {
+            m_occlusionBuffer.Render(viewProjection.m, m_occluders.data(), static_cast<uint32_t>(m_occluders.size()), &JobSystem::Get());
+        }
+
+        // Bit 0 of the view masks from updateShadowCascades is the camera.
+        const uint16_t* viewMasks = m_frustumCuller.ViewMasks();
+        const XMVECTOR eye = m_camera.eye;
+        for (size_t i = 0; i < m_sceneClusters.size(); i++)
+        {
+            if (!(viewMasks[i] & 1))
+            {
+                continue;
+            }
+            const IndirectObject& cluster = m_sceneClusters[i];
+            if (m_occlusionCulling && !m_occlusionBuffer.IsVisible(cluster.center, cluster.radius))
+            {
+                m_occlusionCulledDraws++;
+                m_occlusionCulledTriangles += cluster.vertexCount / 3;
+                continue;
+            }
+
+            // Distance to the nearest point of the bounds, in the projection's
+            // near to far range.
+            const XMVECTOR center = XMLoadFloat3(reinterpret_cast<const XMFLOAT3*>(cluster.center));
+            const float distance = XMVectorGetX(XMVector3Length(XMVectorSubtract(center, eye))) - cluster.radius;
+            const uint32_t depthBucket = DrawSortKey::DepthBucket(distance, 0.1f, 100.0f);
+
+            DrawItem draw = m_sceneDraw;
+            draw.firstVertex = cluster.firstVertex;
+            draw.vertexCount = cluster.vertexCount;
+            if (m_depthPrepass)
+            {
+                draw.pipeline = m_depthPrepassPipeline;
+                m_sceneDraws.Submit(DrawSortKey::ForItem(0, draw, depthBucket), draw);
+
+                // Clusters are drawn with the scene's material.
+                draw.pipeline = m_sceneEqualPipelines[ScenePermutation.Index()];
+            }
+            m_sceneDraws.Submit(DrawSortKey::ForItem(1, draw, depthBucket), draw);
+        }
+    }
+
+    // Setting the title sends the window a message and redraws its frame,
+    // so the counts are only refreshed once a second.
+    const double time = m_timeInSeconds.count();
+    if (m_occlusionCulling && (m_culledTitleTime < 0.0 || time - m_culledTitleTime >= 1.0))
+    {
+        m_culledTitleTime = time;
+        wchar_t text[96];
+        swprintf_s(text, L"occlusion culled %u clusters, %u triangles", m_occlusionCulledDraws, m_occlusionCulledTriangles);
+        SetCustomWindowText(text);
+    }
+}
+
+// Fits the shadow cascades to the camera, writes their constants (the scene
+// constants with PV replaced by the cascade's) and culls the scene's clusters
+// against each, and against the camera, in one pass. Also fills in the
+// cascade and light fields of the scene constants, so it runs before they
+// are copied.
+void BasicGameEngine::updateShadowCascades()
+{
+    CascadedShadows::View view;
+    XMStoreFloat3(reinterpret_cast<XMFLOAT3*>(view.eye), m_camera.eye);
+    XMStoreFloat3(reinterpret_cast<XMFLOAT3*>(view.forward), XMVector3Normalize(m_camera.forward()));
+    view.tanHalfFovY = tanf(XMConvertToRadians(m_FoV) * 0.5f);
+    view.aspect = 16.0f / 9;
+    view.nearZ = 0.1f;
+    view.farZ = 100.0f;
+
+    const XMVECTOR toLight = XMVector3Normalize(XMVectorSet(6, 9, 4, 0));
+    XMStoreFloat3(&m_constantBufferData.toLight, toLight);
+    float lightDirection[3];
+    XMStoreFloat3(reinterpret_cast<XMFLOAT3*>(lightDirection), toLight);
+    CascadedShadows::FitCascades(view, lightDirection, ShadowCascadeCount, ShadowSplitLambda, ShadowMapSize, m_cascades);
+
+    float splits[4];
+    for (UINT i = 0; i < ShadowCascadeCount; i++)
+    {
+        m_constantBufferData.cascadePV[i] = XMLoadFloat4x4(reinterpret_cast<const XMFLOAT4X4*>(m_cascades[i].viewProjection));
+        splits[i] = m_cascades[i].splitFar;
+    }
+    m_constantBufferData.cascadeSplits = XMFLOAT4(splits);
+
+    // View 0 is the camera, view i + 1 cascade i.
+    Frustum views[1 + ShadowCascadeCount];
+    views[0] = m_cullFrustum;
+    for (UINT i = 0; i < ShadowCascadeCount; i++)
+    {
+        views[i + 1] = CascadedShadows::CasterFrustum(m_cascades[i]);
+    }
+    m_frustumCuller.CullViews(views, 1 + ShadowCascadeCount, m_clusterBounds, FrustumCulling::Shape::Box, &JobSystem::Get());
+    const uint16_t* viewMasks = m_frustumCuller.ViewMasks();
+
+    for (UINT i = 0; i < ShadowCascadeCount; i++)
+    {
+        SceneConstantBuffer cascadeConstants = m_constantBufferData;
+        cascadeConstants.PV = m_constantBufferData.cascadePV[i];
+        UploadRingBuffer::Allocation constants = m_uploadRing.Allocate(sizeof(SceneConstantBuffer));
+        memcpy(constants.cpuAddress, &cascadeConstants, sizeof(cascadeConstants));
+        m_shadowConstantsOffsets[i] = constants.offset;
+
+        m_shadowDraws[i].clear();
+        for (size_t c = 0; c < m_sceneClusters.size(); c++)
+        {
+            if (viewMasks[c] & (2u << i))
+            {
+                const IndirectObject& cluster = m_sceneClusters[c];
+                DrawItem draw = m_sceneDraw;
+                draw.firstVertex = cluster.firstVertex;
+                draw.vertexCount = cluster.vertexCount;
+                draw.pipeline = m_shadowCasterPipeline;
+                m_shadowDraws[i].push_back(draw);
+            }
+        }
+    }
+}
+
+// Animates the lights and bins them into the clusters of this frame's view,
+// then copies the lights, clusters and index list into the upload ring.
+// Slices are binned in parallel on the job system.
+void BasicGameEngine::updateClusteredLights()
+{
+    const float time = static_cast<float>(m_timeInSeconds.count());
+    for (size_t i = 0; i < m_sceneLights.size(); i++)
+    {
+        m_frameLights[i] = m_sceneLights[i];
+        m_frameLights[i].position[1] += 0.5f * sinf(time + static_cast<float>(i));
+    }
+
+    XMFLOAT4X4 view;
+    XMStoreFloat4x4(&view, *m_camera.viewMatrix());
+    const uint32_t lightCount = m_clusteredLights ? static_cast<uint32_t>(m_frameLights.size()) : 0;
+    m_lightBinner.Bin(view.m, m_frameLights.data(), lightCount, &JobSystem::Get());
+
+    // Root SRVs need at least one element behind them, even with no lights.
+    const std::vector<LightCluster>& clusters = m_lightBinner.Clusters();
+    const std::vector<uint32_t>& indices = m_lightBinner.LightIndices();
+    UploadRingBuffer::Allocation lights = m_uploadRing.Allocate(m_frameLights.size() * sizeof(ClusterLight), 16);
+    memcpy(lights.cpuAddress, m_frameLights.data(), m_frameLights.size() * sizeof(ClusterLight));
+    UploadRingBuffer::Allocation lightClusters = m_uploadRing.Allocate(clusters.size() * sizeof(LightCluster), 16);
+    memcpy(lightClusters.cpuAddress, clusters.data(), clusters.size() * sizeof(LightCluster));
+    UploadRingBuffer::Allocation lightIndices = m_uploadRing.Allocate((std::max)(indices.size(), size_t(1)) * sizeof(uint32_t), 16);
+    if (!indices.empty())
+    {
+        memcpy(lightIndices.cpuAddress, indices.data(), indices.size() * sizeof(uint32_t));
+    }
+    m_lightsOffset = lights.offset;
+    m_lightClustersOffset = lightClusters.offset;
+    m_lightIndicesOffset = lightIndices.offset;
+}
+
+// Picks this frame's render resolution from the GPU time of the frame that
+// last used this frame slot; FramePacer has already waited for it to finish.
+// Only the viewport and the constants that depend on it change; the scene
+// color and depth targets stay at full size.
+void BasicGameEngine::updateRenderScale()
+{
+    const float scale = m_dynamicResolution ? m_resolutionController.Update(m_gpuTimer.ReadMilliseconds(m_frameIndex)) : 1.0f;
+    uint32_t renderWidth, renderHeight;
+    DynamicResolutionController::ScaledSize(m_width, m_height, scale, renderWidth, renderHeight);
+    m_renderWidth = renderWidth;
+    m_renderHeight = renderHeight;
+    m_viewport = CD3DX12_VIEWPORT(0.0f, 0.0f, static_cast<float>(renderWidth), static_cast<float>(renderHeight));
+    m_scissorRect = CD3DX12_RECT(0, 0, static_cast<LONG>(renderWidth), static_cast<LONG>(renderHeight));
+
+    // Light cluster tiles cover the rendered pixels.
+    const ClusteredLighting::GridDesc& grid = m_lightBinner.Grid();
+    m_constantBufferData.clusterTileScale = XMFLOAT2(static_cast<float>(grid.tilesX) / renderWidth, static_cast<float>(grid.tilesY) / renderHeight);
 }
 
 // Render the scene.
@@ -418,93 +716,394 @@ void BasicGameEngine::OnRender()
     PopulateCommandList();
 
     // Execute the command list.
-    ID3D12CommandList* ppCommandLists[] = { m_commandList.Get() };
-    m_commandQueue->ExecuteCommandLists(_countof(ppCommandLists), ppCommandLists);
+    m_renderDevice.Submit(m_frameCommandLists.data(), static_cast<uint32_t>(m_frameCommandLists.size()));
 
     // Present the frame.
     ThrowIfFailed(m_swapChain->Present(1, 0));
 
-    WaitForPreviousFrame();
+    // Everything allocated from the ring this frame is released with its fence.
+    m_uploadRing.FinishFrame(m_framePacer.CurrentFenceValue());
+    MoveToNextFrame();
 }
 
 void BasicGameEngine::OnDestroy()
 {
     // Ensure that the GPU is no longer referencing resources that are about to be
     // cleaned up by the destructor.
-    WaitForPreviousFrame();
-
-    CloseHandle(m_fenceEvent);
+    WaitForGpu();
+    m_copyQueue.WaitForValue(m_geometryUploader.LastSubmittedFenceValue());
+    m_pipelineCache.Save();
 }
 
 // Fill the command list with all the render commands and dependent state.
+// The frame is declared as a frame graph: the shadow pass writes the
+// cascades of the shadow map, the scene pass reads them and writes transient
+// scene color and depth targets, the upscale pass stretches the scene color
+// over the back buffer, and the graph supplies the barriers and the
+// transients' memory. The scene is rendered into the top left of the
+// full size targets, at this frame's dynamic resolution. The scene pass
+// records the scene list (clears plus the static scene: either a depth
+// prepass and an EQUAL shading pass over CPU-culled clusters, or culled and
+// drawn indirectly on the GPU, or replayed from the bundle) and the dynamic
+// draw lists recorded in parallel; a final list upscales and returns the
+// back buffer to present. They are submitted in that order, after the shadow
+// list, and timed from the start of the shadow list to the end of the last.
 void BasicGameEngine::PopulateCommandList()
 {
-    // Command list allocators can only be reset when the associated 
-    // command lists have finished execution on the GPU; apps should use 
-    // fences to determine GPU execution progress.
-    ThrowIfFailed(m_commandAllocator->Reset());
+    CD3DX12_CPU_DESCRIPTOR_HANDLE backBufferRtv(m_rtvHeap->GetCPUDescriptorHandleForHeapStart(), m_frameIndex, m_rtvDescriptorSize);
+    CD3DX12_CPU_DESCRIPTOR_HANDLE rtvHandle(m_rtvHeap->GetCPUDescriptorHandleForHeapStart(), FrameCount, m_rtvDescriptorSize);
+    CD3DX12_CPU_DESCRIPTOR_HANDLE dsvHandle(m_dsvHeap->GetCPUDescriptorHandleForHeapStart());
 
-    // However, when ExecuteCommandList() is called on a particular command 
-    // list, that command list can then be reset at any time and must be before 
-    // re-recording.
-    ThrowIfFailed(m_commandList->Reset(m_commandAllocator.Get(), m_pipelineState.Get()));
+    // Every command list starts without output state.
+    auto beginPass = [&](IRenderCommandList& list)
+    {
+        ID3D12GraphicsCommandList* commandList = static_cast<D3D12RenderCommandList&>(list).Native();
+        commandList->RSSetViewports(1, &m_viewport);
+        commandList->RSSetScissorRects(1, &m_scissorRect);
+        commandList->OMSetRenderTargets(1, &rtvHandle, FALSE, &dsvHandle);
+    };
 
-    // Set necessary state.
-    m_commandList->SetGraphicsRootSignature(m_rootSignature.Get());
+    const float clearColor[] = { 0.0f, 0.2f, 0.4f, 1.0f };
 
-    ID3D12DescriptorHeap* ppHeaps[] = { m_cbvHeap.Get() };
-    m_commandList->SetDescriptorHeaps(_countof(ppHeaps), ppHeaps);
+    DrawListBindings bindings;
+    bindings.sceneConstants = m_uploadRingHandle;
+    bindings.sceneConstantsOffset = m_sceneConstantsOffset;
+    bindings.shadowMap = m_shadowTexture;
+    bindings.lights = m_uploadRingHandle;
+    bindings.lightsOffset = m_lightsOffset;
+    bindings.lightClustersOffset = m_lightClustersOffset;
+    bindings.lightIndicesOffset = m_lightIndicesOffset;
+
+    m_frameGraph.Reset();
+    const FrameGraphResource backBuffer = m_frameGraph.Import("BackBuffer", ResourceState::Present, ResourceState::Present);
+    const FrameGraphResource shadowMap = m_frameGraph.Import("ShadowMap", ResourceState::PixelShaderResource, ResourceState::PixelShaderResource);
+    FrameGraphResource sceneColor = FrameGraph::InvalidResource;
+    FrameGraphResource depth = FrameGraph::InvalidResource;
+    uint32_t sceneDrawLists = 0;
+
+    m_frameGraph.AddPass("Shadows",
+        [&](FrameGraph::Builder& builder)
+        {
+            builder.Write(shadowMap, ResourceState::DepthWrite);
+        },
+        [&](const FrameGraph::PassContext& pass)
+        {
+            m_shadowCommands->Begin(m_frameIndex);
+            {
+                ID3D12GraphicsCommandList* commandList = m_shadowCommands->Native();
+                m_gpuTimer.Begin(commandList, m_frameIndex);
+                m_frameGraphResources.RecordBarriers(commandList, pass.barriers, pass.barrierCount);
+
+                const D3D12_VIEWPORT viewport = m_shadowMap->Viewport();
+                const D3D12_RECT scissorRect = m_shadowMap->ScissorRect();
+                commandList->RSSetViewports(1, &viewport);
+                commandList->RSSetScissorRects(1, &scissorRect);
+                for (UINT i = 0; i < ShadowCascadeCount; i++)
+                {
+                    const CD3DX12_CPU_DESCRIPTOR_HANDLE cascadeDsv = m_shadowMap->Dsv(i);
+                    commandList->OMSetRenderTargets(0, nullptr, FALSE, &cascadeDsv);
+                    commandList->ClearDepthStencilView(cascadeDsv, D3D12_CLEAR_FLAG_DEPTH, 1.0f, 0, 0, nullptr);
+                    m_shadowCommands->SetConstantBuffer(0, m_uploadRingHandle, m_shadowConstantsOffsets[i]);
+                    RecordDrawItems(*m_shadowCommands, m_shadowDraws[i].data(), m_shadowDraws[i].size());
+                }
+            }
+            m_shadowCommands->End();
+        });
+
+    m_frameGraph.AddPass("Scene",
+        [&](FrameGraph::Builder& builder)
+        {
+            // Full size whatever the render scale, so the graph's layout (and
+            // with it the transients) stays the same from frame to frame.
+            FrameGraphTextureDesc colorDesc;
+            colorDesc.width = m_width;
+            colorDesc.height = m_height;
+            colorDesc.format = DXGI_FORMAT_R8G8B8A8_UNORM;
+            memcpy(colorDesc.clearColor, clearColor, sizeof(clearColor));
+            sceneColor = builder.Create("SceneColor", colorDesc);
+
+            FrameGraphTextureDesc depthDesc;
+            depthDesc.width = m_width;
+            depthDesc.height = m_height;
+            depthDesc.format = DXGI_FORMAT_D32_FLOAT;
+            depthDesc.clearDepth = 1.0f;
+            depth = builder.Create("Depth", depthDesc);
+
+            builder.Read(shadowMap, ResourceState::PixelShaderResource);
+            builder.Write(sceneColor, ResourceState::RenderTarget);
+            builder.Write(depth, ResourceState::DepthWrite);
+        },
+        [&](const FrameGraph::PassContext& pass)
+        {
+            // Begin resets this frame slot's allocator; MoveToNextFrame has already
+            // waited for the GPU to finish the frame that last used it. It also binds
+            // the root signature and descriptor heap.
+            m_sceneCommands->Begin(m_frameIndex);
+            {
+                ID3D12GraphicsCommandList* commandList = m_sceneCommands->Native();
+                m_frameGraphResources.RecordBarriers(commandList, pass.barriers, pass.barrierCount);
+
+                // The clears also initialize the targets, whose memory may be
+                // shared with other transients, so they cover all of them.
+                beginPass(*m_sceneCommands);
+                commandList->ClearRenderTargetView(rtvHandle, clearColor, 0, nullptr);
+                commandList->ClearDepthStencilView(dsvHandle, D3D12_CLEAR_FLAG_DEPTH, 1.0f, 0, 0, nullptr);
+
+                // The bundle inherits the scene constants, shadow map and lights
+                // bound here. With the prepass or occlusion culling the clusters
+                // are in m_sceneDraws instead, recorded below.
+                BindDrawList(*m_sceneCommands, bindings);
+                if (m_depthPrepass || m_occlusionCulling)
+                {
+                    // Nothing to draw here.
+                }
+                else if (m_indirectScene)
+                {
+                    // Culling replaces the pipeline, so the scene's is bound after it.
+                    m_indirectDraw.Cull(commandList, m_cullFrustum);
+                    m_sceneCommands->SetPipeline(m_sceneDraw.pipeline);
+                    m_sceneCommands->SetVertexBuffer(m_sceneDraw.vertexBuffer, m_sceneDraw.vertexStride);
+                    m_sceneCommands->SetInstanceBuffer(m_sceneDraw.instanceBuffer);
+                    m_indirectDraw.Draw(commandList);
+                }
+                else
+                {
+                    m_sceneCommands->ExecuteBundle(*m_sceneBundle);
+                }
+            }
+            m_sceneCommands->End();
+
+            // The recorded lists execute after the scene list, so they draw
+            // into the targets it cleared.
+            m_sceneDraws.Sort();
+            sceneDrawLists = m_drawRecorder->Record(m_frameIndex, bindings, m_sceneDraws.Items(), m_sceneDraws.Count(), beginPass);
+        });
+
+    m_frameGraph.AddPass("Upscale",
+        [&](FrameGraph::Builder& builder)
+        {
+            builder.Read(sceneColor, ResourceState::PixelShaderResource);
+            builder.Write(backBuffer, ResourceState::RenderTarget);
+        },
+        [&](const FrameGraph::PassContext& pass)
+        {
+            m_presentCommands->Begin(m_frameIndex);
+            ID3D12GraphicsCommandList* commandList = m_presentCommands->Native();
+            m_frameGraphResources.RecordBarriers(commandList, pass.barriers, pass.barrierCount);
+
+            commandList->OMSetRenderTargets(1, &backBufferRtv, FALSE, nullptr);
+            m_presentCommands->SetViewport(0.0f, 0.0f, static_cast<float>(m_width), static_cast<float>(m_height));
+            m_presentCommands->SetPipeline(m_upscalePipeline);
+
+            // The source slot and the rendered fraction of the target.
+            const float uvScale[2] = { static_cast<float>(m_renderWidth) / m_width, static_cast<float>(m_renderHeight) / m_height };
+            UINT constants[3] = { m_sceneColorSlot };
+            memcpy(&constants[1], uvScale, sizeof(uvScale));
+            commandList->SetGraphicsRoot32BitConstants(1, _countof(constants), constants, 0);
+            m_presentCommands->Draw(3);
+        });
+
+    m_frameGraph.Compile(m_frameGraphResources.SizeQuery());
+
+    // The graph has the same shape every frame, so its resources are only
+    // created on the first one.
+    if (m_frameGraphResources.Realize(m_frameGraph, m_framePacer.CurrentFenceValue(), m_framePacer.CompletedFenceValue()))
+    {
+        m_device->CreateDepthStencilView(m_frameGraphResources.Resource(depth), nullptr, dsvHandle);
+        m_device->CreateRenderTargetView(m_frameGraphResources.Resource(sceneColor), nullptr, rtvHandle);
+        // Frames still in flight sample the old view; the slot goes back to
+        // the heap once the one being recorded has finished.
+        if (m_sceneColorSlot != DescriptorAllocator::InvalidSlot)
+        {
+            m_descriptorHeap.Free(m_sceneColorSlot, m_framePacer.CurrentFenceValue());
+        }
+        m_sceneColorSlot = m_descriptorHeap.CreateShaderResourceView(m_frameGraphResources.Resource(sceneColor), nullptr);
+    }
+    m_frameGraphResources.Bind(backBuffer, m_renderTargets[m_frameIndex].Get());
+    m_frameGraphResources.Bind(shadowMap, m_shadowMap->Resource());
+    m_frameGraph.Execute();
 
-    CD3DX12_GPU_DESCRIPTOR_HANDLE cbv_srv_handle(m_cbvHeap->GetGPUDescriptorHandleForHeapStart());
-    m_commandList->SetGraphicsRootDescriptorTable(0, cbv_srv_handle);
-    cbv_srv_handle.Offset(1, m_cbvHeapDescriptorSize);
-    m_commandList->SetGraphicsRootDescriptorTable(1, cbv_srv_handle);
-    m_commandList->RSSetViewports(1, &m_viewport);
-    m_commandList->RSSetScissorRects(1, &m_scissorRect);
-    m_commandList->ClearDepthStencilView(m_dsvHeap->GetCPUDescriptorHandleForHeapStart(), 
-        D3D12_CLEAR_FLAG_DEPTH, 1.0f, 0, 0, nullptr);
+    // Indicate that the back buffer will now be used to present.
+    const std::vector<ResourceBarrierDesc>& finalBarriers = m_frameGraph.FinalBarriers();
+    m_frameGraphResources.RecordBarriers(m_presentCommands->Native(), finalBarriers.data(), finalBarriers.size());
+    m_gpuTimer.End(m_presentCommands->Native(), m_frameIndex);
+    m_presentCommands->End();
+
+    m_frameCommandLists.clear();
+    m_frameCommandLists.push_back(m_shadowCommands.get());
+    m_frameCommandLists.push_back(m_sceneCommands.get());
+    m_frameCommandLists.insert(m_frameCommandLists.end(), m_drawRecorder->Lists(), m_drawRecorder->Lists() + sceneDrawLists);
+    m_frameCommandLists.push_back(m_presentCommands.get());
+}
 
+// Static scene content never changes, so it is recorded once into a bundle
+// and replayed every frame instead of being re-recorded.
+void BasicGameEngine::recordSceneBundle()
+{
+    m_sceneBundle->Begin(0);
+    RecordDrawItems(*m_sceneBundle, &m_sceneDraw, 1);
+    m_sceneBundle->End();
+}
 
-    // Indicate that the back buffer will be used as a render target.
-    m_commandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(m_renderTargets[m_frameIndex].Get(), D3D12_RESOURCE_STATE_PRESENT, D3D12_RESOURCE_STATE_RENDER_TARGET));
+// Splits the scene into clusters for GPU culling and the depth prepass.
+void BasicGameEngine::loadIndirectObjects()
+{
+    std::vector<IndirectObject> objects = IndirectCulling::BuildObjects(&m_vertices[0].position, sizeof(Vertex),
+        static_cast<uint32_t>(m_vertices.size()), IndirectClusterVertices, m_albedoSlot);
+    m_indirectDraw.SetObjects(objects.data(), static_cast<UINT>(objects.size()));
 
-    CD3DX12_CPU_DESCRIPTOR_HANDLE rtvHandle(m_rtvHeap->GetCPUDescriptorHandleForHeapStart(), m_frameIndex, m_rtvDescriptorSize);
-    CD3DX12_CPU_DESCRIPTOR_HANDLE dsvHandle(m_dsvHeap->GetCPUDescriptorHandleForHeapStart());
-    m_commandList->OMSetRenderTargets(1, &rtvHandle, FALSE, &dsvHandle);
+    m_clusterBounds.Clear();
+    for (const IndirectObject& object : objects)
+    {
+        m_clusterBounds.AddPoints(&m_vertices[object.firstVertex].position, sizeof(Vertex), object.vertexCount);
+    }
+    m_sceneClusters = std::move(objects);
+}
 
-    // Record commands.
-    const float clearColor[] = { 0.0f, 0.2f, 0.4f, 1.0f };
-    m_commandList->ClearRenderTargetView(rtvHandle, clearColor, 0, nullptr);
-    m_commandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-    m_commandList->IASetVertexBuffers(0, 1, &m_vertexBufferView);
-    m_commandList->DrawInstanced(m_vertices.size(), 1, 0, 0);
+// Picks the scene's largest triangles as occluders.
+void BasicGameEngine::loadOccluders()
+{
+    m_occluders = OcclusionCulling::SelectOccluders(&m_vertices[0].position, sizeof(Vertex),
+        static_cast<uint32_t>(m_vertices.size()), MaxOccluderTriangles);
+    m_occlusionBuffer.Resize(OcclusionWidth, OcclusionHeight);
+}
 
-    // Indicate that the back buffer will now be used to present.
-    m_commandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(m_renderTargets[m_frameIndex].Get(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PRESENT));
+// Renders the current view on the CPU, at a quarter of the window size, to
+// Thumbnail.ppm.
+void BasicGameEngine::saveThumbnail()
+{
+    // Decoded texels are only kept in the layout the sampler reads.
+    RasterTexture albedo;
+    if (sometexture && sometexture->decodedData && sometexture->resource->GetDesc().Format == DXGI_FORMAT_R8G8B8A8_UNORM) {
+        const D3D12_RESOURCE_DESC desc = sometexture->resource->GetDesc();
+        albedo.width = static_cast<uint32_t>(desc.Width);
+        albedo.height = desc.Height;
+        albedo.rowPitch = static_cast<uint32_t>(sometexture->subresources[0].RowPitch);
+        albedo.texels = static_cast<const uint8_t*>(sometexture->subresources[0].pData);
+    }
 
-    ThrowIfFailed(m_commandList->Close());
+    RasterDraw draw;
+    draw.vertexCount = static_cast<uint32_t>(m_vertices.size());
+    draw.albedo = albedo.texels ? &albedo : nullptr;
+
+    static_assert(sizeof(Vertex) == sizeof(RasterVertex), "The rasterizer reads the scene's vertices as they are");
+    RasterScene scene;
+    scene.vertices = reinterpret_cast<const RasterVertex*>(m_vertices.data());
+    scene.draws = &draw;
+    scene.drawCount = 1;
+    XMFLOAT4X4 viewProjection;
+    XMStoreFloat4x4(&viewProjection, m_constantBufferData.PV);
+    memcpy(scene.viewProjection, viewProjection.m, sizeof(scene.viewProjection));
+    memcpy(scene.toLight, &m_constantBufferData.toLight, sizeof(scene.toLight));
+
+    SoftwareRasterizer rasterizer;
+    rasterizer.Resize((std::max)(m_width / 4, 1u), (std::max)(m_height / 4, 1u));
+    rasterizer.Render(scene, &JobSystem::Get());
+    if (!rasterizer.SavePpm("Thumbnail.ppm")) {
+        _RPT0(0, "Could not write Thumbnail.ppm\n");
+    }
+}
+
+// Scatters point and spot lights through the scene and sets up the cluster
+// grid for the camera's projection.
+void BasicGameEngine::loadSceneLights()
+{
+    ClusteredLighting::GridDesc grid;
+    grid.tanHalfFovY = tanf(XMConvertToRadians(m_FoV) * 0.5f);
+    grid.aspect = 16.0f / 9;
+    grid.nearZ = 0.1f;
+    grid.farZ = 100.0f;
+    m_lightBinner.SetGrid(grid);
+    ClusteredLighting::SliceScaleBias(grid, m_constantBufferData.clusterZScale, m_constantBufferData.clusterZBias);
+    m_constantBufferData.clusterTilesX = grid.tilesX;
+    m_constantBufferData.clusterTilesY = grid.tilesY;
+    m_constantBufferData.clusterSlices = grid.slices;
+
+    // A fixed seed, so the lights are the same on every run. Every fourth
+    // light is a spot light pointing down.
+    uint32_t state = 0x2545F491u;
+    auto random = [&state](float low, float high)
+    {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return low + (high - low) * static_cast<float>(state >> 8) / 16777216.0f;
+    };
+    m_sceneLights.resize(SceneLightCount);
+    for (UINT i = 0; i < SceneLightCount; i++)
+    {
+        ClusterLight& light = m_sceneLights[i];
+        light.position[0] = random(-15.0f, 15.0f);
+        light.position[1] = random(0.5f, 8.0f);
+        light.position[2] = random(-10.0f, 5.0f);
+        light.range = random(1.5f, 4.0f);
+        light.color[0] = random(0.2f, 1.0f);
+        light.color[1] = random(0.2f, 1.0f);
+        light.color[2] = random(0.2f, 1.0f);
+        light.spotCosAngle = i % 4 == 3 ? cosf(XMConvertToRadians(random(20.0f, 45.0f))) : ClusteredLighting::PointLight;
+        light.direction[0] = 0.0f;
+        light.direction[1] = -1.0f;
+        light.direction[2] = 0.0f;
+        light.padding = 0.0f;
+    }
+    m_frameLights = m_sceneLights;
 }
 
-void BasicGameEngine::WaitForPreviousFrame()
+// Places a grid of teapots over the floor of the scene, scaled to about
+// half a unit whatever the model's own size, each turned a different way.
+void BasicGameEngine::loadProps()
 {
-    // WAITING FOR THE FRAME TO COMPLETE BEFORE CONTINUING IS NOT BEST PRACTICE.
-    // This is code implemented as such for simplicity. The D3D12HelloFrameBuffering
-    // sample illustrates how to use fences for efficient resource usage and to
-    // maximize GPU utilization.
-
-    // Signal and increment the fence value.
-    const UINT64 fence = m_fenceValue;
-    ThrowIfFailed(m_commandQueue->Signal(m_fence.Get(), fence));
-    m_fenceValue++;
-
-    // Wait until the previous frame is finished.
-    if (m_fence->GetCompletedValue() < fence)
+    XMVECTOR low = XMVectorReplicate(FLT_MAX);
+    XMVECTOR high = XMVectorReplicate(-FLT_MAX);
+    for (const Vertex& vertex : m_propVertices)
     {
-        ThrowIfFailed(m_fence->SetEventOnCompletion(fence, m_fenceEvent));
-        WaitForSingleObject(m_fenceEvent, INFINITE);
+        const XMVECTOR position = XMLoadFloat3(&vertex.position);
+        low = XMVectorMin(low, position);
+        high = XMVectorMax(high, position);
     }
+    XMFLOAT3 extent, base;
+    XMStoreFloat3(&extent, XMVectorSubtract(high, low));
+    XMStoreFloat3(&base, low);
+    const float scale = 0.5f / (std::max)((std::max)(extent.x, extent.y), (std::max)(extent.z, 1e-6f));
 
-    m_frameIndex = m_swapChain->GetCurrentBackBufferIndex();
+    m_propInstances.clear();
+    for (int z = -8; z <= 4; z += 2)
+    {
+        for (int x = -12; x <= 12; x += 2)
+        {
+            const float angle = 0.7f * static_cast<float>(m_propInstances.size());
+            const float c = scale * cosf(angle);
+            const float s = scale * sinf(angle);
+
+            // Turned about y, with the bottom of the model's bounds on y = 0.
+            InstanceData instance = {};
+            instance.world[0][0] = c;
+            instance.world[0][2] = s;
+            instance.world[1][1] = scale;
+            instance.world[2][0] = -s;
+            instance.world[2][2] = c;
+            instance.world[0][3] = static_cast<float>(x);
+            instance.world[1][3] = -scale * base.y;
+            instance.world[2][3] = static_cast<float>(z);
+            instance.material = InstanceData::DrawMaterial;
+            m_propInstances.push_back(instance);
+        }
+    }
+}
+
+// Wait for pending GPU work to complete.
+void BasicGameEngine::WaitForGpu()
+{
+    m_framePacer.WaitForIdle();
+}
+
+// Prepare to render the next frame. Only blocks when the GPU is still
+// FrameCount frames behind, so OnUpdate for the next frame overlaps with the
+// GPU executing this one.
+void BasicGameEngine::MoveToNextFrame()
+{
+    m_framePacer.EndFrame(m_swapChain->GetCurrentBackBufferIndex());
+    m_frameIndex = m_framePacer.FrameSlot();
 }
 
 void BasicGameEngine::updateTime() {
@@ -540,6 +1139,32 @@ void BasicGameEngine::OnKeyDown(UINT8 keyCode) {
     case 'A':
         m_moveRight = -1;
         break;
+    case 'G':
+        m_indirectScene = !m_indirectScene;
+        break;
+    case 'P':
+        m_depthPrepass = !m_depthPrepass;
+        break;
+    case 'L':
+        m_clusteredLights = !m_clusteredLights;
+        break;
+    case 'R':
+        m_dynamicResolution = !m_dynamicResolution;
+        m_resolutionController.Reset();
+        break;
+    case 'K':
+        saveThumbnail();
+        break;
+    case 'T':
+        m_props = !m_props;
+        break;
+    case 'O':
+        m_occlusionCulling = !m_occlusionCulling;
+        if (!m_occlusionCulling) {
+            SetCustomWindowText(L"occlusion culling off");
+        }
+        m_culledTitleTime = -1.0;
+        break;
     default:
         ;
     }
@@ -676,10 +1301,18 @@ std::vector<UINT8> GenerateTextureData(int TextureWidth, int TexturePixelSize)
 
 
 void BasicGameEngine::loadTextureFromFile(Texture* texture) {
-    ThrowIfFailed(DirectX::LoadWICTextureFromFile(m_device.Get(), texture->filename.c_str(),
-        texture->resource.GetAddressOf(), texture->decodedData, texture->subresource));
+    const std::wstring& filename = texture->filename;
+    if (filename.size() > 4 && filename.compare(filename.size() - 4, 4, L".stc") == 0) {
+        loadSupercompressedTexture(texture);
+    }
+    else {
+        texture->subresources.resize(1);
+        ThrowIfFailed(DirectX::LoadWICTextureFromFile(m_device.Get(), texture->filename.c_str(),
+            texture->resource.GetAddressOf(), texture->decodedData, texture->subresources[0]));
+    }
 
-    const UINT64 uploadBufferSize = GetRequiredIntermediateSize(texture->resource.Get(), 0, 1);
+    const UINT subresourceCount = static_cast<UINT>(texture->subresources.size());
+    const UINT64 uploadBufferSize = GetRequiredIntermediateSize(texture->resource.Get(), 0, subresourceCount);
     CD3DX12_HEAP_PROPERTIES heapProps(D3D12_HEAP_TYPE_UPLOAD);
     auto desc = CD3DX12_RESOURCE_DESC::Buffer(uploadBufferSize);
 
@@ -688,41 +1321,63 @@ void BasicGameEngine::loadTextureFromFile(Texture* texture) {
         D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(texture->uploadHeap.GetAddressOf())
     ));
 
-    UpdateSubresources(m_commandList.Get(), texture->resource.Get(), texture->uploadHeap.Get(), 0, 0, 1, &texture->subresource);
-    auto barrier = CD3DX12_RESOURCE_BARRIER::Transition(texture->resource.Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
-    m_commandList->ResourceBarrier(1, &barrier);
-    
+    UpdateSubresources(m_commandList.Get(), texture->resource.Get(), texture->uploadHeap.Get(), 0, 0, subresourceCount, texture->subresources.data());
+    const uint32_t textureState = m_resourceStates.Register(texture->resource.Get(), D3D12_RESOURCE_STATE_COPY_DEST);
+    m_resourceStates.Transition(textureState, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+    m_resourceStates.Flush(m_commandList.Get());
+
 
     ThrowIfFailed(m_commandList->Close());
     ID3D12CommandList* ppCommandLists[] = { m_commandList.Get() };
     m_commandQueue->ExecuteCommandLists(_countof(ppCommandLists), ppCommandLists);
 
 
-    // Create synchronization objects and wait until assets have been uploaded to the GPU.
-    {
-        ThrowIfFailed(m_device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&m_fence)));
-        m_fenceValue = 1;
+    // Wait until the texture has been uploaded to the GPU.
+    WaitForGpu();
 
-        // Create an event handle to use for frame synchronization.
-        m_fenceEvent = CreateEvent(nullptr, FALSE, FALSE, nullptr);
-        if (m_fenceEvent == nullptr)
-        {
-            ThrowIfFailed(HRESULT_FROM_WIN32(GetLastError()));
-        }
+    loadSrvHeapResources(texture);
+}
 
-        // Wait for the command list to execute; we are reusing the same command 
-        // list in our main loop but for now, we just want to wait for setup to 
-        // complete before continuing.
-        WaitForPreviousFrame();
+// Transcodes a .stc container straight to BC blocks; no pixel decoding happens at load time.
+void BasicGameEngine::loadSupercompressedTexture(Texture* texture) {
+    byte* fileData = nullptr;
+    UINT fileSize = 0;
+    ThrowIfFailed(ReadDataFromFile(texture->filename.c_str(), &fileData, &fileSize));
+
+    SupercompressedTexture::TranscodedTexture transcoded;
+    const bool transcodedOk = SupercompressedTexture::Transcode(fileData, fileSize, transcoded);
+    free(fileData);
+    if (!transcodedOk) {
+        ThrowIfFailed(HRESULT_FROM_WIN32(ERROR_INVALID_DATA));
     }
 
-    loadSrvHeapResources(texture);
+    DXGI_FORMAT format;
+    if (transcoded.format == SupercompressedTexture::BlockFormat::BC1)
+        format = transcoded.srgb ? DXGI_FORMAT_BC1_UNORM_SRGB : DXGI_FORMAT_BC1_UNORM;
+    else
+        format = transcoded.srgb ? DXGI_FORMAT_BC3_UNORM_SRGB : DXGI_FORMAT_BC3_UNORM;
+
+    const UINT16 mipCount = static_cast<UINT16>(transcoded.mips.size());
+    auto desc = CD3DX12_RESOURCE_DESC::Tex2D(format, transcoded.width, transcoded.height, 1, mipCount);
+    ThrowIfFailed(m_device->CreateCommittedResource(
+        &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
+        D3D12_HEAP_FLAG_NONE,
+        &desc,
+        D3D12_RESOURCE_STATE_COPY_DEST,
+        nullptr,
+        IID_PPV_ARGS(texture->resource.ReleaseAndGetAddressOf())));
+
+    texture->decodedData = std::move(transcoded.data);
+    texture->subresources.resize(mipCount);
+    for (UINT16 mip = 0; mip < mipCount; mip++) {
+        const SupercompressedTexture::MipLevel& level = transcoded.mips[mip];
+        texture->subresources[mip].pData = texture->decodedData.get() + level.offset;
+        texture->subresources[mip].RowPitch = static_cast<LONG_PTR>(level.rowPitch);
+        texture->subresources[mip].SlicePitch = static_cast<LONG_PTR>(level.size);
+    }
 }
 
 void BasicGameEngine::loadSrvHeapResources(Texture* texture) {
-    CD3DX12_CPU_DESCRIPTOR_HANDLE hDescriptor(
-        m_cbvHeap -> GetCPUDescriptorHandleForHeapStart());
-    hDescriptor.Offset(1, m_cbvHeapDescriptorSize);
     D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
     srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
     srvDesc.Format = texture->resource -> GetDesc().Format;
@@ -730,6 +1385,8 @@ void BasicGameEngine::loadSrvHeapResources(Texture* texture) {
     srvDesc.Texture2D.MostDetailedMip = 0;
     srvDesc.Texture2D.MipLevels = texture->resource -> GetDesc().MipLevels;
     srvDesc.Texture2D.ResourceMinLODClamp = 0.0f;
-    m_device->CreateShaderResourceView(texture->resource.Get(), &srvDesc, hDescriptor);
+    const UINT slot = m_descriptorHeap.CreateShaderResourceView(texture->resource.Get(), &srvDesc);
+    m_albedoSlot = slot;
+    m_sceneDraw.albedo = m_renderDevice.ImportTexture(texture->resource.Get(), slot);
 
 }
@@ -12,6 +12,28 @@
 #pragma once
 
 #include "DXSample.h"
+#include "D3D12FenceQueue.h"
+#include "FramePacer.h"
+#include "UploadRingBuffer.h"
+#include "D3D12CopyQueue.h"
+#include "D3D12RenderDevice.h"
+#include "D3D12ResourceStates.h"
+#include "D3D12FrameGraphResources.h"
+#include "D3D12ShaderCompiler.h"
+#include "ShaderPermutation.h"
+#include "DrawList.h"
+#include "DrawQueue.h"
+#include "InstanceBatcher.h"
+#include "D3D12IndirectDraw.h"
+#include "ShadowMap.h"
+#include "CascadedShadows.h"
+#include "ClusteredLighting.h"
+#include "DynamicResolution.h"
+#include "D3D12GpuTimer.h"
+#include "ParallelDrawRecorder.h"
+#include "SoftwareRasterizer.h"
+#include "OcclusionCulling.h"
+#include "FrustumCulling.h"
 #include <chrono>
 #include <ctime>  
 #include "Camera.cpp"
@@ -41,7 +63,7 @@ struct Texture
     Microsoft::WRL::ComPtr<ID3D12Resource> uploadHeap =
         nullptr;
     std::unique_ptr<uint8_t[]> decodedData;
-    D3D12_SUBRESOURCE_DATA subresource;
+    std::vector<D3D12_SUBRESOURCE_DATA> subresources;
 
     Texture(std::wstring filename) {
         this->filename = filename;
@@ -74,40 +96,127 @@ public:
     virtual void OnMouseLeave();
 
 private:
-    static const UINT FrameCount = 2;
+    // Number of frames the CPU may run ahead of the GPU; also the swap chain length.
+    static const UINT FrameCount = 3;
+    static_assert(FrameCount >= 2 && FrameCount <= 3, "FrameCount must be 2 or 3");
 
     struct SceneConstantBuffer
     {
         DirectX::XMMATRIX PV;
         XMFLOAT3 eye;
-        float padding[45]; // Padding so the constant buffer is 256-byte aligned.
+        DirectX::XMMATRIX cascadePV[4]; // World to each cascade's clip space, for SHADOWED materials.
+        XMFLOAT4 cascadeSplits;         // Far view depth of each cascade.
+        XMFLOAT3 toLight;               // Unit vector towards the directional light.
+        float clusterZScale;            // Light cluster grid: slice of a view depth, see ClusteredLighting::SliceScaleBias...
+        XMFLOAT2 clusterTileScale;      // ...and tile of a pixel.
+        float clusterZBias;
+        UINT clusterTilesX;
+        UINT clusterTilesY;
+        UINT clusterSlices;
+        float padding[30]; // Padding so the constant buffer is 256-byte aligned.
     };
     static_assert((sizeof(SceneConstantBuffer) % 256) == 0, "Constant Buffer size must be 256-byte aligned");
 
+    // Enough for several frames of dynamic data; allocations fail loudly if exceeded.
+    static const UINT64 UploadRingSize = 4 * 1024 * 1024;
+    // Staging space for geometry uploads; larger meshes are streamed through it in chunks.
+    static const UINT64 GeometryStagingSize = 16 * 1024 * 1024;
+    // Bindless heap layout: long-lived SRVs, plus a region per frame in flight
+    // for descriptors that only live for one frame.
+    static const UINT PersistentDescriptorCount = 4096;
+    static const UINT TransientDescriptorsPerFrame = 256;
+    // Vertices per GPU-culled scene cluster.
+    static const UINT IndirectClusterVertices = 3 * 512;
+    // Directional light shadows: cascades over the view range, blending
+    // logarithmic and uniform splits.
+    static const UINT ShadowCascadeCount = CascadedShadows::MaxCascades;
+    static const UINT ShadowMapSize = 2048;
+    static constexpr float ShadowSplitLambda = 0.7f;
+    // Point and spot lights shaded through the light clusters.
+    static const UINT SceneLightCount = 256;
+    // Masked occlusion culling of the scene's clusters: the largest triangles
+    // are the occluders, rasterized into a low resolution depth buffer.
+    static const UINT OcclusionWidth = 320;
+    static const UINT OcclusionHeight = 192;
+    static const UINT MaxOccluderTriangles = 4096;
+
     // Pipeline objects.
     CD3DX12_VIEWPORT m_viewport;
     CD3DX12_RECT m_scissorRect;
     ComPtr<IDXGISwapChain3> m_swapChain;
     ComPtr<ID3D12Device> m_device;
     ComPtr<ID3D12Resource> m_renderTargets[FrameCount];
-    ComPtr<ID3D12CommandAllocator> m_commandAllocator;
+    ComPtr<ID3D12CommandAllocator> m_commandAllocator;    // Setup work only; frames record into m_sceneCommands.
     ComPtr<ID3D12CommandQueue> m_commandQueue;
     ComPtr<ID3D12RootSignature> m_rootSignature;
     ComPtr<ID3D12DescriptorHeap> m_rtvHeap;
-    ComPtr<ID3D12DescriptorHeap> m_cbvHeap;
+    D3D12DescriptorHeap m_descriptorHeap;
     ComPtr<ID3D12DescriptorHeap> m_dsvHeap;
-    ComPtr<ID3D12PipelineState> m_pipelineState;
     ComPtr<ID3D12GraphicsCommandList> m_commandList;
+    D3D12ShaderCompiler m_shaderCompiler;
+    D3D12PipelineCache m_pipelineCache;                           // Background PSO compilation, persisted as a pipeline library.
+    D3D12RenderDevice m_renderDevice;
+    std::unique_ptr<D3D12RenderCommandList> m_shadowCommands;     // Shadow cascades.
+    std::unique_ptr<D3D12RenderCommandList> m_sceneCommands;      // Clears and the static scene bundle.
+    std::unique_ptr<D3D12RenderCommandList> m_sceneBundle;        // Static draws, recorded once.
+    std::unique_ptr<ParallelDrawRecorder> m_drawRecorder;         // m_sceneDraws, recorded across threads.
+    std::unique_ptr<D3D12RenderCommandList> m_presentCommands;    // Upscale to the back buffer, and its transition to present.
+    std::vector<IRenderCommandList*> m_frameCommandLists;         // Submission order for this frame.
+    D3D12ResourceStates m_resourceStates;                         // Barriers for setup work (texture uploads).
+    FrameGraph m_frameGraph;                                      // Passes, barriers and transient targets of a frame.
+    D3D12FrameGraphResources m_frameGraphResources;
     UINT m_rtvDescriptorSize;
-    UINT m_cbvHeapDescriptorSize;
+    D3D12GpuTimer m_gpuTimer;                                     // Whole frames, for dynamic resolution.
 
     // App resources.
     ComPtr<ID3D12Resource> m_vertexBuffer;
-    D3D12_VERTEX_BUFFER_VIEW m_vertexBufferView;
-    ComPtr<ID3D12Resource> m_constantBuffer;
-    ComPtr<ID3D12Resource> m_depthStencilBuffer;
     SceneConstantBuffer m_constantBufferData;
-    UINT8* m_pCbvDataBegin;
+    UploadRingBuffer m_uploadRing;                  // Per-frame dynamic data (constants, ...).
+    BufferHandle m_uploadRingHandle;
+    UINT64 m_sceneConstantsOffset;                  // This frame's SceneConstantBuffer in m_uploadRing.
+    PipelineHandle m_scenePipelines[ShaderPermutationKey::PermutationCount];        // By permutation; only materials' are created.
+    PipelineHandle m_sceneEqualPipelines[ShaderPermutationKey::PermutationCount];   // The same, for shading after a depth prepass.
+    PipelineHandle m_depthPrepassPipeline;          // Position only, no pixel shader.
+    PipelineHandle m_shadowCasterPipeline;          // Cascade depth, clamped instead of clipped.
+    DrawItem m_sceneDraw;
+    UINT m_albedoSlot;                              // Bindless slot of the scene texture.
+    D3D12IndirectDraw m_indirectDraw;               // Scene clusters, culled and drawn on the GPU.
+    Frustum m_cullFrustum;                          // This frame's camera frustum.
+    bool m_indirectScene = true;                    // GPU culling, or the CPU-recorded bundle; unused while the prepass or occlusion culling is on.
+    bool m_depthPrepass = false;                    // Depth prepass over CPU-culled clusters; takes precedence.
+    std::vector<IndirectObject> m_sceneClusters;    // Bounds and vertex ranges of the scene's clusters.
+    CullingBounds m_clusterBounds;                  // The same clusters' boxes, for CPU culling.
+    FrustumCuller m_frustumCuller;
+    DrawQueue m_sceneDraws;                         // This frame's cluster and instanced draws, recorded in sort key order.
+    std::unique_ptr<ShadowMap> m_shadowMap;         // One slice per cascade.
+    TextureHandle m_shadowTexture;
+    ShadowCascade m_cascades[ShadowCascadeCount];   // Fitted to this frame's camera.
+    std::vector<DrawItem> m_shadowDraws[ShadowCascadeCount];    // Clusters casting into each cascade.
+    UINT64 m_shadowConstantsOffsets[ShadowCascadeCount];        // Scene constants with PV set to the cascade's.
+    LightBinner m_lightBinner;
+    std::vector<ClusterLight> m_sceneLights;        // Lights at rest; they bob around these positions.
+    std::vector<ClusterLight> m_frameLights;        // This frame's lights.
+    bool m_clusteredLights = true;
+    UINT64 m_lightsOffset;                          // This frame's lights, clusters and light indices in m_uploadRing.
+    UINT64 m_lightClustersOffset;
+    UINT64 m_lightIndicesOffset;
+    OcclusionBuffer m_occlusionBuffer;
+    std::vector<OccluderTriangle> m_occluders;
+    bool m_occlusionCulling = false;                // CPU-culled clusters, tested against the occluders; takes precedence.
+    UINT m_occlusionCulledDraws = 0;                // This frame's clusters hidden by the occluders...
+    UINT m_occlusionCulledTriangles = 0;            // ...and their triangles.
+    double m_culledTitleTime = -1.0;                // m_timeInSeconds when the counts were last put in the window title.
+    DynamicResolutionController m_resolutionController;
+    bool m_dynamicResolution = true;
+    UINT m_renderWidth;                             // This frame's part of the scene color target.
+    UINT m_renderHeight;
+    UINT m_sceneColorSlot = DescriptorAllocator::InvalidSlot;   // Bindless SRV of the scene color target.
+    PipelineHandle m_upscalePipeline;
+    InstanceBatcher m_instances;                    // Mesh placements for the next frame, drawn instanced.
+    DrawItem m_propDraw;                            // Models/teapot.obj, placed around the scene...
+    std::vector<InstanceData> m_propInstances;      // ...at these transforms, through m_instances every frame.
+    bool m_props = true;
+    std::vector<DrawItem> m_instancedDraws;
     std::chrono::duration<double> m_timeInSeconds = std::chrono::duration<double> (0);
     std::chrono::system_clock::time_point m_time_point = std::chrono::system_clock::now();
     double m_deltaTime = 1.0 / 144;
@@ -121,25 +230,38 @@ private:
     int m_mouse_dy = 0;
     bool m_mouseClicked = false;
     std::vector<Vertex> m_vertices;
-    Texture* sometexture;
+    std::vector<Vertex> m_propVertices;
+    Texture* sometexture = nullptr;
 
     DirectX::XMMATRIX m_projectionMatrix = XMMatrixPerspectiveFovRH(XMConvertToRadians(m_FoV), 16.0/9, 0.1f, 100.0f);
     Camera m_camera = Camera();
 
     // Synchronization objects.
     UINT m_frameIndex;
-    HANDLE m_fenceEvent;
-    ComPtr<ID3D12Fence> m_fence;
-    UINT64 m_fenceValue;
+    D3D12FenceQueue m_fenceQueue;
+    FramePacer m_framePacer;
+    D3D12CopyQueue m_copyQueue;
+    GeometryUploader m_geometryUploader;
 
     void LoadPipeline();
     void LoadPipelineAssets();
     void PopulateCommandList();
-    void WaitForPreviousFrame();
+    void recordSceneBundle();
+    void loadIndirectObjects();
+    void loadSceneLights();
+    void loadOccluders();
+    void loadProps();
+    void saveThumbnail();
+    void WaitForGpu();
+    void MoveToNextFrame();
     void updateTime();
     void updateCamera();
+    void updateShadowCascades();
+    void updateClusteredLights();
+    void updateRenderScale();
     void loadObjects();
     void createTexture2D(int width, int height, ComPtr<ID3D12Resource> texture);
     void loadTextureFromFile(Texture* texture);
+    void loadSupercompressedTexture(Texture* texture);
     void loadSrvHeapResources(Texture* texture);
 };
\ No newline at end of file
@@ -0,0 +1,127 @@
+#include "RecordingBenchmark.h"
+
+#include <cstdio>
+#include <cstring>
+#include <thread>
+
+// Runs the headless CPU benchmarks and prints one table per benchmark, or
+// only those whose names contain the first argument. Benchmarks that check
+// their output against a reference count a mismatch as a failure; the
+// number of failures is the exit code.
+int main(int argc, char** argv)
+{
+    const char* filter = argc > 1 ? argv[1] : nullptr;
+    auto selected = [filter](const char* name)
+    {
+        if (filter && !std::strstr(name, filter))
+        {
+            return false;
+        }
+        std::printf("\n%s\n", name);
+        return true;
+    };
+
+    std::vector<unsigned> threadCounts = { 1, 2, 4 };
+    const unsigned hardwareThreads = std::thread::hardware_concurrency();
+    if (hardwareThreads > threadCounts.back())
+    {
+        threadCounts.push_back(hardwareThreads);
+    }
+
+    int failed = 0;
+    auto check = [&failed](bool matchesReference)
+    {
+        if (!matchesReference)
+        {
+            failed++;
+        }
+        return matchesReference ? "" : "  MISMATCH";
+    };
+
+    if (selected("Recording (10000 draws)"))
+    {
+        for (const RecordingBenchmark::Result& result : RecordingBenchmark::Run(10000, threadCounts))
+        {
+            std::printf("  %2u threads  %8.3f ms  %6.2f M draws/s\n", result.threads, result.millisecondsPerFrame, result.drawsPerSecond / 1e6);
+        }
+    }
+
+    if (selected("DrawQueue sort (100000 draws)"))
+    {
+        for (const RecordingBenchmark::SortResult& result : RecordingBenchmark::RunSort(100000, threadCounts))
+        {
+            std::printf("  %2u threads  %8.3f ms  (reference %8.3f ms)  %6.2f M draws/s%s\n",
+                result.threads, result.milliseconds, result.referenceMilliseconds, result.drawsPerSecond / 1e6, check(result.matchesReference));
+        }
+    }
+
+    if (selected("Instancing (100000 teapots)"))
+    {
+        const RecordingBenchmark::InstancingResult result = RecordingBenchmark::RunInstancing();
+        std::printf("  %zu instances in %zu draws: batch %.3f ms, record %.3f ms, one draw per instance %.3f ms\n",
+            result.instances, result.draws, result.batchMilliseconds, result.recordMilliseconds, result.unbatchedRecordMilliseconds);
+    }
+
+    if (selected("Light binning (1024 lights)"))
+    {
+        for (const RecordingBenchmark::LightBinningResult& result : RecordingBenchmark::RunLightBinning(threadCounts))
+        {
+            std::printf("  %2u threads  %8.3f ms  (reference %8.3f ms)  %zu indices%s\n",
+                result.threads, result.milliseconds, result.referenceMilliseconds, result.lightIndices, check(result.matchesReference));
+        }
+    }
+
+    if (selected("Software rasterizer (20000 boxes, 1280x720)"))
+    {
+        for (const RecordingBenchmark::SoftwareRasterResult& result : RecordingBenchmark::RunSoftwareRaster(threadCounts))
+        {
+            std::printf("  %2u threads  %8.3f ms  (reference %8.3f ms)  %u triangles%s\n",
+                result.threads, result.milliseconds, result.referenceMilliseconds, result.triangles, check(result.matchesReference));
+        }
+    }
+
+    if (selected("Occlusion culling (10000 spheres, 320x192)"))
+    {
+        for (const RecordingBenchmark::OcclusionResult& result : RecordingBenchmark::RunOcclusionCulling(threadCounts))
+        {
+            std::printf("  %2u threads  %8.3f ms  (reference %8.3f ms)  %u culled%s\n",
+                result.threads, result.milliseconds, result.referenceMilliseconds, result.culledSpheres, check(result.matchesReference));
+        }
+    }
+
+    if (selected("Frustum culling (1M volumes)"))
+    {
+        for (const RecordingBenchmark::FrustumCullingResult& result : RecordingBenchmark::RunFrustumCulling(threadCounts))
+        {
+            std::printf("  %2u threads  spheres %8.3f ms  boxes %8.3f ms  (reference %8.3f ms)  %u / %u visible%s\n",
+                result.threads, result.sphereMilliseconds, result.boxMilliseconds, result.referenceMilliseconds,
+                result.visibleSpheres, result.visibleBoxes, check(result.matchesReference));
+        }
+    }
+
+    if (selected("Multi-view culling (1M boxes, 8 views)"))
+    {
+        for (const RecordingBenchmark::MultiViewCullingResult& result : RecordingBenchmark::RunMultiViewCulling(threadCounts))
+        {
+            std::printf("  %2u threads  one pass %8.3f ms  per view %8.3f ms%s\n",
+                result.threads, result.multiViewMilliseconds, result.independentMilliseconds, check(result.matchesReference));
+        }
+    }
+
+    if (selected("Texture transcode (1024x1024, every mip)"))
+    {
+        for (SupercompressedTexture::BlockFormat format : { SupercompressedTexture::BlockFormat::BC1, SupercompressedTexture::BlockFormat::BC3 })
+        {
+            const RecordingBenchmark::TranscodeResult result = RecordingBenchmark::RunTranscode(format);
+            std::printf("  BC%u  %2u threads  %8.3f ms  %7.1f MB/s  %zu bytes from %zu%s\n",
+                static_cast<unsigned>(format), result.threads, result.milliseconds, result.megabytesPerSecond, result.blockBytes, result.fileBytes,
+                check(result.matchesReference));
+        }
+    }
+
+    if (failed)
+    {
+        std::printf("\n%d benchmark runs did not match their reference\n", failed);
+    }
+    return failed;
+}
@@ -0,0 +1,650 @@
+#include "RecordingBenchmark.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include "ClusteredLighting.h"
+#include "DrawQueue.h"
+#include "FrustumCulling.h"
+#include "InstanceBatcher.h"
+#include "NullRenderDevice.h"
+#include "OcclusionCulling.h"
+#include "ParallelDrawRecorder.h"
+#include "SoftwareRasterizer.h"
+#include "Tests/ClusteredLightingFixtures.h"
+#include "Tests/FrustumCullingFixtures.h"
+#include "Tests/OcclusionCullingFixtures.h"
+#include "Tests/SoftwareRasterizerFixtures.h"
+#include "Tests/SupercompressedTextureFixtures.h"
+
+namespace RecordingBenchmark
+{
+    std::vector<Result> Run(size_t drawCount, const std::vector<unsigned>& threadCounts, unsigned frames)
+    {
+        NullRenderDevice device;
+
+        // A scene with a handful of materials and meshes, like a real draw list.
+        const uint32_t vertexStride = 32;
+        const uint32_t verticesPerMesh = 3 * 256;
+        const uint32_t meshCount = 64;
+
+        BufferDesc vertexDesc;
+        vertexDesc.size = static_cast<uint64_t>(vertexStride) * verticesPerMesh * meshCount;
+        const BufferHandle vertexBuffer = device.CreateBuffer(vertexDesc);
+
+        BufferDesc constantsDesc;
+        constantsDesc.size = ConstantBufferAlignment;
+        constantsDesc.memory = MemoryType::Upload;
+        const BufferHandle constants = device.CreateBuffer(constantsDesc);
+
+        const unsigned char bytecode[4] = {};
+        PipelineDesc pipelineDesc;
+        pipelineDesc.vertexShader.data = bytecode;
+        pipelineDesc.vertexShader.size = sizeof(bytecode);
+        pipelineDesc.pixelShader = pipelineDesc.vertexShader;
+
+        std::vector<PipelineHandle> pipelines(4);
+        for (PipelineHandle& pipeline : pipelines)
+        {
+            pipeline = device.CreatePipeline(pipelineDesc);
+        }
+
+        TextureDesc textureDesc;
+        textureDesc.width = 256;
+        textureDesc.height = 256;
+        std::vector<TextureHandle> textures(16);
+        for (TextureHandle& texture : textures)
+        {
+            texture = device.CreateTexture(textureDesc);
+        }
+
+        BufferDesc instanceDesc;
+        instanceDesc.size = sizeof(InstanceData);
+        const BufferHandle instance = device.CreateBuffer(instanceDesc);
+
+        std::vector<DrawItem> items(drawCount);
+        for (size_t i = 0; i < drawCount; i++)
+        {
+            items[i].instanceBuffer = instance;
+            items[i].pipeline = pipelines[i % pipelines.size()];
+            items[i].albedo = textures[(i / 3) % textures.size()];
+            items[i].vertexBuffer = vertexBuffer;
+            items[i].vertexStride = vertexStride;
+            items[i].vertexCount = verticesPerMesh;
+            items[i].firstVertex = static_cast<uint32_t>(i % meshCount) * verticesPerMesh;
+        }
+
+        DrawListBindings bindings;
+        bindings.sceneConstants = constants;
+
+        std::vector<Result> results;
+        for (unsigned threads : threadCounts)
+        {
+            threads = std::max(threads, 1u);
+
+            // The pool size is the calling thread plus threads - 1 workers. A single
+            // list is always recorded inline, so any pool works for one thread.
+            std::unique_ptr<JobSystem> jobs(new JobSystem(threads > 1 ? threads - 1 : 1));
+            ParallelDrawRecorder recorder(device, threads, 1, *jobs);
+
+            double best = 0.0;
+            for (unsigned frame = 0; frame <= frames; frame++)
+            {
+                const auto start = std::chrono::high_resolution_clock::now();
+                recorder.Record(frame % 3, bindings, items.data(), items.size(), [](IRenderCommandList& list)
+                {
+                    list.SetViewport(0.0f, 0.0f, 1280.0f, 720.0f);
+                });
+                const std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+
+                // The first frame grows the command storage; leave it out.
+                if (frame == 1 || (frame > 1 && elapsed.count() < best))
+                {
+                    best = elapsed.count();
+                }
+            }
+
+            Result result;
+            result.threads = threads;
+            result.millisecondsPerFrame = best;
+            result.drawsPerSecond = best > 0.0 ? drawCount / (best / 1000.0) : 0.0;
+            results.push_back(result);
+        }
+        return results;
+    }
+
+    std::vector<SortResult> RunSort(size_t drawCount, const std::vector<unsigned>& threadCounts, unsigned frames)
+    {
+        // Keys as a scene would produce them: a couple of passes, a few
+        // pipelines, many materials and meshes, depth all over the place.
+        std::mt19937 random(1);
+        std::vector<uint64_t> keys(drawCount);
+        std::vector<DrawItem> items(drawCount);
+        for (size_t i = 0; i < drawCount; i++)
+        {
+            keys[i] = DrawSortKey::Make(random() % 2, random() % 8, random() % 256, random() % 65536, random() % 1024);
+            items[i].vertexCount = 3;
+            items[i].firstVertex = static_cast<uint32_t>(i);
+        }
+
+        // The submission indices in key order, ties in submission order.
+        std::vector<uint32_t> expected;
+        double referenceBest = 0.0;
+        for (unsigned frame = 0; frame <= frames; frame++)
+        {
+            expected.resize(drawCount);
+            for (size_t i = 0; i < drawCount; i++)
+            {
+                expected[i] = static_cast<uint32_t>(i);
+            }
+
+            const auto start = std::chrono::high_resolution_clock::now();
+            std::stable_sort(expected.begin(), expected.end(), [&keys](uint32_t a, uint32_t b) { return keys[a] < keys[b]; });
+            const std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+            if (frame == 1 || (frame > 1 && elapsed.count() < referenceBest))
+            {
+                referenceBest = elapsed.count();
+            }
+        }
+
+        std::vector<SortResult> results;
+        for (unsigned threads : threadCounts)
+        {
+            threads = std::max(threads, 1u);
+            std::unique_ptr<JobSystem> jobs(new JobSystem(threads > 1 ? threads - 1 : 1));
+            DrawQueue queue;
+
+            double best = 0.0;
+            for (unsigned frame = 0; frame <= frames; frame++)
+            {
+                queue.Reset();
+                for (size_t i = 0; i < drawCount; i++)
+                {
+                    queue.Submit(keys[i], items[i]);
+                }
+
+                const auto start = std::chrono::high_resolution_clock::now();
+                queue.Sort(threads > 1 ? jobs.get() : nullptr);
+                const std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+
+                // The first frame grows the sort buffers; leave it out.
+                if (frame == 1 || (frame > 1 && elapsed.count() < best))
+                {
+                    best = elapsed.count();
+                }
+            }
+
+            bool matches = queue.Count() == drawCount;
+            for (size_t i = 0; matches && i < drawCount; i++)
+            {
+                matches = queue.Items()[i].firstVertex == expected[i];
+            }
+
+            SortResult result;
+            result.threads = threads;
+            result.milliseconds = best;
+            result.referenceMilliseconds = referenceBest;
+            result.drawsPerSecond = best > 0.0 ? drawCount / (best / 1000.0) : 0.0;
+            result.matchesReference = matches;
+            results.push_back(result);
+        }
+        return results;
+    }
+
+    InstancingResult RunInstancing(size_t instanceCount, uint32_t meshVertices, unsigned frames)
+    {
+        NullRenderDevice device;
+
+        const uint32_t vertexStride = 32;
+        BufferDesc vertexDesc;
+        vertexDesc.size = static_cast<uint64_t>(vertexStride) * meshVertices;
+        const BufferHandle vertexBuffer = device.CreateBuffer(vertexDesc);
+
+        BufferDesc constantsDesc;
+        constantsDesc.size = ConstantBufferAlignment;
+        constantsDesc.memory = MemoryType::Upload;
+        const BufferHandle constants = device.CreateBuffer(constantsDesc);
+
+        BufferDesc instanceDesc;
+        instanceDesc.size = std::max<uint64_t>(instanceCount, 1) * sizeof(InstanceData);
+        instanceDesc.memory = MemoryType::Upload;
+        const BufferHandle instanceBuffer = device.CreateBuffer(instanceDesc);
+        void* instanceData = device.Map(instanceBuffer);
+
+        const unsigned char bytecode[4] = {};
+        PipelineDesc pipelineDesc;
+        pipelineDesc.vertexShader.data = bytecode;
+        pipelineDesc.vertexShader.size = sizeof(bytecode);
+        pipelineDesc.pixelShader = pipelineDesc.vertexShader;
+        const PipelineHandle pipeline = device.CreatePipeline(pipelineDesc);
+
+        TextureDesc textureDesc;
+        textureDesc.width = 256;
+        textureDesc.height = 256;
+        std::vector<TextureHandle> textures(4);
+        for (TextureHandle& texture : textures)
+        {
+            texture = device.CreateTexture(textureDesc);
+        }
+
+        // Teapots on a grid, turned and scaled at random, with materials
+        // interleaved the way a scene would place them.
+        std::mt19937 random(1);
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+        const size_t side = static_cast<size_t>(std::ceil(std::sqrt(static_cast<double>(instanceCount))));
+        std::vector<DrawItem> meshes(instanceCount);
+        std::vector<InstanceData> instances(instanceCount);
+        for (size_t i = 0; i < instanceCount; i++)
+        {
+            meshes[i].pipeline = pipeline;
+            meshes[i].albedo = textures[random() % textures.size()];
+            meshes[i].vertexBuffer = vertexBuffer;
+            meshes[i].vertexStride = vertexStride;
+            meshes[i].vertexCount = meshVertices;
+
+            const float angle = unit(random) * 6.2831853f;
+            const float scale = 0.5f + unit(random);
+            InstanceData& instance = instances[i];
+            memset(&instance, 0, sizeof(instance));
+            instance.world[0][0] = scale * std::cos(angle);
+            instance.world[0][2] = scale * std::sin(angle);
+            instance.world[1][1] = scale;
+            instance.world[2][0] = -scale * std::sin(angle);
+            instance.world[2][2] = scale * std::cos(angle);
+            instance.world[0][3] = 4.0f * static_cast<float>(i % side);
+            instance.world[2][3] = 4.0f * static_cast<float>(i / side);
+            instance.material = InstanceData::DrawMaterial;
+        }
+
+        DrawListBindings bindings;
+        bindings.sceneConstants = constants;
+        std::unique_ptr<IRenderCommandList> list = device.CreateCommandList();
+
+        // Records draws into the list and submits it; returns milliseconds.
+        auto record = [&](const std::vector<DrawItem>& draws)
+        {
+            const auto start = std::chrono::high_resolution_clock::now();
+            list->Begin(0);
+            list->SetViewport(0.0f, 0.0f, 1280.0f, 720.0f);
+            RecordDrawList(*list, bindings, draws.data(), draws.size());
+            list->End();
+            IRenderCommandList* lists[] = { list.get() };
+            device.Submit(lists, 1);
+            const std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+            return elapsed.count();
+        };
+
+        InstancingResult result = {};
+        result.instances = instanceCount;
+
+        InstanceBatcher batcher;
+        std::vector<DrawItem> draws;
+        for (unsigned frame = 0; frame <= frames; frame++)
+        {
+            const auto start = std::chrono::high_resolution_clock::now();
+            batcher.Reset();
+            for (size_t i = 0; i < instanceCount; i++)
+            {
+                batcher.Add(meshes[i], instances[i]);
+            }
+            draws.clear();
+            batcher.Build(instanceBuffer, 0, instanceData, draws);
+            const std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+            const double recordTime = record(draws);
+
+            // The first frame grows the containers; leave it out.
+            if (frame == 1 || (frame > 1 && elapsed.count() < result.batchMilliseconds))
+            {
+                result.batchMilliseconds = elapsed.count();
+            }
+            if (frame == 1 || (frame > 1 && recordTime < result.recordMilliseconds))
+            {
+                result.recordMilliseconds = recordTime;
+            }
+        }
+        result.draws = draws.size();
+
+        // Without grouping every instance is its own draw of one instance.
+        std::vector<DrawItem> unbatched(meshes);
+        memcpy(instanceData, instances.data(), instanceCount * sizeof(InstanceData));
+        for (size_t i = 0; i < instanceCount; i++)
+        {
+            unbatched[i].instanceBuffer = instanceBuffer;
+            unbatched[i].instanceOffset = i * sizeof(InstanceData);
+        }
+        for (unsigned frame = 0; frame <= frames; frame++)
+        {
+            const double recordTime = record(unbatched);
+            if (frame == 1 || (frame > 1 && recordTime < result.unbatchedRecordMilliseconds))
+            {
+                result.unbatchedRecordMilliseconds = recordTime;
+            }
+        }
+        return result;
+    }
+
+    std::vector<LightBinningResult> RunLightBinning(const std::vector<unsigned>& threadCounts, uint32_t lightCount, unsigned frames)
+    {
+        const ClusteredLightingFixtures::TestScene scene = ClusteredLightingFixtures::MakeTestScene(lightCount, 1);
+
+        ClusteredLightingFixtures::Bins reference;
+        double referenceBest = 0.0;
+        for (unsigned frame = 0; frame <= frames; frame++)
+        {
+            const auto start = std::chrono::high_resolution_clock::now();
+            ClusteredLightingFixtures::BinReference(scene.grid, scene.view, scene.lights.data(), lightCount, reference);
+            const std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+            if (frame == 1 || (frame > 1 && elapsed.count() < referenceBest))
+            {
+                referenceBest = elapsed.count();
+            }
+        }
+
+        std::vector<LightBinningResult> results;
+        for (unsigned threads : threadCounts)
+        {
+            threads = std::max(threads, 1u);
+            std::unique_ptr<JobSystem> jobs(new JobSystem(threads > 1 ? threads - 1 : 1));
+            LightBinner binner;
+            binner.SetGrid(scene.grid);
+
+            double best = 0.0;
+            for (unsigned frame = 0; frame <= frames; frame++)
+            {
+                const auto start = std::chrono::high_resolution_clock::now();
+                binner.Bin(scene.view, scene.lights.data(), lightCount, threads > 1 ? jobs.get() : nullptr);
+                const std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+
+                // The first frame grows the slices' buffers; leave it out.
+                if (frame == 1 || (frame > 1 && elapsed.count() < best))
+                {
+                    best = elapsed.count();
+                }
+            }
+
+            std::string mismatch;
+            LightBinningResult result;
+            result.threads = threads;
+            result.milliseconds = best;
+            result.referenceMilliseconds = referenceBest;
+            result.lightIndices = binner.LightIndices().size();
+            result.matchesReference = ClusteredLightingFixtures::Compare(reference, binner, mismatch);
+            results.push_back(result);
+        }
+        return results;
+    }
+
+    std::vector<SoftwareRasterResult> RunSoftwareRaster(const std::vector<unsigned>& threadCounts, uint32_t boxCount,
+        uint32_t width, uint32_t height, unsigned frames)
+    {
+        const std::unique_ptr<SoftwareRasterizerFixtures::TestScene> scene =
+            SoftwareRasterizerFixtures::MakeTestScene(boxCount, 1, static_cast<float>(width) / height);
+
+        SoftwareRasterizer reference;
+        reference.Resize(width, height);
+        const auto referenceStart = std::chrono::high_resolution_clock::now();
+        reference.RenderReference(scene->scene);
+        const std::chrono::duration<double, std::milli> referenceElapsed = std::chrono::high_resolution_clock::now() - referenceStart;
+
+        std::vector<SoftwareRasterResult> results;
+        for (unsigned threads : threadCounts)
+        {
+            threads = std::max(threads, 1u);
+            std::unique_ptr<JobSystem> jobs(new JobSystem(threads > 1 ? threads - 1 : 1));
+            SoftwareRasterizer rasterizer;
+            rasterizer.Resize(width, height);
+
+            double best = 0.0;
+            for (unsigned frame = 0; frame <= frames; frame++)
+            {
+                const auto start = std::chrono::high_resolution_clock::now();
+                rasterizer.Render(scene->scene, threads > 1 ? jobs.get() : nullptr);
+                const std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+
+                // The first frame grows the chunks and bins; leave it out.
+                if (frame == 1 || (frame > 1 && elapsed.count() < best))
+                {
+                    best = elapsed.count();
+                }
+            }
+
+            std::string mismatch;
+            SoftwareRasterResult result;
+            result.threads = threads;
+            result.milliseconds = best;
+            result.referenceMilliseconds = referenceElapsed.count();
+            result.triangles = rasterizer.GetStats().setupTriangles;
+            result.matchesReference = SoftwareRasterizerFixtures::Compare(reference, rasterizer, mismatch);
+            results.push_back(result);
+        }
+        return results;
+    }
+
+    std::vector<OcclusionResult> RunOcclusionCulling(const std::vector<unsigned>& threadCounts, uint32_t sphereCount,
+        uint32_t width, uint32_t height, unsigned frames)
+    {
+        const OcclusionCullingFixtures::TestScene scene = OcclusionCullingFixtures::MakeTestScene(sphereCount, 1);
+        const uint32_t occluderCount = static_cast<uint32_t>(scene.occluders.size());
+        auto cull = [&scene, sphereCount](const OcclusionBuffer& buffer, std::vector<bool>& visible)
+        {
+            uint32_t culled = 0;
+            for (uint32_t i = 0; i < sphereCount; i++)
+            {
+                visible[i] = buffer.IsVisible(&scene.spheres[i * 4], scene.spheres[i * 4 + 3]);
+                culled += visible[i] ? 0 : 1;
+            }
+            return culled;
+        };
+
+        OcclusionBuffer reference;
+        reference.Resize(width, height);
+        std::vector<bool> referenceVisible(sphereCount);
+        double referenceBest = 0.0;
+        for (unsigned frame = 0; frame <= frames; frame++)
+        {
+            const auto start = std::chrono::high_resolution_clock::now();
+            reference.RenderReference(scene.viewProjection, scene.occluders.data(), occluderCount);
+            cull(reference, referenceVisible);
+            const std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+            if (frame == 1 || (frame > 1 && elapsed.count() < referenceBest))
+            {
+                referenceBest = elapsed.count();
+            }
+        }
+
+        std::vector<OcclusionResult> results;
+        for (unsigned threads : threadCounts)
+        {
+            threads = std::max(threads, 1u);
+            std::unique_ptr<JobSystem> jobs(new JobSystem(threads > 1 ? threads - 1 : 1));
+            OcclusionBuffer buffer;
+            buffer.Resize(width, height);
+            std::vector<bool> visible(sphereCount);
+
+            double best = 0.0;
+            uint32_t culled = 0;
+            for (unsigned frame = 0; frame <= frames; frame++)
+            {
+                const auto start = std::chrono::high_resolution_clock::now();
+                buffer.Render(scene.viewProjection, scene.occluders.data(), occluderCount, threads > 1 ? jobs.get() : nullptr);
+                culled = cull(buffer, visible);
+                const std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+
+                // The first frame grows the triangle list; leave it out.
+                if (frame == 1 || (frame > 1 && elapsed.count() < best))
+                {
+                    best = elapsed.count();
+                }
+            }
+
+            std::string mismatch;
+            OcclusionResult result;
+            result.threads = threads;
+            result.milliseconds = best;
+            result.referenceMilliseconds = referenceBest;
+            result.culledSpheres = culled;
+            result.matchesReference = OcclusionCullingFixtures::Compare(reference, buffer, mismatch) && visible == referenceVisible;
+            results.push_back(result);
+        }
+        return results;
+    }
+
+    std::vector<FrustumCullingResult> RunFrustumCulling(const std::vector<unsigned>& threadCounts, uint32_t count, unsigned frames)
+    {
+        const FrustumCullingFixtures::TestScene scene = FrustumCullingFixtures::MakeTestScene(count, 1);
+        const FrustumCulling::Shape shapes[2] = { FrustumCulling::Shape::Sphere, FrustumCulling::Shape::Box };
+
+        std::vector<uint32_t> reference[2];
+        uint32_t referenceCounts[2];
+        double referenceBest = 0.0;
+        for (int shape = 0; shape < 2; shape++)
+        {
+            reference[shape].resize(count);
+            for (unsigned frame = 0; frame <= (shape == 0 ? frames : 0); frame++)
+            {
+                const auto start = std::chrono::high_resolution_clock::now();
+                referenceCounts[shape] = FrustumCulling::CullReference(scene.frustum, scene.bounds, shapes[shape], 0, count, reference[shape].data());
+                const std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+                if (frame == 1 || (frame > 1 && elapsed.count() < referenceBest))
+                {
+                    referenceBest = elapsed.count();
+                }
+            }
+        }
+
+        std::vector<FrustumCullingResult> results;
+        for (unsigned threads : threadCounts)
+        {
+            threads = std::max(threads, 1u);
+            std::unique_ptr<JobSystem> jobs(new JobSystem(threads > 1 ? threads - 1 : 1));
+            FrustumCuller culler;
+
+            FrustumCullingResult result;
+            result.threads = threads;
+            result.matchesReference = true;
+            for (int shape = 0; shape < 2; shape++)
+            {
+                double best = 0.0;
+                for (unsigned frame = 0; frame <= frames; frame++)
+                {
+                    const auto start = std::chrono::high_resolution_clock::now();
+                    culler.Cull(scene.frustum, scene.bounds, shapes[shape], threads > 1 ? jobs.get() : nullptr);
+                    const std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+
+                    // The first frame grows the output lists; leave it out.
+                    if (frame == 1 || (frame > 1 && elapsed.count() < best))
+                    {
+                        best = elapsed.count();
+                    }
+                }
+
+                std::string mismatch;
+                result.matchesReference = result.matchesReference && FrustumCullingFixtures::Compare(reference[shape].data(), referenceCounts[shape],
+                    culler.Visible(), culler.VisibleCount(), mismatch);
+                (shape == 0 ? result.sphereMilliseconds : result.boxMilliseconds) = best;
+                (shape == 0 ? result.visibleSpheres : result.visibleBoxes) = culler.VisibleCount();
+            }
+            result.referenceMilliseconds = referenceBest;
+            results.push_back(result);
+        }
+        return results;
+    }
+
+    std::vector<MultiViewCullingResult> RunMultiViewCulling(const std::vector<unsigned>& threadCounts, uint32_t count, uint32_t viewCount,
+        unsigned frames)
+    {
+        const FrustumCullingFixtures::TestScene scene = FrustumCullingFixtures::MakeTestScene(count, 1);
+        const std::vector<Frustum> views = FrustumCullingFixtures::MakeTestViews(viewCount, 1);
+        std::vector<uint16_t> reference(count);
+        FrustumCulling::CullViewsReference(views.data(), viewCount, scene.bounds, FrustumCulling::Shape::Box, 0, count, reference.data());
+
+        std::vector<MultiViewCullingResult> results;
+        for (unsigned threads : threadCounts)
+        {
+            threads = std::max(threads, 1u);
+            std::unique_ptr<JobSystem> jobs(new JobSystem(threads > 1 ? threads - 1 : 1));
+            FrustumCuller multiView;
+            std::vector<FrustumCuller> independent(viewCount);
+
+            MultiViewCullingResult result;
+            result.threads = threads;
+            for (unsigned frame = 0; frame <= frames; frame++)
+            {
+                const auto start = std::chrono::high_resolution_clock::now();
+                multiView.CullViews(views.data(), viewCount, scene.bounds, FrustumCulling::Shape::Box, threads > 1 ? jobs.get() : nullptr);
+                const auto split = std::chrono::high_resolution_clock::now();
+                for (uint32_t v = 0; v < viewCount; v++)
+                {
+                    independent[v].Cull(views[v], scene.bounds, FrustumCulling::Shape::Box, threads > 1 ? jobs.get() : nullptr);
+                }
+                const std::chrono::duration<double, std::milli> multiViewElapsed = split - start;
+                const std::chrono::duration<double, std::milli> independentElapsed = std::chrono::high_resolution_clock::now() - split;
+
+                // The first frame grows the output lists; leave it out.
+                if (frame == 1 || (frame > 1 && multiViewElapsed.count() < result.multiViewMilliseconds))
+                {
+                    result.multiViewMilliseconds = multiViewElapsed.count();
+                }
+                if (frame == 1 || (frame > 1 && independentElapsed.count() < result.independentMilliseconds))
+                {
+                    result.independentMilliseconds = independentElapsed.count();
+                }
+            }
+
+            // Bit v of the masks must pick out the same volumes as view v's
+            // own cull.
+            std::string mismatch;
+            result.matchesReference = FrustumCullingFixtures::CompareViewMasks(reference.data(), multiView.ViewMasks(), count, mismatch);
+            for (uint32_t v = 0; v < viewCount && result.matchesReference; v++)
+            {
+                std::vector<uint32_t> visible;
+                for (uint32_t i = 0; i < count; i++)
+                {
+                    if (reference[i] & (1u << v))
+                    {
+                        visible.push_back(i);
+                    }
+                }
+                result.matchesReference = FrustumCullingFixtures::Compare(visible.data(), static_cast<uint32_t>(visible.size()),
+                    independent[v].Visible(), independent[v].VisibleCount(), mismatch);
+            }
+            results.push_back(result);
+        }
+        return results;
+    }
+
+    TranscodeResult RunTranscode(SupercompressedTexture::BlockFormat format, uint32_t size, unsigned frames)
+    {
+        const std::vector<uint8_t> pixels = SupercompressedTextureFixtures::MakeTestImage(size, size, 1);
+        const ImageResampler::ImageView image = { pixels.data(), size, size, size_t(size) * 4, ImageResampler::PixelLayout::RGBA8, true };
+        std::vector<uint8_t> file;
+        SupercompressedTexture::Encode(image, format, true, file);
+
+        TranscodeResult result = {};
+        result.threads = JobSystem::Get().ThreadCount();
+        result.fileBytes = file.size();
+        result.matchesReference = !file.empty();
+
+        SupercompressedTexture::TranscodedTexture texture = {};
+        for (unsigned frame = 0; frame < frames && result.matchesReference; frame++)
+        {
+            const auto start = std::chrono::high_resolution_clock::now();
+            result.matchesReference = SupercompressedTexture::Transcode(file.data(), file.size(), texture);
+            const std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+            if (frame == 0 || elapsed.count() < result.milliseconds)
+            {
+                result.milliseconds = elapsed.count();
+            }
+        }
+
+        std::string mismatch;
+        result.matchesReference = result.matchesReference &&
+            SupercompressedTextureFixtures::Compare(SupercompressedTextureFixtures::EncodeReference(image, format, true), texture, mismatch);
+        result.blockBytes = texture.dataSize;
+        result.megabytesPerSecond = result.milliseconds > 0.0 ? texture.dataSize / (result.milliseconds * 1000.0) : 0.0;
+        return result;
+    }
+}
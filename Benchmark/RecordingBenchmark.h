@@ -0,0 +1,150 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "SupercompressedTexture.h"
+
+// Headless measurement of draw recording throughput on the null backend, so
+// the CPU cost of a frame can be tracked on machines without a GPU.
+namespace RecordingBenchmark
+{
+    struct Result
+    {
+        unsigned threads;
+        double millisecondsPerFrame;
+        double drawsPerSecond;
+    };
+
+    // Records a synthetic scene of drawCount items with ParallelDrawRecorder,
+    // once per entry of threadCounts (one command list per thread), and
+    // reports the best of frames runs for each.
+    std::vector<Result> Run(size_t drawCount, const std::vector<unsigned>& threadCounts, unsigned frames = 20);
+
+    struct SortResult
+    {
+        unsigned threads;
+        double milliseconds;                    // DrawQueue::Sort.
+        double referenceMilliseconds;           // std::stable_sort of the same keys, single threaded.
+        double drawsPerSecond;
+        bool matchesReference;
+    };
+
+    // Sorts drawCount randomly ordered draws with DrawQueue, per entry of
+    // threadCounts, checks the order against std::stable_sort of the keys
+    // and reports the best of frames runs for each.
+    std::vector<SortResult> RunSort(size_t drawCount, const std::vector<unsigned>& threadCounts, unsigned frames = 20);
+
+    // Vertices of Models/teapot.obj (6320 triangles, unindexed as ObjLoader
+    // loads it).
+    const uint32_t TeapotVertexCount = 3 * 6320;
+
+    struct InstancingResult
+    {
+        size_t instances;
+        size_t draws;                           // Instanced draws after grouping.
+        double batchMilliseconds;               // Grouping and writing the instance data.
+        double recordMilliseconds;              // Recording and submitting the instanced draws.
+        double unbatchedRecordMilliseconds;     // The same instances as one draw each.
+    };
+
+    // Places instanceCount copies of a meshVertices mesh, spread over a few
+    // materials, groups them with InstanceBatcher and records the result on
+    // the null backend. Reports the best of frames runs, next to recording
+    // one draw per instance. Only the vertex count of the mesh matters to the
+    // null backend, so no model is loaded.
+    InstancingResult RunInstancing(size_t instanceCount = 100000, uint32_t meshVertices = TeapotVertexCount, unsigned frames = 20);
+
+    struct LightBinningResult
+    {
+        unsigned threads;
+        double milliseconds;                    // LightBinner::Bin.
+        double referenceMilliseconds;           // ClusteredLightingFixtures::BinReference, single threaded.
+        size_t lightIndices;                    // Entries of the light index list.
+        bool matchesReference;
+    };
+
+    // Bins the lightCount lights of ClusteredLightingFixtures::MakeTestScene
+    // into the default cluster grid, per entry of threadCounts, checks the
+    // result against the reference binner and reports the best of frames runs.
+    std::vector<LightBinningResult> RunLightBinning(const std::vector<unsigned>& threadCounts, uint32_t lightCount = 1024, unsigned frames = 20);
+
+    struct SoftwareRasterResult
+    {
+        unsigned threads;
+        double milliseconds;                    // SoftwareRasterizer::Render.
+        double referenceMilliseconds;           // SoftwareRasterizer::RenderReference, single threaded.
+        uint32_t triangles;                     // Left to rasterize after clipping and culling.
+        bool matchesReference;
+    };
+
+    // Renders SoftwareRasterizerFixtures::MakeTestScene with boxCount boxes
+    // at width by height, per entry of threadCounts, checks the image against
+    // the reference renderer and reports the best of frames runs.
+    std::vector<SoftwareRasterResult> RunSoftwareRaster(const std::vector<unsigned>& threadCounts, uint32_t boxCount = 20000,
+        uint32_t width = 1280, uint32_t height = 720, unsigned frames = 10);
+
+    struct OcclusionResult
+    {
+        unsigned threads;
+        double milliseconds;                    // OcclusionBuffer::Render and the sphere tests.
+        double referenceMilliseconds;           // OcclusionBuffer::RenderReference and the sphere tests, single threaded.
+        uint32_t culledSpheres;
+        bool matchesReference;
+    };
+
+    // Rasterizes the occluders of OcclusionCullingFixtures::MakeTestScene
+    // into a width by height buffer and tests its sphereCount spheres against
+    // it, per entry of threadCounts. Checks the buffer and the results against
+    // the reference rasterizer and reports the best of frames runs.
+    std::vector<OcclusionResult> RunOcclusionCulling(const std::vector<unsigned>& threadCounts, uint32_t sphereCount = 10000,
+        uint32_t width = 320, uint32_t height = 192, unsigned frames = 20);
+
+    struct FrustumCullingResult
+    {
+        unsigned threads;
+        double sphereMilliseconds;              // FrustumCuller::Cull, testing spheres...
+        double boxMilliseconds;                 // ...and boxes.
+        double referenceMilliseconds;           // FrustumCulling::CullReference on the spheres, single threaded.
+        uint32_t visibleSpheres;
+        uint32_t visibleBoxes;
+        bool matchesReference;
+    };
+
+    // Culls the count volumes of FrustumCullingFixtures::MakeTestScene as
+    // spheres and as boxes, per entry of threadCounts, checks the visible
+    // lists against the reference and reports the best of frames runs.
+    std::vector<FrustumCullingResult> RunFrustumCulling(const std::vector<unsigned>& threadCounts, uint32_t count = 1u << 20, unsigned frames = 20);
+
+    struct MultiViewCullingResult
+    {
+        unsigned threads;
+        double multiViewMilliseconds;           // FrustumCuller::CullViews, every view in one pass...
+        double independentMilliseconds;         // ...and FrustumCuller::Cull once per view.
+        bool matchesReference;
+    };
+
+    // Culls the count boxes of FrustumCullingFixtures::MakeTestScene against
+    // viewCount views from FrustumCullingFixtures::MakeTestViews, in one pass
+    // and as viewCount separate culls, per entry of threadCounts. Checks the
+    // view masks against the reference and the separate culls, and reports
+    // the best of frames runs.
+    std::vector<MultiViewCullingResult> RunMultiViewCulling(const std::vector<unsigned>& threadCounts, uint32_t count = 1u << 20,
+        uint32_t viewCount = 8, unsigned frames = 20);
+
+    struct TranscodeResult
+    {
+        unsigned threads;                       // Of JobSystem::Get(), which Transcode runs on.
+        size_t fileBytes;
+        size_t blockBytes;                      // Transcoded block data, every mip.
+        double milliseconds;                    // SupercompressedTexture::Transcode.
+        double megabytesPerSecond;              // Of block data.
+        bool matchesReference;
+    };
+
+    // Encodes SupercompressedTextureFixtures::MakeTestImage at size by size
+    // with every mip, transcodes the file, checks the blocks against
+    // SupercompressedTextureFixtures::EncodeReference and reports the best of
+    // frames runs.
+    TranscodeResult RunTranscode(SupercompressedTexture::BlockFormat format, uint32_t size = 1024, unsigned frames = 20);
+}
@@ -56,6 +56,10 @@ public:
 		};
 	}
 
+	XMVECTOR forward() const {
+		return front;
+	}
+
 	XMMATRIX* viewMatrix() {
 		return &m_viewMatrix;
 	}
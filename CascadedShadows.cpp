@@ -0,0 +1,156 @@
+#include "CascadedShadows.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+    float Dot(const float a[3], const float b[3])
+    {
+        return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+    }
+
+    void Cross(const float a[3], const float b[3], float result[3])
+    {
+        result[0] = a[1] * b[2] - a[2] * b[1];
+        result[1] = a[2] * b[0] - a[0] * b[2];
+        result[2] = a[0] * b[1] - a[1] * b[0];
+    }
+
+    void Normalize(float v[3])
+    {
+        const float length = std::sqrt(Dot(v, v));
+        for (int i = 0; i < 3; i++)
+        {
+            v[i] /= length;
+        }
+    }
+
+    // Light space axes: right, up and forward (along the light's rays). They
+    // only depend on the light, so they are the same every frame.
+    void LightBasis(const float toLight[3], float right[3], float up[3], float forward[3])
+    {
+        for (int i = 0; i < 3; i++)
+        {
+            forward[i] = -toLight[i];
+        }
+        const float worldUp[3] = { 0.0f, 1.0f, 0.0f };
+        const float worldRight[3] = { 1.0f, 0.0f, 0.0f };
+        Cross(std::fabs(forward[1]) < 0.99f ? worldUp : worldRight, forward, right);
+        Normalize(right);
+        Cross(forward, right, up);
+    }
+}
+
+namespace CascadedShadows
+{
+    void ComputeSplits(float nearZ, float farZ, uint32_t count, float lambda, float* splitFar)
+    {
+        for (uint32_t i = 0; i < count; i++)
+        {
+            const float t = static_cast<float>(i + 1) / static_cast<float>(count);
+            const float logarithmic = nearZ * std::pow(farZ / nearZ, t);
+            const float uniform = nearZ + (farZ - nearZ) * t;
+            splitFar[i] = lambda * logarithmic + (1.0f - lambda) * uniform;
+        }
+        // Exactly farZ, whatever the rounding.
+        if (count > 0)
+        {
+            splitFar[count - 1] = farZ;
+        }
+    }
+
+    ShadowCascade FitCascade(const View& view, float splitNear, float splitFar, const float toLight[3], uint32_t resolution)
+    {
+        ShadowCascade cascade;
+        cascade.splitNear = splitNear;
+        cascade.splitFar = splitFar;
+
+        // Smallest sphere through the slice's corners: its center is on the
+        // view axis, at the depth where the near and far corners are equally
+        // far away, but no further than the far plane.
+        const float tanHalfFovX = view.tanHalfFovY * view.aspect;
+        const float k2 = view.tanHalfFovY * view.tanHalfFovY + tanHalfFovX * tanHalfFovX;
+        const float centerDepth = std::min(0.5f * (splitNear + splitFar) * (1.0f + k2), splitFar);
+        const float farDistance = std::sqrt((splitFar - centerDepth) * (splitFar - centerDepth) + splitFar * splitFar * k2);
+        const float nearDistance = std::sqrt((centerDepth - splitNear) * (centerDepth - splitNear) + splitNear * splitNear * k2);
+        const float radius = std::max(farDistance, nearDistance);
+
+        float center[3];
+        for (int i = 0; i < 3; i++)
+        {
+            center[i] = view.eye[i] + view.forward[i] * centerDepth;
+        }
+
+        // Snap the center across the light's rays to the texel grid, so the
+        // map moves in whole texels.
+        float right[3], up[3], forward[3];
+        LightBasis(toLight, right, up, forward);
+        const float texel = 2.0f * radius / static_cast<float>(resolution);
+        const float x = std::floor(Dot(center, right) / texel) * texel;
+        const float y = std::floor(Dot(center, up) / texel) * texel;
+        const float z = Dot(center, forward);
+
+        for (int i = 0; i < 3; i++)
+        {
+            cascade.center[i] = right[i] * x + up[i] * y + forward[i] * z;
+        }
+        cascade.radius = radius;
+
+        // Orthographic projection of the sphere's bounding box in light space:
+        // x and y to [-1, 1], and depth from z - radius (0) to z + radius (1).
+        float (&m)[4][4] = cascade.viewProjection;
+        std::memset(m, 0, sizeof(m));
+        for (int i = 0; i < 3; i++)
+        {
+            m[i][0] = right[i] / radius;
+            m[i][1] = up[i] / radius;
+            m[i][2] = forward[i] / (2.0f * radius);
+        }
+        m[3][0] = -x / radius;
+        m[3][1] = -y / radius;
+        m[3][2] = -(z - radius) / (2.0f * radius);
+        m[3][3] = 1.0f;
+
+        cascade.frustum = Frustum::FromViewProjection(m);
+        return cascade;
+    }
+
+    void FitCascades(const View& view, const float toLight[3], uint32_t count, float lambda, uint32_t resolution,
+        ShadowCascade* cascades)
+    {
+        float splits[MaxCascades];
+        count = std::min(count, MaxCascades);
+        ComputeSplits(view.nearZ, view.farZ, count, lambda, splits);
+        for (uint32_t i = 0; i < count; i++)
+        {
+            cascades[i] = FitCascade(view, i == 0 ? view.nearZ : splits[i - 1], splits[i], toLight, resolution);
+        }
+    }
+
+    bool IsCasterVisible(const ShadowCascade& cascade, const float center[3], float radius)
+    {
+        // Planes are left, right, bottom, top, near, far; skip near.
+        for (int plane = 0; plane < 6; plane++)
+        {
+            if (plane == 4)
+            {
+                continue;
+            }
+            const float* p = cascade.frustum.planes[plane];
+            if (Dot(p, center) + p[3] < -radius)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    Frustum CasterFrustum(const ShadowCascade& cascade)
+    {
+        Frustum frustum = cascade.frustum;
+        const float everything[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+        std::memcpy(frustum.planes[4], everything, sizeof(everything));
+        return frustum;
+    }
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+#include "Frustum.h"
+
+// Cascade fitting and shadow caster culling for a directional light. Pure
+// math, so it runs without a GPU; ShadowMap renders the result.
+//
+// Matrices are row-major for row vectors (clip = p * M), as in DirectXMath
+// and Frustum, and project to D3D clip space (0 <= z <= w).
+struct ShadowCascade
+{
+    float viewProjection[4][4];     // World to the cascade's clip space.
+    float splitNear;                // View depth range the cascade covers.
+    float splitFar;
+    float center[3];                // Bounding sphere of the frustum slice, snapped.
+    float radius;
+    Frustum frustum;                // Of viewProjection; see IsCasterVisible.
+};
+
+namespace CascadedShadows
+{
+    const uint32_t MaxCascades = 4;
+
+    // The camera the cascades cover: a symmetric perspective frustum.
+    struct View
+    {
+        float eye[3];
+        float forward[3];           // Unit length.
+        float tanHalfFovY;
+        float aspect;               // Width / height.
+        float nearZ;
+        float farZ;
+    };
+
+    // Far view depth of each of count cascades between nearZ and farZ,
+    // blending logarithmic (lambda = 1) and uniform (lambda = 0) splits.
+    void ComputeSplits(float nearZ, float farZ, uint32_t count, float lambda, float* splitFar);
+
+    // Fits a cascade to the slice of view between splitNear and splitFar, as
+    // seen by a light shining along -toLight (a unit vector pointing at the
+    // light). The cascade covers the slice's bounding sphere, whose size does
+    // not change as the camera turns, and its origin is snapped to whole
+    // texels of a resolution-sized map, so static shadows do not shimmer when
+    // the camera moves.
+    //
+    // Depth covers only the sphere; casters between it and the light must be
+    // rendered with depth clipping off so they clamp to the near plane.
+    ShadowCascade FitCascade(const View& view, float splitNear, float splitFar, const float toLight[3], uint32_t resolution);
+
+    // ComputeSplits and FitCascade for count cascades.
+    void FitCascades(const View& view, const float toLight[3], uint32_t count, float lambda, uint32_t resolution,
+        ShadowCascade* cascades);
+
+    // Whether a sphere can cast a shadow into the cascade: inside its side
+    // and far planes. The near plane is ignored, because casters between the
+    // cascade and the light still shadow it.
+    bool IsCasterVisible(const ShadowCascade& cascade, const float center[3], float radius);
+
+    // The cascade's frustum with the near plane replaced by one that
+    // everything is inside, for culling casters alongside other views.
+    Frustum CasterFrustum(const ShadowCascade& cascade);
+}
@@ -0,0 +1,367 @@
+#include "StrictFloat.h"
+#include "ClusteredLighting.h"
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+#if defined(_M_X64) || defined(__x86_64__) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CLUSTERS_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+    float Dot(const float a[3], const float b[3])
+    {
+        return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+    }
+
+    // Distance from value to the range [low, high] along one axis; the SIMD
+    // path computes it with the same operations.
+    float AxisDistance(float low, float high, float value)
+    {
+        return std::max(std::max(low - value, 0.0f), value - high);
+    }
+}
+
+namespace ClusteredLighting
+{
+    void SliceScaleBias(const GridDesc& grid, float& scale, float& bias)
+    {
+        const float logRange = std::log(grid.farZ / grid.nearZ);
+        scale = static_cast<float>(grid.slices) / logRange;
+        bias = -static_cast<float>(grid.slices) * std::log(grid.nearZ) / logRange;
+    }
+}
+
+void LightBinner::SetGrid(const ClusteredLighting::GridDesc& grid)
+{
+    if (grid.tilesX == 0 || grid.tilesY == 0 || grid.slices == 0)
+    {
+        throw std::invalid_argument("LightBinner: the grid needs at least one cluster");
+    }
+    if (!(grid.nearZ > 0.0f) || !(grid.farZ > grid.nearZ))
+    {
+        throw std::invalid_argument("LightBinner: depth range must satisfy 0 < nearZ < farZ");
+    }
+    m_grid = grid;
+
+    const uint32_t tiles = grid.tilesX * grid.tilesY;
+    m_bounds.resize(static_cast<size_t>(tiles) * grid.slices);
+    m_clusters.assign(m_bounds.size(), LightCluster());
+    m_slices.resize(grid.slices);
+
+    const float tanHalfFovX = grid.tanHalfFovY * grid.aspect;
+    for (uint32_t slice = 0; slice < grid.slices; slice++)
+    {
+        const float nearDepth = slice == 0 ? grid.nearZ :
+            grid.nearZ * std::pow(grid.farZ / grid.nearZ, static_cast<float>(slice) / grid.slices);
+        const float farDepth = slice + 1 == grid.slices ? grid.farZ :
+            grid.nearZ * std::pow(grid.farZ / grid.nearZ, static_cast<float>(slice + 1) / grid.slices);
+        for (uint32_t y = 0; y < grid.tilesY; y++)
+        {
+            // Row 0 is the top of the screen.
+            const float bottom = (1.0f - 2.0f * (y + 1) / grid.tilesY) * grid.tanHalfFovY;
+            const float top = (1.0f - 2.0f * y / grid.tilesY) * grid.tanHalfFovY;
+            for (uint32_t x = 0; x < grid.tilesX; x++)
+            {
+                const float left = (2.0f * x / grid.tilesX - 1.0f) * tanHalfFovX;
+                const float right = (2.0f * (x + 1) / grid.tilesX - 1.0f) * tanHalfFovX;
+
+                // The frustum widens with depth, so the box spans the tile's
+                // extent at both ends of the slice.
+                ClusterBounds& bounds = m_bounds[(static_cast<size_t>(slice) * grid.tilesY + y) * grid.tilesX + x];
+                bounds.low[0] = std::min(left * nearDepth, left * farDepth);
+                bounds.high[0] = std::max(right * nearDepth, right * farDepth);
+                bounds.low[1] = std::min(bottom * nearDepth, bottom * farDepth);
+                bounds.high[1] = std::max(top * nearDepth, top * farDepth);
+                bounds.low[2] = nearDepth;
+                bounds.high[2] = farDepth;
+
+                // Grown slightly, so pixels the shader rounds into the
+                // neighbouring cluster are still covered.
+                float radiusSquared = 0.0f;
+                for (int axis = 0; axis < 3; axis++)
+                {
+                    const float margin = 1e-3f * (bounds.high[axis] - bounds.low[axis]);
+                    bounds.low[axis] -= margin;
+                    bounds.high[axis] += margin;
+                    bounds.center[axis] = 0.5f * (bounds.low[axis] + bounds.high[axis]);
+                    const float half = bounds.high[axis] - bounds.center[axis];
+                    radiusSquared += half * half;
+                }
+                bounds.radius = std::sqrt(radiusSquared);
+            }
+        }
+    }
+}
+
+void LightBinner::TransformLights(const float view[4][4], const ClusterLight* lights, uint32_t count)
+{
+    if (m_bounds.empty())
+    {
+        throw std::logic_error("LightBinner: SetGrid must be called before binning");
+    }
+
+    m_viewLights.resize(count);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        const ClusterLight& light = lights[i];
+        ViewLight& viewLight = m_viewLights[i];
+        for (int axis = 0; axis < 3; axis++)
+        {
+            viewLight.center[axis] = light.position[0] * view[0][axis] + light.position[1] * view[1][axis] +
+                light.position[2] * view[2][axis] + view[3][axis];
+            viewLight.direction[axis] = light.direction[0] * view[0][axis] + light.direction[1] * view[1][axis] +
+                light.direction[2] * view[2][axis];
+        }
+        // The camera looks down -z; depth grows the other way.
+        viewLight.center[2] = -viewLight.center[2];
+        viewLight.direction[2] = -viewLight.direction[2];
+        viewLight.range = light.range;
+        viewLight.rangeSquared = light.range * light.range;
+        viewLight.spot = light.spotCosAngle > -1.0f;
+        viewLight.cosAngle = light.spotCosAngle;
+        viewLight.sinAngle = viewLight.spot ? std::sqrt(std::max(1.0f - light.spotCosAngle * light.spotCosAngle, 0.0f)) : 1.0f;
+    }
+}
+
+// Cone against the cluster's bounding sphere: rejects clusters outside the
+// cone's angle, beyond its range or behind its apex.
+bool LightBinner::TouchesCone(const ViewLight& light, const ClusterBounds& bounds)
+{
+    const float toCluster[3] = {
+        bounds.center[0] - light.center[0],
+        bounds.center[1] - light.center[1],
+        bounds.center[2] - light.center[2] };
+    const float lengthSquared = Dot(toCluster, toCluster);
+    const float along = Dot(toCluster, light.direction);
+    const float closest = light.cosAngle * std::sqrt(std::max(lengthSquared - along * along, 0.0f)) - along * light.sinAngle;
+    return !(closest > bounds.radius || along > bounds.radius + light.range || along < -bounds.radius);
+}
+
+void LightBinner::Candidates::Clear()
+{
+    x.clear();
+    y.clear();
+    depth.clear();
+    rangeSquared.clear();
+    lights.clear();
+}
+
+void LightBinner::Candidates::Add(float lightX, float lightY, float lightDepth, float lightRangeSquared, uint32_t light)
+{
+    x.push_back(lightX);
+    y.push_back(lightY);
+    depth.push_back(lightDepth);
+    rangeSquared.push_back(lightRangeSquared);
+    lights.push_back(light);
+}
+
+void LightBinner::Candidates::Pad()
+{
+    // Distances are never negative.
+    while (lights.size() % 4 != 0)
+    {
+        Add(0.0f, 0.0f, 0.0f, -1.0f, ~0u);
+    }
+}
+
+// Hands each light to the slices its depth range overlaps. The slice range
+// is estimated from the log mapping, widened by a slice each way, and then
+// tested exactly.
+void LightBinner::AssignSlices()
+{
+    for (Slice& slice : m_slices)
+    {
+        slice.lights.clear();
+    }
+
+    float scale, bias;
+    ClusteredLighting::SliceScaleBias(m_grid, scale, bias);
+    const uint32_t tiles = m_grid.tilesX * m_grid.tilesY;
+    const int lastSlice = static_cast<int>(m_grid.slices) - 1;
+    auto sliceOf = [&](float depth)
+    {
+        depth = std::min(std::max(depth, m_grid.nearZ), m_grid.farZ);
+        return static_cast<int>(std::floor(std::log(depth) * scale + bias));
+    };
+
+    for (uint32_t i = 0; i < m_viewLights.size(); i++)
+    {
+        const ViewLight& light = m_viewLights[i];
+        const int first = std::max(sliceOf(light.center[2] - light.range) - 1, 0);
+        const int last = std::min(sliceOf(light.center[2] + light.range) + 1, lastSlice);
+        for (int slice = first; slice <= last; slice++)
+        {
+            // Every cluster of a slice has the same depth range.
+            const ClusterBounds& bounds = m_bounds[static_cast<size_t>(slice) * tiles];
+            const float dz = AxisDistance(bounds.low[2], bounds.high[2], light.center[2]);
+            if (dz * dz <= light.rangeSquared)
+            {
+                m_slices[slice].lights.push_back(i);
+            }
+        }
+    }
+}
+
+// Narrows the slice's lights down to each row of tiles, then tests each
+// tile against four lights at a time. The narrowing is conservative: the
+// full distance adds non-negative terms to the rounded partial sums the
+// filters compare, and float addition is monotonic. StrictFloat.h keeps
+// every product rounded on its own, as in the SIMD lanes.
+void LightBinner::BinSlice(uint32_t sliceIndex)
+{
+    Slice& slice = m_slices[sliceIndex];
+    const uint32_t tiles = m_grid.tilesX * m_grid.tilesY;
+    const ClusterBounds* bounds = &m_bounds[static_cast<size_t>(sliceIndex) * tiles];
+
+    // Every cluster of a row has the same height range too. The rows a
+    // sphere touches are consecutive, so the scan stops after the last one.
+    slice.rows.resize(m_grid.tilesY);
+    for (Candidates& row : slice.rows)
+    {
+        row.Clear();
+    }
+    for (uint32_t light : slice.lights)
+    {
+        const ViewLight& viewLight = m_viewLights[light];
+        bool touched = false;
+        for (uint32_t y = 0; y < m_grid.tilesY; y++)
+        {
+            const ClusterBounds& rowBounds = bounds[y * m_grid.tilesX];
+            const float dy = AxisDistance(rowBounds.low[1], rowBounds.high[1], viewLight.center[1]);
+            const float dz = AxisDistance(rowBounds.low[2], rowBounds.high[2], viewLight.center[2]);
+            const float distance = dy * dy + dz * dz;
+            if (distance <= viewLight.rangeSquared)
+            {
+                slice.rows[y].Add(viewLight.center[0], viewLight.center[1], viewLight.center[2], viewLight.rangeSquared, light);
+                touched = true;
+            }
+            else if (touched)
+            {
+                break;
+            }
+        }
+    }
+
+    // Hits are written without branching: every candidate is stored and
+    // the cursor only advances past the ones that touch the tile, so the
+    // buffer needs room for a whole row of candidates past the cursor.
+    uint32_t used = 0;
+    for (uint32_t y = 0; y < m_grid.tilesY; y++)
+    {
+        Candidates& row = slice.rows[y];
+        row.Pad();
+        for (uint32_t x = 0; x < m_grid.tilesX; x++)
+        {
+            if (slice.indices.size() < used + row.lights.size())
+            {
+                slice.indices.resize(2 * (used + row.lights.size()));
+            }
+            uint32_t* out = slice.indices.data();
+
+            const uint32_t tile = y * m_grid.tilesX + x;
+            const ClusterBounds& cluster = bounds[tile];
+            const uint32_t offset = used;
+            for (size_t first = 0; first < row.lights.size(); first += 4)
+            {
+#if defined(CLUSTERS_SSE2)
+                const __m128 zero = _mm_setzero_ps();
+                const __m128 lightX = _mm_loadu_ps(&row.x[first]);
+                const __m128 lightY = _mm_loadu_ps(&row.y[first]);
+                const __m128 lightDepth = _mm_loadu_ps(&row.depth[first]);
+                const __m128 dx = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_set1_ps(cluster.low[0]), lightX), zero), _mm_sub_ps(lightX, _mm_set1_ps(cluster.high[0])));
+                const __m128 dy = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_set1_ps(cluster.low[1]), lightY), zero), _mm_sub_ps(lightY, _mm_set1_ps(cluster.high[1])));
+                const __m128 dz = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_set1_ps(cluster.low[2]), lightDepth), zero), _mm_sub_ps(lightDepth, _mm_set1_ps(cluster.high[2])));
+                const __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+                const int mask = _mm_movemask_ps(_mm_cmple_ps(distance, _mm_loadu_ps(&row.rangeSquared[first])));
+#else
+                int mask = 0;
+                for (int lane = 0; lane < 4; lane++)
+                {
+                    const float dx = AxisDistance(cluster.low[0], cluster.high[0], row.x[first + lane]);
+                    const float dy = AxisDistance(cluster.low[1], cluster.high[1], row.y[first + lane]);
+                    const float dz = AxisDistance(cluster.low[2], cluster.high[2], row.depth[first + lane]);
+                    const float distance = dx * dx + dy * dy + dz * dz;
+                    mask |= distance <= row.rangeSquared[first + lane] ? 1 << lane : 0;
+                }
+#endif
+                for (int lane = 0; lane < 4; lane++)
+                {
+                    out[used] = row.lights[first + lane];
+                    used += (mask >> lane) & 1;
+                }
+            }
+
+            // Spot lights that touch the box may still miss it with their cone.
+            uint32_t kept = offset;
+            for (uint32_t i = offset; i < used; i++)
+            {
+                const ViewLight& light = m_viewLights[out[i]];
+                if (!light.spot || TouchesCone(light, cluster))
+                {
+                    out[kept++] = out[i];
+                }
+            }
+            used = kept;
+
+            // Relative to the slice until the slices are joined.
+            LightCluster& result = m_clusters[static_cast<size_t>(sliceIndex) * tiles + tile];
+            result.offset = offset;
+            result.count = used - offset;
+        }
+    }
+    slice.indexCount = used;
+}
+
+void LightBinner::Bin(const float view[4][4], const ClusterLight* lights, uint32_t count, JobSystem* jobs)
+{
+    TransformLights(view, lights, count);
+    AssignSlices();
+
+    // Slices own their clusters, so they bin independently.
+    if (jobs)
+    {
+        jobs->ParallelFor(m_grid.slices, 1, [this](size_t begin, size_t end)
+        {
+            for (size_t slice = begin; slice < end; slice++)
+            {
+                BinSlice(static_cast<uint32_t>(slice));
+            }
+        });
+    }
+    else
+    {
+        for (uint32_t slice = 0; slice < m_grid.slices; slice++)
+        {
+            BinSlice(slice);
+        }
+    }
+
+    size_t total = 0;
+    for (const Slice& slice : m_slices)
+    {
+        total += slice.indexCount;
+    }
+    m_indices.resize(total);
+
+    const uint32_t tiles = m_grid.tilesX * m_grid.tilesY;
+    uint32_t base = 0;
+    for (uint32_t sliceIndex = 0; sliceIndex < m_grid.slices; sliceIndex++)
+    {
+        const Slice& slice = m_slices[sliceIndex];
+        if (slice.indexCount > 0)
+        {
+            std::memcpy(&m_indices[base], slice.indices.data(), slice.indexCount * sizeof(uint32_t));
+        }
+        for (uint32_t tile = 0; tile < tiles; tile++)
+        {
+            m_clusters[static_cast<size_t>(sliceIndex) * tiles + tile].offset += base;
+        }
+        base += slice.indexCount;
+    }
+}
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+class JobSystem;
+
+// Clustered forward lighting: the view frustum is cut into a grid of
+// clusters (screen tiles times exponentially spaced depth slices), lights
+// are binned into the clusters they touch every frame, and the pixel shader
+// only shades with the lights of its own cluster. The structures match
+// shaders.hlsl.
+
+// One light, in world space.
+struct ClusterLight
+{
+    float position[3];
+    float range;                // Distance at which the light's influence ends.
+    float color[3];
+    float spotCosAngle;         // Cosine of a spot light's half angle (below 90 degrees), or PointLight.
+    float direction[3];         // Spot lights: unit axis of the cone.
+    float padding;
+};
+static_assert(sizeof(ClusterLight) == 48, "ClusterLight must match shaders.hlsl");
+
+// The lights of one cluster: count entries of the light index list from offset.
+struct LightCluster
+{
+    uint32_t offset;
+    uint32_t count;
+};
+static_assert(sizeof(LightCluster) == 8, "LightCluster must match shaders.hlsl");
+
+namespace ClusteredLighting
+{
+    const float PointLight = -2.0f;
+
+    // tilesX by tilesY screen tiles (row 0 at the top of the screen) and
+    // slices depth slices between nearZ and farZ, of a symmetric perspective
+    // projection. Cluster (x, y, slice) is index (slice * tilesY + y) * tilesX + x.
+    struct GridDesc
+    {
+        uint32_t tilesX = 16;
+        uint32_t tilesY = 9;
+        uint32_t slices = 24;
+        float tanHalfFovY = 0.57735027f;
+        float aspect = 16.0f / 9.0f;
+        float nearZ = 0.1f;
+        float farZ = 100.0f;
+    };
+
+    // A view depth's slice is floor(log(depth) * scale + bias), as the shader
+    // computes it.
+    void SliceScaleBias(const GridDesc& grid, float& scale, float& bias);
+}
+
+// Bins lights into the clusters of a grid. Bin tests each slice's clusters
+// against four lights at a time with SIMD, with the slices spread over a
+// JobSystem. Tests/ClusteredLightingFixtures has a brute force reference it
+// matches exactly.
+class LightBinner
+{
+public:
+    // Precomputes the clusters' bounds; call again when the projection changes.
+    void SetGrid(const ClusteredLighting::GridDesc& grid);
+    const ClusteredLighting::GridDesc& Grid() const { return m_grid; }
+    uint32_t ClusterCount() const { return static_cast<uint32_t>(m_clusters.size()); }
+
+    // view is the world to view transform for row vectors (p * view) of a
+    // right-handed camera looking down -z, as XMMatrixLookToRH builds it.
+    // Each cluster lists its lights in ascending order. Without jobs, Bin
+    // runs on the calling thread.
+    void Bin(const float view[4][4], const ClusterLight* lights, uint32_t count, JobSystem* jobs);
+
+    const std::vector<LightCluster>& Clusters() const { return m_clusters; }
+    const std::vector<uint32_t>& LightIndices() const { return m_indices; }
+
+private:
+    // A light in view space, with depth (-z) as the third coordinate.
+    struct ViewLight
+    {
+        float center[3];
+        float range;
+        float rangeSquared;
+        float direction[3];
+        float cosAngle;
+        float sinAngle;
+        bool spot;
+    };
+
+    // View space bounds of a cluster, with depth as the third coordinate,
+    // and the sphere around them for the spot light test.
+    struct ClusterBounds
+    {
+        float low[3];
+        float high[3];
+        float center[3];
+        float radius;
+    };
+
+    // Lights that may touch a group of clusters, laid out for SIMD and
+    // padded to a multiple of 4 with entries that touch nothing.
+    struct Candidates
+    {
+        std::vector<float> x, y, depth, rangeSquared;
+        std::vector<uint32_t> lights;
+
+        void Clear();
+        void Add(float lightX, float lightY, float lightDepth, float lightRangeSquared, uint32_t light);
+        void Pad();
+    };
+
+    // Per slice working space, kept between frames.
+    struct Slice
+    {
+        std::vector<uint32_t> lights;           // Lights within range of the slice.
+        std::vector<Candidates> rows;           // Of those, the ones within range of each row of tiles.
+        std::vector<uint32_t> indices;          // The slice's part of the light index list...
+        uint32_t indexCount = 0;                // ...which is this long.
+    };
+
+    void TransformLights(const float view[4][4], const ClusterLight* lights, uint32_t count);
+    void AssignSlices();
+    void BinSlice(uint32_t slice);
+    static bool TouchesCone(const ViewLight& light, const ClusterBounds& bounds);
+
+    ClusteredLighting::GridDesc m_grid;
+    std::vector<ClusterBounds> m_bounds;
+    std::vector<ViewLight> m_viewLights;
+    std::vector<Slice> m_slices;
+    std::vector<LightCluster> m_clusters;
+    std::vector<uint32_t> m_indices;
+};
@@ -0,0 +1,121 @@
+// Offline cooker for the supercompressed texture container (.stc). Decodes
+// any image WIC can read, converts it to RGBA8 and writes it BC compressed
+// and entropy coded, ready for BasicGameEngine::loadSupercompressedTexture.
+//
+//   TextureCooker <input image> <output.stc> [--bc1 | --bc3] [--linear] [--no-mips]
+//
+// BC1 is the default; --bc3 keeps alpha. Colour is treated as sRGB unless
+// --linear is given.
+
+#include <windows.h>
+#include <wincodec.h>
+#include <wrl/client.h>
+
+#include <cstdio>
+#include <cwchar>
+#include <vector>
+
+#include "SupercompressedTexture.h"
+
+using Microsoft::WRL::ComPtr;
+
+namespace
+{
+    bool LoadRgba8(const wchar_t* path, std::vector<uint8_t>& pixels, UINT& width, UINT& height)
+    {
+        ComPtr<IWICImagingFactory> factory;
+        ComPtr<IWICBitmapDecoder> decoder;
+        ComPtr<IWICBitmapFrameDecode> frame;
+        ComPtr<IWICFormatConverter> converter;
+        if (FAILED(CoCreateInstance(CLSID_WICImagingFactory, nullptr, CLSCTX_INPROC_SERVER, IID_PPV_ARGS(&factory)))
+            || FAILED(factory->CreateDecoderFromFilename(path, nullptr, GENERIC_READ, WICDecodeMetadataCacheOnDemand, &decoder))
+            || FAILED(decoder->GetFrame(0, &frame))
+            || FAILED(factory->CreateFormatConverter(&converter))
+            || FAILED(converter->Initialize(frame.Get(), GUID_WICPixelFormat32bppRGBA, WICBitmapDitherTypeNone, nullptr, 0.0,
+                WICBitmapPaletteTypeCustom))
+            || FAILED(converter->GetSize(&width, &height)))
+        {
+            return false;
+        }
+
+        pixels.resize(size_t(width) * height * 4);
+        return SUCCEEDED(converter->CopyPixels(nullptr, width * 4, static_cast<UINT>(pixels.size()), pixels.data()));
+    }
+
+    bool SaveFile(const wchar_t* path, const std::vector<uint8_t>& data)
+    {
+        FILE* file = nullptr;
+        if (_wfopen_s(&file, path, L"wb") != 0 || !file)
+        {
+            return false;
+        }
+        const bool written = fwrite(data.data(), 1, data.size(), file) == data.size();
+        return fclose(file) == 0 && written;
+    }
+}
+
+int wmain(int argc, wchar_t** argv)
+{
+    if (argc < 3)
+    {
+        fwprintf(stderr, L"usage: TextureCooker <input image> <output.stc> [--bc1 | --bc3] [--linear] [--no-mips]\n");
+        return 2;
+    }
+
+    SupercompressedTexture::BlockFormat format = SupercompressedTexture::BlockFormat::BC1;
+    bool srgb = true;
+    bool generateMips = true;
+    for (int i = 3; i < argc; i++)
+    {
+        if (wcscmp(argv[i], L"--bc1") == 0)
+            format = SupercompressedTexture::BlockFormat::BC1;
+        else if (wcscmp(argv[i], L"--bc3") == 0)
+            format = SupercompressedTexture::BlockFormat::BC3;
+        else if (wcscmp(argv[i], L"--linear") == 0)
+            srgb = false;
+        else if (wcscmp(argv[i], L"--no-mips") == 0)
+            generateMips = false;
+        else
+        {
+            fwprintf(stderr, L"unknown option %ls\n", argv[i]);
+            return 2;
+        }
+    }
+
+    if (FAILED(CoInitializeEx(nullptr, COINIT_MULTITHREADED)))
+    {
+        fwprintf(stderr, L"COM initialization failed\n");
+        return 1;
+    }
+
+    int result = 1;
+    std::vector<uint8_t> pixels;
+    UINT width = 0, height = 0;
+    std::vector<uint8_t> file;
+    if (!LoadRgba8(argv[1], pixels, width, height))
+    {
+        fwprintf(stderr, L"%ls: cannot decode image\n", argv[1]);
+    }
+    else
+    {
+        const ImageResampler::ImageView image = { pixels.data(), width, height, size_t(width) * 4,
+            ImageResampler::PixelLayout::RGBA8, srgb };
+        if (!SupercompressedTexture::Encode(image, format, generateMips, file))
+        {
+            fwprintf(stderr, L"%ls: encoding failed\n", argv[1]);
+        }
+        else if (!SaveFile(argv[2], file))
+        {
+            fwprintf(stderr, L"%ls: cannot write\n", argv[2]);
+        }
+        else
+        {
+            wprintf(L"%ls: %ux%u, %zu bytes (%.1f%% of RGBA8)\n", argv[2], width, height, file.size(),
+                100.0 * file.size() / pixels.size());
+            result = 0;
+        }
+    }
+
+    CoUninitialize();
+    return result;
+}
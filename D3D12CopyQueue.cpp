@@ -0,0 +1,109 @@
+#include "stdafx.h"
+#include "D3D12CopyQueue.h"
+
+D3D12CopyQueue::~D3D12CopyQueue()
+{
+    if (m_staging && m_stagingData)
+    {
+        m_staging->Unmap(0, nullptr);
+    }
+}
+
+void D3D12CopyQueue::Initialize(ID3D12Device* device, UINT64 stagingCapacity)
+{
+    m_device = device;
+
+    D3D12_COMMAND_QUEUE_DESC queueDesc = {};
+    queueDesc.Flags = D3D12_COMMAND_QUEUE_FLAG_NONE;
+    queueDesc.Type = D3D12_COMMAND_LIST_TYPE_COPY;
+    ThrowIfFailed(device->CreateCommandQueue(&queueDesc, IID_PPV_ARGS(&m_queue)));
+    m_fenceQueue.Initialize(device, m_queue.Get());
+
+    ThrowIfFailed(device->CreateCommittedResource(
+        &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
+        D3D12_HEAP_FLAG_NONE,
+        &CD3DX12_RESOURCE_DESC::Buffer(stagingCapacity),
+        D3D12_RESOURCE_STATE_GENERIC_READ,
+        nullptr,
+        IID_PPV_ARGS(&m_staging)));
+
+    CD3DX12_RANGE readRange(0, 0);        // We do not intend to read from this resource on the CPU.
+    ThrowIfFailed(m_staging->Map(0, &readRange, reinterpret_cast<void**>(&m_stagingData)));
+}
+
+uint32_t D3D12CopyQueue::AddDestination(ID3D12Resource* buffer)
+{
+    m_destinations.push_back(buffer);
+    return static_cast<uint32_t>(m_destinations.size() - 1);
+}
+
+void D3D12CopyQueue::GpuWait(ID3D12CommandQueue* queue, uint64_t value)
+{
+    ThrowIfFailed(queue->Wait(m_fenceQueue.Fence(), value));
+}
+
+void D3D12CopyQueue::WriteStaging(uint64_t stagingOffset, const void* data, uint64_t size)
+{
+    memcpy(m_stagingData + stagingOffset, data, static_cast<size_t>(size));
+}
+
+void D3D12CopyQueue::CopyToBuffer(uint32_t destination, uint64_t destinationOffset, uint64_t stagingOffset, uint64_t size)
+{
+    if (!m_recording)
+    {
+        BeginRecording();
+    }
+    m_commandList->CopyBufferRegion(m_destinations[destination], destinationOffset, m_staging.Get(), stagingOffset, size);
+}
+
+void D3D12CopyQueue::Execute()
+{
+    if (!m_recording)
+    {
+        return;
+    }
+
+    ThrowIfFailed(m_commandList->Close());
+    ID3D12CommandList* ppCommandLists[] = { m_commandList.Get() };
+    m_queue->ExecuteCommandLists(_countof(ppCommandLists), ppCommandLists);
+
+    m_executedAllocator = m_recordingAllocator;
+    m_recordingAllocator.Reset();
+    m_recording = false;
+}
+
+void D3D12CopyQueue::Signal(uint64_t value)
+{
+    m_fenceQueue.Signal(value);
+
+    // The allocator of the batch just submitted can be reused once value completes.
+    if (m_executedAllocator)
+    {
+        m_allocators.push_back({ value, m_executedAllocator });
+        m_executedAllocator.Reset();
+    }
+}
+
+void D3D12CopyQueue::BeginRecording()
+{
+    if (!m_allocators.empty() && m_allocators.front().fenceValue <= m_fenceQueue.CompletedValue())
+    {
+        m_recordingAllocator = m_allocators.front().allocator;
+        m_allocators.pop_front();
+        ThrowIfFailed(m_recordingAllocator->Reset());
+    }
+    else
+    {
+        ThrowIfFailed(m_device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_COPY, IID_PPV_ARGS(&m_recordingAllocator)));
+    }
+
+    if (m_commandList)
+    {
+        ThrowIfFailed(m_commandList->Reset(m_recordingAllocator.Get(), nullptr));
+    }
+    else
+    {
+        ThrowIfFailed(m_device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_COPY, m_recordingAllocator.Get(), nullptr, IID_PPV_ARGS(&m_commandList)));
+    }
+    m_recording = true;
+}
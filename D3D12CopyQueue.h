@@ -0,0 +1,59 @@
+#pragma once
+#include "stdafx.h"
+#include "DXSampleHelper.h"
+#include "D3D12FenceQueue.h"
+#include "GeometryUploader.h"
+#include <deque>
+#include <vector>
+
+// ICopyQueue on a dedicated D3D12_COMMAND_LIST_TYPE_COPY queue, with a
+// persistently mapped UPLOAD buffer as the staging area. Destination buffers
+// are registered up front and referred to by index. They should be created in
+// D3D12_RESOURCE_STATE_COMMON: buffers are implicitly promoted to COPY_DEST on
+// the copy queue and decay back to COMMON once the copy completes, so the
+// direct queue can read them without any barriers.
+class D3D12CopyQueue : public ICopyQueue
+{
+public:
+    D3D12CopyQueue() = default;
+    D3D12CopyQueue(const D3D12CopyQueue& rhs) = delete;
+    D3D12CopyQueue& operator=(const D3D12CopyQueue& rhs) = delete;
+    ~D3D12CopyQueue();
+
+    void Initialize(ID3D12Device* device, UINT64 stagingCapacity);
+
+    uint32_t AddDestination(ID3D12Resource* buffer);
+
+    // Makes another queue wait on the GPU until the copy fence reaches value.
+    void GpuWait(ID3D12CommandQueue* queue, uint64_t value);
+
+    virtual void WriteStaging(uint64_t stagingOffset, const void* data, uint64_t size);
+    virtual void CopyToBuffer(uint32_t destination, uint64_t destinationOffset, uint64_t stagingOffset, uint64_t size);
+    virtual void Execute();
+
+    virtual void Signal(uint64_t value);
+    virtual uint64_t CompletedValue() { return m_fenceQueue.CompletedValue(); }
+    virtual void WaitForValue(uint64_t value) { m_fenceQueue.WaitForValue(value); }
+
+private:
+    struct PendingAllocator
+    {
+        uint64_t fenceValue;
+        ComPtr<ID3D12CommandAllocator> allocator;
+    };
+
+    void BeginRecording();
+
+    ID3D12Device* m_device = nullptr;
+    ComPtr<ID3D12CommandQueue> m_queue;
+    D3D12FenceQueue m_fenceQueue;
+    ComPtr<ID3D12GraphicsCommandList> m_commandList;
+    ComPtr<ID3D12CommandAllocator> m_recordingAllocator;    // Allocator of the open list.
+    ComPtr<ID3D12CommandAllocator> m_executedAllocator;     // Submitted, waiting for its Signal.
+    std::deque<PendingAllocator> m_allocators;              // Oldest fence first.
+    bool m_recording = false;
+
+    ComPtr<ID3D12Resource> m_staging;
+    UINT8* m_stagingData = nullptr;
+    std::vector<ID3D12Resource*> m_destinations;
+};
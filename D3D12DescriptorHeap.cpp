@@ -0,0 +1,63 @@
+#include "stdafx.h"
+#include "D3D12DescriptorHeap.h"
+
+void D3D12DescriptorHeap::Initialize(ID3D12Device* device, UINT persistentCount, UINT transientPerFrame, UINT framesInFlight)
+{
+    m_device = device;
+    m_allocator.reset(new DescriptorAllocator(persistentCount, transientPerFrame, framesInFlight));
+
+    D3D12_DESCRIPTOR_HEAP_DESC heapDesc = {};
+    heapDesc.NumDescriptors = m_allocator->Capacity();
+    heapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
+    heapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
+    ThrowIfFailed(device->CreateDescriptorHeap(&heapDesc, IID_PPV_ARGS(&m_heap)));
+    m_descriptorSize = device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+}
+
+CD3DX12_CPU_DESCRIPTOR_HANDLE D3D12DescriptorHeap::CpuHandle(UINT slot) const
+{
+    return CD3DX12_CPU_DESCRIPTOR_HANDLE(m_heap->GetCPUDescriptorHandleForHeapStart(), slot, m_descriptorSize);
+}
+
+CD3DX12_GPU_DESCRIPTOR_HANDLE D3D12DescriptorHeap::GpuHandle(UINT slot) const
+{
+    return CD3DX12_GPU_DESCRIPTOR_HANDLE(m_heap->GetGPUDescriptorHandleForHeapStart(), slot, m_descriptorSize);
+}
+
+UINT D3D12DescriptorHeap::CreateShaderResourceView(ID3D12Resource* resource, const D3D12_SHADER_RESOURCE_VIEW_DESC* desc)
+{
+    const UINT slot = m_allocator->Allocate();
+    if (slot == DescriptorAllocator::InvalidSlot)
+    {
+        ThrowIfFailed(E_OUTOFMEMORY);
+    }
+    m_device->CreateShaderResourceView(resource, desc, CpuHandle(slot));
+    return slot;
+}
+
+void D3D12DescriptorHeap::Free(UINT slot)
+{
+    m_allocator->Free(slot, m_currentFence.load());
+}
+
+void D3D12DescriptorHeap::Free(UINT slot, UINT64 fenceValue)
+{
+    m_allocator->Free(slot, fenceValue);
+}
+
+void D3D12DescriptorHeap::BeginFrame(UINT frameSlot, UINT64 currentFence, UINT64 completedFence)
+{
+    m_currentFence.store(currentFence);
+    m_allocator->Retire(completedFence);
+    m_allocator->BeginFrame(frameSlot);
+}
+
+UINT D3D12DescriptorHeap::AllocateTransient(UINT count)
+{
+    const UINT slot = m_allocator->AllocateTransient(count);
+    if (slot == DescriptorAllocator::InvalidSlot)
+    {
+        ThrowIfFailed(E_OUTOFMEMORY);
+    }
+    return slot;
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include "stdafx.h"
+#include "DXSampleHelper.h"
+#include "DescriptorAllocator.h"
+
+// The engine's single shader-visible CBV/SRV/UAV heap, laid out for bindless
+// access: the root signature maps the whole heap as one unbounded SRV range,
+// and draws pass slot numbers as root constants instead of switching tables.
+// Slot management is DescriptorAllocator's. The unbounded range needs
+// resource binding tier 2 or later.
+class D3D12DescriptorHeap
+{
+public:
+    D3D12DescriptorHeap() = default;
+    D3D12DescriptorHeap(const D3D12DescriptorHeap& rhs) = delete;
+    D3D12DescriptorHeap& operator=(const D3D12DescriptorHeap& rhs) = delete;
+
+    void Initialize(ID3D12Device* device, UINT persistentCount, UINT transientPerFrame, UINT framesInFlight);
+
+    ID3D12DescriptorHeap* Heap() const { return m_heap.Get(); }
+    UINT Capacity() const { return m_allocator->Capacity(); }
+    const DescriptorAllocator& Allocator() const { return *m_allocator; }
+
+    CD3DX12_CPU_DESCRIPTOR_HANDLE CpuHandle(UINT slot) const;
+    CD3DX12_GPU_DESCRIPTOR_HANDLE GpuHandle(UINT slot) const;
+
+    // Persistent slots. Safe to call from any thread; throws E_OUTOFMEMORY when
+    // the heap is full.
+    UINT CreateShaderResourceView(ID3D12Resource* resource, const D3D12_SHADER_RESOURCE_VIEW_DESC* desc);
+    // The slot is reused once the frame being recorded has finished on the GPU.
+    void Free(UINT slot);
+    // The slot is reused once fenceValue has completed.
+    void Free(UINT slot, UINT64 fenceValue);
+
+    // Retires freed slots and starts the transient region of frameSlot.
+    // currentFence is the value signaled at the end of the frame being recorded.
+    void BeginFrame(UINT frameSlot, UINT64 currentFence, UINT64 completedFence);
+    // Descriptors that only live for the current frame; throws E_OUTOFMEMORY
+    // when the frame's region is full.
+    UINT AllocateTransient(UINT count = 1);
+
+private:
+    ID3D12Device* m_device = nullptr;
+    ComPtr<ID3D12DescriptorHeap> m_heap;
+    UINT m_descriptorSize = 0;
+    std::unique_ptr<DescriptorAllocator> m_allocator;
+    std::atomic<UINT64> m_currentFence{ 0 };
+};
@@ -0,0 +1,42 @@
+#include "stdafx.h"
+#include "D3D12FenceQueue.h"
+
+D3D12FenceQueue::~D3D12FenceQueue()
+{
+    if (m_fenceEvent)
+    {
+        CloseHandle(m_fenceEvent);
+    }
+}
+
+void D3D12FenceQueue::Initialize(ID3D12Device* device, ID3D12CommandQueue* queue)
+{
+    m_queue = queue;
+    ThrowIfFailed(device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&m_fence)));
+
+    // Create an event handle to use for frame synchronization.
+    m_fenceEvent = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+    if (m_fenceEvent == nullptr)
+    {
+        ThrowIfFailed(HRESULT_FROM_WIN32(GetLastError()));
+    }
+}
+
+void D3D12FenceQueue::Signal(uint64_t value)
+{
+    ThrowIfFailed(m_queue->Signal(m_fence.Get(), value));
+}
+
+uint64_t D3D12FenceQueue::CompletedValue()
+{
+    return m_fence->GetCompletedValue();
+}
+
+void D3D12FenceQueue::WaitForValue(uint64_t value)
+{
+    if (m_fence->GetCompletedValue() < value)
+    {
+        ThrowIfFailed(m_fence->SetEventOnCompletion(value, m_fenceEvent));
+        WaitForSingleObjectEx(m_fenceEvent, INFINITE, FALSE);
+    }
+}
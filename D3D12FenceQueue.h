@@ -0,0 +1,28 @@
+#pragma once
+#include "stdafx.h"
+#include "DXSampleHelper.h"
+#include "FramePacer.h"
+
+// IFenceQueue over an ID3D12CommandQueue and its ID3D12Fence.
+class D3D12FenceQueue : public IFenceQueue
+{
+public:
+    D3D12FenceQueue() = default;
+    D3D12FenceQueue(const D3D12FenceQueue& rhs) = delete;
+    D3D12FenceQueue& operator=(const D3D12FenceQueue& rhs) = delete;
+    ~D3D12FenceQueue();
+
+    void Initialize(ID3D12Device* device, ID3D12CommandQueue* queue);
+
+    ID3D12Fence* Fence() const { return m_fence.Get(); }
+    ID3D12CommandQueue* Queue() const { return m_queue; }
+
+    virtual void Signal(uint64_t value);
+    virtual uint64_t CompletedValue();
+    virtual void WaitForValue(uint64_t value);
+
+private:
+    ID3D12CommandQueue* m_queue = nullptr;
+    ComPtr<ID3D12Fence> m_fence;
+    HANDLE m_fenceEvent = nullptr;
+};
@@ -0,0 +1,155 @@
+#include "stdafx.h"
+#include "D3D12FrameGraphResources.h"
+
+void D3D12FrameGraphResources::Initialize(ID3D12Device* device)
+{
+    m_device = device;
+}
+
+D3D12_RESOURCE_DESC D3D12FrameGraphResources::ResourceDesc(const FrameGraphTextureDesc& desc, ResourceStates usage)
+{
+    D3D12_RESOURCE_FLAGS flags = D3D12_RESOURCE_FLAG_NONE;
+    if (usage & ResourceState::RenderTarget)
+    {
+        flags |= D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET;
+    }
+    if (usage & (ResourceState::DepthWrite | ResourceState::DepthRead))
+    {
+        flags |= D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL;
+        if (!(usage & (ResourceState::PixelShaderResource | ResourceState::NonPixelShaderResource)))
+        {
+            flags |= D3D12_RESOURCE_FLAG_DENY_SHADER_RESOURCE;
+        }
+    }
+    if (usage & ResourceState::UnorderedAccess)
+    {
+        flags |= D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS;
+    }
+
+    return CD3DX12_RESOURCE_DESC::Tex2D(static_cast<DXGI_FORMAT>(desc.format), desc.width, desc.height,
+        static_cast<UINT16>(desc.arraySize), 1, 1, 0, flags);
+}
+
+FrameGraph::MemoryQuery D3D12FrameGraphResources::SizeQuery() const
+{
+    ID3D12Device* device = m_device;
+    return [device](const FrameGraphTextureDesc& desc, ResourceStates usage)
+    {
+        const D3D12_RESOURCE_DESC resourceDesc = ResourceDesc(desc, usage);
+        const D3D12_RESOURCE_ALLOCATION_INFO info = device->GetResourceAllocationInfo(0, 1, &resourceDesc);
+        FrameGraphMemoryInfo memory = { info.SizeInBytes, info.Alignment };
+        return memory;
+    };
+}
+
+bool D3D12FrameGraphResources::SamePlacement(const Placement& a, const Placement& b)
+{
+    if (a.transient != b.transient)
+    {
+        return false;
+    }
+    if (!a.transient)
+    {
+        return true;
+    }
+    return a.desc.width == b.desc.width && a.desc.height == b.desc.height && a.desc.arraySize == b.desc.arraySize &&
+        a.desc.format == b.desc.format && memcmp(a.desc.clearColor, b.desc.clearColor, sizeof(a.desc.clearColor)) == 0 &&
+        a.desc.clearDepth == b.desc.clearDepth && a.usage == b.usage && a.restState == b.restState && a.offset == b.offset;
+}
+
+bool D3D12FrameGraphResources::Realize(const FrameGraph& graph, uint64_t currentFence, uint64_t completedFence)
+{
+    while (!m_retired.empty() && m_retired.front().fence <= completedFence)
+    {
+        m_retired.pop_front();
+    }
+
+    const uint32_t count = graph.ResourceCount();
+    std::vector<Placement> placements(count);
+    for (FrameGraphResource r = 0; r < count; r++)
+    {
+        const FrameGraph::ResourceInfo& info = graph.Resource(r);
+        Placement& placement = placements[r];
+        placement.transient = info.used && !info.imported;
+        placement.desc = info.desc;
+        placement.usage = info.usage;
+        placement.restState = info.restState;
+        placement.offset = info.heapOffset;
+    }
+
+    m_resources.assign(count, nullptr);
+    bool unchanged = placements.size() == m_placements.size() && (!m_heap || m_heap->GetDesc().SizeInBytes >= graph.HeapSize());
+    for (FrameGraphResource r = 0; unchanged && r < count; r++)
+    {
+        unchanged = SamePlacement(placements[r], m_placements[r]);
+    }
+    if (unchanged)
+    {
+        for (FrameGraphResource r = 0; r < count; r++)
+        {
+            m_resources[r] = m_placed[r].Get();
+        }
+        return false;
+    }
+
+    // The GPU may still be using the old layout for the frames in flight.
+    Retired retired;
+    retired.fence = currentFence;
+    retired.heap = m_heap;
+    retired.resources.swap(m_placed);
+    m_retired.push_back(retired);
+    m_heap.Reset();
+
+    if (graph.HeapSize() > 0)
+    {
+        D3D12_HEAP_DESC heapDesc = {};
+        heapDesc.SizeInBytes = graph.HeapSize();
+        heapDesc.Properties = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT);
+        heapDesc.Alignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+        heapDesc.Flags = D3D12_HEAP_FLAG_ALLOW_ONLY_RT_DS_TEXTURES;
+        ThrowIfFailed(m_device->CreateHeap(&heapDesc, IID_PPV_ARGS(&m_heap)));
+    }
+
+    m_placed.assign(count, nullptr);
+    for (FrameGraphResource r = 0; r < count; r++)
+    {
+        const Placement& placement = placements[r];
+        if (!placement.transient)
+        {
+            continue;
+        }
+
+        const D3D12_RESOURCE_DESC desc = ResourceDesc(placement.desc, placement.usage);
+        D3D12_CLEAR_VALUE clearValue = {};
+        clearValue.Format = desc.Format;
+        if (desc.Flags & D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL)
+        {
+            clearValue.DepthStencil.Depth = placement.desc.clearDepth;
+        }
+        else if (desc.Flags & D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET)
+        {
+            memcpy(clearValue.Color, placement.desc.clearColor, sizeof(clearValue.Color));
+        }
+        else
+        {
+            ThrowIfFailed(E_INVALIDARG);
+        }
+
+        ThrowIfFailed(m_device->CreatePlacedResource(m_heap.Get(), placement.offset, &desc,
+            static_cast<D3D12_RESOURCE_STATES>(placement.restState), &clearValue, IID_PPV_ARGS(&m_placed[r])));
+        m_resources[r] = m_placed[r].Get();
+    }
+
+    m_placements.swap(placements);
+    return true;
+}
+
+void D3D12FrameGraphResources::Bind(FrameGraphResource resource, ID3D12Resource* d3dResource)
+{
+    m_resources[resource] = d3dResource;
+}
+
+void D3D12FrameGraphResources::RecordBarriers(ID3D12GraphicsCommandList* commandList, const ResourceBarrierDesc* barriers, size_t count)
+{
+    RecordResourceBarriers(commandList, barriers, count, m_resources.data(), m_barriers);
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include "stdafx.h"
+#include "DXSampleHelper.h"
+#include <deque>
+#include "FrameGraph.h"
+#include "D3D12ResourceStates.h"
+
+// Backs a compiled FrameGraph with D3D12 memory: one heap sized for the
+// aliased layout, with a placed resource per transient at the offset the
+// graph chose. Imported resources are bound by the caller every frame.
+//
+// Transients must be render targets or depth buffers (the heap only allows
+// those on resource heap tier 1 hardware).
+class D3D12FrameGraphResources
+{
+public:
+    D3D12FrameGraphResources() = default;
+    D3D12FrameGraphResources(const D3D12FrameGraphResources& rhs) = delete;
+    D3D12FrameGraphResources& operator=(const D3D12FrameGraphResources& rhs) = delete;
+
+    void Initialize(ID3D12Device* device);
+
+    static D3D12_RESOURCE_DESC ResourceDesc(const FrameGraphTextureDesc& desc, ResourceStates usage);
+
+    // Real allocation sizes for FrameGraph::Compile.
+    FrameGraph::MemoryQuery SizeQuery() const;
+
+    // Creates the heap and placed resources for the graph's transients, or
+    // keeps the current ones if the layout has not changed. Returns true when
+    // resources were created, so views onto them need to be rebuilt. Replaced
+    // resources are released once completedFence reaches currentFence.
+    bool Realize(const FrameGraph& graph, uint64_t currentFence, uint64_t completedFence);
+
+    void Bind(FrameGraphResource resource, ID3D12Resource* d3dResource);
+    ID3D12Resource* Resource(FrameGraphResource resource) const { return m_resources[resource]; }
+
+    void RecordBarriers(ID3D12GraphicsCommandList* commandList, const ResourceBarrierDesc* barriers, size_t count);
+
+private:
+    struct Placement
+    {
+        bool transient;
+        FrameGraphTextureDesc desc;
+        ResourceStates usage;
+        ResourceStates restState;
+        uint64_t offset;
+    };
+
+    struct Retired
+    {
+        uint64_t fence;
+        ComPtr<ID3D12Heap> heap;
+        std::vector<ComPtr<ID3D12Resource>> resources;
+    };
+
+    static bool SamePlacement(const Placement& a, const Placement& b);
+
+    ID3D12Device* m_device = nullptr;
+    ComPtr<ID3D12Heap> m_heap;
+    std::vector<Placement> m_placements;
+    std::vector<ComPtr<ID3D12Resource>> m_placed;
+    std::vector<ID3D12Resource*> m_resources;
+    std::deque<Retired> m_retired;
+    std::vector<D3D12_RESOURCE_BARRIER> m_barriers;
+};
@@ -0,0 +1,59 @@
+#include "stdafx.h"
+#include "D3D12GpuTimer.h"
+
+D3D12GpuTimer::~D3D12GpuTimer()
+{
+    if (m_mappedTicks)
+    {
+        m_readback->Unmap(0, nullptr);
+    }
+}
+
+void D3D12GpuTimer::Initialize(ID3D12Device* device, ID3D12CommandQueue* queue, UINT frameSlots)
+{
+    UINT64 frequency = 0;
+    ThrowIfFailed(queue->GetTimestampFrequency(&frequency));
+    m_millisecondsPerTick = 1000.0 / static_cast<double>(frequency);
+
+    D3D12_QUERY_HEAP_DESC queryHeapDesc = {};
+    queryHeapDesc.Type = D3D12_QUERY_HEAP_TYPE_TIMESTAMP;
+    queryHeapDesc.Count = 2 * frameSlots;
+    ThrowIfFailed(device->CreateQueryHeap(&queryHeapDesc, IID_PPV_ARGS(&m_queryHeap)));
+
+    ThrowIfFailed(device->CreateCommittedResource(
+        &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_READBACK),
+        D3D12_HEAP_FLAG_NONE,
+        &CD3DX12_RESOURCE_DESC::Buffer(2 * frameSlots * sizeof(UINT64)),
+        D3D12_RESOURCE_STATE_COPY_DEST,
+        nullptr,
+        IID_PPV_ARGS(&m_readback)));
+    void* mapped = nullptr;
+    ThrowIfFailed(m_readback->Map(0, nullptr, &mapped));
+    m_mappedTicks = static_cast<const UINT64*>(mapped);
+
+    m_slotUsed.assign(frameSlots, false);
+}
+
+void D3D12GpuTimer::Begin(ID3D12GraphicsCommandList* commandList, UINT frameSlot)
+{
+    commandList->EndQuery(m_queryHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, 2 * frameSlot);
+}
+
+void D3D12GpuTimer::End(ID3D12GraphicsCommandList* commandList, UINT frameSlot)
+{
+    commandList->EndQuery(m_queryHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, 2 * frameSlot + 1);
+    commandList->ResolveQueryData(m_queryHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, 2 * frameSlot, 2,
+        m_readback.Get(), 2 * frameSlot * sizeof(UINT64));
+    m_slotUsed[frameSlot] = true;
+}
+
+float D3D12GpuTimer::ReadMilliseconds(UINT frameSlot)
+{
+    if (!m_slotUsed[frameSlot])
+    {
+        return -1.0f;
+    }
+    const UINT64 begin = m_mappedTicks[2 * frameSlot];
+    const UINT64 end = m_mappedTicks[2 * frameSlot + 1];
+    return end > begin ? static_cast<float>((end - begin) * m_millisecondsPerTick) : 0.0f;
+}
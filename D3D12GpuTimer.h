@@ -0,0 +1,34 @@
+#pragma once
+#include "stdafx.h"
+#include "DXSampleHelper.h"
+#include <vector>
+
+// Measures the GPU time of whole frames with a pair of timestamp queries per
+// frame slot. Begin goes at the start of a frame's first command list and
+// End at the end of its last; End also resolves the pair into readback
+// memory. A slot's result can be read once the frame that last used it has
+// retired, which is when FramePacer hands the slot out again.
+class D3D12GpuTimer
+{
+public:
+    D3D12GpuTimer() = default;
+    D3D12GpuTimer(const D3D12GpuTimer& rhs) = delete;
+    D3D12GpuTimer& operator=(const D3D12GpuTimer& rhs) = delete;
+    ~D3D12GpuTimer();
+
+    void Initialize(ID3D12Device* device, ID3D12CommandQueue* queue, UINT frameSlots);
+
+    void Begin(ID3D12GraphicsCommandList* commandList, UINT frameSlot);
+    void End(ID3D12GraphicsCommandList* commandList, UINT frameSlot);
+
+    // GPU milliseconds of the last frame recorded in frameSlot, or a negative
+    // value if the slot has not been used yet.
+    float ReadMilliseconds(UINT frameSlot);
+
+private:
+    ComPtr<ID3D12QueryHeap> m_queryHeap;
+    ComPtr<ID3D12Resource> m_readback;          // Two UINT64 ticks per slot, persistently mapped.
+    const UINT64* m_mappedTicks = nullptr;
+    std::vector<bool> m_slotUsed;
+    double m_millisecondsPerTick = 0.0;
+};
@@ -0,0 +1,141 @@
+#include "stdafx.h"
+#include "D3D12IndirectDraw.h"
+
+namespace
+{
+    // Compute root parameters, matching IndirectCull.hlsl.
+    enum CullRootParameter
+    {
+        CullConstants,      // b0
+        CullObjects,        // t0
+        CullCommands,       // u0
+        CullDrawCount,      // u1
+        CullRootParameterCount
+    };
+}
+
+void D3D12IndirectDraw::Initialize(ID3D12Device* device, D3D12ShaderCompiler& compiler, const std::wstring& shaderPath, UINT compileFlags,
+    ID3D12RootSignature* graphicsRootSignature, UINT textureSlotParameter, UINT maxObjects)
+{
+    m_device = device;
+    m_maxObjects = maxObjects;
+
+    // Everything is bound as root constants and root descriptors, so the pass
+    // needs no descriptor heap space.
+    {
+        CD3DX12_ROOT_PARAMETER rootParameters[CullRootParameterCount];
+        rootParameters[CullConstants].InitAsConstants(sizeof(IndirectCullConstants) / sizeof(uint32_t), 0);
+        rootParameters[CullObjects].InitAsShaderResourceView(0);
+        rootParameters[CullCommands].InitAsUnorderedAccessView(0);
+        rootParameters[CullDrawCount].InitAsUnorderedAccessView(1);
+
+        CD3DX12_ROOT_SIGNATURE_DESC rootSignatureDesc;
+        rootSignatureDesc.Init(_countof(rootParameters), rootParameters);
+
+        ComPtr<ID3DBlob> signature;
+        ComPtr<ID3DBlob> error;
+        ThrowIfFailed(D3D12SerializeRootSignature(&rootSignatureDesc, D3D_ROOT_SIGNATURE_VERSION_1, &signature, &error));
+        ThrowIfFailed(device->CreateRootSignature(0, signature->GetBufferPointer(), signature->GetBufferSize(), IID_PPV_ARGS(&m_rootSignature)));
+    }
+
+    // A single compute pipeline, so it is created here rather than going
+    // through the graphics pipeline cache.
+    {
+        const std::vector<uint8_t>& computeShader = compiler.Compile(shaderPath, "CSMain", "cs_5_1", compileFlags);
+
+        D3D12_COMPUTE_PIPELINE_STATE_DESC psoDesc = {};
+        psoDesc.pRootSignature = m_rootSignature.Get();
+        psoDesc.CS = CD3DX12_SHADER_BYTECODE(computeShader.data(), computeShader.size());
+        ThrowIfFailed(device->CreateComputePipelineState(&psoDesc, IID_PPV_ARGS(&m_pipelineState)));
+    }
+
+    // Each command sets the albedo slot, then draws.
+    {
+        D3D12_INDIRECT_ARGUMENT_DESC arguments[2] = {};
+        arguments[0].Type = D3D12_INDIRECT_ARGUMENT_TYPE_CONSTANT;
+        arguments[0].Constant.RootParameterIndex = textureSlotParameter;
+        arguments[0].Constant.DestOffsetIn32BitValues = 0;
+        arguments[0].Constant.Num32BitValuesToSet = 1;
+        arguments[1].Type = D3D12_INDIRECT_ARGUMENT_TYPE_DRAW;
+
+        D3D12_COMMAND_SIGNATURE_DESC signatureDesc = {};
+        signatureDesc.ByteStride = sizeof(IndirectDrawCommand);
+        signatureDesc.NumArgumentDescs = _countof(arguments);
+        signatureDesc.pArgumentDescs = arguments;
+        ThrowIfFailed(device->CreateCommandSignature(&signatureDesc, graphicsRootSignature, IID_PPV_ARGS(&m_commandSignature)));
+    }
+
+    CreateBuffer(D3D12_HEAP_TYPE_UPLOAD, maxObjects * sizeof(IndirectObject), D3D12_RESOURCE_FLAG_NONE,
+        D3D12_RESOURCE_STATE_GENERIC_READ, m_objects);
+    CreateBuffer(D3D12_HEAP_TYPE_DEFAULT, maxObjects * sizeof(IndirectDrawCommand), D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS,
+        D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT, m_commands);
+    CreateBuffer(D3D12_HEAP_TYPE_DEFAULT, sizeof(uint32_t), D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS,
+        D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT, m_drawCount);
+    m_commandsState = m_states.Register(m_commands.Get(), D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT);
+    m_drawCountState = m_states.Register(m_drawCount.Get(), D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT);
+
+    CD3DX12_RANGE readRange(0, 0);
+    ThrowIfFailed(m_objects->Map(0, &readRange, reinterpret_cast<void**>(&m_mappedObjects)));
+}
+
+void D3D12IndirectDraw::CreateBuffer(D3D12_HEAP_TYPE heap, UINT64 size, D3D12_RESOURCE_FLAGS flags, D3D12_RESOURCE_STATES state, ComPtr<ID3D12Resource>& buffer)
+{
+    ThrowIfFailed(m_device->CreateCommittedResource(
+        &CD3DX12_HEAP_PROPERTIES(heap),
+        D3D12_HEAP_FLAG_NONE,
+        &CD3DX12_RESOURCE_DESC::Buffer(size, flags),
+        state,
+        nullptr,
+        IID_PPV_ARGS(&buffer)));
+}
+
+void D3D12IndirectDraw::SetObjects(const IndirectObject* objects, UINT count)
+{
+    if (count > m_maxObjects)
+    {
+        ThrowIfFailed(E_INVALIDARG);
+    }
+    memcpy(m_mappedObjects, objects, count * sizeof(IndirectObject));
+    m_objectCount = count;
+}
+
+void D3D12IndirectDraw::TransitionOutputs(ID3D12GraphicsCommandList* commandList, D3D12_RESOURCE_STATES state)
+{
+    m_states.Transition(m_commandsState, state);
+    m_states.Transition(m_drawCountState, state);
+    m_states.Flush(commandList);
+}
+
+void D3D12IndirectDraw::Cull(ID3D12GraphicsCommandList* commandList, const Frustum& frustum)
+{
+    const IndirectCullConstants constants = IndirectCulling::MakeConstants(frustum, m_objectCount);
+
+    // The previous frame's draws were recorded earlier on the same queue, so
+    // this barrier also orders the overwrite after them.
+    TransitionOutputs(commandList, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+
+    commandList->SetComputeRootSignature(m_rootSignature.Get());
+    commandList->SetPipelineState(m_pipelineState.Get());
+    commandList->SetComputeRoot32BitConstants(CullConstants, sizeof(constants) / sizeof(uint32_t), &constants, 0);
+    commandList->SetComputeRootShaderResourceView(CullObjects, m_objects->GetGPUVirtualAddress());
+    commandList->SetComputeRootUnorderedAccessView(CullCommands, m_commands->GetGPUVirtualAddress());
+    commandList->SetComputeRootUnorderedAccessView(CullDrawCount, m_drawCount->GetGPUVirtualAddress());
+
+    // One group, so the prefix sum can keep the commands in object order.
+    commandList->Dispatch(1, 1, 1);
+
+    TransitionOutputs(commandList, D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT);
+}
+
+void D3D12IndirectDraw::Draw(ID3D12GraphicsCommandList* commandList)
+{
+    commandList->ExecuteIndirect(m_commandSignature.Get(), m_objectCount, m_commands.Get(), 0, m_drawCount.Get(), 0);
+}
+
+void D3D12IndirectDraw::CopyResults(ID3D12GraphicsCommandList* commandList, ID3D12Resource* readback)
+{
+    TransitionOutputs(commandList, D3D12_RESOURCE_STATE_COPY_SOURCE);
+    commandList->CopyBufferRegion(readback, 0, m_drawCount.Get(), 0, sizeof(uint32_t));
+    commandList->CopyBufferRegion(readback, ReadbackCommandsOffset, m_commands.Get(), 0, m_objectCount * sizeof(IndirectDrawCommand));
+    TransitionOutputs(commandList, D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT);
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include "stdafx.h"
+#include "DXSampleHelper.h"
+#include "D3D12ResourceStates.h"
+#include "D3D12ShaderCompiler.h"
+#include "IndirectCulling.h"
+
+// GPU-driven drawing of a static object list: a compute pass (IndirectCull.hlsl)
+// frustum culls the objects and writes a compacted list of draw commands and
+// its length, and ExecuteIndirect draws exactly those, without the CPU
+// reading anything back.
+//
+// Each command sets the albedo slot root constant of the graphics root
+// signature and draws a vertex range of the bound vertex buffer.
+class D3D12IndirectDraw
+{
+public:
+    D3D12IndirectDraw() = default;
+    D3D12IndirectDraw(const D3D12IndirectDraw& rhs) = delete;
+    D3D12IndirectDraw& operator=(const D3D12IndirectDraw& rhs) = delete;
+
+    // textureSlotParameter is the root constants parameter of the graphics root
+    // signature whose first value is the albedo slot.
+    void Initialize(ID3D12Device* device, D3D12ShaderCompiler& compiler, const std::wstring& shaderPath, UINT compileFlags,
+        ID3D12RootSignature* graphicsRootSignature, UINT textureSlotParameter, UINT maxObjects);
+
+    // Replaces the object list. The objects live in an upload heap, so this
+    // must not be called while the GPU may still be culling the old ones.
+    void SetObjects(const IndirectObject* objects, UINT count);
+    UINT ObjectCount() const { return m_objectCount; }
+
+    // Records the cull pass. It replaces the pipeline state, but leaves the
+    // graphics root signature and its bindings alone.
+    void Cull(ID3D12GraphicsCommandList* commandList, const Frustum& frustum);
+
+    // Records the draws written by the last Cull. The pipeline, vertex buffer
+    // and other root parameters must already be bound.
+    void Draw(ID3D12GraphicsCommandList* commandList);
+
+    // Copies the draw count and commands written by the last Cull to readback,
+    // for checking them against IndirectCulling::CullAndCompact: the count at
+    // offset 0 and the commands at ReadbackCommandsOffset. readback must be in
+    // COPY_DEST and have room for ObjectCount commands.
+    static const UINT64 ReadbackCommandsOffset = 16;
+    void CopyResults(ID3D12GraphicsCommandList* commandList, ID3D12Resource* readback);
+
+private:
+    void CreateBuffer(D3D12_HEAP_TYPE heap, UINT64 size, D3D12_RESOURCE_FLAGS flags, D3D12_RESOURCE_STATES state, ComPtr<ID3D12Resource>& buffer);
+    void TransitionOutputs(ID3D12GraphicsCommandList* commandList, D3D12_RESOURCE_STATES state);
+
+    ID3D12Device* m_device = nullptr;
+    ComPtr<ID3D12RootSignature> m_rootSignature;
+    ComPtr<ID3D12PipelineState> m_pipelineState;
+    ComPtr<ID3D12CommandSignature> m_commandSignature;
+
+    UINT m_maxObjects = 0;
+    UINT m_objectCount = 0;
+    ComPtr<ID3D12Resource> m_objects;           // Upload heap, persistently mapped.
+    IndirectObject* m_mappedObjects = nullptr;
+    ComPtr<ID3D12Resource> m_commands;          // Rest in INDIRECT_ARGUMENT between culls.
+    ComPtr<ID3D12Resource> m_drawCount;
+    D3D12ResourceStates m_states;
+    uint32_t m_commandsState = 0;
+    uint32_t m_drawCountState = 0;
+};
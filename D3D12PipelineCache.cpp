@@ -0,0 +1,305 @@
+#include "stdafx.h"
+#include "D3D12PipelineCache.h"
+#include <fstream>
+#include <iterator>
+#include "Hash.h"
+
+namespace
+{
+    void HashShader(Fnv1aHasher& hasher, const D3D12_SHADER_BYTECODE& shader)
+    {
+        hasher.Value(shader.BytecodeLength);
+        hasher.Bytes(shader.pShaderBytecode, shader.BytecodeLength);
+    }
+
+    // Field by field: the structs have padding that is not reliably zeroed.
+    void HashBlend(Fnv1aHasher& hasher, const D3D12_BLEND_DESC& blend)
+    {
+        hasher.Value(blend.AlphaToCoverageEnable);
+        hasher.Value(blend.IndependentBlendEnable);
+        for (const D3D12_RENDER_TARGET_BLEND_DESC& target : blend.RenderTarget)
+        {
+            hasher.Value(target.BlendEnable);
+            hasher.Value(target.LogicOpEnable);
+            hasher.Value(target.SrcBlend);
+            hasher.Value(target.DestBlend);
+            hasher.Value(target.BlendOp);
+            hasher.Value(target.SrcBlendAlpha);
+            hasher.Value(target.DestBlendAlpha);
+            hasher.Value(target.BlendOpAlpha);
+            hasher.Value(target.LogicOp);
+            hasher.Value(target.RenderTargetWriteMask);
+        }
+    }
+
+    void HashStencilOp(Fnv1aHasher& hasher, const D3D12_DEPTH_STENCILOP_DESC& op)
+    {
+        hasher.Value(op.StencilFailOp);
+        hasher.Value(op.StencilDepthFailOp);
+        hasher.Value(op.StencilPassOp);
+        hasher.Value(op.StencilFunc);
+    }
+
+    void HashDepthStencil(Fnv1aHasher& hasher, const D3D12_DEPTH_STENCIL_DESC& depthStencil)
+    {
+        hasher.Value(depthStencil.DepthEnable);
+        hasher.Value(depthStencil.DepthWriteMask);
+        hasher.Value(depthStencil.DepthFunc);
+        hasher.Value(depthStencil.StencilEnable);
+        hasher.Value(depthStencil.StencilReadMask);
+        hasher.Value(depthStencil.StencilWriteMask);
+        HashStencilOp(hasher, depthStencil.FrontFace);
+        HashStencilOp(hasher, depthStencil.BackFace);
+    }
+
+    void HashRasterizer(Fnv1aHasher& hasher, const D3D12_RASTERIZER_DESC& rasterizer)
+    {
+        hasher.Value(rasterizer.FillMode);
+        hasher.Value(rasterizer.CullMode);
+        hasher.Value(rasterizer.FrontCounterClockwise);
+        hasher.Value(static_cast<uint32_t>(rasterizer.DepthBias));
+        hasher.Bytes(&rasterizer.DepthBiasClamp, sizeof(rasterizer.DepthBiasClamp));
+        hasher.Bytes(&rasterizer.SlopeScaledDepthBias, sizeof(rasterizer.SlopeScaledDepthBias));
+        hasher.Value(rasterizer.DepthClipEnable);
+        hasher.Value(rasterizer.MultisampleEnable);
+        hasher.Value(rasterizer.AntialiasedLineEnable);
+        hasher.Value(rasterizer.ForcedSampleCount);
+        hasher.Value(rasterizer.ConservativeRaster);
+    }
+
+    void CopyShader(std::vector<uint8_t>& storage, D3D12_SHADER_BYTECODE& shader)
+    {
+        const uint8_t* bytes = static_cast<const uint8_t*>(shader.pShaderBytecode);
+        storage.assign(bytes, bytes + shader.BytecodeLength);
+        shader.pShaderBytecode = storage.empty() ? nullptr : storage.data();
+    }
+}
+
+D3D12PipelineCache::~D3D12PipelineCache()
+{
+    // Join the workers before the entries they write go away.
+    m_queue.reset();
+}
+
+void D3D12PipelineCache::Initialize(ID3D12Device* device, const std::wstring& libraryPath, unsigned workerCount)
+{
+    m_device = device;
+    m_libraryPath = libraryPath;
+
+    ComPtr<ID3D12Device1> device1;
+    if (SUCCEEDED(device->QueryInterface(IID_PPV_ARGS(&device1))))
+    {
+        std::ifstream file(libraryPath, std::ios::binary);
+        if (file)
+        {
+            m_libraryData.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        }
+
+        HRESULT hr = E_FAIL;
+        if (!m_libraryData.empty())
+        {
+            hr = device1->CreatePipelineLibrary(m_libraryData.data(), m_libraryData.size(), IID_PPV_ARGS(&m_library));
+        }
+        if (FAILED(hr))
+        {
+            // Missing, corrupt, or written by another driver version: start a new one.
+            m_libraryData.clear();
+            hr = device1->CreatePipelineLibrary(nullptr, 0, IID_PPV_ARGS(&m_library));
+        }
+        if (FAILED(hr))
+        {
+            // Some drivers do not support libraries; pipelines are still compiled.
+            m_library.Reset();
+        }
+    }
+
+    if (workerCount == 0)
+    {
+        const unsigned threads = std::thread::hardware_concurrency();
+        workerCount = threads > 2 ? threads - 1 : 1;
+        workerCount = workerCount > 4 ? 4 : workerCount;
+    }
+    m_entries.reset(new Entry[Capacity]);
+    m_queue.reset(new PipelineCompileQueue(Capacity, workerCount, [this](uint32_t pipeline) { return Compile(pipeline); }));
+}
+
+void D3D12PipelineCache::AddRootSignature(ID3D12RootSignature* rootSignature, ID3DBlob* blob)
+{
+    Fnv1aHasher hasher;
+    hasher.Bytes(blob->GetBufferPointer(), blob->GetBufferSize());
+    m_rootSignatures[rootSignature] = hasher.Get();
+}
+
+uint32_t D3D12PipelineCache::Request(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc)
+{
+    const uint64_t hash = Hash(desc);
+    return m_queue->Request(hash, [&](uint32_t pipeline) { Copy(m_entries[pipeline], desc, hash); });
+}
+
+ID3D12PipelineState* D3D12PipelineCache::TryGet(uint32_t pipeline) const
+{
+    if (pipeline >= m_queue->Count())
+    {
+        ThrowIfFailed(E_INVALIDARG);
+    }
+    if (m_queue->GetStatus(pipeline) != PipelineCompileQueue::Status::Ready)
+    {
+        return nullptr;
+    }
+    return m_entries[pipeline].pipeline.Get();
+}
+
+ID3D12PipelineState* D3D12PipelineCache::Wait(uint32_t pipeline)
+{
+    if (pipeline >= m_queue->Count())
+    {
+        ThrowIfFailed(E_INVALIDARG);
+    }
+    if (m_queue->Wait(pipeline) != PipelineCompileQueue::Status::Ready)
+    {
+        const HRESULT result = m_entries[pipeline].result;
+        ThrowIfFailed(FAILED(result) ? result : E_FAIL);
+    }
+    return m_entries[pipeline].pipeline.Get();
+}
+
+void D3D12PipelineCache::WaitAll()
+{
+    m_queue->WaitAll();
+}
+
+void D3D12PipelineCache::Save()
+{
+    WaitAll();
+
+    std::lock_guard<std::mutex> lock(m_libraryMutex);
+    if (!m_library || !m_libraryDirty)
+    {
+        return;
+    }
+
+    std::vector<uint8_t> data(m_library->GetSerializedSize());
+    ThrowIfFailed(m_library->Serialize(data.data(), data.size()));
+
+    std::ofstream file(m_libraryPath, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char*>(data.data()), data.size());
+    if (file)
+    {
+        m_libraryDirty = false;
+    }
+}
+
+D3D12PipelineCache::Stats D3D12PipelineCache::GetStats() const
+{
+    const PipelineCompileQueue::Stats queue = m_queue->GetStats();
+    Stats stats;
+    stats.requested = queue.requested;
+    stats.deduplicated = queue.deduplicated;
+    stats.loadedFromLibrary = m_loadedFromLibrary.load();
+    stats.compiled = queue.compiled;
+    stats.failed = queue.failed;
+    return stats;
+}
+
+uint64_t D3D12PipelineCache::Hash(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc) const
+{
+    auto rootSignature = m_rootSignatures.find(desc.pRootSignature);
+    if (rootSignature == m_rootSignatures.end() || desc.StreamOutput.NumEntries != 0)
+    {
+        ThrowIfFailed(E_INVALIDARG);
+    }
+
+    Fnv1aHasher hasher;
+    hasher.Value(rootSignature->second);
+    HashShader(hasher, desc.VS);
+    HashShader(hasher, desc.PS);
+    HashShader(hasher, desc.DS);
+    HashShader(hasher, desc.HS);
+    HashShader(hasher, desc.GS);
+    HashBlend(hasher, desc.BlendState);
+    hasher.Value(desc.SampleMask);
+    HashRasterizer(hasher, desc.RasterizerState);
+    HashDepthStencil(hasher, desc.DepthStencilState);
+
+    hasher.Value(desc.InputLayout.NumElements);
+    for (UINT i = 0; i < desc.InputLayout.NumElements; i++)
+    {
+        const D3D12_INPUT_ELEMENT_DESC& element = desc.InputLayout.pInputElementDescs[i];
+        hasher.String(element.SemanticName);
+        hasher.Value(element.SemanticIndex);
+        hasher.Value(element.Format);
+        hasher.Value(element.InputSlot);
+        hasher.Value(element.AlignedByteOffset);
+        hasher.Value(element.InputSlotClass);
+        hasher.Value(element.InstanceDataStepRate);
+    }
+
+    hasher.Value(desc.IBStripCutValue);
+    hasher.Value(desc.PrimitiveTopologyType);
+    hasher.Value(desc.NumRenderTargets);
+    for (DXGI_FORMAT format : desc.RTVFormats)
+    {
+        hasher.Value(format);
+    }
+    hasher.Value(desc.DSVFormat);
+    hasher.Value(desc.SampleDesc.Count);
+    hasher.Value(desc.SampleDesc.Quality);
+    hasher.Value(desc.NodeMask);
+    hasher.Value(desc.Flags);
+    return hasher.Get();
+}
+
+void D3D12PipelineCache::Copy(Entry& entry, const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc, uint64_t hash)
+{
+    entry.desc = desc;
+    entry.desc.CachedPSO = {};
+    CopyShader(entry.shaders[0], entry.desc.VS);
+    CopyShader(entry.shaders[1], entry.desc.PS);
+    CopyShader(entry.shaders[2], entry.desc.DS);
+    CopyShader(entry.shaders[3], entry.desc.HS);
+    CopyShader(entry.shaders[4], entry.desc.GS);
+
+    const UINT elementCount = desc.InputLayout.NumElements;
+    entry.inputElements.assign(desc.InputLayout.pInputElementDescs, desc.InputLayout.pInputElementDescs + elementCount);
+    entry.semanticNames.resize(elementCount);
+    for (UINT i = 0; i < elementCount; i++)
+    {
+        entry.semanticNames[i] = entry.inputElements[i].SemanticName;
+        entry.inputElements[i].SemanticName = entry.semanticNames[i].c_str();
+    }
+    entry.desc.InputLayout.pInputElementDescs = entry.inputElements.empty() ? nullptr : entry.inputElements.data();
+
+    wchar_t name[17];
+    swprintf_s(name, L"%016llx", static_cast<unsigned long long>(hash));
+    entry.name = name;
+}
+
+bool D3D12PipelineCache::Compile(uint32_t pipeline)
+{
+    Entry& entry = m_entries[pipeline];
+    if (m_library)
+    {
+        std::lock_guard<std::mutex> lock(m_libraryMutex);
+        if (SUCCEEDED(m_library->LoadGraphicsPipeline(entry.name.c_str(), &entry.desc, IID_PPV_ARGS(&entry.pipeline))))
+        {
+            m_loadedFromLibrary++;
+            return true;
+        }
+    }
+
+    entry.result = m_device->CreateGraphicsPipelineState(&entry.desc, IID_PPV_ARGS(&entry.pipeline));
+    if (FAILED(entry.result))
+    {
+        return false;
+    }
+
+    if (m_library)
+    {
+        std::lock_guard<std::mutex> lock(m_libraryMutex);
+        if (SUCCEEDED(m_library->StorePipeline(entry.name.c_str(), entry.pipeline.Get())))
+        {
+            m_libraryDirty = true;
+        }
+    }
+    return true;
+}
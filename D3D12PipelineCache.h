@@ -0,0 +1,87 @@
+#pragma once
+#include "stdafx.h"
+#include "DXSampleHelper.h"
+#include <unordered_map>
+#include "PipelineCompileQueue.h"
+
+// Graphics pipeline states, deduplicated by a hash of the complete
+// D3D12_GRAPHICS_PIPELINE_STATE_DESC (shader bytecode, input layout and every
+// fixed-function field) and compiled on background threads.
+//
+// Compiled pipelines are stored in an ID3D12PipelineLibrary that is written
+// to disk by Save and loaded by Initialize, so later runs skip driver
+// compilation. Library entries are named by the hash, which includes the
+// serialized root signature rather than the pointer, so names are stable
+// from run to run.
+class D3D12PipelineCache
+{
+public:
+    static const uint32_t InvalidPipeline = PipelineCompileQueue::InvalidId;
+    static const uint32_t Capacity = 1024;
+
+    struct Stats
+    {
+        uint32_t requested;
+        uint32_t deduplicated;
+        uint32_t loadedFromLibrary;
+        uint32_t compiled;          // Includes library loads.
+        uint32_t failed;
+    };
+
+    D3D12PipelineCache() = default;
+    D3D12PipelineCache(const D3D12PipelineCache& rhs) = delete;
+    D3D12PipelineCache& operator=(const D3D12PipelineCache& rhs) = delete;
+    ~D3D12PipelineCache();
+
+    // workerCount == 0 picks hardware_concurrency() - 1, at most 4.
+    void Initialize(ID3D12Device* device, const std::wstring& libraryPath, unsigned workerCount = 0);
+
+    // Root signatures must be registered before pipelines using them are
+    // requested; blob is the serialized root signature it was created from.
+    void AddRootSignature(ID3D12RootSignature* rootSignature, ID3DBlob* blob);
+
+    // Queues desc for compilation and returns its id right away. The desc is
+    // copied, including everything it points to.
+    uint32_t Request(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc);
+
+    // nullptr while the pipeline is still compiling. Safe from any thread.
+    ID3D12PipelineState* TryGet(uint32_t pipeline) const;
+
+    // Blocks until the pipeline is ready; throws if it failed to compile.
+    ID3D12PipelineState* Wait(uint32_t pipeline);
+    void WaitAll();
+
+    // Writes the library to disk if it gained pipelines. Waits for pending
+    // compiles first.
+    void Save();
+
+    Stats GetStats() const;
+
+private:
+    struct Entry
+    {
+        D3D12_GRAPHICS_PIPELINE_STATE_DESC desc;
+        std::vector<uint8_t> shaders[5];
+        std::vector<D3D12_INPUT_ELEMENT_DESC> inputElements;
+        std::vector<std::string> semanticNames;
+        std::wstring name;
+        ComPtr<ID3D12PipelineState> pipeline;
+        HRESULT result = S_OK;
+    };
+
+    uint64_t Hash(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc) const;
+    void Copy(Entry& entry, const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc, uint64_t hash);
+    bool Compile(uint32_t pipeline);
+
+    ID3D12Device* m_device = nullptr;
+    ComPtr<ID3D12PipelineLibrary> m_library;
+    std::vector<uint8_t> m_libraryData;     // Must outlive m_library.
+    std::wstring m_libraryPath;
+    std::mutex m_libraryMutex;
+    bool m_libraryDirty = false;
+    std::atomic<uint32_t> m_loadedFromLibrary{ 0 };
+
+    std::unordered_map<ID3D12RootSignature*, uint64_t> m_rootSignatures;
+    std::unique_ptr<Entry[]> m_entries;
+    std::unique_ptr<PipelineCompileQueue> m_queue;
+};
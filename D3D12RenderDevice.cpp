@@ -0,0 +1,500 @@
+#include "stdafx.h"
+#include "D3D12RenderDevice.h"
+
+namespace
+{
+    DXGI_FORMAT ToDxgiFormat(TextureFormat format)
+    {
+        switch (format)
+        {
+        case TextureFormat::RGBA8:      return DXGI_FORMAT_R8G8B8A8_UNORM;
+        case TextureFormat::RGBA8_SRGB: return DXGI_FORMAT_R8G8B8A8_UNORM_SRGB;
+        case TextureFormat::BC1:        return DXGI_FORMAT_BC1_UNORM;
+        case TextureFormat::BC1_SRGB:   return DXGI_FORMAT_BC1_UNORM_SRGB;
+        case TextureFormat::BC3:        return DXGI_FORMAT_BC3_UNORM;
+        case TextureFormat::BC3_SRGB:   return DXGI_FORMAT_BC3_UNORM_SRGB;
+        default:                        return DXGI_FORMAT_UNKNOWN;
+        }
+    }
+
+    DXGI_FORMAT ToDxgiFormat(DepthFormat format)
+    {
+        switch (format)
+        {
+        case DepthFormat::D32:          return DXGI_FORMAT_D32_FLOAT;
+        case DepthFormat::D24S8:        return DXGI_FORMAT_D24_UNORM_S8_UINT;
+        default:                        return DXGI_FORMAT_UNKNOWN;
+        }
+    }
+
+    D3D12_COMPARISON_FUNC ToComparisonFunc(CompareFunc func)
+    {
+        switch (func)
+        {
+        case CompareFunc::LessEqual:    return D3D12_COMPARISON_FUNC_LESS_EQUAL;
+        case CompareFunc::Equal:        return D3D12_COMPARISON_FUNC_EQUAL;
+        case CompareFunc::Always:       return D3D12_COMPARISON_FUNC_ALWAYS;
+        default:                        return D3D12_COMPARISON_FUNC_LESS;
+        }
+    }
+}
+
+//--------------------------------------------------------------------------------------
+
+D3D12RenderCommandList::D3D12RenderCommandList(D3D12RenderDevice& device, ID3D12Device* d3dDevice, D3D12_COMMAND_LIST_TYPE type, UINT allocatorCount) :
+    m_device(device),
+    m_allocators(allocatorCount)
+{
+    for (UINT n = 0; n < allocatorCount; n++)
+    {
+        ThrowIfFailed(d3dDevice->CreateCommandAllocator(type, IID_PPV_ARGS(&m_allocators[n])));
+    }
+    ThrowIfFailed(d3dDevice->CreateCommandList(0, type, m_allocators[0].Get(), nullptr, IID_PPV_ARGS(&m_commandList)));
+
+    // Lists are created recording; Begin expects them closed.
+    ThrowIfFailed(m_commandList->Close());
+}
+
+void D3D12RenderCommandList::Begin(uint32_t frameSlot)
+{
+    ID3D12CommandAllocator* allocator = m_allocators[frameSlot % m_allocators.size()].Get();
+    ThrowIfFailed(allocator->Reset());
+    ThrowIfFailed(m_commandList->Reset(allocator, nullptr));
+
+    // Bundles must bind the same root signature and heap as the list that
+    // executes them, and do not inherit the primitive topology.
+    m_commandList->SetGraphicsRootSignature(m_device.m_rootSignature);
+    ID3D12DescriptorHeap* ppHeaps[] = { m_device.m_descriptors->Heap() };
+    m_commandList->SetDescriptorHeaps(_countof(ppHeaps), ppHeaps);
+    m_commandList->SetGraphicsRootDescriptorTable(2, m_device.m_descriptors->GpuHandle(0));
+    m_commandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+}
+
+void D3D12RenderCommandList::End()
+{
+    ThrowIfFailed(m_commandList->Close());
+}
+
+void D3D12RenderCommandList::SetPipeline(PipelineHandle pipeline)
+{
+    m_commandList->SetPipelineState(m_device.GetPipeline(pipeline));
+}
+
+void D3D12RenderCommandList::SetConstantBuffer(uint32_t slot, BufferHandle buffer, uint64_t offset)
+{
+    if (slot >= MaxConstantBufferSlots)
+    {
+        ThrowIfFailed(E_INVALIDARG);
+    }
+    const D3D12_GPU_VIRTUAL_ADDRESS address = m_device.GetBuffer(buffer).resource->GetGPUVirtualAddress() + offset;
+    m_commandList->SetGraphicsRootConstantBufferView(0, address);
+}
+
+void D3D12RenderCommandList::SetTexture(uint32_t slot, TextureHandle texture)
+{
+    if (slot >= MaxTextureSlots)
+    {
+        ThrowIfFailed(E_INVALIDARG);
+    }
+    // Shaders index the bindless table with the slot, so switching textures
+    // is a root constant rather than a new descriptor table.
+    m_commandList->SetGraphicsRoot32BitConstant(1, m_device.GetTexture(texture).srvSlot, slot);
+}
+
+void D3D12RenderCommandList::SetVertexBuffer(BufferHandle buffer, uint32_t stride, uint64_t offset)
+{
+    const D3D12RenderDevice::Buffer& data = m_device.GetBuffer(buffer);
+
+    D3D12_VERTEX_BUFFER_VIEW view;
+    view.BufferLocation = data.resource->GetGPUVirtualAddress() + offset;
+    view.StrideInBytes = stride;
+    view.SizeInBytes = static_cast<UINT>(data.size - offset);
+    m_commandList->IASetVertexBuffers(0, 1, &view);
+}
+
+void D3D12RenderCommandList::SetIndexBuffer(BufferHandle buffer, uint64_t offset)
+{
+    const D3D12RenderDevice::Buffer& data = m_device.GetBuffer(buffer);
+
+    D3D12_INDEX_BUFFER_VIEW view;
+    view.BufferLocation = data.resource->GetGPUVirtualAddress() + offset;
+    view.SizeInBytes = static_cast<UINT>(data.size - offset);
+    view.Format = DXGI_FORMAT_R32_UINT;
+    m_commandList->IASetIndexBuffer(&view);
+}
+
+void D3D12RenderCommandList::SetInstanceBuffer(BufferHandle buffer, uint64_t offset)
+{
+    // A root SRV has no size, so the offset is how each draw finds its records.
+    const D3D12_GPU_VIRTUAL_ADDRESS address = m_device.GetBuffer(buffer).resource->GetGPUVirtualAddress() + offset;
+    m_commandList->SetGraphicsRootShaderResourceView(3, address);
+}
+
+void D3D12RenderCommandList::SetShaderBuffer(uint32_t slot, BufferHandle buffer, uint64_t offset)
+{
+    if (slot >= MaxShaderBufferSlots)
+    {
+        ThrowIfFailed(E_INVALIDARG);
+    }
+    const D3D12_GPU_VIRTUAL_ADDRESS address = m_device.GetBuffer(buffer).resource->GetGPUVirtualAddress() + offset;
+    m_commandList->SetGraphicsRootShaderResourceView(4 + slot, address);
+}
+
+void D3D12RenderCommandList::SetViewport(float x, float y, float width, float height)
+{
+    CD3DX12_VIEWPORT viewport(x, y, width, height);
+    CD3DX12_RECT scissorRect(static_cast<LONG>(x), static_cast<LONG>(y), static_cast<LONG>(x + width), static_cast<LONG>(y + height));
+    m_commandList->RSSetViewports(1, &viewport);
+    m_commandList->RSSetScissorRects(1, &scissorRect);
+}
+
+void D3D12RenderCommandList::Draw(uint32_t vertexCount, uint32_t instanceCount, uint32_t firstVertex, uint32_t firstInstance)
+{
+    m_commandList->DrawInstanced(vertexCount, instanceCount, firstVertex, firstInstance);
+}
+
+void D3D12RenderCommandList::DrawIndexed(uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, int32_t baseVertex, uint32_t firstInstance)
+{
+    m_commandList->DrawIndexedInstanced(indexCount, instanceCount, firstIndex, baseVertex, firstInstance);
+}
+
+void D3D12RenderCommandList::ExecuteBundle(IRenderCommandList& bundle)
+{
+    m_commandList->ExecuteBundle(static_cast<D3D12RenderCommandList&>(bundle).Native());
+}
+
+//--------------------------------------------------------------------------------------
+
+D3D12RenderDevice::~D3D12RenderDevice()
+{
+    // Imported and created buffers alike are released by their ComPtr; only
+    // the upload buffers this device mapped need unmapping.
+    for (uint32_t i = 0; i < m_buffers.SlotCount(); i++)
+    {
+        Buffer* buffer = m_buffers.Get(i);
+        if (buffer && buffer->mapped)
+        {
+            buffer->resource->Unmap(0, nullptr);
+        }
+    }
+}
+
+void D3D12RenderDevice::Initialize(ID3D12Device* device, ID3D12CommandQueue* queue, D3D12FenceQueue* fences,
+    ID3D12RootSignature* rootSignature, D3D12DescriptorHeap* descriptors, UINT framesInFlight)
+{
+    m_device = device;
+    m_queue = queue;
+    m_fences = fences;
+    m_rootSignature = rootSignature;
+    m_descriptors = descriptors;
+    m_framesInFlight = framesInFlight;
+}
+
+void D3D12RenderDevice::SetUploader(D3D12CopyQueue* copyQueue, GeometryUploader* uploader)
+{
+    m_copyQueue = copyQueue;
+    m_uploader = uploader;
+}
+
+void D3D12RenderDevice::SetPipelineCache(D3D12PipelineCache* pipelineCache)
+{
+    m_pipelineCache = pipelineCache;
+}
+
+BufferHandle D3D12RenderDevice::ImportBuffer(ID3D12Resource* resource)
+{
+    Buffer buffer = { resource, resource->GetDesc().Width, nullptr };
+    BufferHandle handle;
+    handle.index = m_buffers.Add(buffer);
+    return handle;
+}
+
+TextureHandle D3D12RenderDevice::ImportTexture(ID3D12Resource* resource, UINT srvSlot)
+{
+    Texture texture = { resource, srvSlot, false };
+    TextureHandle handle;
+    handle.index = m_textures.Add(texture);
+    return handle;
+}
+
+PipelineHandle D3D12RenderDevice::ImportPipeline(ID3D12PipelineState* pipeline)
+{
+    PipelineHandle handle;
+    Pipeline data = { pipeline, D3D12PipelineCache::InvalidPipeline, PipelineHandle() };
+    handle.index = m_pipelines.Add(data);
+    return handle;
+}
+
+void D3D12RenderDevice::WaitForPipeline(PipelineHandle pipeline)
+{
+    const Pipeline* data = m_pipelines.Get(pipeline.index);
+    if (!data)
+    {
+        ThrowIfFailed(E_INVALIDARG);
+    }
+    if (!data->pipeline)
+    {
+        m_pipelineCache->Wait(data->cachedPipeline);
+    }
+}
+
+PipelineHandle D3D12RenderDevice::ImportCachedPipeline(uint32_t cachedPipeline, PipelineHandle fallback)
+{
+    if (!m_pipelineCache || (fallback.IsValid() && !m_pipelines.Get(fallback.index)))
+    {
+        ThrowIfFailed(E_INVALIDARG);
+    }
+
+    PipelineHandle handle;
+    Pipeline data = { nullptr, cachedPipeline, fallback };
+    handle.index = m_pipelines.Add(data);
+    return handle;
+}
+
+std::unique_ptr<D3D12RenderCommandList> D3D12RenderDevice::CreateD3D12CommandList()
+{
+    return std::unique_ptr<D3D12RenderCommandList>(new D3D12RenderCommandList(*this, m_device, D3D12_COMMAND_LIST_TYPE_DIRECT, m_framesInFlight));
+}
+
+std::unique_ptr<D3D12RenderCommandList> D3D12RenderDevice::CreateD3D12Bundle()
+{
+    return std::unique_ptr<D3D12RenderCommandList>(new D3D12RenderCommandList(*this, m_device, D3D12_COMMAND_LIST_TYPE_BUNDLE, 1));
+}
+
+BufferHandle D3D12RenderDevice::CreateBuffer(const BufferDesc& desc, const void* initialData)
+{
+    const bool upload = desc.memory == MemoryType::Upload;
+
+    Buffer buffer = { nullptr, desc.size, nullptr };
+    ThrowIfFailed(m_device->CreateCommittedResource(
+        &CD3DX12_HEAP_PROPERTIES(upload ? D3D12_HEAP_TYPE_UPLOAD : D3D12_HEAP_TYPE_DEFAULT),
+        D3D12_HEAP_FLAG_NONE,
+        &CD3DX12_RESOURCE_DESC::Buffer(desc.size),
+        upload ? D3D12_RESOURCE_STATE_GENERIC_READ : D3D12_RESOURCE_STATE_COMMON,
+        nullptr,
+        IID_PPV_ARGS(&buffer.resource)));
+
+    if (upload)
+    {
+        CD3DX12_RANGE readRange(0, 0);        // We do not intend to read from this resource on the CPU.
+        ThrowIfFailed(buffer.resource->Map(0, &readRange, reinterpret_cast<void**>(&buffer.mapped)));
+        if (initialData)
+        {
+            memcpy(buffer.mapped, initialData, static_cast<size_t>(desc.size));
+        }
+    }
+    else if (initialData)
+    {
+        if (!m_uploader)
+        {
+            ThrowIfFailed(E_NOTIMPL);
+        }
+        const uint32_t destination = m_copyQueue->AddDestination(buffer.resource.Get());
+        m_uploader->Upload(destination, 0, initialData, desc.size);
+        m_copyQueue->GpuWait(m_queue, m_uploader->Flush());
+    }
+
+    BufferHandle handle;
+    handle.index = m_buffers.Add(buffer);
+    return handle;
+}
+
+TextureHandle D3D12RenderDevice::CreateTexture(const TextureDesc& desc)
+{
+    const DXGI_FORMAT format = ToDxgiFormat(desc.format);
+    Texture texture;
+
+    // Textures created in COMMON are implicitly promoted to a shader resource
+    // on first use, so no barrier is needed before sampling them.
+    ThrowIfFailed(m_device->CreateCommittedResource(
+        &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
+        D3D12_HEAP_FLAG_NONE,
+        &CD3DX12_RESOURCE_DESC::Tex2D(format, desc.width, desc.height, 1, static_cast<UINT16>(desc.mipLevels)),
+        D3D12_RESOURCE_STATE_COMMON,
+        nullptr,
+        IID_PPV_ARGS(&texture.resource)));
+
+    D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+    srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+    srvDesc.Format = format;
+    srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
+    srvDesc.Texture2D.MipLevels = desc.mipLevels;
+
+    texture.srvSlot = m_descriptors->CreateShaderResourceView(texture.resource.Get(), &srvDesc);
+    texture.ownsSrv = true;
+
+    TextureHandle handle;
+    handle.index = m_textures.Add(texture);
+    return handle;
+}
+
+PipelineHandle D3D12RenderDevice::CreatePipeline(const PipelineDesc& desc)
+{
+    // The engine's Vertex: position, normal, uv.
+    D3D12_INPUT_ELEMENT_DESC inputElementDescs[] =
+    {
+        { "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+        { "NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 12, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+        { "UV", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 24, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 }
+    };
+
+    if (desc.renderTargetCount > MaxRenderTargets || (desc.fallback.IsValid() && !m_pipelines.Get(desc.fallback.index)))
+    {
+        ThrowIfFailed(E_INVALIDARG);
+    }
+
+    CD3DX12_RASTERIZER_DESC rasterizerDesc(D3D12_DEFAULT);
+    rasterizerDesc.CullMode = D3D12_CULL_MODE_NONE;
+    rasterizerDesc.DepthClipEnable = desc.depthClip ? TRUE : FALSE;
+    rasterizerDesc.DepthBias = desc.depthBias;
+    rasterizerDesc.DepthBiasClamp = desc.depthBiasClamp;
+    rasterizerDesc.SlopeScaledDepthBias = desc.slopeScaledDepthBias;
+
+    CD3DX12_DEPTH_STENCIL_DESC depthStencilDesc(D3D12_DEFAULT);
+    depthStencilDesc.DepthEnable = desc.depthTest ? TRUE : FALSE;
+    depthStencilDesc.DepthWriteMask = desc.depthWrite ? D3D12_DEPTH_WRITE_MASK_ALL : D3D12_DEPTH_WRITE_MASK_ZERO;
+    depthStencilDesc.DepthFunc = ToComparisonFunc(desc.depthFunc);
+    depthStencilDesc.StencilEnable = FALSE;
+
+    D3D12_GRAPHICS_PIPELINE_STATE_DESC psoDesc = {};
+    switch (desc.vertexInput)
+    {
+    case VertexInput::Vertex:       psoDesc.InputLayout = { inputElementDescs, _countof(inputElementDescs) }; break;
+    case VertexInput::PositionOnly: psoDesc.InputLayout = { inputElementDescs, 1 }; break;
+    default:                        psoDesc.InputLayout = { nullptr, 0 }; break;
+    }
+    psoDesc.pRootSignature = m_rootSignature;
+    psoDesc.VS = { desc.vertexShader.data, desc.vertexShader.size };
+    psoDesc.PS = { desc.pixelShader.data, desc.pixelShader.size };
+    psoDesc.RasterizerState = rasterizerDesc;
+    psoDesc.BlendState = CD3DX12_BLEND_DESC(D3D12_DEFAULT);
+    psoDesc.DepthStencilState = depthStencilDesc;
+    psoDesc.SampleMask = UINT_MAX;
+    psoDesc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
+    psoDesc.NumRenderTargets = desc.renderTargetCount;
+    for (uint32_t i = 0; i < desc.renderTargetCount; i++)
+    {
+        psoDesc.RTVFormats[i] = ToDxgiFormat(desc.renderTargetFormats[i]);
+    }
+    psoDesc.DSVFormat = ToDxgiFormat(desc.depthFormat);
+    psoDesc.SampleDesc.Count = 1;
+
+    Pipeline pipeline = { nullptr, D3D12PipelineCache::InvalidPipeline, desc.fallback };
+    if (m_pipelineCache)
+    {
+        pipeline.cachedPipeline = m_pipelineCache->Request(psoDesc);
+    }
+    else
+    {
+        ThrowIfFailed(m_device->CreateGraphicsPipelineState(&psoDesc, IID_PPV_ARGS(&pipeline.pipeline)));
+    }
+
+    PipelineHandle handle;
+    handle.index = m_pipelines.Add(pipeline);
+    return handle;
+}
+
+void D3D12RenderDevice::Destroy(BufferHandle buffer)
+{
+    Buffer& data = GetBuffer(buffer);
+    if (data.mapped)
+    {
+        data.resource->Unmap(0, nullptr);
+    }
+    m_buffers.Remove(buffer.index);
+}
+
+void D3D12RenderDevice::Destroy(TextureHandle texture)
+{
+    // The slot is reused once frames recorded so far are done with it.
+    const Texture& data = GetTexture(texture);
+    if (data.ownsSrv)
+    {
+        m_descriptors->Free(data.srvSlot);
+    }
+    m_textures.Remove(texture.index);
+}
+
+void D3D12RenderDevice::Destroy(PipelineHandle pipeline)
+{
+    if (!m_pipelines.Get(pipeline.index))
+    {
+        ThrowIfFailed(E_INVALIDARG);
+    }
+    m_pipelines.Remove(pipeline.index);
+}
+
+void* D3D12RenderDevice::Map(BufferHandle buffer)
+{
+    Buffer& data = GetBuffer(buffer);
+    if (!data.mapped)
+    {
+        ThrowIfFailed(E_INVALIDARG);
+    }
+    return data.mapped;
+}
+
+std::unique_ptr<IRenderCommandList> D3D12RenderDevice::CreateCommandList()
+{
+    return CreateD3D12CommandList();
+}
+
+std::unique_ptr<IRenderCommandList> D3D12RenderDevice::CreateBundle()
+{
+    return CreateD3D12Bundle();
+}
+
+void D3D12RenderDevice::Submit(IRenderCommandList* const* lists, uint32_t count)
+{
+    std::vector<ID3D12CommandList*> commandLists(count);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        commandLists[i] = static_cast<D3D12RenderCommandList*>(lists[i])->Native();
+    }
+    m_queue->ExecuteCommandLists(count, commandLists.data());
+}
+
+D3D12RenderDevice::Buffer& D3D12RenderDevice::GetBuffer(BufferHandle buffer)
+{
+    Buffer* data = m_buffers.Get(buffer.index);
+    if (!data)
+    {
+        ThrowIfFailed(E_INVALIDARG);
+    }
+    return *data;
+}
+
+D3D12RenderDevice::Texture& D3D12RenderDevice::GetTexture(TextureHandle texture)
+{
+    Texture* data = m_textures.Get(texture.index);
+    if (!data)
+    {
+        ThrowIfFailed(E_INVALIDARG);
+    }
+    return *data;
+}
+
+ID3D12PipelineState* D3D12RenderDevice::GetPipeline(PipelineHandle pipeline)
+{
+    const Pipeline* data = m_pipelines.Get(pipeline.index);
+    if (!data)
+    {
+        ThrowIfFailed(E_INVALIDARG);
+    }
+    if (data->pipeline)
+    {
+        return data->pipeline.Get();
+    }
+
+    // Still compiling: draw with the fallback rather than stall the frame.
+    if (ID3D12PipelineState* ready = m_pipelineCache->TryGet(data->cachedPipeline))
+    {
+        return ready;
+    }
+    if (data->fallback.IsValid())
+    {
+        m_pipelineFallbacks++;
+        return GetPipeline(data->fallback);
+    }
+    return m_pipelineCache->Wait(data->cachedPipeline);
+}
@@ -0,0 +1,144 @@
+#pragma once
+#include "stdafx.h"
+#include "DXSampleHelper.h"
+#include "RenderBackend.h"
+#include "D3D12FenceQueue.h"
+#include "D3D12CopyQueue.h"
+#include "GeometryUploader.h"
+#include "D3D12PipelineCache.h"
+#include "D3D12DescriptorHeap.h"
+
+class D3D12RenderDevice;
+
+// IRenderCommandList over an ID3D12GraphicsCommandList with one allocator per
+// frame in flight (a single one for bundles). Native() gives access to
+// whatever the interface does not cover (render targets, barriers, clears).
+class D3D12RenderCommandList : public IRenderCommandList
+{
+public:
+    D3D12RenderCommandList(D3D12RenderDevice& device, ID3D12Device* d3dDevice, D3D12_COMMAND_LIST_TYPE type, UINT allocatorCount);
+
+    ID3D12GraphicsCommandList* Native() const { return m_commandList.Get(); }
+
+    virtual void Begin(uint32_t frameSlot);
+    virtual void End();
+
+    virtual void SetPipeline(PipelineHandle pipeline);
+    virtual void SetConstantBuffer(uint32_t slot, BufferHandle buffer, uint64_t offset);
+    virtual void SetTexture(uint32_t slot, TextureHandle texture);
+    virtual void SetVertexBuffer(BufferHandle buffer, uint32_t stride, uint64_t offset = 0);
+    virtual void SetIndexBuffer(BufferHandle buffer, uint64_t offset = 0);
+    virtual void SetInstanceBuffer(BufferHandle buffer, uint64_t offset = 0);
+    virtual void SetShaderBuffer(uint32_t slot, BufferHandle buffer, uint64_t offset = 0);
+    virtual void SetViewport(float x, float y, float width, float height);
+
+    virtual void Draw(uint32_t vertexCount, uint32_t instanceCount = 1, uint32_t firstVertex = 0, uint32_t firstInstance = 0);
+    virtual void DrawIndexed(uint32_t indexCount, uint32_t instanceCount = 1, uint32_t firstIndex = 0, int32_t baseVertex = 0, uint32_t firstInstance = 0);
+
+    virtual void ExecuteBundle(IRenderCommandList& bundle);
+
+private:
+    D3D12RenderDevice& m_device;
+    std::vector<ComPtr<ID3D12CommandAllocator>> m_allocators;
+    ComPtr<ID3D12GraphicsCommandList> m_commandList;
+};
+
+// IRenderDevice on the engine's device and direct queue. Pipelines use the
+// engine's root signature (root CBV at parameter 0, texture slot constants at
+// parameter 1, the bindless SRV table at parameter 2, the instance buffer as
+// a root SRV at parameter 3, shader buffers as root SRVs from parameter 4)
+// and texture SRVs are placed in the engine's
+// bindless descriptor heap. Resources
+// the engine already created can be imported so frame code only sees handles.
+class D3D12RenderDevice : public IRenderDevice
+{
+public:
+    D3D12RenderDevice() = default;
+    D3D12RenderDevice(const D3D12RenderDevice& rhs) = delete;
+    D3D12RenderDevice& operator=(const D3D12RenderDevice& rhs) = delete;
+    ~D3D12RenderDevice();
+
+    // SRVs of created textures take persistent slots in descriptors.
+    void Initialize(ID3D12Device* device, ID3D12CommandQueue* queue, D3D12FenceQueue* fences,
+        ID3D12RootSignature* rootSignature, D3D12DescriptorHeap* descriptors, UINT framesInFlight);
+
+    // GpuOnly buffers created with initial data are filled through this uploader.
+    void SetUploader(D3D12CopyQueue* copyQueue, GeometryUploader* uploader);
+
+    // With a cache, CreatePipeline returns at once and the pipeline compiles in
+    // the background; until it is ready SetPipeline binds PipelineDesc::fallback.
+    void SetPipelineCache(D3D12PipelineCache* pipelineCache);
+    uint64_t PipelineFallbacks() const { return m_pipelineFallbacks.load(); }
+    // Blocks until pipeline has compiled, e.g. before it serves as a fallback.
+    void WaitForPipeline(PipelineHandle pipeline);
+
+    BufferHandle ImportBuffer(ID3D12Resource* resource);
+    // srvSlot stays owned by the caller.
+    TextureHandle ImportTexture(ID3D12Resource* resource, UINT srvSlot);
+    PipelineHandle ImportPipeline(ID3D12PipelineState* pipeline);
+    // A pipeline requested from the cache; it may still be compiling.
+    PipelineHandle ImportCachedPipeline(uint32_t cachedPipeline, PipelineHandle fallback = PipelineHandle());
+
+    std::unique_ptr<D3D12RenderCommandList> CreateD3D12CommandList();
+    std::unique_ptr<D3D12RenderCommandList> CreateD3D12Bundle();
+
+    virtual BufferHandle CreateBuffer(const BufferDesc& desc, const void* initialData = nullptr);
+    virtual TextureHandle CreateTexture(const TextureDesc& desc);
+    virtual PipelineHandle CreatePipeline(const PipelineDesc& desc);
+
+    virtual void Destroy(BufferHandle buffer);
+    virtual void Destroy(TextureHandle texture);
+    virtual void Destroy(PipelineHandle pipeline);
+
+    virtual void* Map(BufferHandle buffer);
+
+    virtual std::unique_ptr<IRenderCommandList> CreateCommandList();
+    virtual std::unique_ptr<IRenderCommandList> CreateBundle();
+    virtual void Submit(IRenderCommandList* const* lists, uint32_t count);
+
+    virtual IFenceQueue& Fences() { return *m_fences; }
+
+private:
+    friend class D3D12RenderCommandList;
+
+    struct Buffer
+    {
+        ComPtr<ID3D12Resource> resource;
+        UINT64 size;
+        UINT8* mapped;
+    };
+
+    struct Texture
+    {
+        ComPtr<ID3D12Resource> resource;
+        UINT srvSlot;           // Index into the bindless heap.
+        bool ownsSrv;
+    };
+
+    struct Pipeline
+    {
+        ComPtr<ID3D12PipelineState> pipeline;   // Set for imported and synchronously created pipelines.
+        uint32_t cachedPipeline;
+        PipelineHandle fallback;
+    };
+
+    // Throw E_INVALIDARG for stale or invalid handles.
+    Buffer& GetBuffer(BufferHandle buffer);
+    Texture& GetTexture(TextureHandle texture);
+    ID3D12PipelineState* GetPipeline(PipelineHandle pipeline);
+
+    ID3D12Device* m_device = nullptr;
+    ID3D12CommandQueue* m_queue = nullptr;
+    D3D12FenceQueue* m_fences = nullptr;
+    ID3D12RootSignature* m_rootSignature = nullptr;
+    D3D12DescriptorHeap* m_descriptors = nullptr;
+    UINT m_framesInFlight = 0;
+    D3D12CopyQueue* m_copyQueue = nullptr;
+    GeometryUploader* m_uploader = nullptr;
+    D3D12PipelineCache* m_pipelineCache = nullptr;
+    std::atomic<uint64_t> m_pipelineFallbacks{ 0 };
+
+    RenderResourcePool<Buffer> m_buffers;
+    RenderResourcePool<Texture> m_textures;
+    RenderResourcePool<Pipeline> m_pipelines;
+};
@@ -0,0 +1,111 @@
+#include "stdafx.h"
+#include "D3D12ResourceStates.h"
+
+static_assert(ResourceState::RenderTarget == D3D12_RESOURCE_STATE_RENDER_TARGET, "State values must match D3D12");
+static_assert(ResourceState::UnorderedAccess == D3D12_RESOURCE_STATE_UNORDERED_ACCESS, "State values must match D3D12");
+static_assert(ResourceState::DepthWrite == D3D12_RESOURCE_STATE_DEPTH_WRITE, "State values must match D3D12");
+static_assert(ResourceState::DepthRead == D3D12_RESOURCE_STATE_DEPTH_READ, "State values must match D3D12");
+static_assert(ResourceState::PixelShaderResource == D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, "State values must match D3D12");
+static_assert(ResourceState::CopyDest == D3D12_RESOURCE_STATE_COPY_DEST, "State values must match D3D12");
+static_assert(ResourceState::GenericRead == D3D12_RESOURCE_STATE_GENERIC_READ, "State values must match D3D12");
+static_assert(ResourceStateTracker::AllSubresources == D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES, "Subresource sentinel must match D3D12");
+
+uint32_t D3D12ResourceStates::Register(ID3D12Resource* resource, D3D12_RESOURCE_STATES initialState)
+{
+    const D3D12_RESOURCE_DESC desc = resource->GetDesc();
+    UINT subresourceCount = 1;
+    if (desc.Dimension != D3D12_RESOURCE_DIMENSION_BUFFER)
+    {
+        const UINT arraySize = desc.Dimension == D3D12_RESOURCE_DIMENSION_TEXTURE3D ? 1 : desc.DepthOrArraySize;
+        subresourceCount = desc.MipLevels * arraySize;
+    }
+
+    const uint32_t id = m_tracker.Register(subresourceCount, initialState);
+    if (id >= m_resources.size())
+    {
+        m_resources.resize(id + 1);
+    }
+    m_resources[id] = resource;
+    return id;
+}
+
+void D3D12ResourceStates::Unregister(uint32_t resource)
+{
+    m_tracker.Unregister(resource);
+    if (resource < m_resources.size())
+    {
+        m_resources[resource] = nullptr;
+    }
+}
+
+D3D12_RESOURCE_STATES D3D12ResourceStates::State(uint32_t resource, UINT subresource) const
+{
+    return static_cast<D3D12_RESOURCE_STATES>(m_tracker.State(resource, subresource));
+}
+
+void D3D12ResourceStates::Assume(uint32_t resource, D3D12_RESOURCE_STATES state)
+{
+    m_tracker.Assume(resource, state);
+}
+
+void D3D12ResourceStates::Transition(uint32_t resource, D3D12_RESOURCE_STATES after, UINT subresource)
+{
+    m_tracker.Transition(resource, after, subresource);
+}
+
+void D3D12ResourceStates::BeginTransition(uint32_t resource, D3D12_RESOURCE_STATES after)
+{
+    m_tracker.BeginTransition(resource, after);
+}
+
+void D3D12ResourceStates::UavBarrier(uint32_t resource)
+{
+    m_tracker.UnorderedAccessBarrier(resource);
+}
+
+void D3D12ResourceStates::Flush(ID3D12GraphicsCommandList* commandList)
+{
+    const std::vector<ResourceBarrierDesc>& batch = m_tracker.Flush();
+    RecordResourceBarriers(commandList, batch.data(), batch.size(), m_resources.data(), m_barriers);
+}
+
+void RecordResourceBarriers(ID3D12GraphicsCommandList* commandList, const ResourceBarrierDesc* barriers, size_t count,
+    ID3D12Resource* const* resources, std::vector<D3D12_RESOURCE_BARRIER>& scratch)
+{
+    if (count == 0)
+    {
+        return;
+    }
+
+    scratch.resize(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        const ResourceBarrierDesc& desc = barriers[i];
+        ID3D12Resource* resource = resources[desc.resource];
+        if (desc.type == ResourceBarrierDesc::Type::UnorderedAccess)
+        {
+            scratch[i] = CD3DX12_RESOURCE_BARRIER::UAV(resource);
+            continue;
+        }
+        if (desc.type == ResourceBarrierDesc::Type::Aliasing)
+        {
+            // No "before" resource: whichever one last used the memory.
+            scratch[i] = CD3DX12_RESOURCE_BARRIER::Aliasing(nullptr, resource);
+            continue;
+        }
+
+        D3D12_RESOURCE_BARRIER_FLAGS flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+        if (desc.split == ResourceBarrierDesc::Split::BeginOnly)
+        {
+            flags = D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY;
+        }
+        else if (desc.split == ResourceBarrierDesc::Split::EndOnly)
+        {
+            flags = D3D12_RESOURCE_BARRIER_FLAG_END_ONLY;
+        }
+        scratch[i] = CD3DX12_RESOURCE_BARRIER::Transition(resource,
+            static_cast<D3D12_RESOURCE_STATES>(desc.before), static_cast<D3D12_RESOURCE_STATES>(desc.after),
+            desc.subresource, flags);
+    }
+    commandList->ResourceBarrier(static_cast<UINT>(count), scratch.data());
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include "stdafx.h"
+#include "DXSampleHelper.h"
+#include "ResourceStateTracker.h"
+
+// Records count barriers with a single ResourceBarrier call. resources maps the
+// ids in the descs to D3D12 resources; scratch is reused between calls.
+void RecordResourceBarriers(ID3D12GraphicsCommandList* commandList, const ResourceBarrierDesc* barriers, size_t count,
+    ID3D12Resource* const* resources, std::vector<D3D12_RESOURCE_BARRIER>& scratch);
+
+// ResourceStateTracker over ID3D12Resources. Barriers requested between two
+// Flush calls are recorded with a single ResourceBarrier call.
+//
+// States are tracked in recording order, so lists that transition resources
+// must be recorded in the order they are submitted.
+class D3D12ResourceStates
+{
+public:
+    uint32_t Register(ID3D12Resource* resource, D3D12_RESOURCE_STATES initialState);
+    void Unregister(uint32_t resource);
+
+    D3D12_RESOURCE_STATES State(uint32_t resource, UINT subresource = 0) const;
+    void Assume(uint32_t resource, D3D12_RESOURCE_STATES state);
+
+    void Transition(uint32_t resource, D3D12_RESOURCE_STATES after, UINT subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES);
+    void BeginTransition(uint32_t resource, D3D12_RESOURCE_STATES after);
+    void UavBarrier(uint32_t resource);
+
+    // Records the pending barriers, if any, into commandList.
+    void Flush(ID3D12GraphicsCommandList* commandList);
+
+    const ResourceStateTracker::Stats& GetStats() const { return m_tracker.GetStats(); }
+
+private:
+    ResourceStateTracker m_tracker;
+    std::vector<ID3D12Resource*> m_resources;
+    std::vector<D3D12_RESOURCE_BARRIER> m_barriers;
+};
@@ -0,0 +1,92 @@
+#include "stdafx.h"
+#include "D3D12ShaderCompiler.h"
+#include <fstream>
+#include <sstream>
+
+namespace
+{
+    std::string ToUtf8(const std::wstring& text)
+    {
+        const int length = WideCharToMultiByte(CP_UTF8, 0, text.c_str(), static_cast<int>(text.size()), nullptr, 0, nullptr, nullptr);
+        std::string result(length, '\0');
+        WideCharToMultiByte(CP_UTF8, 0, text.c_str(), static_cast<int>(text.size()), &result[0], length, nullptr, nullptr);
+        return result;
+    }
+
+    std::wstring FromUtf8(const std::string& text)
+    {
+        const int length = MultiByteToWideChar(CP_UTF8, 0, text.c_str(), static_cast<int>(text.size()), nullptr, 0);
+        std::wstring result(length, L'\0');
+        MultiByteToWideChar(CP_UTF8, 0, text.c_str(), static_cast<int>(text.size()), &result[0], length);
+        return result;
+    }
+
+    bool ReadTextFile(const std::string& path, std::string& contents)
+    {
+        std::ifstream file(FromUtf8(path), std::ios::binary);
+        if (!file)
+        {
+            return false;
+        }
+        std::ostringstream stream;
+        stream << file.rdbuf();
+        contents = stream.str();
+        return true;
+    }
+
+    bool CompileWithD3D(const ShaderCompileRequest& request, std::vector<uint8_t>& bytecode, std::string& errors)
+    {
+        std::vector<D3D_SHADER_MACRO> macros;
+        for (const ShaderDefine& define : request.defines)
+        {
+            D3D_SHADER_MACRO macro = { define.name.c_str(), define.value.c_str() };
+            macros.push_back(macro);
+        }
+        D3D_SHADER_MACRO terminator = { nullptr, nullptr };
+        macros.push_back(terminator);
+
+        ComPtr<ID3DBlob> code;
+        ComPtr<ID3DBlob> messages;
+        const HRESULT hr = D3DCompile(request.source.data(), request.source.size(), request.sourcePath.c_str(), macros.data(),
+            D3D_COMPILE_STANDARD_FILE_INCLUDE, request.entryPoint.c_str(), request.target.c_str(), request.flags, 0, &code, &messages);
+        if (messages)
+        {
+            errors.assign(static_cast<const char*>(messages->GetBufferPointer()), messages->GetBufferSize());
+        }
+        if (FAILED(hr))
+        {
+            return false;
+        }
+
+        const uint8_t* data = static_cast<const uint8_t*>(code->GetBufferPointer());
+        bytecode.assign(data, data + code->GetBufferSize());
+        return true;
+    }
+}
+
+void D3D12ShaderCompiler::Initialize(const std::wstring& cachePath)
+{
+    m_cache = ShaderCache(ToUtf8(cachePath));
+    m_cache.Load();
+}
+
+const std::vector<uint8_t>& D3D12ShaderCompiler::Compile(const std::wstring& path, const char* entryPoint, const char* target, UINT flags,
+    const std::vector<ShaderDefine>& defines)
+{
+    ShaderCompileRequest request;
+    request.sourcePath = ToUtf8(path);
+    if (!ReadTextFile(request.sourcePath, request.source))
+    {
+        ThrowIfFailed(HRESULT_FROM_WIN32(ERROR_FILE_NOT_FOUND));
+    }
+    request.defines = defines;
+    request.entryPoint = entryPoint;
+    request.target = target;
+    request.flags = flags;
+    return m_cache.GetOrCompile(request, ReadTextFile, CompileWithD3D);
+}
+
+void D3D12ShaderCompiler::Save()
+{
+    m_cache.Save();
+}
@@ -0,0 +1,25 @@
+#pragma once
+#include "stdafx.h"
+#include "DXSampleHelper.h"
+#include "ShaderCache.h"
+
+// Compiles HLSL with D3DCompile behind a persistent ShaderCache, so shaders
+// are only compiled when their source, includes or options change.
+class D3D12ShaderCompiler
+{
+public:
+    // Loads the cache file at cachePath; it is created on the first Save.
+    void Initialize(const std::wstring& cachePath);
+
+    // The bytecode stays valid until the same shader is compiled again.
+    // Throws std::runtime_error with the compiler output on errors.
+    const std::vector<uint8_t>& Compile(const std::wstring& path, const char* entryPoint, const char* target, UINT flags,
+        const std::vector<ShaderDefine>& defines = std::vector<ShaderDefine>());
+
+    void Save();
+
+    const ShaderCache::Stats& GetStats() const { return m_cache.GetStats(); }
+
+private:
+    ShaderCache m_cache;
+};
@@ -0,0 +1,124 @@
+#include "DescriptorAllocator.h"
+#include <stdexcept>
+
+DescriptorAllocator::DescriptorAllocator(uint32_t persistentCount, uint32_t transientPerFrame, uint32_t framesInFlight) :
+    m_persistentCount(persistentCount),
+    m_transientPerFrame(transientPerFrame),
+    m_framesInFlight(framesInFlight),
+    m_head(Pack(0, persistentCount ? 0 : InvalidSlot)),
+    m_next(new std::atomic<uint32_t>[persistentCount ? persistentCount : 1])
+{
+    if (framesInFlight == 0 || static_cast<uint64_t>(persistentCount) + static_cast<uint64_t>(transientPerFrame) * framesInFlight >= InvalidSlot)
+    {
+        throw std::invalid_argument("DescriptorAllocator: invalid layout");
+    }
+
+    // Slots are handed out lowest first.
+    for (uint32_t i = 0; i < persistentCount; i++)
+    {
+        m_next[i].store(i + 1 < persistentCount ? i + 1 : InvalidSlot, std::memory_order_relaxed);
+    }
+    m_transientBase = persistentCount;
+}
+
+uint32_t DescriptorAllocator::Allocate()
+{
+    uint64_t head = m_head.load(std::memory_order_acquire);
+    for (;;)
+    {
+        const uint32_t slot = static_cast<uint32_t>(head);
+        if (slot == InvalidSlot)
+        {
+            return InvalidSlot;
+        }
+
+        // May read a stale link if another thread pops slot first; the tag
+        // check below then fails and the loop retries with the new head.
+        const uint32_t next = m_next[slot].load(std::memory_order_relaxed);
+        if (m_head.compare_exchange_weak(head, Pack(static_cast<uint32_t>(head >> 32) + 1, next),
+            std::memory_order_acquire, std::memory_order_acquire))
+        {
+            m_persistentInUse.fetch_add(1, std::memory_order_relaxed);
+            return slot;
+        }
+    }
+}
+
+void DescriptorAllocator::Free(uint32_t slot)
+{
+    if (slot >= m_persistentCount)
+    {
+        throw std::out_of_range("DescriptorAllocator: not a persistent slot");
+    }
+
+    uint64_t head = m_head.load(std::memory_order_relaxed);
+    for (;;)
+    {
+        m_next[slot].store(static_cast<uint32_t>(head), std::memory_order_relaxed);
+        if (m_head.compare_exchange_weak(head, Pack(static_cast<uint32_t>(head >> 32) + 1, slot),
+            std::memory_order_release, std::memory_order_relaxed))
+        {
+            m_persistentInUse.fetch_sub(1, std::memory_order_relaxed);
+            return;
+        }
+    }
+}
+
+void DescriptorAllocator::Free(uint32_t slot, uint64_t fenceValue)
+{
+    if (slot >= m_persistentCount)
+    {
+        throw std::out_of_range("DescriptorAllocator: not a persistent slot");
+    }
+
+    std::lock_guard<std::mutex> lock(m_pendingMutex);
+    PendingFree pending = { fenceValue, slot };
+    m_pending.push_back(pending);
+}
+
+void DescriptorAllocator::Retire(uint64_t completedFenceValue)
+{
+    std::lock_guard<std::mutex> lock(m_pendingMutex);
+
+    // Frees arrive in fence order from the render thread, but loader threads
+    // may interleave, so scan rather than stopping at the first pending one.
+    size_t kept = 0;
+    for (size_t i = 0; i < m_pending.size(); i++)
+    {
+        if (m_pending[i].fenceValue <= completedFenceValue)
+        {
+            Free(m_pending[i].slot);
+        }
+        else
+        {
+            m_pending[kept++] = m_pending[i];
+        }
+    }
+    m_pending.resize(kept);
+}
+
+void DescriptorAllocator::BeginFrame(uint32_t frameSlot)
+{
+    if (frameSlot >= m_framesInFlight)
+    {
+        throw std::out_of_range("DescriptorAllocator: frame slot out of range");
+    }
+    m_transientBase = m_persistentCount + frameSlot * m_transientPerFrame;
+    m_transientOffset.store(0, std::memory_order_relaxed);
+}
+
+uint32_t DescriptorAllocator::AllocateTransient(uint32_t count)
+{
+    const uint32_t offset = m_transientOffset.fetch_add(count, std::memory_order_relaxed);
+    if (count > m_transientPerFrame || offset > m_transientPerFrame - count)
+    {
+        return InvalidSlot;
+    }
+    return m_transientBase + offset;
+}
+
+uint32_t DescriptorAllocator::TransientInUse() const
+{
+    const uint32_t offset = m_transientOffset.load(std::memory_order_relaxed);
+    return offset < m_transientPerFrame ? offset : m_transientPerFrame;
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+
+// Hands out slots of one large bindless descriptor heap. It only deals in
+// indices, so it is backend agnostic; see D3D12DescriptorHeap for the heap.
+//
+// The heap is split into two parts:
+//  - persistent slots [0, persistentCount) for textures and buffers that live
+//    across frames, kept on a lock-free free list so loader threads can
+//    allocate and free without a lock;
+//  - framesInFlight regions of transientPerFrame slots after them, bump
+//    allocated for descriptors that only live for one frame and reset
+//    wholesale when the frame slot comes around again.
+//
+// Shaders index the heap with the slot number directly.
+class DescriptorAllocator
+{
+public:
+    static const uint32_t InvalidSlot = ~0u;
+
+    DescriptorAllocator(uint32_t persistentCount, uint32_t transientPerFrame, uint32_t framesInFlight);
+    DescriptorAllocator(const DescriptorAllocator& rhs) = delete;
+    DescriptorAllocator& operator=(const DescriptorAllocator& rhs) = delete;
+
+    uint32_t Capacity() const { return m_persistentCount + m_transientPerFrame * m_framesInFlight; }
+    uint32_t PersistentCount() const { return m_persistentCount; }
+    uint32_t PersistentInUse() const { return m_persistentInUse.load(std::memory_order_relaxed); }
+
+    // Lock-free. Returns InvalidSlot when every persistent slot is taken.
+    uint32_t Allocate();
+    // Lock-free. The slot may be handed out again at once, so only use this
+    // when the GPU cannot still be reading the descriptor.
+    void Free(uint32_t slot);
+    // Returns slot to the free list once Retire sees fenceValue complete.
+    void Free(uint32_t slot, uint64_t fenceValue);
+    void Retire(uint64_t completedFenceValue);
+
+    // Starts bump allocating from frameSlot's region. As with FramePacer, the
+    // caller guarantees the GPU has finished the frame that last used it.
+    // Must not run concurrently with AllocateTransient.
+    void BeginFrame(uint32_t frameSlot);
+    // Lock-free. Returns the first of count consecutive slots, or InvalidSlot
+    // when this frame's region is exhausted.
+    uint32_t AllocateTransient(uint32_t count = 1);
+    uint32_t TransientInUse() const;
+
+private:
+    static uint64_t Pack(uint32_t tag, uint32_t slot) { return (static_cast<uint64_t>(tag) << 32) | slot; }
+
+    struct PendingFree
+    {
+        uint64_t fenceValue;
+        uint32_t slot;
+    };
+
+    uint32_t m_persistentCount;
+    uint32_t m_transientPerFrame;
+    uint32_t m_framesInFlight;
+
+    // Treiber stack threaded through m_next. The head carries a tag that
+    // changes on every update, so a pop racing with pop+push of the same slot
+    // (ABA) fails its compare-exchange instead of corrupting the list.
+    std::atomic<uint64_t> m_head;
+    std::unique_ptr<std::atomic<uint32_t>[]> m_next;
+    std::atomic<uint32_t> m_persistentInUse{ 0 };
+
+    std::mutex m_pendingMutex;
+    std::deque<PendingFree> m_pending;
+
+    uint32_t m_transientBase = 0;
+    std::atomic<uint32_t> m_transientOffset{ 0 };
+};
@@ -0,0 +1,51 @@
+#include "DrawList.h"
+
+void BindDrawList(IRenderCommandList& commandList, const DrawListBindings& bindings)
+{
+    commandList.SetConstantBuffer(0, bindings.sceneConstants, bindings.sceneConstantsOffset);
+    if (bindings.shadowMap.IsValid())
+    {
+        commandList.SetTexture(2, bindings.shadowMap);
+    }
+    if (bindings.lights.IsValid())
+    {
+        commandList.SetShaderBuffer(0, bindings.lights, bindings.lightsOffset);
+        commandList.SetShaderBuffer(1, bindings.lights, bindings.lightClustersOffset);
+        commandList.SetShaderBuffer(2, bindings.lights, bindings.lightIndicesOffset);
+    }
+}
+
+void RecordDrawList(IRenderCommandList& commandList, const DrawListBindings& bindings, const DrawItem* items, size_t count)
+{
+    BindDrawList(commandList, bindings);
+    RecordDrawItems(commandList, items, count);
+}
+
+void RecordDrawItems(IRenderCommandList& commandList, const DrawItem* items, size_t count)
+{
+    // Only state that differs from the previous draw is bound; sorted lists
+    // (see DrawQueue) keep most of it unchanged from draw to draw.
+    const DrawItem* previous = nullptr;
+    for (size_t i = 0; i < count; i++)
+    {
+        const DrawItem& item = items[i];
+        if (!previous || item.pipeline != previous->pipeline)
+        {
+            commandList.SetPipeline(item.pipeline);
+        }
+        if (!previous || item.albedo != previous->albedo)
+        {
+            commandList.SetTexture(0, item.albedo);
+        }
+        if (!previous || item.vertexBuffer != previous->vertexBuffer || item.vertexStride != previous->vertexStride)
+        {
+            commandList.SetVertexBuffer(item.vertexBuffer, item.vertexStride);
+        }
+        if (!previous || item.instanceBuffer != previous->instanceBuffer || item.instanceOffset != previous->instanceOffset)
+        {
+            commandList.SetInstanceBuffer(item.instanceBuffer, item.instanceOffset);
+        }
+        commandList.Draw(item.vertexCount, item.instanceCount, item.firstVertex, 0);
+        previous = &item;
+    }
+}
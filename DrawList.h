@@ -0,0 +1,42 @@
+#pragma once
+
+#include "RenderBackend.h"
+
+// One draw of the scene, expressed in backend handles so the same list can be
+// recorded into a D3D12 or a null command list.
+struct DrawItem
+{
+    PipelineHandle pipeline;
+    TextureHandle albedo;
+    BufferHandle vertexBuffer;
+    uint32_t vertexStride = 0;
+    uint32_t vertexCount = 0;
+    uint32_t firstVertex = 0;
+    // instanceCount InstanceData records at instanceOffset; see InstanceBatcher.
+    BufferHandle instanceBuffer;
+    uint64_t instanceOffset = 0;
+    uint32_t instanceCount = 1;
+};
+
+// Per-frame data bound once before the draws.
+struct DrawListBindings
+{
+    BufferHandle sceneConstants;
+    uint64_t sceneConstantsOffset = 0;
+    TextureHandle shadowMap;                // Texture slot 2 when valid.
+    // Clustered lights, bound to shader buffer slots 0 to 2 when valid. The
+    // three arrays share one buffer.
+    BufferHandle lights;
+    uint64_t lightsOffset = 0;
+    uint64_t lightClustersOffset = 0;
+    uint64_t lightIndicesOffset = 0;
+};
+
+// Binds the per-frame data.
+void BindDrawList(IRenderCommandList& commandList, const DrawListBindings& bindings);
+
+// Binds the per-frame data, then records the draws.
+void RecordDrawList(IRenderCommandList& commandList, const DrawListBindings& bindings, const DrawItem* items, size_t count);
+
+// Records only the draws, e.g. into a bundle that inherits the bindings.
+void RecordDrawItems(IRenderCommandList& commandList, const DrawItem* items, size_t count);
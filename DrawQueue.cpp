@@ -0,0 +1,43 @@
+#include "DrawQueue.h"
+
+namespace DrawSortKey
+{
+    uint32_t DepthBucket(float viewDepth, float nearZ, float farZ, bool backToFront)
+    {
+        const uint32_t maxBucket = (1u << DepthBits) - 1;
+        float t = farZ > nearZ ? (viewDepth - nearZ) / (farZ - nearZ) : 0.0f;
+        t = t < 0.0f ? 0.0f : (t > 1.0f ? 1.0f : t);
+        const uint32_t bucket = static_cast<uint32_t>(t * maxBucket + 0.5f);
+        return backToFront ? maxBucket - bucket : bucket;
+    }
+
+    uint64_t ForItem(uint32_t pass, const DrawItem& item, uint32_t depthBucket)
+    {
+        return Make(pass, item.pipeline.index, item.albedo.index, depthBucket, item.vertexBuffer.index);
+    }
+}
+
+void DrawQueue::Reset()
+{
+    m_items.clear();
+    m_entries.clear();
+    m_sorted.clear();
+}
+
+void DrawQueue::Submit(uint64_t key, const DrawItem& item)
+{
+    RadixSortEntry entry = { key, static_cast<uint32_t>(m_items.size()) };
+    m_entries.push_back(entry);
+    m_items.push_back(item);
+}
+
+void DrawQueue::Sort(JobSystem* jobs)
+{
+    RadixSort(m_entries, m_scratch, jobs);
+
+    m_sorted.resize(m_items.size());
+    for (size_t i = 0; i < m_entries.size(); i++)
+    {
+        m_sorted[i] = m_items[m_entries[i].value];
+    }
+}
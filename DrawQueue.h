@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "DrawList.h"
+#include "RadixSort.h"
+
+// 64-bit draw sort keys. Fields from most to least significant:
+//
+//     pass (4) | pipeline (12) | material (16) | depth bucket (16) | mesh (16)
+//
+// so sorted draws are grouped by pass, then pipeline, then material, which
+// are the expensive state changes, and within a material go front to back
+// (or back to front) with draws of the same mesh next to each other.
+namespace DrawSortKey
+{
+    const unsigned PassBits = 4;
+    const unsigned PipelineBits = 12;
+    const unsigned MaterialBits = 16;
+    const unsigned DepthBits = 16;
+    const unsigned MeshBits = 16;
+
+    // Fields wider than their bits are truncated.
+    inline uint64_t Make(uint32_t pass, uint32_t pipeline, uint32_t material, uint32_t depth, uint32_t mesh)
+    {
+        uint64_t key = pass & ((1u << PassBits) - 1);
+        key = (key << PipelineBits) | (pipeline & ((1u << PipelineBits) - 1));
+        key = (key << MaterialBits) | (material & ((1u << MaterialBits) - 1));
+        key = (key << DepthBits) | (depth & ((1u << DepthBits) - 1));
+        key = (key << MeshBits) | (mesh & ((1u << MeshBits) - 1));
+        return key;
+    }
+
+    // Quantizes view-space depth in [nearZ, farZ]; backToFront inverts the
+    // order, for blended draws.
+    uint32_t DepthBucket(float viewDepth, float nearZ, float farZ, bool backToFront = false);
+
+    // The key for item: pipeline, albedo texture and vertex buffer indices.
+    uint64_t ForItem(uint32_t pass, const DrawItem& item, uint32_t depthBucket);
+}
+
+// Draws submitted in any order (possibly from several threads' results
+// concatenated) and recorded in sort key order.
+class DrawQueue
+{
+public:
+    void Reset();
+    void Submit(uint64_t key, const DrawItem& item);
+
+    // Orders the draws by key, on jobs when there are many; ties keep
+    // submission order.
+    void Sort(JobSystem* jobs = &JobSystem::Get());
+
+    // Sorted after Sort.
+    const DrawItem* Items() const { return m_sorted.data(); }
+    size_t Count() const { return m_sorted.size(); }
+
+private:
+    std::vector<DrawItem> m_items;
+    std::vector<DrawItem> m_sorted;
+    std::vector<RadixSortEntry> m_entries;
+    RadixSortScratch m_scratch;
+};
@@ -0,0 +1,46 @@
+#include "DynamicResolution.h"
+#include <algorithm>
+#include <cmath>
+
+DynamicResolutionController::DynamicResolutionController(const DynamicResolutionSettings& settings) :
+    m_settings(settings)
+{
+    Reset();
+}
+
+void DynamicResolutionController::Reset()
+{
+    m_scale = m_settings.maxScale;
+    m_area = m_scale * m_scale;
+    m_previousError = 0.0f;
+    m_olderError = 0.0f;
+}
+
+float DynamicResolutionController::Update(float gpuMilliseconds)
+{
+    if (gpuMilliseconds < 0.0f)
+    {
+        return m_scale;
+    }
+
+    // Beyond twice the budget the frame is simply too slow; a larger error
+    // would only make the loop overreact to a single hitch.
+    const float error = std::max((m_settings.budgetMilliseconds - gpuMilliseconds) / m_settings.budgetMilliseconds, -1.0f);
+    const float change = m_settings.proportionalGain * (error - m_previousError) +
+        m_settings.integralGain * error +
+        m_settings.derivativeGain * (error - 2.0f * m_previousError + m_olderError);
+    m_olderError = m_previousError;
+    m_previousError = error;
+
+    const float minArea = m_settings.minScale * m_settings.minScale;
+    const float maxArea = m_settings.maxScale * m_settings.maxScale;
+    m_area = std::min(std::max(m_area * (1.0f + change), minArea), maxArea);
+    m_scale = std::sqrt(m_area);
+    return m_scale;
+}
+
+void DynamicResolutionController::ScaledSize(uint32_t width, uint32_t height, float scale, uint32_t& scaledWidth, uint32_t& scaledHeight)
+{
+    scaledWidth = std::min(std::max(static_cast<uint32_t>(width * scale + 0.5f), 1u), width);
+    scaledHeight = std::min(std::max(static_cast<uint32_t>(height * scale + 0.5f), 1u), height);
+}
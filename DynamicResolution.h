@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+
+// Dynamic resolution: the scene is rendered into part of a full size target,
+// at a scale (per axis) picked from the measured GPU time of past frames,
+// and upscaled to the back buffer. The target never changes size, so a new
+// scale only changes the viewport.
+
+struct DynamicResolutionSettings
+{
+    float budgetMilliseconds = 14.0f;   // GPU time to aim for.
+    float minScale = 0.5f;
+    float maxScale = 1.0f;
+
+    // Gains of the PID loop. The error is how far below the budget a frame
+    // came in, as a fraction of the budget; the output is a relative change
+    // of the rendered area, which GPU time is roughly proportional to.
+    float proportionalGain = 0.2f;
+    float integralGain = 0.15f;
+    float derivativeGain = 0.05f;
+};
+
+// PID controller from GPU frame time to resolution scale. It runs in
+// velocity form (each update changes the area by the PID of the error's
+// changes), so clamping the area to the scale range needs no separate
+// integral windup handling. Pure arithmetic, so the tests drive it with
+// synthetic frame times.
+class DynamicResolutionController
+{
+public:
+    explicit DynamicResolutionController(const DynamicResolutionSettings& settings = DynamicResolutionSettings());
+
+    const DynamicResolutionSettings& Settings() const { return m_settings; }
+
+    // Back to the largest scale, forgetting past errors.
+    void Reset();
+
+    // Feeds the GPU time of one frame, rendered at whatever scale was current
+    // then, and returns the scale for the next. A negative time (no
+    // measurement yet) leaves the scale unchanged.
+    float Update(float gpuMilliseconds);
+    float Scale() const { return m_scale; }
+
+    // Pixels rendered at scale within a width by height target; at least 1x1.
+    static void ScaledSize(uint32_t width, uint32_t height, float scale, uint32_t& scaledWidth, uint32_t& scaledHeight);
+
+private:
+    DynamicResolutionSettings m_settings;
+    float m_area = 1.0f;                // Rendered fraction of the target, scale squared.
+    float m_scale = 1.0f;
+    float m_previousError = 0.0f;
+    float m_olderError = 0.0f;
+};
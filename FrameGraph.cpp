@@ -0,0 +1,390 @@
+#include "FrameGraph.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace
+{
+    const uint64_t DefaultPlacementAlignment = 64 * 1024;
+
+    uint64_t AlignUp(uint64_t value, uint64_t alignment)
+    {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    FrameGraphMemoryInfo EstimateMemory(const FrameGraphTextureDesc& desc)
+    {
+        const uint64_t bytes = static_cast<uint64_t>(desc.width) * desc.height * desc.arraySize * desc.bytesPerTexel;
+        FrameGraphMemoryInfo info = { AlignUp(bytes, DefaultPlacementAlignment), DefaultPlacementAlignment };
+        return info;
+    }
+}
+
+//------------------------------------------------------------------------------------------------
+// Declaration
+
+FrameGraphResource FrameGraph::Builder::Create(const char* name, const FrameGraphTextureDesc& desc)
+{
+    ResourceInfo resource;
+    resource.name = name;
+    resource.desc = desc;
+    m_graph.m_resources.push_back(resource);
+    return static_cast<FrameGraphResource>(m_graph.m_resources.size() - 1);
+}
+
+void FrameGraph::Builder::Read(FrameGraphResource resource, ResourceStates state)
+{
+    m_graph.AddAccess(m_pass, resource, state, false);
+}
+
+void FrameGraph::Builder::Write(FrameGraphResource resource, ResourceStates state)
+{
+    m_graph.AddAccess(m_pass, resource, state, true);
+}
+
+void FrameGraph::Builder::SideEffect()
+{
+    m_graph.m_passes[m_pass].sideEffect = true;
+}
+
+void FrameGraph::Reset()
+{
+    m_passes.clear();
+    m_resources.clear();
+    m_schedule.clear();
+    m_passBarriers.clear();
+    m_finalBarriers.clear();
+    m_stats = Stats();
+}
+
+FrameGraphResource FrameGraph::Import(const char* name, ResourceStates initialState, ResourceStates finalState)
+{
+    ResourceInfo resource;
+    resource.name = name;
+    resource.imported = true;
+    resource.restState = initialState;
+    resource.finalState = finalState;
+    m_resources.push_back(resource);
+    return static_cast<FrameGraphResource>(m_resources.size() - 1);
+}
+
+uint32_t FrameGraph::AddPass(const char* name, const SetupCallback& setup, const ExecuteCallback& execute)
+{
+    const uint32_t pass = static_cast<uint32_t>(m_passes.size());
+    m_passes.emplace_back();
+    m_passes[pass].name = name;
+    m_passes[pass].execute = execute;
+
+    Builder builder(*this, pass);
+    setup(builder);
+    return pass;
+}
+
+void FrameGraph::AddAccess(uint32_t pass, FrameGraphResource resource, ResourceStates state, bool write)
+{
+    if (resource >= m_resources.size())
+    {
+        throw std::logic_error("FrameGraph: unknown resource in pass " + m_passes[pass].name);
+    }
+
+    // A pass uses each resource in a single state for its whole duration.
+    for (Access& access : m_passes[pass].accesses)
+    {
+        if (access.resource != resource)
+        {
+            continue;
+        }
+        if (access.write && write && access.state != state)
+        {
+            throw std::logic_error("FrameGraph: conflicting writes to " + m_resources[resource].name + " in pass " + m_passes[pass].name);
+        }
+        if (write || access.write)
+        {
+            // The write state covers reading too (depth test, blending, ...).
+            access.state = write ? state : access.state;
+            access.write = true;
+            return;
+        }
+        const ResourceStates combined = access.state | state;
+        if (combined != state && combined != access.state && (combined & ~ResourceState::ReadOnly) != 0)
+        {
+            throw std::logic_error("FrameGraph: conflicting reads of " + m_resources[resource].name + " in pass " + m_passes[pass].name);
+        }
+        access.state = combined;
+        return;
+    }
+
+    Access access = { resource, state, write };
+    m_passes[pass].accesses.push_back(access);
+}
+
+//------------------------------------------------------------------------------------------------
+// Compilation
+
+void FrameGraph::Compile(const MemoryQuery& query)
+{
+    m_stats = Stats();
+    Cull();
+    ComputeLifetimes();
+    PlaceTransients(query);
+    BuildBarriers();
+}
+
+void FrameGraph::Cull()
+{
+    // Walk backwards so every reader is seen before the writers it keeps alive.
+    std::vector<bool> needed(m_resources.size(), false);
+    std::vector<bool> kept(m_passes.size(), false);
+    for (size_t p = m_passes.size(); p-- > 0;)
+    {
+        const Pass& pass = m_passes[p];
+        bool keep = pass.sideEffect;
+        for (const Access& access : pass.accesses)
+        {
+            keep = keep || (access.write && (m_resources[access.resource].imported || needed[access.resource]));
+        }
+        if (!keep)
+        {
+            continue;
+        }
+
+        kept[p] = true;
+        for (const Access& access : pass.accesses)
+        {
+            if (!access.write)
+            {
+                needed[access.resource] = true;
+            }
+        }
+    }
+
+    m_schedule.clear();
+    for (uint32_t p = 0; p < m_passes.size(); p++)
+    {
+        if (kept[p])
+        {
+            m_schedule.push_back(p);
+        }
+    }
+    m_stats.passes = static_cast<uint32_t>(m_schedule.size());
+    m_stats.culledPasses = static_cast<uint32_t>(m_passes.size() - m_schedule.size());
+}
+
+void FrameGraph::ComputeLifetimes()
+{
+    for (ResourceInfo& resource : m_resources)
+    {
+        resource.used = false;
+        resource.usage = 0;
+    }
+
+    for (uint32_t i = 0; i < m_schedule.size(); i++)
+    {
+        const Pass& pass = m_passes[m_schedule[i]];
+        for (const Access& access : pass.accesses)
+        {
+            ResourceInfo& resource = m_resources[access.resource];
+            if (!resource.used)
+            {
+                if (!resource.imported)
+                {
+                    if (!access.write)
+                    {
+                        throw std::logic_error("FrameGraph: " + resource.name + " is read by " + pass.name + " before anything writes it");
+                    }
+                    resource.restState = access.state;
+                }
+                resource.used = true;
+                resource.firstPass = i;
+            }
+            resource.lastPass = i;
+            resource.usage |= access.state;
+        }
+    }
+}
+
+bool FrameGraph::SharesMemory(FrameGraphResource resource) const
+{
+    const ResourceInfo& info = m_resources[resource];
+    for (FrameGraphResource other = 0; other < m_resources.size(); other++)
+    {
+        const ResourceInfo& rhs = m_resources[other];
+        if (other != resource && rhs.used && !rhs.imported &&
+            rhs.heapOffset < info.heapOffset + info.size && info.heapOffset < rhs.heapOffset + rhs.size)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void FrameGraph::PlaceTransients(const MemoryQuery& query)
+{
+    std::vector<FrameGraphResource> transients;
+    std::vector<uint64_t> alignments(m_resources.size(), DefaultPlacementAlignment);
+    for (FrameGraphResource r = 0; r < m_resources.size(); r++)
+    {
+        ResourceInfo& resource = m_resources[r];
+        if (!resource.used || resource.imported)
+        {
+            continue;
+        }
+
+        const FrameGraphMemoryInfo memory = query ? query(resource.desc, resource.usage) : EstimateMemory(resource.desc);
+        resource.size = memory.size;
+        alignments[r] = std::max<uint64_t>(memory.alignment, 1);
+        transients.push_back(r);
+        m_stats.unaliasedBytes += AlignUp(memory.size, alignments[r]);
+    }
+    m_stats.transientResources = static_cast<uint32_t>(transients.size());
+
+    // Largest first: big targets claim the low offsets and small ones fill the
+    // gaps between them.
+    std::sort(transients.begin(), transients.end(), [this](FrameGraphResource a, FrameGraphResource b)
+    {
+        if (m_resources[a].size != m_resources[b].size)
+        {
+            return m_resources[a].size > m_resources[b].size;
+        }
+        return m_resources[a].firstPass < m_resources[b].firstPass;
+    });
+
+    struct Range
+    {
+        uint64_t begin;
+        uint64_t end;
+    };
+    std::vector<FrameGraphResource> placed;
+    std::vector<Range> busy;
+    for (FrameGraphResource r : transients)
+    {
+        ResourceInfo& resource = m_resources[r];
+
+        // Memory used by anything alive during any pass this resource is.
+        busy.clear();
+        for (FrameGraphResource other : placed)
+        {
+            const ResourceInfo& rhs = m_resources[other];
+            if (rhs.firstPass <= resource.lastPass && resource.firstPass <= rhs.lastPass)
+            {
+                Range range = { rhs.heapOffset, rhs.heapOffset + rhs.size };
+                busy.push_back(range);
+            }
+        }
+        std::sort(busy.begin(), busy.end(), [](const Range& a, const Range& b) { return a.begin < b.begin; });
+
+        uint64_t offset = 0;
+        for (const Range& range : busy)
+        {
+            if (offset + resource.size <= range.begin)
+            {
+                break;
+            }
+            offset = std::max(offset, AlignUp(range.end, alignments[r]));
+        }
+
+        resource.heapOffset = offset;
+        m_stats.heapBytes = std::max(m_stats.heapBytes, offset + resource.size);
+        placed.push_back(r);
+    }
+}
+
+void FrameGraph::BuildBarriers()
+{
+    // Tracker ids match resource indices; unused resources are never touched.
+    ResourceStateTracker tracker;
+    for (const ResourceInfo& resource : m_resources)
+    {
+        tracker.Register(1, resource.restState);
+    }
+
+    std::vector<bool> sharesMemory(m_resources.size(), false);
+    for (FrameGraphResource r = 0; r < m_resources.size(); r++)
+    {
+        sharesMemory[r] = m_resources[r].used && !m_resources[r].imported && SharesMemory(r);
+    }
+
+    m_passBarriers.resize(m_schedule.size());
+    for (uint32_t i = 0; i < m_schedule.size(); i++)
+    {
+        const Pass& pass = m_passes[m_schedule[i]];
+        for (const Access& access : pass.accesses)
+        {
+            const ResourceInfo& resource = m_resources[access.resource];
+            if (access.state == ResourceState::UnorderedAccess && resource.firstPass < i &&
+                tracker.State(access.resource) == ResourceState::UnorderedAccess)
+            {
+                tracker.UnorderedAccessBarrier(access.resource);
+            }
+            tracker.Transition(access.resource, access.state);
+        }
+
+        std::vector<ResourceBarrierDesc>& barriers = m_passBarriers[i];
+        barriers = tracker.Flush();
+
+        // The previous occupant's transitions above go first, then the
+        // transients that take over its memory.
+        for (const Access& access : pass.accesses)
+        {
+            if (sharesMemory[access.resource] && m_resources[access.resource].firstPass == i)
+            {
+                ResourceBarrierDesc aliasing = { ResourceBarrierDesc::Type::Aliasing, ResourceBarrierDesc::Split::None,
+                    access.resource, ResourceStateTracker::AllSubresources, 0, 0 };
+                barriers.push_back(aliasing);
+                m_stats.aliasingBarriers++;
+            }
+        }
+        m_stats.barriers += static_cast<uint32_t>(barriers.size());
+
+        // Send transients back to their rest state once they are done. When
+        // nothing else lives in their memory the transition can be split and
+        // overlap with the rest of the frame.
+        for (const Access& access : pass.accesses)
+        {
+            const ResourceInfo& resource = m_resources[access.resource];
+            if (resource.imported || resource.lastPass != i || tracker.State(access.resource) == resource.restState)
+            {
+                continue;
+            }
+            if (sharesMemory[access.resource])
+            {
+                tracker.Transition(access.resource, resource.restState);
+            }
+            else
+            {
+                tracker.BeginTransition(access.resource, resource.restState);
+            }
+        }
+    }
+
+    for (FrameGraphResource r = 0; r < m_resources.size(); r++)
+    {
+        const ResourceInfo& resource = m_resources[r];
+        if (resource.imported)
+        {
+            tracker.Transition(r, resource.finalState);
+        }
+        else if (resource.used)
+        {
+            // Completes any split transition begun above.
+            tracker.Transition(r, resource.restState);
+        }
+    }
+    m_finalBarriers = tracker.Flush();
+    m_stats.barriers += static_cast<uint32_t>(m_finalBarriers.size());
+}
+
+//------------------------------------------------------------------------------------------------
+// Execution
+
+void FrameGraph::Execute() const
+{
+    for (uint32_t i = 0; i < m_schedule.size(); i++)
+    {
+        const Pass& pass = m_passes[m_schedule[i]];
+        if (pass.execute)
+        {
+            PassContext context = { m_schedule[i], m_passBarriers[i].data(), m_passBarriers[i].size() };
+            pass.execute(context);
+        }
+    }
+}
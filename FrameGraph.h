@@ -0,0 +1,163 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+#include "ResourceStateTracker.h"
+
+typedef uint32_t FrameGraphResource;
+
+struct FrameGraphTextureDesc
+{
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t arraySize = 1;
+    uint32_t format = 0;            // Backend format (DXGI_FORMAT on D3D12); opaque to the graph.
+    uint32_t bytesPerTexel = 4;     // Only used by the default memory estimate.
+    float clearColor[4] = {};       // Optimized clear value for render targets.
+    float clearDepth = 1.0f;        // Optimized clear value for depth targets.
+};
+
+struct FrameGraphMemoryInfo
+{
+    uint64_t size;
+    uint64_t alignment;
+};
+
+// Describes a frame as passes that declare which resources they read and
+// write. Compile turns that into:
+//  - a schedule: the passes in declaration order, minus those whose output
+//    nothing uses (a pass survives if it has side effects, writes an
+//    imported resource, or writes something a surviving pass reads);
+//  - placements: transient resources are packed into one heap, sharing
+//    memory whenever their lifetimes within the schedule do not overlap;
+//  - barriers: one batch before each pass, plus a final batch that returns
+//    imported resources to their final state.
+//
+// Transients rest in the state of their first use, so they are created in
+// it and need no barrier at the start of a frame; the graph moves them back
+// after their last use. Memory shared with another transient holds garbage
+// on first use, so the first pass writing a transient must clear or discard
+// it.
+//
+// Compiling needs no GPU; D3D12FrameGraphResources realizes the result.
+class FrameGraph
+{
+public:
+    static const FrameGraphResource InvalidResource = ~0u;
+
+    typedef std::function<FrameGraphMemoryInfo(const FrameGraphTextureDesc& desc, ResourceStates usage)> MemoryQuery;
+
+    class Builder
+    {
+    public:
+        FrameGraphResource Create(const char* name, const FrameGraphTextureDesc& desc);
+        void Read(FrameGraphResource resource, ResourceStates state);
+        void Write(FrameGraphResource resource, ResourceStates state);
+
+        // Keeps the pass even if nothing reads what it writes.
+        void SideEffect();
+
+    private:
+        friend class FrameGraph;
+        Builder(FrameGraph& graph, uint32_t pass) : m_graph(graph), m_pass(pass) {}
+
+        FrameGraph& m_graph;
+        uint32_t m_pass;
+    };
+
+    struct PassContext
+    {
+        uint32_t pass;
+        const ResourceBarrierDesc* barriers;    // Record before the pass's own commands.
+        size_t barrierCount;
+    };
+
+    typedef std::function<void(Builder&)> SetupCallback;
+    typedef std::function<void(const PassContext&)> ExecuteCallback;
+
+    struct ResourceInfo
+    {
+        std::string name;
+        bool imported = false;
+        bool used = false;                      // Referenced by a scheduled pass.
+        FrameGraphTextureDesc desc;
+        ResourceStates usage = 0;               // Every state it is used in.
+        ResourceStates restState = 0;           // Imported: initial state; transient: first use.
+        ResourceStates finalState = 0;
+        uint32_t firstPass = 0;                 // Schedule indices; valid when used.
+        uint32_t lastPass = 0;
+        uint64_t heapOffset = 0;                // Transients only.
+        uint64_t size = 0;
+    };
+
+    struct Stats
+    {
+        uint32_t passes = 0;
+        uint32_t culledPasses = 0;
+        uint32_t transientResources = 0;
+        uint32_t barriers = 0;
+        uint32_t aliasingBarriers = 0;
+        uint64_t unaliasedBytes = 0;            // Every transient in memory of its own.
+        uint64_t heapBytes = 0;                 // What the aliased placement needs.
+
+        uint64_t SavedBytes() const { return unaliasedBytes - heapBytes; }
+    };
+
+    FrameGraph() = default;
+    FrameGraph(const FrameGraph& rhs) = delete;
+    FrameGraph& operator=(const FrameGraph& rhs) = delete;
+
+    // Clears passes and resources so the next frame's graph can be declared.
+    void Reset();
+
+    FrameGraphResource Import(const char* name, ResourceStates initialState, ResourceStates finalState);
+    uint32_t AddPass(const char* name, const SetupCallback& setup, const ExecuteCallback& execute);
+
+    // Without a query, sizes are width * height * arraySize * bytesPerTexel
+    // rounded up to 64KB. Throws std::logic_error on a malformed graph.
+    void Compile(const MemoryQuery& query = MemoryQuery());
+
+    // Runs the scheduled passes in order.
+    void Execute() const;
+
+    const std::vector<uint32_t>& Schedule() const { return m_schedule; }
+    const std::string& PassName(uint32_t pass) const { return m_passes[pass].name; }
+    uint32_t ResourceCount() const { return static_cast<uint32_t>(m_resources.size()); }
+    const ResourceInfo& Resource(FrameGraphResource resource) const { return m_resources[resource]; }
+    const std::vector<ResourceBarrierDesc>& PassBarriers(uint32_t scheduleIndex) const { return m_passBarriers[scheduleIndex]; }
+    const std::vector<ResourceBarrierDesc>& FinalBarriers() const { return m_finalBarriers; }
+    uint64_t HeapSize() const { return m_stats.heapBytes; }
+    const Stats& GetStats() const { return m_stats; }
+
+private:
+    struct Access
+    {
+        FrameGraphResource resource;
+        ResourceStates state;
+        bool write;
+    };
+
+    struct Pass
+    {
+        std::string name;
+        ExecuteCallback execute;
+        std::vector<Access> accesses;
+        bool sideEffect = false;
+    };
+
+    void AddAccess(uint32_t pass, FrameGraphResource resource, ResourceStates state, bool write);
+    void Cull();
+    void ComputeLifetimes();
+    bool SharesMemory(FrameGraphResource resource) const;
+    void PlaceTransients(const MemoryQuery& query);
+    void BuildBarriers();
+
+    std::vector<Pass> m_passes;
+    std::vector<ResourceInfo> m_resources;
+    std::vector<uint32_t> m_schedule;
+    std::vector<std::vector<ResourceBarrierDesc>> m_passBarriers;
+    std::vector<ResourceBarrierDesc> m_finalBarriers;
+    Stats m_stats;
+};
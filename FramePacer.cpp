@@ -0,0 +1,37 @@
+#include "FramePacer.h"
+
+FramePacer::FramePacer(IFenceQueue& queue, uint32_t framesInFlight) :
+    m_queue(queue),
+    m_slotFenceValues(framesInFlight ? framesInFlight : 1, 0)
+{
+}
+
+bool FramePacer::EndFrame(uint32_t nextSlot)
+{
+    const uint64_t fenceValue = m_nextFenceValue++;
+    m_queue.Signal(fenceValue);
+    m_slotFenceValues[m_slot] = fenceValue;
+
+    m_slot = nextSlot % FramesInFlight();
+
+    // Only block if the GPU still owns the resources of the slot we move into.
+    const uint64_t required = m_slotFenceValues[m_slot];
+    if (m_queue.CompletedValue() < required)
+    {
+        m_queue.WaitForValue(required);
+        return true;
+    }
+    return false;
+}
+
+void FramePacer::WaitForIdle()
+{
+    const uint64_t fenceValue = m_nextFenceValue++;
+    m_queue.Signal(fenceValue);
+    m_queue.WaitForValue(fenceValue);
+
+    for (uint64_t& value : m_slotFenceValues)
+    {
+        value = fenceValue;
+    }
+}
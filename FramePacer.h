@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// The parts of a GPU queue + fence pair that frame pacing needs. The D3D12
+// implementation lives in D3D12FenceQueue; tests can substitute a mock queue.
+class IFenceQueue
+{
+public:
+    virtual ~IFenceQueue() = default;
+
+    // Enqueues a fence signal after all work submitted so far.
+    virtual void Signal(uint64_t value) = 0;
+    virtual uint64_t CompletedValue() = 0;
+    // Blocks the CPU until CompletedValue() >= value.
+    virtual void WaitForValue(uint64_t value) = 0;
+};
+
+// Tracks which per-frame resource slot (command allocator, constant buffer
+// slice, ...) the CPU may record into, keeping up to framesInFlight frames
+// queued on the GPU. The CPU only blocks when it is about to reuse a slot
+// whose previous frame has not retired yet.
+class FramePacer
+{
+public:
+    FramePacer(IFenceQueue& queue, uint32_t framesInFlight);
+    FramePacer(const FramePacer& rhs) = delete;
+    FramePacer& operator=(const FramePacer& rhs) = delete;
+
+    uint32_t FramesInFlight() const { return static_cast<uint32_t>(m_slotFenceValues.size()); }
+    uint32_t FrameSlot() const { return m_slot; }
+    uint64_t SlotFenceValue(uint32_t slot) const { return m_slotFenceValues[slot]; }
+
+    // Fence value that will be signaled at the end of the frame being recorded.
+    uint64_t CurrentFenceValue() const { return m_nextFenceValue; }
+    uint64_t CompletedFenceValue() { return m_queue.CompletedValue(); }
+
+    // Call after the frame has been submitted (and presented). Signals the
+    // frame's fence, moves to nextSlot (the swap chain's next back buffer) and
+    // waits until the GPU has finished the frame that last used it. Returns
+    // true when the CPU had to wait.
+    bool EndFrame(uint32_t nextSlot);
+
+    // Waits for everything submitted so far, e.g. before releasing resources.
+    void WaitForIdle();
+
+private:
+    IFenceQueue& m_queue;
+    std::vector<uint64_t> m_slotFenceValues;
+    uint32_t m_slot = 0;
+    uint64_t m_nextFenceValue = 1;
+};
@@ -0,0 +1,31 @@
+#include "Frustum.h"
+#include <cmath>
+
+Frustum Frustum::FromViewProjection(const float m[4][4])
+{
+    // With clip = p * M, clip.x is p dotted with column 0 of M, and so on.
+    // -w <= x <= w gives the side planes and 0 <= z <= w near and far.
+    Frustum frustum;
+    for (int i = 0; i < 4; i++)
+    {
+        frustum.planes[0][i] = m[i][3] + m[i][0];
+        frustum.planes[1][i] = m[i][3] - m[i][0];
+        frustum.planes[2][i] = m[i][3] + m[i][1];
+        frustum.planes[3][i] = m[i][3] - m[i][1];
+        frustum.planes[4][i] = m[i][2];
+        frustum.planes[5][i] = m[i][3] - m[i][2];
+    }
+
+    for (float* plane : frustum.planes)
+    {
+        const float length = std::sqrt(plane[0] * plane[0] + plane[1] * plane[1] + plane[2] * plane[2]);
+        if (length > 0.0f)
+        {
+            for (int i = 0; i < 4; i++)
+            {
+                plane[i] /= length;
+            }
+        }
+    }
+    return frustum;
+}
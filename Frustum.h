@@ -0,0 +1,14 @@
+#pragma once
+
+// View frustum as six inward-facing planes (a, b, c, d), with points inside
+// satisfying a*x + b*y + c*z + d >= 0. Order: left, right, bottom, top,
+// near, far.
+struct Frustum
+{
+    float planes[6][4];
+
+    // From a row-major view-projection matrix for row vectors (clip = p * M,
+    // as with DirectXMath) and D3D clip space (0 <= z <= w). Planes are
+    // normalized so plane distances are in world units.
+    static Frustum FromViewProjection(const float m[4][4]);
+};
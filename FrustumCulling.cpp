@@ -0,0 +1,622 @@
+#include "StrictFloat.h"
+#include "FrustumCulling.h"
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#if defined(__AVX2__)
+#define CULLING_AVX2 1
+#endif
+#if defined(_M_X64) || defined(__x86_64__) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CULLING_SSE2 1
+#include <immintrin.h>
+#endif
+
+namespace
+{
+    const uint32_t Lanes = 8;
+    const uint32_t PlaneCount = 6;
+
+    // Signed distance of a center from a plane and the box's reach towards
+    // it, rounded after every step like the SIMD lanes; StrictFloat.h keeps
+    // the steps from being fused.
+    float PlaneDistance(const float plane[4], float x, float y, float z)
+    {
+        float distance = plane[0] * x;
+        distance = distance + plane[1] * y;
+        distance = distance + plane[2] * z;
+        return distance + plane[3];
+    }
+
+    float BoxReach(const float plane[4], float x, float y, float z)
+    {
+        float reach = std::fabs(plane[0]) * x;
+        reach = reach + std::fabs(plane[1]) * y;
+        return reach + std::fabs(plane[2]) * z;
+    }
+
+    bool IsOutside(const Frustum& frustum, const CullingBounds& bounds, FrustumCulling::Shape shape, uint32_t i)
+    {
+        const float x = bounds.CenterX()[i];
+        const float y = bounds.CenterY()[i];
+        const float z = bounds.CenterZ()[i];
+        for (const float* plane : frustum.planes)
+        {
+            const float reach = shape == FrustumCulling::Shape::Sphere ? bounds.Radius()[i] :
+                BoxReach(plane, bounds.ExtentX()[i], bounds.ExtentY()[i], bounds.ExtentZ()[i]);
+            if (PlaneDistance(plane, x, y, z) < -reach)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+#if defined(CULLING_AVX2)
+    typedef __m256 Vector;
+    Vector Splat(float value) { return _mm256_set1_ps(value); }
+
+    // Lanes outside plane, in the order of PlaneDistance and BoxReach.
+    Vector OutsideSphere(const Vector plane[4], Vector x, Vector y, Vector z, Vector negativeRadius)
+    {
+        Vector distance = _mm256_mul_ps(plane[0], x);
+        distance = _mm256_add_ps(distance, _mm256_mul_ps(plane[1], y));
+        distance = _mm256_add_ps(distance, _mm256_mul_ps(plane[2], z));
+        distance = _mm256_add_ps(distance, plane[3]);
+        return _mm256_cmp_ps(distance, negativeRadius, _CMP_LT_OQ);
+    }
+
+    Vector OutsideBox(const Vector plane[4], const Vector absolute[3], Vector x, Vector y, Vector z, Vector ex, Vector ey, Vector ez)
+    {
+        Vector reach = _mm256_mul_ps(absolute[0], ex);
+        reach = _mm256_add_ps(reach, _mm256_mul_ps(absolute[1], ey));
+        reach = _mm256_add_ps(reach, _mm256_mul_ps(absolute[2], ez));
+        return OutsideSphere(plane, x, y, z, _mm256_xor_ps(reach, _mm256_set1_ps(-0.0f)));
+    }
+#elif defined(CULLING_SSE2)
+    typedef __m128 Vector;
+    Vector Splat(float value) { return _mm_set1_ps(value); }
+
+    Vector OutsideSphere(const Vector plane[4], Vector x, Vector y, Vector z, Vector negativeRadius)
+    {
+        Vector distance = _mm_mul_ps(plane[0], x);
+        distance = _mm_add_ps(distance, _mm_mul_ps(plane[1], y));
+        distance = _mm_add_ps(distance, _mm_mul_ps(plane[2], z));
+        distance = _mm_add_ps(distance, plane[3]);
+        return _mm_cmplt_ps(distance, negativeRadius);
+    }
+
+    Vector OutsideBox(const Vector plane[4], const Vector absolute[3], Vector x, Vector y, Vector z, Vector ex, Vector ey, Vector ez)
+    {
+        Vector reach = _mm_mul_ps(absolute[0], ex);
+        reach = _mm_add_ps(reach, _mm_mul_ps(absolute[1], ey));
+        reach = _mm_add_ps(reach, _mm_mul_ps(absolute[2], ez));
+        return OutsideSphere(plane, x, y, z, _mm_xor_ps(reach, _mm_set1_ps(-0.0f)));
+    }
+#endif
+
+#if defined(CULLING_SSE2)
+    // A view's planes, and the absolute values of their normals for the box
+    // test, splatted across the lanes once per call rather than per block.
+    struct ViewPlanes
+    {
+        Vector planes[PlaneCount][4];
+        Vector absolute[PlaneCount][3];
+    };
+
+    void LoadViewPlanes(const Frustum* views, uint32_t viewCount, ViewPlanes* planes)
+    {
+        for (uint32_t v = 0; v < viewCount; v++)
+        {
+            for (uint32_t p = 0; p < PlaneCount; p++)
+            {
+                for (int i = 0; i < 4; i++)
+                {
+                    planes[v].planes[p][i] = Splat(views[v].planes[p][i]);
+                }
+                for (int i = 0; i < 3; i++)
+                {
+                    planes[v].absolute[p][i] = Splat(std::fabs(views[v].planes[p][i]));
+                }
+            }
+        }
+    }
+#endif
+
+#if defined(CULLING_SSE2)
+    // For each 8 bit mask of visible lanes, the lanes in order (what a SIMD
+    // permute needs to move them to the front) and how many there are.
+    struct CompactionTable
+    {
+        uint8_t lanes[256][Lanes];
+        uint8_t counts[256];
+
+        CompactionTable()
+        {
+            for (uint32_t mask = 0; mask < 256; mask++)
+            {
+                uint8_t count = 0;
+                for (uint8_t lane = 0; lane < Lanes; lane++)
+                {
+                    if (mask & (1u << lane))
+                    {
+                        lanes[mask][count++] = lane;
+                    }
+                }
+                counts[mask] = count;
+                while (count < Lanes)
+                {
+                    lanes[mask][count++] = 0;
+                }
+            }
+        }
+    };
+
+    const CompactionTable& Compaction()
+    {
+        static const CompactionTable table;
+        return table;
+    }
+#endif
+}
+
+void CullingBounds::Clear()
+{
+    m_count = 0;
+    for (std::vector<float>* array : { &m_centerX, &m_centerY, &m_centerZ, &m_extentX, &m_extentY, &m_extentZ, &m_radius })
+    {
+        array->clear();
+    }
+}
+
+void CullingBounds::Reserve(uint32_t count)
+{
+    const size_t padded = (static_cast<size_t>(count) + Lanes - 1) / Lanes * Lanes;
+    for (std::vector<float>* array : { &m_centerX, &m_centerY, &m_centerZ, &m_extentX, &m_extentY, &m_extentZ, &m_radius })
+    {
+        array->reserve(padded);
+    }
+}
+
+uint32_t CullingBounds::Add(const float center[3], const float extents[3], float radius)
+{
+    const uint32_t index = m_count++;
+    if (index % Lanes == 0)
+    {
+        const size_t padded = static_cast<size_t>(index) + Lanes;
+        for (std::vector<float>* array : { &m_centerX, &m_centerY, &m_centerZ, &m_extentX, &m_extentY, &m_extentZ, &m_radius })
+        {
+            array->resize(padded, 0.0f);
+        }
+    }
+    m_centerX[index] = center[0];
+    m_centerY[index] = center[1];
+    m_centerZ[index] = center[2];
+    m_extentX[index] = extents[0];
+    m_extentY[index] = extents[1];
+    m_extentZ[index] = extents[2];
+    m_radius[index] = radius;
+    return index;
+}
+
+uint32_t CullingBounds::AddPoints(const void* positions, size_t positionStride, uint32_t count)
+{
+    const unsigned char* bytes = static_cast<const unsigned char*>(positions);
+    auto position = [&](uint32_t point)
+    {
+        return reinterpret_cast<const float*>(bytes + point * positionStride);
+    };
+
+    float low[3] = { 0.0f, 0.0f, 0.0f };
+    float high[3] = { 0.0f, 0.0f, 0.0f };
+    for (uint32_t point = 0; point < count; point++)
+    {
+        const float* p = position(point);
+        for (int axis = 0; axis < 3; axis++)
+        {
+            low[axis] = point == 0 ? p[axis] : std::min(low[axis], p[axis]);
+            high[axis] = point == 0 ? p[axis] : std::max(high[axis], p[axis]);
+        }
+    }
+
+    float center[3], extents[3];
+    for (int axis = 0; axis < 3; axis++)
+    {
+        center[axis] = 0.5f * (low[axis] + high[axis]);
+        extents[axis] = 0.5f * (high[axis] - low[axis]);
+    }
+    float radiusSquared = 0.0f;
+    for (uint32_t point = 0; point < count; point++)
+    {
+        const float* p = position(point);
+        const float dx = p[0] - center[0];
+        const float dy = p[1] - center[1];
+        const float dz = p[2] - center[2];
+        radiusSquared = std::max(radiusSquared, dx * dx + dy * dy + dz * dz);
+    }
+
+    // Pad by a relative epsilon to cover rounding in the center, the extents
+    // and the square root.
+    for (float& extent : extents)
+    {
+        extent *= 1.0001f;
+    }
+    return Add(center, extents, std::sqrt(radiusSquared) * 1.0001f);
+}
+
+namespace FrustumCulling
+{
+    uint32_t CullReference(const Frustum& frustum, const CullingBounds& bounds, Shape shape, uint32_t begin, uint32_t end, uint32_t* visible)
+    {
+        uint32_t count = 0;
+        for (uint32_t i = begin; i < end; i++)
+        {
+            if (!IsOutside(frustum, bounds, shape, i))
+            {
+                visible[count++] = i;
+            }
+        }
+        return count;
+    }
+
+    uint32_t Cull(const Frustum& frustum, const CullingBounds& bounds, Shape shape, uint32_t begin, uint32_t end, uint32_t* visible)
+    {
+#if defined(CULLING_AVX2)
+        const CompactionTable& table = Compaction();
+        __m256 planes[PlaneCount][4];
+        __m256 absolute[PlaneCount][3];
+        for (uint32_t p = 0; p < PlaneCount; p++)
+        {
+            for (int i = 0; i < 4; i++)
+            {
+                planes[p][i] = _mm256_set1_ps(frustum.planes[p][i]);
+            }
+            for (int i = 0; i < 3; i++)
+            {
+                absolute[p][i] = _mm256_set1_ps(std::fabs(frustum.planes[p][i]));
+            }
+        }
+        const __m256 signBit = _mm256_set1_ps(-0.0f);
+        const __m256i laneOffsets = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+
+        uint32_t count = 0;
+        uint32_t i = begin;
+        // Unaligned starts are handled one volume at a time.
+        for (; i < end && i % Lanes != 0; i++)
+        {
+            count += CullReference(frustum, bounds, shape, i, i + 1, visible + count);
+        }
+        for (; i < end; i += Lanes)
+        {
+            const __m256 x = _mm256_loadu_ps(bounds.CenterX() + i);
+            const __m256 y = _mm256_loadu_ps(bounds.CenterY() + i);
+            const __m256 z = _mm256_loadu_ps(bounds.CenterZ() + i);
+            __m256 outside = _mm256_setzero_ps();
+            if (shape == Shape::Sphere)
+            {
+                // -radius, by flipping the sign like the reference's negation.
+                const __m256 reach = _mm256_xor_ps(_mm256_loadu_ps(bounds.Radius() + i), signBit);
+                for (uint32_t p = 0; p < PlaneCount; p++)
+                {
+                    __m256 distance = _mm256_mul_ps(planes[p][0], x);
+                    distance = _mm256_add_ps(distance, _mm256_mul_ps(planes[p][1], y));
+                    distance = _mm256_add_ps(distance, _mm256_mul_ps(planes[p][2], z));
+                    distance = _mm256_add_ps(distance, planes[p][3]);
+                    outside = _mm256_or_ps(outside, _mm256_cmp_ps(distance, reach, _CMP_LT_OQ));
+                }
+            }
+            else
+            {
+                const __m256 ex = _mm256_loadu_ps(bounds.ExtentX() + i);
+                const __m256 ey = _mm256_loadu_ps(bounds.ExtentY() + i);
+                const __m256 ez = _mm256_loadu_ps(bounds.ExtentZ() + i);
+                for (uint32_t p = 0; p < PlaneCount; p++)
+                {
+                    __m256 distance = _mm256_mul_ps(planes[p][0], x);
+                    distance = _mm256_add_ps(distance, _mm256_mul_ps(planes[p][1], y));
+                    distance = _mm256_add_ps(distance, _mm256_mul_ps(planes[p][2], z));
+                    distance = _mm256_add_ps(distance, planes[p][3]);
+                    __m256 reach = _mm256_mul_ps(absolute[p][0], ex);
+                    reach = _mm256_add_ps(reach, _mm256_mul_ps(absolute[p][1], ey));
+                    reach = _mm256_add_ps(reach, _mm256_mul_ps(absolute[p][2], ez));
+                    outside = _mm256_or_ps(outside, _mm256_cmp_ps(distance, _mm256_xor_ps(reach, signBit), _CMP_LT_OQ));
+                }
+            }
+
+            // Visible lanes, without those past the end, packed to the front.
+            uint32_t mask = ~static_cast<uint32_t>(_mm256_movemask_ps(outside)) & 0xFF;
+            if (end - i < Lanes)
+            {
+                mask &= (1u << (end - i)) - 1;
+            }
+            const __m256i indices = _mm256_add_epi32(_mm256_set1_epi32(static_cast<int>(i)), laneOffsets);
+            const __m256i permutation = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(table.lanes[mask])));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(visible + count), _mm256_permutevar8x32_epi32(indices, permutation));
+            count += table.counts[mask];
+        }
+        return count;
+#elif defined(CULLING_SSE2)
+        const CompactionTable& table = Compaction();
+        __m128 planes[PlaneCount][4];
+        __m128 absolute[PlaneCount][3];
+        for (uint32_t p = 0; p < PlaneCount; p++)
+        {
+            for (int i = 0; i < 4; i++)
+            {
+                planes[p][i] = _mm_set1_ps(frustum.planes[p][i]);
+            }
+            for (int i = 0; i < 3; i++)
+            {
+                absolute[p][i] = _mm_set1_ps(std::fabs(frustum.planes[p][i]));
+            }
+        }
+        const __m128 signBit = _mm_set1_ps(-0.0f);
+
+        uint32_t count = 0;
+        uint32_t i = begin;
+        for (; i < end && i % 4 != 0; i++)
+        {
+            count += CullReference(frustum, bounds, shape, i, i + 1, visible + count);
+        }
+        for (; i < end; i += 4)
+        {
+            const __m128 x = _mm_loadu_ps(bounds.CenterX() + i);
+            const __m128 y = _mm_loadu_ps(bounds.CenterY() + i);
+            const __m128 z = _mm_loadu_ps(bounds.CenterZ() + i);
+            __m128 outside = _mm_setzero_ps();
+            if (shape == Shape::Sphere)
+            {
+                const __m128 reach = _mm_xor_ps(_mm_loadu_ps(bounds.Radius() + i), signBit);
+                for (uint32_t p = 0; p < PlaneCount; p++)
+                {
+                    __m128 distance = _mm_mul_ps(planes[p][0], x);
+                    distance = _mm_add_ps(distance, _mm_mul_ps(planes[p][1], y));
+                    distance = _mm_add_ps(distance, _mm_mul_ps(planes[p][2], z));
+                    distance = _mm_add_ps(distance, planes[p][3]);
+                    outside = _mm_or_ps(outside, _mm_cmplt_ps(distance, reach));
+                }
+            }
+            else
+            {
+                const __m128 ex = _mm_loadu_ps(bounds.ExtentX() + i);
+                const __m128 ey = _mm_loadu_ps(bounds.ExtentY() + i);
+                const __m128 ez = _mm_loadu_ps(bounds.ExtentZ() + i);
+                for (uint32_t p = 0; p < PlaneCount; p++)
+                {
+                    __m128 distance = _mm_mul_ps(planes[p][0], x);
+                    distance = _mm_add_ps(distance, _mm_mul_ps(planes[p][1], y));
+                    distance = _mm_add_ps(distance, _mm_mul_ps(planes[p][2], z));
+                    distance = _mm_add_ps(distance, planes[p][3]);
+                    __m128 reach = _mm_mul_ps(absolute[p][0], ex);
+                    reach = _mm_add_ps(reach, _mm_mul_ps(absolute[p][1], ey));
+                    reach = _mm_add_ps(reach, _mm_mul_ps(absolute[p][2], ez));
+                    outside = _mm_or_ps(outside, _mm_cmplt_ps(distance, _mm_xor_ps(reach, signBit)));
+                }
+            }
+
+            // SSE2 has no lane permute, so the visible lanes are stored one
+            // at a time, still without a branch per volume.
+            uint32_t mask = ~static_cast<uint32_t>(_mm_movemask_ps(outside)) & 0xF;
+            if (end - i < 4)
+            {
+                mask &= (1u << (end - i)) - 1;
+            }
+            const uint8_t* lanes = table.lanes[mask];
+            for (uint32_t lane = 0; lane < 4; lane++)
+            {
+                visible[count + lane] = i + lanes[lane];
+            }
+            count += table.counts[mask];
+        }
+        return count;
+#else
+        return CullReference(frustum, bounds, shape, begin, end, visible);
+#endif
+    }
+
+    void CullViewsReference(const Frustum* views, uint32_t viewCount, const CullingBounds& bounds, Shape shape, uint32_t begin,
+        uint32_t end, uint16_t* masks)
+    {
+        if (viewCount > MaxViews)
+        {
+            throw std::invalid_argument("FrustumCulling: too many views");
+        }
+        for (uint32_t i = begin; i < end; i++)
+        {
+            uint32_t mask = 0;
+            for (uint32_t v = 0; v < viewCount; v++)
+            {
+                if (!IsOutside(views[v], bounds, shape, i))
+                {
+                    mask |= 1u << v;
+                }
+            }
+            masks[i - begin] = static_cast<uint16_t>(mask);
+        }
+    }
+
+    void CullViews(const Frustum* views, uint32_t viewCount, const CullingBounds& bounds, Shape shape, uint32_t begin, uint32_t end,
+        uint16_t* masks)
+    {
+        if (viewCount > MaxViews)
+        {
+            throw std::invalid_argument("FrustumCulling: too many views");
+        }
+#if defined(CULLING_SSE2)
+        ViewPlanes planes[MaxViews];
+        LoadViewPlanes(views, viewCount, planes);
+
+#if defined(CULLING_AVX2)
+        const uint32_t width = Lanes;
+#else
+        const uint32_t width = 4;
+#endif
+        uint32_t i = begin;
+        for (; i < end && i % width != 0; i++)
+        {
+            CullViewsReference(views, viewCount, bounds, shape, i, i + 1, masks + (i - begin));
+        }
+        for (; i < end; i += width)
+        {
+            // Each block of volumes is loaded once and tested against every
+            // view; lanes gather their view bits as they go.
+#if defined(CULLING_AVX2)
+            const __m256 x = _mm256_loadu_ps(bounds.CenterX() + i);
+            const __m256 y = _mm256_loadu_ps(bounds.CenterY() + i);
+            const __m256 z = _mm256_loadu_ps(bounds.CenterZ() + i);
+            __m256i bits = _mm256_setzero_si256();
+            if (shape == Shape::Sphere)
+            {
+                const __m256 negativeRadius = _mm256_xor_ps(_mm256_loadu_ps(bounds.Radius() + i), _mm256_set1_ps(-0.0f));
+                for (uint32_t v = 0; v < viewCount; v++)
+                {
+                    __m256 outside = _mm256_setzero_ps();
+                    for (uint32_t p = 0; p < PlaneCount; p++)
+                    {
+                        outside = _mm256_or_ps(outside, OutsideSphere(planes[v].planes[p], x, y, z, negativeRadius));
+                    }
+                    bits = _mm256_or_si256(bits, _mm256_andnot_si256(_mm256_castps_si256(outside), _mm256_set1_epi32(1 << v)));
+                }
+            }
+            else
+            {
+                const __m256 ex = _mm256_loadu_ps(bounds.ExtentX() + i);
+                const __m256 ey = _mm256_loadu_ps(bounds.ExtentY() + i);
+                const __m256 ez = _mm256_loadu_ps(bounds.ExtentZ() + i);
+                for (uint32_t v = 0; v < viewCount; v++)
+                {
+                    __m256 outside = _mm256_setzero_ps();
+                    for (uint32_t p = 0; p < PlaneCount; p++)
+                    {
+                        outside = _mm256_or_ps(outside, OutsideBox(planes[v].planes[p], planes[v].absolute[p], x, y, z, ex, ey, ez));
+                    }
+                    bits = _mm256_or_si256(bits, _mm256_andnot_si256(_mm256_castps_si256(outside), _mm256_set1_epi32(1 << v)));
+                }
+            }
+            const __m128i packed = _mm_packus_epi32(_mm256_castsi256_si128(bits), _mm256_extracti128_si256(bits, 1));
+#else
+            const __m128 x = _mm_loadu_ps(bounds.CenterX() + i);
+            const __m128 y = _mm_loadu_ps(bounds.CenterY() + i);
+            const __m128 z = _mm_loadu_ps(bounds.CenterZ() + i);
+            __m128i bits = _mm_setzero_si128();
+            if (shape == Shape::Sphere)
+            {
+                const __m128 negativeRadius = _mm_xor_ps(_mm_loadu_ps(bounds.Radius() + i), _mm_set1_ps(-0.0f));
+                for (uint32_t v = 0; v < viewCount; v++)
+                {
+                    __m128 outside = _mm_setzero_ps();
+                    for (uint32_t p = 0; p < PlaneCount; p++)
+                    {
+                        outside = _mm_or_ps(outside, OutsideSphere(planes[v].planes[p], x, y, z, negativeRadius));
+                    }
+                    bits = _mm_or_si128(bits, _mm_andnot_si128(_mm_castps_si128(outside), _mm_set1_epi32(1 << v)));
+                }
+            }
+            else
+            {
+                const __m128 ex = _mm_loadu_ps(bounds.ExtentX() + i);
+                const __m128 ey = _mm_loadu_ps(bounds.ExtentY() + i);
+                const __m128 ez = _mm_loadu_ps(bounds.ExtentZ() + i);
+                for (uint32_t v = 0; v < viewCount; v++)
+                {
+                    __m128 outside = _mm_setzero_ps();
+                    for (uint32_t p = 0; p < PlaneCount; p++)
+                    {
+                        outside = _mm_or_ps(outside, OutsideBox(planes[v].planes[p], planes[v].absolute[p], x, y, z, ex, ey, ez));
+                    }
+                    bits = _mm_or_si128(bits, _mm_andnot_si128(_mm_castps_si128(outside), _mm_set1_epi32(1 << v)));
+                }
+            }
+            // SSE2 can only pack to signed 16 bits, so bias the masks into
+            // that range and back.
+            const __m128i bias = _mm_set1_epi32(0x8000);
+            const __m128i biased = _mm_packs_epi32(_mm_sub_epi32(bits, bias), _mm_setzero_si128());
+            const __m128i packed = _mm_add_epi16(biased, _mm_set1_epi16(static_cast<short>(0x8000)));
+#endif
+            // The last block may end part way; the bounds are padded, so
+            // only the store needs trimming.
+            if (end - i >= width)
+            {
+#if defined(CULLING_AVX2)
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(masks + (i - begin)), packed);
+#else
+                _mm_storel_epi64(reinterpret_cast<__m128i*>(masks + (i - begin)), packed);
+#endif
+            }
+            else
+            {
+                uint16_t block[Lanes];
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(block), packed);
+                std::copy(block, block + (end - i), masks + (i - begin));
+            }
+        }
+#else
+        CullViewsReference(views, viewCount, bounds, shape, begin, end, masks);
+#endif
+    }
+}
+
+void FrustumCuller::Cull(const Frustum& frustum, const CullingBounds& bounds, FrustumCulling::Shape shape, JobSystem* jobs)
+{
+    const uint32_t count = bounds.Count();
+    const uint32_t chunkCount = (count + ChunkSize - 1) / ChunkSize;
+    m_chunkVisible.resize(static_cast<size_t>(chunkCount) * ChunkSize + Lanes);
+    m_chunkCounts.resize(chunkCount);
+
+    auto cull = [&](size_t first, size_t last)
+    {
+        for (size_t chunk = first; chunk < last; chunk++)
+        {
+            const uint32_t begin = static_cast<uint32_t>(chunk) * ChunkSize;
+            const uint32_t end = std::min(begin + ChunkSize, count);
+            m_chunkCounts[chunk] = FrustumCulling::Cull(frustum, bounds, shape, begin, end, &m_chunkVisible[begin]);
+        }
+    };
+    if (jobs && chunkCount > 1)
+    {
+        jobs->ParallelFor(chunkCount, 1, cull);
+    }
+    else
+    {
+        cull(0, chunkCount);
+    }
+
+    // Join the chunks' lists in chunk order.
+    m_visibleCount = 0;
+    m_visible.resize(count);
+    for (uint32_t chunk = 0; chunk < chunkCount; chunk++)
+    {
+        const uint32_t* source = &m_chunkVisible[static_cast<size_t>(chunk) * ChunkSize];
+        std::copy(source, source + m_chunkCounts[chunk], m_visible.begin() + m_visibleCount);
+        m_visibleCount += m_chunkCounts[chunk];
+    }
+}
+
+void FrustumCuller::CullViews(const Frustum* views, uint32_t viewCount, const CullingBounds& bounds, FrustumCulling::Shape shape,
+    JobSystem* jobs)
+{
+    const uint32_t count = bounds.Count();
+    const uint32_t chunkCount = (count + ChunkSize - 1) / ChunkSize;
+    m_viewMasks.resize(count);
+
+    // Chunks write their own range of masks, so there is nothing to join.
+    auto cull = [&](size_t first, size_t last)
+    {
+        for (size_t chunk = first; chunk < last; chunk++)
+        {
+            const uint32_t begin = static_cast<uint32_t>(chunk) * ChunkSize;
+            const uint32_t end = std::min(begin + ChunkSize, count);
+            FrustumCulling::CullViews(views, viewCount, bounds, shape, begin, end, &m_viewMasks[begin]);
+        }
+    };
+    if (jobs && chunkCount > 1)
+    {
+        jobs->ParallelFor(chunkCount, 1, cull);
+    }
+    else
+    {
+        cull(0, chunkCount);
+    }
+}
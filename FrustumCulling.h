@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Frustum.h"
+
+class JobSystem;
+
+// Frustum culling of many bounding volumes on the CPU. The bounds are kept
+// as structure of arrays, so the tests run 8 volumes at a time with AVX2 (4
+// with SSE2), and the indices of the visible ones are packed together with a
+// SIMD permute rather than a branch per volume.
+
+// Each volume is a box (center and half extents) with a sphere around it
+// (the same center and a radius); the test picks which one to use. Arrays
+// are padded to a multiple of 8 with empty entries.
+class CullingBounds
+{
+public:
+    uint32_t Count() const { return m_count; }
+    void Clear();
+    void Reserve(uint32_t count);
+
+    // Returns the index of the new volume.
+    uint32_t Add(const float center[3], const float extents[3], float radius);
+
+    // Adds the box around count points, with positions positionStride bytes
+    // apart, and the sphere around its center.
+    uint32_t AddPoints(const void* positions, size_t positionStride, uint32_t count);
+
+    const float* CenterX() const { return m_centerX.data(); }
+    const float* CenterY() const { return m_centerY.data(); }
+    const float* CenterZ() const { return m_centerZ.data(); }
+    const float* ExtentX() const { return m_extentX.data(); }
+    const float* ExtentY() const { return m_extentY.data(); }
+    const float* ExtentZ() const { return m_extentZ.data(); }
+    const float* Radius() const { return m_radius.data(); }
+
+private:
+    uint32_t m_count = 0;
+    std::vector<float> m_centerX, m_centerY, m_centerZ;
+    std::vector<float> m_extentX, m_extentY, m_extentZ;
+    std::vector<float> m_radius;
+};
+
+namespace FrustumCulling
+{
+    enum class Shape
+    {
+        Sphere,     // Outside if the center is further than the radius behind a plane.
+        Box,        // Outside if the whole box is behind a plane.
+    };
+
+    // Writes the indices of the volumes in [begin, end) that are not outside
+    // the frustum to visible, in ascending order, and returns how many there
+    // are. Cull stores 8 indices at a time, so visible needs room for
+    // end - begin + 7 entries; CullReference tests one volume at a time.
+    // Both round every step of the plane distances on its own and return
+    // the same indices.
+    uint32_t Cull(const Frustum& frustum, const CullingBounds& bounds, Shape shape, uint32_t begin, uint32_t end, uint32_t* visible);
+    uint32_t CullReference(const Frustum& frustum, const CullingBounds& bounds, Shape shape, uint32_t begin, uint32_t end, uint32_t* visible);
+
+    // Several views (shadow cascades, cube map faces, split screens) can be
+    // culled in one pass over the bounds, so each volume is loaded once
+    // rather than once per view.
+    const uint32_t MaxViews = 16;
+
+    // Writes a mask per volume in [begin, end) to masks[i - begin], with bit
+    // v set if the volume is not outside views[v], by the same test as Cull.
+    // Throws std::invalid_argument for more than MaxViews views.
+    void CullViews(const Frustum* views, uint32_t viewCount, const CullingBounds& bounds, Shape shape, uint32_t begin, uint32_t end,
+        uint16_t* masks);
+    void CullViewsReference(const Frustum* views, uint32_t viewCount, const CullingBounds& bounds, Shape shape, uint32_t begin,
+        uint32_t end, uint16_t* masks);
+}
+
+// Culls a whole CullingBounds, in fixed size chunks spread over a JobSystem.
+// Each chunk packs its visible indices into its own part of the output, then
+// the parts are joined, so the result is in ascending order whatever the
+// thread count. CullViews writes a view mask per volume instead.
+class FrustumCuller
+{
+public:
+    static const uint32_t ChunkSize = 16384;
+
+    // Without jobs, or for a single chunk, Cull runs on the calling thread.
+    void Cull(const Frustum& frustum, const CullingBounds& bounds, FrustumCulling::Shape shape, JobSystem* jobs);
+    void CullViews(const Frustum* views, uint32_t viewCount, const CullingBounds& bounds, FrustumCulling::Shape shape, JobSystem* jobs);
+
+    const uint32_t* Visible() const { return m_visible.data(); }
+    uint32_t VisibleCount() const { return m_visibleCount; }
+
+    // One per volume, from the last CullViews.
+    const uint16_t* ViewMasks() const { return m_viewMasks.data(); }
+
+private:
+    std::vector<uint32_t> m_chunkVisible;       // ChunkSize entries per chunk, plus room for the last store.
+    std::vector<uint32_t> m_chunkCounts;
+    std::vector<uint32_t> m_visible;
+    uint32_t m_visibleCount = 0;
+    std::vector<uint16_t> m_viewMasks;
+};
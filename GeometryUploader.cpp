@@ -0,0 +1,77 @@
+#include "GeometryUploader.h"
+#include <algorithm>
+
+namespace
+{
+    // Keeps chunks cache-line aligned in staging memory.
+    const uint64_t StagingAlignment = 64;
+}
+
+GeometryUploader::GeometryUploader(ICopyQueue& queue, uint64_t stagingCapacity, uint64_t maxChunkSize) :
+    m_queue(queue),
+    m_staging(stagingCapacity),
+    m_maxChunkSize(std::max<uint64_t>(1, std::min(maxChunkSize, stagingCapacity)))
+{
+}
+
+void GeometryUploader::Upload(uint32_t destination, uint64_t destinationOffset, const void* data, uint64_t size)
+{
+    const uint8_t* source = static_cast<const uint8_t*>(data);
+    while (size > 0)
+    {
+        const uint64_t chunk = std::min(size, m_maxChunkSize);
+        const uint64_t stagingOffset = AllocateStaging(chunk);
+
+        m_queue.WriteStaging(stagingOffset, source, chunk);
+        m_queue.CopyToBuffer(destination, destinationOffset, stagingOffset, chunk);
+        m_hasPendingCopies = true;
+
+        source += chunk;
+        destinationOffset += chunk;
+        size -= chunk;
+        m_stats.bytes += chunk;
+        m_stats.chunks++;
+    }
+}
+
+uint64_t GeometryUploader::Flush()
+{
+    if (!m_hasPendingCopies)
+        return m_fenceValue;
+
+    m_queue.Execute();
+    m_queue.Signal(++m_fenceValue);
+    m_staging.FinishFrame(m_fenceValue);
+    m_inFlight.push_back(m_fenceValue);
+    m_hasPendingCopies = false;
+    m_stats.submissions++;
+    return m_fenceValue;
+}
+
+void GeometryUploader::Retire()
+{
+    const uint64_t completed = m_queue.CompletedValue();
+    while (!m_inFlight.empty() && m_inFlight.front() <= completed)
+    {
+        m_inFlight.pop_front();
+    }
+    m_staging.Retire(completed);
+}
+
+uint64_t GeometryUploader::AllocateStaging(uint64_t size)
+{
+    Retire();
+    for (;;)
+    {
+        const uint64_t offset = m_staging.Allocate(size, StagingAlignment);
+        if (offset != RingAllocator::InvalidOffset)
+            return offset;
+
+        // Out of staging space: the copies recorded so far still reference it,
+        // so submit them and wait for the oldest batch to free its range.
+        Flush();
+        m_queue.WaitForValue(m_inFlight.front());
+        m_stats.stalls++;
+        Retire();
+    }
+}
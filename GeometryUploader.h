@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include "FramePacer.h"
+#include "RingAllocator.h"
+
+// A copy queue with a staging buffer, as seen by GeometryUploader. Fence
+// values come from the IFenceQueue half. The D3D12 implementation is
+// D3D12CopyQueue; tests can substitute a mock that records the calls.
+class ICopyQueue : public IFenceQueue
+{
+public:
+    // Copies CPU data into the staging buffer at stagingOffset.
+    virtual void WriteStaging(uint64_t stagingOffset, const void* data, uint64_t size) = 0;
+    // Records a staging -> destination buffer copy.
+    virtual void CopyToBuffer(uint32_t destination, uint64_t destinationOffset, uint64_t stagingOffset, uint64_t size) = 0;
+    // Submits the copies recorded since the previous call.
+    virtual void Execute() = 0;
+};
+
+// Streams vertex/index data into GPU-local buffers through a fixed-size
+// staging ring. Large uploads are split into chunks; when the ring is full the
+// pending copies are submitted and the uploader waits for the oldest batch to
+// retire before reusing its staging space.
+//
+// Flush() returns the copy queue fence value that marks everything uploaded so
+// far as resident. Consumers on other queues should GPU-wait on that value
+// rather than block the CPU.
+class GeometryUploader
+{
+public:
+    struct Stats
+    {
+        uint64_t bytes = 0;
+        uint64_t chunks = 0;
+        uint64_t submissions = 0;
+        uint64_t stalls = 0;    // Times the CPU waited for staging space.
+    };
+
+    // stagingCapacity must match the size of the queue's staging buffer and be
+    // a multiple of 64 bytes.
+    GeometryUploader(ICopyQueue& queue, uint64_t stagingCapacity, uint64_t maxChunkSize = 1024 * 1024);
+    GeometryUploader(const GeometryUploader& rhs) = delete;
+    GeometryUploader& operator=(const GeometryUploader& rhs) = delete;
+
+    void Upload(uint32_t destination, uint64_t destinationOffset, const void* data, uint64_t size);
+
+    // Submits any recorded copies. Returns the fence value to wait on, or the
+    // last submitted value when there was nothing new.
+    uint64_t Flush();
+
+    // Frees staging space of batches that have completed.
+    void Retire();
+
+    uint64_t LastSubmittedFenceValue() const { return m_fenceValue; }
+    const Stats& GetStats() const { return m_stats; }
+
+private:
+    uint64_t AllocateStaging(uint64_t size);
+
+    ICopyQueue& m_queue;
+    RingAllocator m_staging;
+    uint64_t m_maxChunkSize;
+    uint64_t m_fenceValue = 0;
+    bool m_hasPendingCopies = false;
+    std::deque<uint64_t> m_inFlight;    // Fence values of submitted batches, oldest first.
+    Stats m_stats;
+};
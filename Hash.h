@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// 64-bit FNV-1a for cache keys. Not cryptographic; keys are only compared
+// against entries this program wrote.
+class Fnv1aHasher
+{
+public:
+    void Bytes(const void* data, size_t size)
+    {
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        for (size_t i = 0; i < size; i++)
+        {
+            m_hash = (m_hash ^ bytes[i]) * 0x100000001b3ull;
+        }
+    }
+
+    void Value(uint64_t value) { Bytes(&value, sizeof(value)); }
+
+    // Length-prefixed so "ab"+"c" and "a"+"bc" hash differently.
+    void String(const std::string& value)
+    {
+        Value(value.size());
+        Bytes(value.data(), value.size());
+    }
+
+    void String(const char* value)
+    {
+        String(std::string(value ? value : ""));
+    }
+
+    uint64_t Get() const { return m_hash; }
+
+private:
+    uint64_t m_hash = 0xcbf29ce484222325ull;
+};
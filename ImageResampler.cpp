@@ -0,0 +1,460 @@
+#include "ImageResampler.h"
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#if defined(__AVX2__)
+#define RESAMPLER_AVX2 1
+#endif
+#if defined(_M_X64) || defined(__x86_64__) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define RESAMPLER_SSE2 1
+#include <immintrin.h>
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#define RESAMPLER_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace
+{
+    using namespace ImageResampler;
+
+    const float kPi = 3.14159265358979f;
+    const size_t kRowsPerJob = 16;
+    const uint32_t kLinearToSrgbLutSize = 4096;
+
+    //-------------------------------------------------------------------------------------
+    // Transfer function tables
+    //-------------------------------------------------------------------------------------
+    struct TransferTables
+    {
+        float srgbToLinear[256];
+        float unormToFloat[256];
+        uint8_t linearToSrgb[kLinearToSrgbLutSize];
+
+        TransferTables()
+        {
+            for (int i = 0; i < 256; i++)
+            {
+                const float c = i / 255.0f;
+                srgbToLinear[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+                unormToFloat[i] = c;
+            }
+            for (uint32_t i = 0; i < kLinearToSrgbLutSize; i++)
+            {
+                const float l = i / float(kLinearToSrgbLutSize - 1);
+                const float s = l <= 0.0031308f ? l * 12.92f : 1.055f * std::pow(l, 1.0f / 2.4f) - 0.055f;
+                linearToSrgb[i] = static_cast<uint8_t>(std::min(255.0f, s * 255.0f + 0.5f));
+            }
+        }
+    };
+
+    const TransferTables& Tables()
+    {
+        static const TransferTables s_tables;
+        return s_tables;
+    }
+
+    inline float Saturate(float v)
+    {
+        return v < 0.0f ? 0.0f : (v > 1.0f ? 1.0f : v);
+    }
+
+    inline uint8_t EncodeUnorm(float v)
+    {
+        return static_cast<uint8_t>(Saturate(v) * 255.0f + 0.5f);
+    }
+
+    inline uint8_t EncodeSrgb(const TransferTables& tables, float v)
+    {
+        return tables.linearToSrgb[static_cast<uint32_t>(Saturate(v) * (kLinearToSrgbLutSize - 1) + 0.5f)];
+    }
+
+    //-------------------------------------------------------------------------------------
+    // Filter kernels
+    //-------------------------------------------------------------------------------------
+    float FilterSupport(Filter filter)
+    {
+        switch (filter)
+        {
+        case Filter::Box:       return 0.5f;
+        case Filter::Mitchell:  return 2.0f;
+        case Filter::Lanczos3:  return 3.0f;
+        }
+        return 0.5f;
+    }
+
+    float Sinc(float x)
+    {
+        if (std::fabs(x) < 1e-6f)
+            return 1.0f;
+        x *= kPi;
+        return std::sin(x) / x;
+    }
+
+    float EvaluateFilter(Filter filter, float x)
+    {
+        x = std::fabs(x);
+        switch (filter)
+        {
+        case Filter::Box:
+            return x < 0.5f ? 1.0f : 0.0f;
+
+        case Filter::Mitchell:
+        {
+            const float B = 1.0f / 3.0f;
+            const float C = 1.0f / 3.0f;
+            if (x < 1.0f)
+                return ((12 - 9 * B - 6 * C) * x * x * x + (-18 + 12 * B + 6 * C) * x * x + (6 - 2 * B)) / 6.0f;
+            if (x < 2.0f)
+                return ((-B - 6 * C) * x * x * x + (6 * B + 30 * C) * x * x + (-12 * B - 48 * C) * x + (8 * B + 24 * C)) / 6.0f;
+            return 0.0f;
+        }
+
+        case Filter::Lanczos3:
+            return x < 3.0f ? Sinc(x) * Sinc(x / 3.0f) : 0.0f;
+        }
+        return 0.0f;
+    }
+
+    // Source taps and normalized weights for every destination coordinate on one axis.
+    struct Contributions
+    {
+        std::vector<uint32_t> first;
+        std::vector<uint32_t> count;
+        std::vector<uint32_t> offset;
+        std::vector<float> weights;
+    };
+
+    Contributions BuildContributions(uint32_t srcSize, uint32_t dstSize, Filter filter)
+    {
+        Contributions c;
+        c.first.resize(dstSize);
+        c.count.resize(dstSize);
+        c.offset.resize(dstSize);
+
+        const float scale = float(srcSize) / float(dstSize);
+        const float filterScale = std::max(scale, 1.0f);
+        const float radius = FilterSupport(filter) * filterScale;
+
+        for (uint32_t i = 0; i < dstSize; i++)
+        {
+            const float center = (i + 0.5f) * scale;
+            int first = std::max(0, static_cast<int>(std::floor(center - radius)));
+            int last = std::min(int(srcSize) - 1, static_cast<int>(std::ceil(center + radius)));
+
+            const size_t offset = c.weights.size();
+            float sum = 0.0f;
+            for (int j = first; j <= last; j++)
+            {
+                const float w = EvaluateFilter(filter, (j + 0.5f - center) / filterScale);
+                c.weights.push_back(w);
+                sum += w;
+            }
+
+            if (sum == 0.0f)
+            {
+                // Box upscales can land exactly between taps; fall back to nearest.
+                c.weights.resize(offset);
+                first = std::min(int(srcSize) - 1, static_cast<int>(center));
+                last = first;
+                c.weights.push_back(1.0f);
+                sum = 1.0f;
+            }
+
+            // Trim zero weight taps from both ends to keep the inner loops short.
+            size_t begin = offset;
+            size_t end = c.weights.size();
+            while (end - begin > 1 && c.weights[begin] == 0.0f) { begin++; first++; }
+            while (end - begin > 1 && c.weights[end - 1] == 0.0f) { end--; }
+
+            c.weights.erase(c.weights.begin() + end, c.weights.end());
+            c.weights.erase(c.weights.begin() + offset, c.weights.begin() + begin);
+            for (size_t k = offset; k < c.weights.size(); k++)
+            {
+                c.weights[k] /= sum;
+            }
+
+            c.first[i] = static_cast<uint32_t>(first);
+            c.count[i] = static_cast<uint32_t>(c.weights.size() - offset);
+            c.offset[i] = static_cast<uint32_t>(offset);
+        }
+
+        return c;
+    }
+
+    //-------------------------------------------------------------------------------------
+    // Row conversion to and from linear float4
+    //-------------------------------------------------------------------------------------
+    void LoadRow(const ImageView& src, uint32_t y, float* out)
+    {
+        const uint8_t* row = src.pixels + y * src.rowPitch;
+        if (src.layout == PixelLayout::RGBA32F)
+        {
+            memcpy(out, row, size_t(src.width) * 4 * sizeof(float));
+            return;
+        }
+
+        const TransferTables& tables = Tables();
+        const float* colour = src.srgb ? tables.srgbToLinear : tables.unormToFloat;
+        const bool bgra = src.layout == PixelLayout::BGRA8;
+        for (uint32_t x = 0; x < src.width; x++, row += 4, out += 4)
+        {
+            out[0] = colour[row[bgra ? 2 : 0]];
+            out[1] = colour[row[1]];
+            out[2] = colour[row[bgra ? 0 : 2]];
+            out[3] = tables.unormToFloat[row[3]];
+        }
+    }
+
+    void StoreRow(const MutableImageView& dst, uint32_t y, const float* in)
+    {
+        uint8_t* row = dst.pixels + y * dst.rowPitch;
+        if (dst.layout == PixelLayout::RGBA32F)
+        {
+            memcpy(row, in, size_t(dst.width) * 4 * sizeof(float));
+            return;
+        }
+
+        const TransferTables& tables = Tables();
+        const bool bgra = dst.layout == PixelLayout::BGRA8;
+        for (uint32_t x = 0; x < dst.width; x++, row += 4, in += 4)
+        {
+            const uint8_t r = dst.srgb ? EncodeSrgb(tables, in[0]) : EncodeUnorm(in[0]);
+            const uint8_t g = dst.srgb ? EncodeSrgb(tables, in[1]) : EncodeUnorm(in[1]);
+            const uint8_t b = dst.srgb ? EncodeSrgb(tables, in[2]) : EncodeUnorm(in[2]);
+            row[0] = bgra ? b : r;
+            row[1] = g;
+            row[2] = bgra ? r : b;
+            row[3] = EncodeUnorm(in[3]);
+        }
+    }
+
+    //-------------------------------------------------------------------------------------
+    // SIMD kernels
+    //-------------------------------------------------------------------------------------
+
+    // out = sum(weights[k] * row[first + k]) for one float4 pixel.
+    inline void FilterPixel(float* out, const float* row, const float* weights, uint32_t count)
+    {
+#if defined(RESAMPLER_SSE2)
+        __m128 acc = _mm_setzero_ps();
+        for (uint32_t k = 0; k < count; k++)
+        {
+            acc = _mm_add_ps(acc, _mm_mul_ps(_mm_set1_ps(weights[k]), _mm_loadu_ps(row + k * 4)));
+        }
+        _mm_storeu_ps(out, acc);
+#elif defined(RESAMPLER_NEON)
+        float32x4_t acc = vdupq_n_f32(0.0f);
+        for (uint32_t k = 0; k < count; k++)
+        {
+            acc = vmlaq_n_f32(acc, vld1q_f32(row + k * 4), weights[k]);
+        }
+        vst1q_f32(out, acc);
+#else
+        float acc[4] = {};
+        for (uint32_t k = 0; k < count; k++)
+        {
+            for (int c = 0; c < 4; c++)
+                acc[c] += weights[k] * row[k * 4 + c];
+        }
+        memcpy(out, acc, sizeof(acc));
+#endif
+    }
+
+    // acc[i] += w * src[i] over a whole row of floats.
+    inline void AccumulateRow(float* acc, const float* src, float w, size_t n)
+    {
+        size_t i = 0;
+#if defined(RESAMPLER_AVX2)
+        const __m256 w8 = _mm256_set1_ps(w);
+        for (; i + 8 <= n; i += 8)
+        {
+            _mm256_storeu_ps(acc + i, _mm256_add_ps(_mm256_loadu_ps(acc + i), _mm256_mul_ps(w8, _mm256_loadu_ps(src + i))));
+        }
+#endif
+#if defined(RESAMPLER_SSE2)
+        const __m128 w4 = _mm_set1_ps(w);
+        for (; i + 4 <= n; i += 4)
+        {
+            _mm_storeu_ps(acc + i, _mm_add_ps(_mm_loadu_ps(acc + i), _mm_mul_ps(w4, _mm_loadu_ps(src + i))));
+        }
+#elif defined(RESAMPLER_NEON)
+        for (; i + 4 <= n; i += 4)
+        {
+            vst1q_f32(acc + i, vmlaq_n_f32(vld1q_f32(acc + i), vld1q_f32(src + i), w));
+        }
+#endif
+        for (; i < n; i++)
+        {
+            acc[i] += w * src[i];
+        }
+    }
+
+    // Swaps the R and B bytes of packed 8-bit pixels (RGBA8 <-> BGRA8).
+    void SwizzleRedBlue(const uint8_t* src, uint8_t* dst, size_t pixels)
+    {
+        size_t i = 0;
+#if defined(RESAMPLER_AVX2)
+        const __m256i shuffle = _mm256_setr_epi8(
+            2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+            2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+        for (; i + 8 <= pixels; i += 8)
+        {
+            const __m256i p = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i * 4));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i * 4), _mm256_shuffle_epi8(p, shuffle));
+        }
+#endif
+#if defined(RESAMPLER_SSE2)
+        const __m128i keep = _mm_set1_epi32(static_cast<int>(0xFF00FF00));
+        const __m128i low = _mm_set1_epi32(0x000000FF);
+        for (; i + 4 <= pixels; i += 4)
+        {
+            const __m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4));
+            const __m128i r = _mm_or_si128(_mm_and_si128(p, keep),
+                _mm_or_si128(_mm_and_si128(_mm_srli_epi32(p, 16), low), _mm_slli_epi32(_mm_and_si128(p, low), 16)));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4), r);
+        }
+#elif defined(RESAMPLER_NEON)
+        for (; i + 16 <= pixels; i += 16)
+        {
+            uint8x16x4_t p = vld4q_u8(src + i * 4);
+            const uint8x16_t t = p.val[0];
+            p.val[0] = p.val[2];
+            p.val[2] = t;
+            vst4q_u8(dst + i * 4, p);
+        }
+#endif
+        for (; i < pixels; i++)
+        {
+            const uint8_t r = src[i * 4 + 0];
+            dst[i * 4 + 0] = src[i * 4 + 2];
+            dst[i * 4 + 1] = src[i * 4 + 1];
+            dst[i * 4 + 2] = r;
+            dst[i * 4 + 3] = src[i * 4 + 3];
+        }
+    }
+
+    bool IsValid(const ImageView& src, const MutableImageView& dst)
+    {
+        return src.pixels && dst.pixels && src.width && src.height && dst.width && dst.height
+            && src.rowPitch >= src.width * BytesPerPixel(src.layout)
+            && dst.rowPitch >= dst.width * BytesPerPixel(dst.layout);
+    }
+
+    bool IsEightBit(PixelLayout layout)
+    {
+        return layout == PixelLayout::RGBA8 || layout == PixelLayout::BGRA8;
+    }
+}
+
+size_t ImageResampler::BytesPerPixel(PixelLayout layout)
+{
+    return layout == PixelLayout::RGBA32F ? 16 : 4;
+}
+
+void ImageResampler::SrgbToLinear(const uint8_t* src, float* dst, size_t count)
+{
+    const TransferTables& tables = Tables();
+    for (size_t i = 0; i < count; i++)
+    {
+        dst[i] = tables.srgbToLinear[src[i]];
+    }
+}
+
+void ImageResampler::LinearToSrgb(const float* src, uint8_t* dst, size_t count)
+{
+    const TransferTables& tables = Tables();
+    for (size_t i = 0; i < count; i++)
+    {
+        dst[i] = EncodeSrgb(tables, src[i]);
+    }
+}
+
+bool ImageResampler::Convert(const ImageView& src, const MutableImageView& dst)
+{
+    if (!IsValid(src, dst) || src.width != dst.width || src.height != dst.height)
+        return false;
+
+    // 8-bit to 8-bit with the same transfer function is a plain copy or swizzle.
+    if (IsEightBit(src.layout) && IsEightBit(dst.layout) && src.srgb == dst.srgb)
+    {
+        const bool swap = src.layout != dst.layout;
+        JobSystem::Get().ParallelFor(src.height, kRowsPerJob, [&](size_t begin, size_t end)
+        {
+            for (size_t y = begin; y < end; y++)
+            {
+                const uint8_t* s = src.pixels + y * src.rowPitch;
+                uint8_t* d = dst.pixels + y * dst.rowPitch;
+                if (swap)
+                    SwizzleRedBlue(s, d, src.width);
+                else
+                    memcpy(d, s, size_t(src.width) * 4);
+            }
+        });
+        return true;
+    }
+
+    JobSystem::Get().ParallelFor(src.height, kRowsPerJob, [&](size_t begin, size_t end)
+    {
+        std::vector<float> row(size_t(src.width) * 4);
+        for (size_t y = begin; y < end; y++)
+        {
+            LoadRow(src, static_cast<uint32_t>(y), row.data());
+            StoreRow(dst, static_cast<uint32_t>(y), row.data());
+        }
+    });
+    return true;
+}
+
+bool ImageResampler::Resize(const ImageView& src, const MutableImageView& dst, Filter filter)
+{
+    if (!IsValid(src, dst))
+        return false;
+
+    if (src.width == dst.width && src.height == dst.height)
+        return Convert(src, dst);
+
+    const Contributions horizontal = BuildContributions(src.width, dst.width, filter);
+    const Contributions vertical = BuildContributions(src.height, dst.height, filter);
+
+    // Horizontal pass: every source row becomes a dst.width row of linear float4.
+    const size_t tempStride = size_t(dst.width) * 4;
+    std::vector<float> temp(tempStride * src.height);
+
+    JobSystem& jobs = JobSystem::Get();
+    jobs.ParallelFor(src.height, kRowsPerJob, [&](size_t begin, size_t end)
+    {
+        std::vector<float> row(size_t(src.width) * 4);
+        for (size_t y = begin; y < end; y++)
+        {
+            LoadRow(src, static_cast<uint32_t>(y), row.data());
+            float* out = temp.data() + y * tempStride;
+            for (uint32_t x = 0; x < dst.width; x++)
+            {
+                FilterPixel(out + x * 4, row.data() + horizontal.first[x] * 4,
+                    horizontal.weights.data() + horizontal.offset[x], horizontal.count[x]);
+            }
+        }
+    });
+
+    // Vertical pass: weighted sum of whole temp rows per destination row.
+    jobs.ParallelFor(dst.height, kRowsPerJob, [&](size_t begin, size_t end)
+    {
+        std::vector<float> acc(tempStride);
+        for (size_t y = begin; y < end; y++)
+        {
+            std::fill(acc.begin(), acc.end(), 0.0f);
+            const float* weights = vertical.weights.data() + vertical.offset[y];
+            for (uint32_t k = 0; k < vertical.count[y]; k++)
+            {
+                AccumulateRow(acc.data(), temp.data() + (vertical.first[y] + k) * tempStride, weights[k], tempStride);
+            }
+            StoreRow(dst, static_cast<uint32_t>(y), acc.data());
+        }
+    });
+
+    return true;
+}
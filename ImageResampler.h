@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Portable replacement for the IWICBitmapScaler / IWICFormatConverter paths in
+// WICTextureLoader12.cpp. Filtering happens in linear light: sRGB inputs are
+// decoded through a lookup table, filtered as float4 and re-encoded on output.
+// Rows are distributed over the JobSystem, inner loops use AVX2/SSE2/NEON.
+// Nothing here depends on Windows so the offline cooker can link it as well.
+namespace ImageResampler
+{
+    enum class Filter
+    {
+        Box,        // Averaging; cheapest, fine for exact power of two reductions.
+        Mitchell,   // Mitchell-Netravali (B = C = 1/3); soft, no visible ringing.
+        Lanczos3,   // Sharpest; slight ringing on hard edges.
+    };
+
+    enum class PixelLayout
+    {
+        RGBA8,
+        BGRA8,
+        RGBA32F,
+    };
+
+    struct ImageView
+    {
+        const uint8_t* pixels;
+        uint32_t width;
+        uint32_t height;
+        size_t rowPitch;
+        PixelLayout layout;
+        bool srgb;          // Colour channels are sRGB encoded (alpha is always linear).
+    };
+
+    struct MutableImageView
+    {
+        uint8_t* pixels;
+        uint32_t width;
+        uint32_t height;
+        size_t rowPitch;
+        PixelLayout layout;
+        bool srgb;
+    };
+
+    size_t BytesPerPixel(PixelLayout layout);
+
+    // sRGB <-> linear transfer through lookup tables.
+    void SrgbToLinear(const uint8_t* src, float* dst, size_t count);
+    void LinearToSrgb(const float* src, uint8_t* dst, size_t count);
+
+    // Layout and transfer function conversion; dst must match src dimensions.
+    bool Convert(const ImageView& src, const MutableImageView& dst);
+
+    // Separable resize from src to dst dimensions, converting layout and transfer
+    // function on the way. Returns false for empty images or mismatched views.
+    bool Resize(const ImageView& src, const MutableImageView& dst, Filter filter);
+}
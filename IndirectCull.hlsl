@@ -0,0 +1,114 @@
+// Frustum culls IndirectObjects and writes a compacted ExecuteIndirect command
+// list plus its draw count. Layouts match IndirectCulling.h, whose
+// CullAndCompact is the CPU reference for this shader: the output has to be
+// identical, byte for byte.
+//
+// A single group walks the objects in chunks of GroupSize and places the
+// visible ones with a prefix sum, so the commands come out in object order
+// rather than in whatever order atomics happen to resolve.
+
+#define GroupSize 256
+
+cbuffer CullConstants : register(b0)
+{
+    float4 planes[6];
+    uint objectCount;
+};
+
+struct IndirectObject
+{
+    float3 center;
+    float radius;
+    uint vertexCount;
+    uint firstVertex;
+    uint textureSlot;
+    uint padding;
+};
+
+struct IndirectDrawCommand
+{
+    uint textureSlot;
+    uint vertexCountPerInstance;
+    uint instanceCount;
+    uint startVertexLocation;
+    uint startInstanceLocation;
+};
+
+StructuredBuffer<IndirectObject> objects : register(t0);
+RWStructuredBuffer<IndirectDrawCommand> commands : register(u0);
+RWByteAddressBuffer drawCount : register(u1);
+
+groupshared uint scan[2][GroupSize];
+
+bool IsVisible(IndirectObject object)
+{
+    [unroll]
+    for (uint i = 0; i < 6; i++)
+    {
+        // precise keeps each step a separately rounded multiply or add, as in
+        // the reference; a fused multiply-add would round differently.
+        precise float distance = planes[i].x * object.center.x;
+        distance = distance + planes[i].y * object.center.y;
+        distance = distance + planes[i].z * object.center.z;
+        distance = distance + planes[i].w;
+        if (distance < -object.radius)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+[numthreads(GroupSize, 1, 1)]
+void CSMain(uint thread : SV_GroupIndex)
+{
+    uint written = 0;
+    for (uint first = 0; first < objectCount; first += GroupSize)
+    {
+        const uint index = first + thread;
+        IndirectObject object = (IndirectObject)0;
+        bool visible = false;
+        if (index < objectCount)
+        {
+            object = objects[index];
+            visible = IsVisible(object);
+        }
+
+        // Inclusive Hillis-Steele scan of the visibility flags.
+        uint source = 0;
+        scan[source][thread] = visible ? 1 : 0;
+        GroupMemoryBarrierWithGroupSync();
+        [unroll]
+        for (uint offset = 1; offset < GroupSize; offset <<= 1)
+        {
+            uint sum = scan[source][thread];
+            if (thread >= offset)
+            {
+                sum += scan[source][thread - offset];
+            }
+            scan[source ^ 1][thread] = sum;
+            source ^= 1;
+            GroupMemoryBarrierWithGroupSync();
+        }
+
+        if (visible)
+        {
+            IndirectDrawCommand command;
+            command.textureSlot = object.textureSlot;
+            command.vertexCountPerInstance = object.vertexCount;
+            command.instanceCount = 1;
+            command.startVertexLocation = object.firstVertex;
+            command.startInstanceLocation = 0;
+            commands[written + scan[source][thread] - 1] = command;
+        }
+        written += scan[source][GroupSize - 1];
+
+        // The next chunk overwrites the scan buffers.
+        GroupMemoryBarrierWithGroupSync();
+    }
+
+    if (thread == 0)
+    {
+        drawCount.Store(0, written);
+    }
+}
@@ -0,0 +1,121 @@
+#include "StrictFloat.h"
+#include "IndirectCulling.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+namespace
+{
+    // Signed distance from a plane, rounded after every step like the shader's
+    // precise arithmetic; StrictFloat.h keeps the steps from being fused.
+    float PlaneDistance(const float plane[4], const float center[3])
+    {
+        float distance = plane[0] * center[0];
+        distance = distance + plane[1] * center[1];
+        distance = distance + plane[2] * center[2];
+        return distance + plane[3];
+    }
+}
+
+namespace IndirectCulling
+{
+    IndirectCullConstants MakeConstants(const Frustum& frustum, uint32_t objectCount)
+    {
+        IndirectCullConstants constants;
+        std::memcpy(constants.planes, frustum.planes, sizeof(constants.planes));
+        constants.objectCount = objectCount;
+        return constants;
+    }
+
+    bool IsVisible(const IndirectCullConstants& constants, const IndirectObject& object)
+    {
+        for (const float* plane : constants.planes)
+        {
+            if (PlaneDistance(plane, object.center) < -object.radius)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    uint32_t CullAndCompact(const IndirectCullConstants& constants, const IndirectObject* objects, IndirectDrawCommand* commands)
+    {
+        uint32_t drawCount = 0;
+        for (uint32_t i = 0; i < constants.objectCount; i++)
+        {
+            const IndirectObject& object = objects[i];
+            if (IsVisible(constants, object))
+            {
+                IndirectDrawCommand& command = commands[drawCount++];
+                command.textureSlot = object.textureSlot;
+                command.vertexCountPerInstance = object.vertexCount;
+                command.instanceCount = 1;
+                command.startVertexLocation = object.firstVertex;
+                command.startInstanceLocation = 0;
+            }
+        }
+        return drawCount;
+    }
+
+    std::vector<IndirectObject> BuildObjects(const void* positions, size_t positionStride, uint32_t vertexCount,
+        uint32_t verticesPerObject, uint32_t textureSlot)
+    {
+        verticesPerObject -= verticesPerObject % 3;
+        if (verticesPerObject == 0)
+        {
+            throw std::invalid_argument("IndirectCulling::BuildObjects: an object needs at least one triangle");
+        }
+
+        const unsigned char* bytes = static_cast<const unsigned char*>(positions);
+        auto position = [&](uint32_t vertex)
+        {
+            return reinterpret_cast<const float*>(bytes + vertex * positionStride);
+        };
+
+        std::vector<IndirectObject> objects;
+        objects.reserve((vertexCount + verticesPerObject - 1) / verticesPerObject);
+        for (uint32_t first = 0; first < vertexCount; first += verticesPerObject)
+        {
+            const uint32_t count = std::min(verticesPerObject, vertexCount - first);
+
+            // Sphere around the box center: not minimal, but cheap and never
+            // smaller than the geometry.
+            float low[3] = { position(first)[0], position(first)[1], position(first)[2] };
+            float high[3] = { low[0], low[1], low[2] };
+            for (uint32_t vertex = first + 1; vertex < first + count; vertex++)
+            {
+                const float* p = position(vertex);
+                for (int axis = 0; axis < 3; axis++)
+                {
+                    low[axis] = std::min(low[axis], p[axis]);
+                    high[axis] = std::max(high[axis], p[axis]);
+                }
+            }
+
+            IndirectObject object = {};
+            float radiusSquared = 0.0f;
+            for (int axis = 0; axis < 3; axis++)
+            {
+                object.center[axis] = 0.5f * (low[axis] + high[axis]);
+            }
+            for (uint32_t vertex = first; vertex < first + count; vertex++)
+            {
+                const float* p = position(vertex);
+                const float dx = p[0] - object.center[0];
+                const float dy = p[1] - object.center[1];
+                const float dz = p[2] - object.center[2];
+                radiusSquared = std::max(radiusSquared, dx * dx + dy * dy + dz * dz);
+            }
+
+            // Pad by a relative epsilon to cover rounding in the square root.
+            object.radius = std::sqrt(radiusSquared) * 1.0001f;
+            object.vertexCount = count;
+            object.firstVertex = first;
+            object.textureSlot = textureSlot;
+            objects.push_back(object);
+        }
+        return objects;
+    }
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Frustum.h"
+
+// CPU reference for the GPU cull-and-compact pass in IndirectCull.hlsl. The
+// structures match the shader's buffers byte for byte, and the visibility
+// test performs the same float operations in the same order, so the GPU
+// output can be compared with this one exactly.
+
+// One cullable object: a bounding sphere and the vertex range it draws.
+struct IndirectObject
+{
+    float center[3];
+    float radius;
+    uint32_t vertexCount;
+    uint32_t firstVertex;
+    uint32_t textureSlot;
+    uint32_t padding;
+};
+static_assert(sizeof(IndirectObject) == 32, "IndirectObject must match IndirectCull.hlsl");
+
+// One ExecuteIndirect command: the texture slot root constant followed by
+// D3D12_DRAW_ARGUMENTS.
+struct IndirectDrawCommand
+{
+    uint32_t textureSlot;
+    uint32_t vertexCountPerInstance;
+    uint32_t instanceCount;
+    uint32_t startVertexLocation;
+    uint32_t startInstanceLocation;
+};
+static_assert(sizeof(IndirectDrawCommand) == 20, "IndirectDrawCommand must match IndirectCull.hlsl");
+
+// Root constants of the cull pass.
+struct IndirectCullConstants
+{
+    float planes[6][4];
+    uint32_t objectCount;
+};
+
+namespace IndirectCulling
+{
+    // Threads per group in IndirectCull.hlsl.
+    const uint32_t GroupSize = 256;
+
+    IndirectCullConstants MakeConstants(const Frustum& frustum, uint32_t objectCount);
+
+    // Same test as the shader: outside if the center is further than radius
+    // behind any plane. Each step is a separately rounded multiply or add.
+    bool IsVisible(const IndirectCullConstants& constants, const IndirectObject& object);
+
+    // Writes a command per visible object, in object order, and returns the
+    // draw count. commands must have room for constants.objectCount entries.
+    uint32_t CullAndCompact(const IndirectCullConstants& constants, const IndirectObject* objects, IndirectDrawCommand* commands);
+
+    // Splits a triangle list into objects of at most verticesPerObject
+    // vertices (rounded down to whole triangles), each with a bounding sphere.
+    // positions has a stride of positionStride bytes.
+    std::vector<IndirectObject> BuildObjects(const void* positions, size_t positionStride, uint32_t vertexCount,
+        uint32_t verticesPerObject, uint32_t textureSlot);
+}
@@ -0,0 +1,90 @@
+#include "InstanceBatcher.h"
+#include <cstring>
+#include <stdexcept>
+
+bool InstanceBatcher::GroupKey::operator==(const GroupKey& rhs) const
+{
+    return pipeline == rhs.pipeline && albedo == rhs.albedo && vertexBuffer == rhs.vertexBuffer &&
+        vertexStride == rhs.vertexStride && vertexCount == rhs.vertexCount && firstVertex == rhs.firstVertex;
+}
+
+size_t InstanceBatcher::GroupKeyHash::operator()(const GroupKey& key) const
+{
+    const uint32_t fields[] = { key.pipeline, key.albedo, key.vertexBuffer, key.vertexStride, key.vertexCount, key.firstVertex };
+    uint64_t hash = 0;
+    for (uint32_t field : fields)
+    {
+        hash = (hash ^ field) * 0x9E3779B97F4A7C15ull;
+        hash ^= hash >> 29;
+    }
+    return static_cast<size_t>(hash);
+}
+
+InstanceBatcher::GroupKey InstanceBatcher::KeyOf(const DrawItem& item)
+{
+    GroupKey key = { item.pipeline.index, item.albedo.index, item.vertexBuffer.index, item.vertexStride, item.vertexCount, item.firstVertex };
+    return key;
+}
+
+void InstanceBatcher::Reset()
+{
+    m_groupIndices.clear();
+    m_groups.clear();
+    m_instances.clear();
+    m_instanceGroups.clear();
+    m_lastGroup = ~0u;
+}
+
+void InstanceBatcher::Add(const DrawItem& mesh, const InstanceData& instance)
+{
+    // Scenes tend to add the copies of a mesh one after the other, so the
+    // previous group is checked before the map.
+    const GroupKey key = KeyOf(mesh);
+    if (m_lastGroup == ~0u || !(key == m_lastKey))
+    {
+        auto inserted = m_groupIndices.insert(std::make_pair(key, static_cast<uint32_t>(m_groups.size())));
+        if (inserted.second)
+        {
+            Group group = { mesh, 0 };
+            m_groups.push_back(group);
+        }
+        m_lastKey = key;
+        m_lastGroup = inserted.first->second;
+    }
+
+    m_groups[m_lastGroup].instanceCount++;
+    m_instances.push_back(instance);
+    m_instanceGroups.push_back(m_lastGroup);
+}
+
+void InstanceBatcher::Build(BufferHandle buffer, uint64_t bufferOffset, void* destination, std::vector<DrawItem>& draws)
+{
+    if (bufferOffset % sizeof(InstanceData) != 0)
+    {
+        throw std::invalid_argument("InstanceBatcher: buffer offset must be a multiple of sizeof(InstanceData)");
+    }
+
+    // A counting sort by group: each group's records start where the
+    // previous group's end, and within a group keep their add order.
+    m_cursors.resize(m_groups.size());
+    uint32_t next = 0;
+    for (size_t i = 0; i < m_groups.size(); i++)
+    {
+        const Group& group = m_groups[i];
+        m_cursors[i] = next;
+
+        DrawItem draw = group.draw;
+        draw.instanceBuffer = buffer;
+        draw.instanceOffset = bufferOffset + static_cast<uint64_t>(next) * sizeof(InstanceData);
+        draw.instanceCount = group.instanceCount;
+        draws.push_back(draw);
+
+        next += group.instanceCount;
+    }
+
+    InstanceData* records = static_cast<InstanceData*>(destination);
+    for (size_t i = 0; i < m_instances.size(); i++)
+    {
+        memcpy(&records[m_cursors[m_instanceGroups[i]]++], &m_instances[i], sizeof(InstanceData));
+    }
+}
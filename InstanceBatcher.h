@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "DrawList.h"
+
+// Turns many placements of a few meshes into a few instanced draws. Instances
+// are added one at a time with the draw they belong to; instances of the same
+// mesh (vertex buffer, stride and vertex range) with the same pipeline and
+// albedo texture become a single draw whose InstanceData records are stored
+// next to each other.
+class InstanceBatcher
+{
+public:
+    void Reset();
+
+    // The instance fields of mesh are ignored.
+    void Add(const DrawItem& mesh, const InstanceData& instance);
+
+    size_t InstanceCount() const { return m_instances.size(); }
+    size_t DrawCount() const { return m_groups.size(); }
+    // Bytes of InstanceData that Build writes.
+    uint64_t DataSize() const { return m_instances.size() * sizeof(InstanceData); }
+
+    // Writes the instance data, grouped by draw, to destination, which is
+    // where bufferOffset of buffer is mapped, and appends one draw per group
+    // to draws in the order the groups were first added. bufferOffset must be
+    // a multiple of sizeof(InstanceData).
+    void Build(BufferHandle buffer, uint64_t bufferOffset, void* destination, std::vector<DrawItem>& draws);
+
+private:
+    struct GroupKey
+    {
+        uint32_t pipeline;
+        uint32_t albedo;
+        uint32_t vertexBuffer;
+        uint32_t vertexStride;
+        uint32_t vertexCount;
+        uint32_t firstVertex;
+
+        bool operator==(const GroupKey& rhs) const;
+    };
+
+    struct GroupKeyHash
+    {
+        size_t operator()(const GroupKey& key) const;
+    };
+
+    struct Group
+    {
+        DrawItem draw;
+        uint32_t instanceCount;
+    };
+
+    static GroupKey KeyOf(const DrawItem& item);
+
+    std::unordered_map<GroupKey, uint32_t, GroupKeyHash> m_groupIndices;
+    std::vector<Group> m_groups;
+    std::vector<InstanceData> m_instances;
+    std::vector<uint32_t> m_instanceGroups;    // Group of each instance, in add order.
+    std::vector<uint32_t> m_cursors;           // Next record of each group, during Build.
+    GroupKey m_lastKey = {};
+    uint32_t m_lastGroup = ~0u;
+};
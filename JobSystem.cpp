@@ -0,0 +1,147 @@
+#include "JobSystem.h"
+
+#include <algorithm>
+
+namespace
+{
+    thread_local bool t_insideJob = false;
+}
+
+JobSystem::JobSystem(unsigned workerCount)
+{
+    if (workerCount == 0)
+    {
+        const unsigned hw = std::thread::hardware_concurrency();
+        workerCount = hw > 1 ? hw - 1 : 0;
+    }
+
+    m_workers.reserve(workerCount);
+    for (unsigned i = 0; i < workerCount; i++)
+    {
+        m_workers.emplace_back(&JobSystem::WorkerMain, this);
+    }
+}
+
+JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+
+    for (std::thread& worker : m_workers)
+    {
+        worker.join();
+    }
+}
+
+JobSystem& JobSystem::Get()
+{
+    static JobSystem s_jobSystem;
+    return s_jobSystem;
+}
+
+void JobSystem::ParallelFor(size_t count, size_t grain, const std::function<void(size_t, size_t)>& fn)
+{
+    if (count == 0)
+    {
+        return;
+    }
+    grain = std::max<size_t>(grain, 1);
+
+    // Small batches, nested calls and single threaded pools are not worth a wake-up.
+    if (t_insideJob || m_workers.empty() || count <= grain)
+    {
+        fn(0, count);
+        return;
+    }
+
+    std::lock_guard<std::mutex> submit(m_submitMutex);
+
+    Batch batch;
+    batch.fn = &fn;
+    batch.count = count;
+    batch.grain = grain;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_batch = &batch;
+        m_batchId++;
+    }
+    m_wake.notify_all();
+
+    t_insideJob = true;
+    RunChunks(batch);
+    t_insideJob = false;
+
+    // The batch lives on this stack frame, so wait for stragglers to let go of
+    // it, even when a chunk threw and others were skipped.
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done.wait(lock, [&] { return (batch.failed.load() || batch.completed.load() == count) && batch.workers == 0; });
+    m_batch = nullptr;
+    lock.unlock();
+
+    if (batch.error)
+    {
+        std::rethrow_exception(batch.error);
+    }
+}
+
+void JobSystem::RunChunks(Batch& batch)
+{
+    for (;;)
+    {
+        const size_t begin = batch.next.fetch_add(batch.grain);
+        if (begin >= batch.count)
+        {
+            return;
+        }
+
+        const size_t end = std::min(begin + batch.grain, batch.count);
+        try
+        {
+            (*batch.fn)(begin, end);
+        }
+        catch (...)
+        {
+            // Keep the first exception for the caller and hand out no more chunks.
+            if (!batch.failed.exchange(true))
+            {
+                batch.error = std::current_exception();
+            }
+            batch.next.store(batch.count);
+            return;
+        }
+        batch.completed.fetch_add(end - begin);
+    }
+}
+
+void JobSystem::WorkerMain()
+{
+    t_insideJob = true;
+    unsigned long long seenBatch = 0;
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (;;)
+    {
+        m_wake.wait(lock, [&] { return m_stop || (m_batch != nullptr && m_batchId != seenBatch); });
+        if (m_stop)
+        {
+            return;
+        }
+
+        seenBatch = m_batchId;
+        Batch* batch = m_batch;
+        batch->workers++;
+        lock.unlock();
+
+        RunChunks(*batch);
+
+        lock.lock();
+        if (--batch->workers == 0)
+        {
+            m_done.notify_all();
+        }
+    }
+}
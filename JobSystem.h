@@ -0,0 +1,60 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Small persistent worker pool used for data-parallel engine work (image
+// resampling, culling, command recording). It has no Windows dependencies so
+// the same code runs in the offline tools.
+class JobSystem
+{
+public:
+    // workerCount == 0 picks hardware_concurrency() - 1 (the caller participates).
+    explicit JobSystem(unsigned workerCount = 0);
+    JobSystem(const JobSystem& rhs) = delete;
+    JobSystem& operator=(const JobSystem& rhs) = delete;
+    ~JobSystem();
+
+    // Process-wide pool shared by engine systems.
+    static JobSystem& Get();
+
+    // Number of threads that execute work, including the calling thread.
+    unsigned ThreadCount() const { return static_cast<unsigned>(m_workers.size()) + 1; }
+
+    // Invokes fn(begin, end) over [0, count) in chunks of at most grain items and
+    // blocks until every chunk has run. Nested calls from inside a job run inline.
+    // If fn throws, chunks not yet started are skipped and the first exception
+    // is rethrown here, once no worker is still running a chunk.
+    void ParallelFor(size_t count, size_t grain, const std::function<void(size_t, size_t)>& fn);
+
+private:
+    struct Batch
+    {
+        const std::function<void(size_t, size_t)>* fn;
+        size_t count;
+        size_t grain;
+        std::atomic<size_t> next{ 0 };
+        std::atomic<size_t> completed{ 0 };
+        unsigned workers = 0;
+        std::atomic<bool> failed{ false };
+        std::exception_ptr error;               // Set by the first chunk to throw.
+    };
+
+    void WorkerMain();
+    static void RunChunks(Batch& batch);
+
+    std::vector<std::thread> m_workers;
+    std::mutex m_submitMutex;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_done;
+    Batch* m_batch = nullptr;
+    unsigned long long m_batchId = 0;
+    bool m_stop = false;
+};
@@ -0,0 +1,383 @@
+#include "NullRenderDevice.h"
+#include <cstring>
+#include <stdexcept>
+
+namespace
+{
+    void Validate(bool condition, const char* message)
+    {
+        if (!condition)
+        {
+            throw std::logic_error(message);
+        }
+    }
+}
+
+void NullFenceQueue::Signal(uint64_t value)
+{
+    Validate(value > m_completed, "Fence values must increase");
+    m_completed = value;
+}
+
+void NullFenceQueue::WaitForValue(uint64_t value)
+{
+    Validate(value <= m_completed, "Waiting on a fence value that was never signaled");
+}
+
+//--------------------------------------------------------------------------------------
+
+class NullRenderDevice::CommandList : public IRenderCommandList
+{
+public:
+    CommandList(NullRenderDevice& device, bool bundle) : m_device(device), m_bundle(bundle) {}
+
+    virtual void Begin(uint32_t frameSlot)
+    {
+        Validate(!m_recording, "Begin called on a list that is already recording");
+        (void)frameSlot;
+        m_commands.clear();
+        m_pipeline = PipelineHandle();
+        m_vertexBuffer = BufferHandle();
+        m_indexBuffer = BufferHandle();
+        m_instanceBuffer = BufferHandle();
+        m_draws = 0;
+        m_recording = true;
+        m_recorded = false;
+    }
+
+    virtual void End()
+    {
+        Validate(m_recording, "End called on a list that is not recording");
+        m_recording = false;
+        m_recorded = true;
+    }
+
+    virtual void SetPipeline(PipelineHandle pipeline)
+    {
+        Validate(m_recording, "Recording into a closed list");
+        Validate(m_device.IsLive(pipeline), "SetPipeline: invalid pipeline");
+        m_pipeline = pipeline;
+        Record(CommandType::SetPipeline, pipeline.index);
+    }
+
+    virtual void SetConstantBuffer(uint32_t slot, BufferHandle buffer, uint64_t offset)
+    {
+        Validate(m_recording, "Recording into a closed list");
+        Validate(slot < MaxConstantBufferSlots, "SetConstantBuffer: slot out of range");
+        const Buffer* data = m_device.FindBuffer(buffer);
+        Validate(data != nullptr, "SetConstantBuffer: invalid buffer");
+        Validate(offset % ConstantBufferAlignment == 0, "SetConstantBuffer: offset must be 256-byte aligned");
+        Validate(offset < data->desc.size, "SetConstantBuffer: offset past the end of the buffer");
+        Record(CommandType::SetConstantBuffer, slot, buffer.index, static_cast<uint32_t>(offset), static_cast<uint32_t>(offset >> 32));
+    }
+
+    virtual void SetTexture(uint32_t slot, TextureHandle texture)
+    {
+        Validate(m_recording, "Recording into a closed list");
+        Validate(slot < MaxTextureSlots, "SetTexture: slot out of range");
+        Validate(m_device.IsLive(texture), "SetTexture: invalid texture");
+        Record(CommandType::SetTexture, slot, texture.index);
+    }
+
+    virtual void SetVertexBuffer(BufferHandle buffer, uint32_t stride, uint64_t offset)
+    {
+        Validate(m_recording, "Recording into a closed list");
+        const Buffer* data = m_device.FindBuffer(buffer);
+        Validate(data != nullptr, "SetVertexBuffer: invalid buffer");
+        Validate(stride > 0, "SetVertexBuffer: zero stride");
+        Validate(offset <= data->desc.size, "SetVertexBuffer: offset past the end of the buffer");
+        m_vertexBuffer = buffer;
+        m_vertexStride = stride;
+        m_vertexOffset = offset;
+        Record(CommandType::SetVertexBuffer, buffer.index, stride, static_cast<uint32_t>(offset), static_cast<uint32_t>(offset >> 32));
+    }
+
+    virtual void SetIndexBuffer(BufferHandle buffer, uint64_t offset)
+    {
+        Validate(m_recording, "Recording into a closed list");
+        const Buffer* data = m_device.FindBuffer(buffer);
+        Validate(data != nullptr, "SetIndexBuffer: invalid buffer");
+        Validate(offset % sizeof(uint32_t) == 0, "SetIndexBuffer: offset must be 4-byte aligned");
+        Validate(offset <= data->desc.size, "SetIndexBuffer: offset past the end of the buffer");
+        m_indexBuffer = buffer;
+        m_indexOffset = offset;
+        Record(CommandType::SetIndexBuffer, buffer.index, static_cast<uint32_t>(offset), static_cast<uint32_t>(offset >> 32));
+    }
+
+    virtual void SetInstanceBuffer(BufferHandle buffer, uint64_t offset)
+    {
+        Validate(m_recording, "Recording into a closed list");
+        const Buffer* data = m_device.FindBuffer(buffer);
+        Validate(data != nullptr, "SetInstanceBuffer: invalid buffer");
+        Validate(offset % sizeof(InstanceData) == 0, "SetInstanceBuffer: offset must be a multiple of the record size");
+        Validate(offset <= data->desc.size, "SetInstanceBuffer: offset past the end of the buffer");
+        m_instanceBuffer = buffer;
+        m_instanceOffset = offset;
+        Record(CommandType::SetInstanceBuffer, buffer.index, static_cast<uint32_t>(offset), static_cast<uint32_t>(offset >> 32));
+    }
+
+    virtual void SetShaderBuffer(uint32_t slot, BufferHandle buffer, uint64_t offset)
+    {
+        Validate(m_recording, "Recording into a closed list");
+        Validate(slot < MaxShaderBufferSlots, "SetShaderBuffer: slot out of range");
+        const Buffer* data = m_device.FindBuffer(buffer);
+        Validate(data != nullptr, "SetShaderBuffer: invalid buffer");
+        Validate(offset % 4 == 0, "SetShaderBuffer: offset must be 4-byte aligned");
+        Validate(offset <= data->desc.size, "SetShaderBuffer: offset past the end of the buffer");
+        Record(CommandType::SetShaderBuffer, slot, buffer.index, static_cast<uint32_t>(offset), static_cast<uint32_t>(offset >> 32));
+    }
+
+    virtual void SetViewport(float x, float y, float width, float height)
+    {
+        Validate(m_recording, "Recording into a closed list");
+        Validate(!m_bundle, "SetViewport: not allowed in a bundle");
+        Validate(width > 0.0f && height > 0.0f, "SetViewport: empty viewport");
+        uint32_t bits[4];
+        const float values[4] = { x, y, width, height };
+        memcpy(bits, values, sizeof(bits));
+        Record(CommandType::SetViewport, bits[0], bits[1], bits[2], bits[3]);
+    }
+
+    virtual void Draw(uint32_t vertexCount, uint32_t instanceCount, uint32_t firstVertex, uint32_t firstInstance)
+    {
+        const Buffer* vertices = ValidateDraw();
+        const uint64_t end = m_vertexOffset + (static_cast<uint64_t>(firstVertex) + vertexCount) * m_vertexStride;
+        Validate(end <= vertices->desc.size, "Draw: vertices read past the end of the vertex buffer");
+        ValidateInstances(instanceCount);
+        Record(CommandType::Draw, vertexCount, instanceCount, firstVertex, firstInstance);
+        m_draws++;
+    }
+
+    virtual void DrawIndexed(uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, int32_t baseVertex, uint32_t firstInstance)
+    {
+        ValidateDraw();
+        Validate(m_indexBuffer.IsValid(), "DrawIndexed: no index buffer set");
+        const Buffer* indices = m_device.FindBuffer(m_indexBuffer);
+        Validate(indices != nullptr, "DrawIndexed: index buffer was destroyed");
+        const uint64_t end = m_indexOffset + (static_cast<uint64_t>(firstIndex) + indexCount) * sizeof(uint32_t);
+        Validate(end <= indices->desc.size, "DrawIndexed: indices read past the end of the index buffer");
+        ValidateInstances(instanceCount);
+        Record(CommandType::DrawIndexed, indexCount, instanceCount, firstIndex, static_cast<uint32_t>(baseVertex), firstInstance);
+        m_draws++;
+    }
+
+    virtual void ExecuteBundle(IRenderCommandList& bundle)
+    {
+        Validate(m_recording, "Recording into a closed list");
+        Validate(!m_bundle, "ExecuteBundle: bundles cannot execute bundles");
+        CommandList* source = dynamic_cast<CommandList*>(&bundle);
+        Validate(source != nullptr && &source->m_device == &m_device, "ExecuteBundle: bundle was not created by this device");
+        Validate(source->m_bundle, "ExecuteBundle: list is not a bundle");
+        Validate(source->m_recorded && !source->m_recording, "ExecuteBundle: bundle is not closed");
+
+        // Inline the bundle; its pipeline and buffers stay set, as in D3D12.
+        m_commands.insert(m_commands.end(), source->m_commands.begin(), source->m_commands.end());
+        m_draws += source->m_draws;
+        if (source->m_pipeline.IsValid())
+        {
+            m_pipeline = source->m_pipeline;
+        }
+        if (source->m_vertexBuffer.IsValid())
+        {
+            m_vertexBuffer = source->m_vertexBuffer;
+            m_vertexStride = source->m_vertexStride;
+            m_vertexOffset = source->m_vertexOffset;
+        }
+        if (source->m_indexBuffer.IsValid())
+        {
+            m_indexBuffer = source->m_indexBuffer;
+            m_indexOffset = source->m_indexOffset;
+        }
+        if (source->m_instanceBuffer.IsValid())
+        {
+            m_instanceBuffer = source->m_instanceBuffer;
+            m_instanceOffset = source->m_instanceOffset;
+        }
+    }
+
+    bool IsBundle() const { return m_bundle; }
+    bool IsRecording() const { return m_recording; }
+    bool IsRecorded() const { return m_recorded; }
+    const std::vector<Command>& Commands() const { return m_commands; }
+    uint64_t DrawCount() const { return m_draws; }
+
+private:
+    // Buffers are held by handle and looked up here, so a buffer destroyed
+    // since it was bound is caught, and pool growth cannot leave them dangling.
+    const Buffer* ValidateDraw()
+    {
+        Validate(m_recording, "Recording into a closed list");
+        Validate(m_pipeline.IsValid(), "Draw: no pipeline set");
+        Validate(m_vertexBuffer.IsValid(), "Draw: no vertex buffer set");
+        const Buffer* vertices = m_device.FindBuffer(m_vertexBuffer);
+        Validate(vertices != nullptr, "Draw: vertex buffer was destroyed");
+        return vertices;
+    }
+
+    // Shader instance ids run from zero, so firstInstance does not move the reads.
+    void ValidateInstances(uint32_t instanceCount)
+    {
+        Validate(m_instanceBuffer.IsValid(), "Draw: no instance buffer set");
+        const Buffer* instances = m_device.FindBuffer(m_instanceBuffer);
+        Validate(instances != nullptr, "Draw: instance buffer was destroyed");
+        const uint64_t end = m_instanceOffset + static_cast<uint64_t>(instanceCount) * sizeof(InstanceData);
+        Validate(end <= instances->desc.size, "Draw: instances read past the end of the instance buffer");
+    }
+
+    void Record(CommandType type, uint32_t a = 0, uint32_t b = 0, uint32_t c = 0, uint32_t d = 0, uint32_t e = 0)
+    {
+        Command command = { type, { a, b, c, d, e } };
+        m_commands.push_back(command);
+    }
+
+    NullRenderDevice& m_device;
+    const bool m_bundle;
+    std::vector<Command> m_commands;
+    bool m_recording = false;
+    bool m_recorded = false;
+    uint64_t m_draws = 0;
+
+    PipelineHandle m_pipeline;
+    BufferHandle m_vertexBuffer;
+    uint32_t m_vertexStride = 0;
+    uint64_t m_vertexOffset = 0;
+    BufferHandle m_indexBuffer;
+    uint64_t m_indexOffset = 0;
+    BufferHandle m_instanceBuffer;
+    uint64_t m_instanceOffset = 0;
+};
+
+//--------------------------------------------------------------------------------------
+
+BufferHandle NullRenderDevice::CreateBuffer(const BufferDesc& desc, const void* initialData)
+{
+    Validate(desc.size > 0, "CreateBuffer: zero size");
+
+    Buffer buffer;
+    buffer.desc = desc;
+    if (desc.memory == MemoryType::Upload)
+    {
+        buffer.data.resize(static_cast<size_t>(desc.size));
+        if (initialData)
+        {
+            memcpy(buffer.data.data(), initialData, buffer.data.size());
+        }
+    }
+
+    BufferHandle handle;
+    handle.index = m_buffers.Add(buffer);
+    return handle;
+}
+
+TextureHandle NullRenderDevice::CreateTexture(const TextureDesc& desc)
+{
+    Validate(desc.width > 0 && desc.height > 0, "CreateTexture: zero size");
+    Validate(desc.mipLevels > 0, "CreateTexture: no mip levels");
+
+    uint32_t largest = desc.width > desc.height ? desc.width : desc.height;
+    uint32_t fullChain = 1;
+    while (largest >>= 1)
+    {
+        fullChain++;
+    }
+    Validate(desc.mipLevels <= fullChain, "CreateTexture: more mip levels than the full chain");
+
+    TextureHandle handle;
+    handle.index = m_textures.Add(desc);
+    return handle;
+}
+
+PipelineHandle NullRenderDevice::CreatePipeline(const PipelineDesc& desc)
+{
+    Validate(desc.vertexShader.data != nullptr && desc.vertexShader.size > 0, "CreatePipeline: missing vertex shader");
+    Validate((desc.pixelShader.data != nullptr) == (desc.pixelShader.size > 0), "CreatePipeline: malformed pixel shader");
+    Validate(desc.renderTargetCount <= MaxRenderTargets, "CreatePipeline: too many render targets");
+    for (uint32_t i = 0; i < desc.renderTargetCount; i++)
+    {
+        Validate(desc.renderTargetFormats[i] == TextureFormat::RGBA8 || desc.renderTargetFormats[i] == TextureFormat::RGBA8_SRGB,
+            "CreatePipeline: render target format is not renderable");
+    }
+    Validate(desc.depthFormat != DepthFormat::None || (!desc.depthTest && !desc.depthWrite),
+        "CreatePipeline: depth test or write without a depth format");
+    Validate(desc.depthTest || !desc.depthWrite, "CreatePipeline: depth write without depth test");
+    Validate(desc.renderTargetCount > 0 || desc.depthFormat != DepthFormat::None, "CreatePipeline: no render target or depth buffer");
+    Validate(!desc.fallback.IsValid() || m_pipelines.Get(desc.fallback.index) != nullptr, "CreatePipeline: invalid fallback pipeline");
+
+    PipelineHandle handle;
+    handle.index = m_pipelines.Add(desc);
+    return handle;
+}
+
+void NullRenderDevice::Destroy(BufferHandle buffer)
+{
+    Validate(m_buffers.Get(buffer.index) != nullptr, "Destroy: invalid buffer");
+    m_buffers.Remove(buffer.index);
+}
+
+void NullRenderDevice::Destroy(TextureHandle texture)
+{
+    Validate(IsLive(texture), "Destroy: invalid texture");
+    m_textures.Remove(texture.index);
+}
+
+void NullRenderDevice::Destroy(PipelineHandle pipeline)
+{
+    Validate(IsLive(pipeline), "Destroy: invalid pipeline");
+    m_pipelines.Remove(pipeline.index);
+}
+
+void* NullRenderDevice::Map(BufferHandle buffer)
+{
+    Buffer* data = m_buffers.Get(buffer.index);
+    Validate(data != nullptr, "Map: invalid buffer");
+    Validate(data->desc.memory == MemoryType::Upload, "Map: only upload buffers can be mapped");
+    return data->data.data();
+}
+
+std::unique_ptr<IRenderCommandList> NullRenderDevice::CreateCommandList()
+{
+    return std::unique_ptr<IRenderCommandList>(new CommandList(*this, false));
+}
+
+std::unique_ptr<IRenderCommandList> NullRenderDevice::CreateBundle()
+{
+    return std::unique_ptr<IRenderCommandList>(new CommandList(*this, true));
+}
+
+void NullRenderDevice::Submit(IRenderCommandList* const* lists, uint32_t count)
+{
+    // Validate everything before "executing" anything, like ExecuteCommandLists.
+    for (uint32_t i = 0; i < count; i++)
+    {
+        const CommandList* list = dynamic_cast<const CommandList*>(lists[i]);
+        Validate(list != nullptr, "Submit: list was not created by this device");
+        Validate(!list->IsBundle(), "Submit: bundles are executed through ExecuteBundle");
+        Validate(!list->IsRecording(), "Submit: list is still recording");
+        Validate(list->IsRecorded(), "Submit: list was never recorded");
+    }
+
+    m_submitted.clear();
+    for (uint32_t i = 0; i < count; i++)
+    {
+        const CommandList* list = static_cast<const CommandList*>(lists[i]);
+        m_submitted.insert(m_submitted.end(), list->Commands().begin(), list->Commands().end());
+        m_stats.commands += list->Commands().size();
+        m_stats.draws += list->DrawCount();
+        m_stats.submittedLists++;
+    }
+}
+
+const NullRenderDevice::Buffer* NullRenderDevice::FindBuffer(BufferHandle buffer)
+{
+    return m_buffers.Get(buffer.index);
+}
+
+bool NullRenderDevice::IsLive(TextureHandle texture)
+{
+    return m_textures.Get(texture.index) != nullptr;
+}
+
+bool NullRenderDevice::IsLive(PipelineHandle pipeline)
+{
+    return m_pipelines.Get(pipeline.index) != nullptr;
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include "RenderBackend.h"
+
+// Fence that completes as soon as it is signaled; there is no GPU behind it.
+class NullFenceQueue : public IFenceQueue
+{
+public:
+    virtual void Signal(uint64_t value);
+    virtual uint64_t CompletedValue() { return m_completed; }
+    virtual void WaitForValue(uint64_t value);
+
+private:
+    uint64_t m_completed = 0;
+};
+
+// Headless IRenderDevice. Every call is validated the way the D3D12 debug
+// layer would complain (stale handles, wrong memory type, drawing without a
+// pipeline, vertex buffer or instance buffer, out of range vertex, index or
+// instance reads, submitting an open list, ...) and throws std::logic_error on misuse. Recorded commands
+// are kept so tests can inspect them, and counted so CPU-side frame cost
+// can be benchmarked on machines without a GPU.
+class NullRenderDevice : public IRenderDevice
+{
+public:
+    enum class CommandType : uint8_t
+    {
+        SetPipeline,
+        SetConstantBuffer,
+        SetTexture,
+        SetVertexBuffer,
+        SetIndexBuffer,
+        SetInstanceBuffer,
+        SetShaderBuffer,
+        SetViewport,
+        Draw,
+        DrawIndexed,
+    };
+
+    struct Command
+    {
+        CommandType type;
+        uint32_t args[5];
+    };
+
+    struct Stats
+    {
+        uint64_t commands = 0;
+        uint64_t draws = 0;
+        uint64_t submittedLists = 0;
+    };
+
+    NullRenderDevice() = default;
+    NullRenderDevice(const NullRenderDevice& rhs) = delete;
+    NullRenderDevice& operator=(const NullRenderDevice& rhs) = delete;
+
+    virtual BufferHandle CreateBuffer(const BufferDesc& desc, const void* initialData = nullptr);
+    virtual TextureHandle CreateTexture(const TextureDesc& desc);
+    virtual PipelineHandle CreatePipeline(const PipelineDesc& desc);
+
+    virtual void Destroy(BufferHandle buffer);
+    virtual void Destroy(TextureHandle texture);
+    virtual void Destroy(PipelineHandle pipeline);
+
+    virtual void* Map(BufferHandle buffer);
+
+    virtual std::unique_ptr<IRenderCommandList> CreateCommandList();
+    virtual std::unique_ptr<IRenderCommandList> CreateBundle();
+    virtual void Submit(IRenderCommandList* const* lists, uint32_t count);
+
+    virtual IFenceQueue& Fences() { return m_fences; }
+
+    // Commands of the most recently submitted lists, in submission order.
+    const std::vector<Command>& SubmittedCommands() const { return m_submitted; }
+    const Stats& GetStats() const { return m_stats; }
+
+private:
+    class CommandList;
+
+    struct Buffer
+    {
+        BufferDesc desc;
+        std::vector<uint8_t> data;    // Upload buffers only.
+    };
+
+    const Buffer* FindBuffer(BufferHandle buffer);
+    bool IsLive(TextureHandle texture);
+    bool IsLive(PipelineHandle pipeline);
+
+    RenderResourcePool<Buffer> m_buffers;
+    RenderResourcePool<TextureDesc> m_textures;
+    RenderResourcePool<PipelineDesc> m_pipelines;
+    NullFenceQueue m_fences;
+    std::vector<Command> m_submitted;
+    Stats m_stats;    // Counted per list and added up on Submit.
+};
@@ -0,0 +1,560 @@
+#include "OcclusionCulling.h"
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+#if defined(__AVX2__)
+#define OCCLUSION_AVX2 1
+#endif
+#if defined(_M_X64) || defined(__x86_64__) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define OCCLUSION_SSE2 1
+#include <immintrin.h>
+#endif
+
+namespace
+{
+    const uint32_t FullRow = 0xFFFFFFFFu;
+    // Span bounds of triangles without a left or right edge in a row.
+    const float Unbounded = 1e30f;
+
+    void Transform(const float m[4][4], const float p[3], float clip[4])
+    {
+        for (int j = 0; j < 4; j++)
+        {
+            clip[j] = p[0] * m[0][j] + p[1] * m[1][j] + p[2] * m[2][j] + m[3][j];
+        }
+    }
+
+    // x of an edge at row center y, with each step rounded on its own, as
+    // the SIMD lanes compute it.
+    float EdgeAt(float edgeX, float edgeY, float slope, float y)
+    {
+        volatile float dy = y - edgeY;
+        volatile float dx = dy * slope;
+        return edgeX + dx;
+    }
+}
+
+void OcclusionBuffer::Resize(uint32_t width, uint32_t height)
+{
+    if (width == 0 || height == 0 || width % TileWidth != 0 || height % TileHeight != 0)
+    {
+        throw std::invalid_argument("OcclusionBuffer: size must be a multiple of the tile size");
+    }
+    m_width = width;
+    m_height = height;
+    m_tilesX = width / TileWidth;
+    m_tilesY = height / TileHeight;
+    m_farDepth.assign(m_tilesX * m_tilesY, 1.0f);
+    m_layerDepth.assign(m_tilesX * m_tilesY, 0.0f);
+    m_layerMask.assign(m_tilesX * m_tilesY * TileHeight, 0);
+}
+
+void OcclusionBuffer::Setup(const float viewProjection[4][4], const OccluderTriangle* occluders, uint32_t count)
+{
+    if (m_width == 0)
+    {
+        throw std::logic_error("OcclusionBuffer: Resize before rendering");
+    }
+    memcpy(m_viewProjection, viewProjection, sizeof(m_viewProjection));
+    std::fill(m_farDepth.begin(), m_farDepth.end(), 1.0f);
+    std::fill(m_layerDepth.begin(), m_layerDepth.end(), 0.0f);
+    std::fill(m_layerMask.begin(), m_layerMask.end(), 0u);
+
+    m_triangles.clear();
+    for (uint32_t t = 0; t < count; t++)
+    {
+        float clip[4][4];
+        uint32_t outside[6] = {};
+        bool crossesNear = false;
+        for (int i = 0; i < 3; i++)
+        {
+            Transform(viewProjection, occluders[t].vertices[i], clip[i]);
+            const float* c = clip[i];
+            outside[0] += c[0] < -c[3];
+            outside[1] += c[0] > c[3];
+            outside[2] += c[1] < -c[3];
+            outside[3] += c[1] > c[3];
+            outside[4] += c[2] < 0.0f;
+            outside[5] += c[2] > c[3];
+            crossesNear |= c[2] < 0.0f;
+        }
+        if (std::find(outside, outside + 6, 3u) != outside + 6)
+        {
+            continue;
+        }
+        if (!crossesNear)
+        {
+            SetupTriangle(clip);
+            continue;
+        }
+
+        // Clip to the near plane: one vertex in front of it leaves a
+        // triangle, two leave a quad.
+        float polygon[4][4];
+        int vertexCount = 0;
+        for (int i = 0; i < 3; i++)
+        {
+            const float* a = clip[i];
+            const float* b = clip[(i + 1) % 3];
+            if (a[2] >= 0.0f)
+            {
+                memcpy(polygon[vertexCount++], a, sizeof(polygon[0]));
+            }
+            if ((a[2] >= 0.0f) != (b[2] >= 0.0f))
+            {
+                const float s = a[2] / (a[2] - b[2]);
+                for (int j = 0; j < 4; j++)
+                {
+                    polygon[vertexCount][j] = a[j] + (b[j] - a[j]) * s;
+                }
+                vertexCount++;
+            }
+        }
+        for (int i = 1; i + 1 < vertexCount; i++)
+        {
+            float fan[3][4];
+            memcpy(fan[0], polygon[0], sizeof(fan[0]));
+            memcpy(fan[1], polygon[i], sizeof(fan[1]));
+            memcpy(fan[2], polygon[i + 1], sizeof(fan[2]));
+            SetupTriangle(fan);
+        }
+    }
+}
+
+void OcclusionBuffer::SetupTriangle(const float (*clip)[4])
+{
+    float x[3], y[3], z[3];
+    for (int i = 0; i < 3; i++)
+    {
+        const float invW = 1.0f / clip[i][3];
+        x[i] = (clip[i][0] * invW * 0.5f + 0.5f) * m_width;
+        y[i] = (0.5f - clip[i][1] * invW * 0.5f) * m_height;
+        z[i] = clip[i][2] * invW;
+    }
+    const double d1x = x[1] - x[0];
+    const double d1y = y[1] - y[0];
+    const double d2x = x[2] - x[0];
+    const double d2y = y[2] - y[0];
+    const double area = d1x * d2y - d2x * d1y;
+    if (!(area != 0.0) || !std::isfinite(area))
+    {
+        return;
+    }
+
+    Triangle t;
+    t.minX = std::min(x[0], std::min(x[1], x[2]));
+    t.maxX = std::max(x[0], std::max(x[1], x[2]));
+    t.minY = std::min(y[0], std::min(y[1], y[2]));
+    t.maxY = std::max(y[0], std::max(y[1], y[2]));
+    if (t.maxX < 0.5f || t.minX > m_width - 0.5f || t.maxY < 0.5f || t.minY > m_height - 0.5f)
+    {
+        return;
+    }
+
+    // Going around a triangle of positive area (y down), an edge heading
+    // down the screen bounds it on the right.
+    t.leftEdges = 0;
+    t.rightEdges = 0;
+    for (int e = 0; e < 3; e++)
+    {
+        const int j = (e + 1) % 3;
+        t.edgeX[e] = x[e];
+        t.edgeY[e] = y[e];
+        t.edgeSlope[e] = 0.0f;
+        if (y[j] != y[e])
+        {
+            t.edgeSlope[e] = (x[j] - x[e]) / (y[j] - y[e]);
+            if ((y[j] > y[e]) == (area > 0.0))
+            {
+                t.rightEdges |= 1u << e;
+            }
+            else
+            {
+                t.leftEdges |= 1u << e;
+            }
+        }
+    }
+
+    t.depth[0] = z[0];
+    t.depth[1] = static_cast<float>(((z[1] - z[0]) * d2y - (z[2] - z[0]) * d1y) / area);
+    t.depth[2] = static_cast<float>(((z[2] - z[0]) * d1x - (z[1] - z[0]) * d2x) / area);
+    t.minDepth = std::min(z[0], std::min(z[1], z[2]));
+    t.maxDepth = std::max(z[0], std::max(z[1], z[2]));
+    m_triangles.push_back(t);
+}
+
+void OcclusionBuffer::RowMasksReference(const Triangle& t, float tileX, float tileY, uint32_t masks[TileHeight])
+{
+    for (uint32_t row = 0; row < TileHeight; row++)
+    {
+        masks[row] = 0;
+        const float y = (tileY + static_cast<float>(row)) + 0.5f;
+        if (!(y >= t.minY && y <= t.maxY))
+        {
+            continue;
+        }
+        float left = -Unbounded;
+        float right = Unbounded;
+        for (int e = 0; e < 3; e++)
+        {
+            if (t.leftEdges & (1u << e))
+            {
+                left = std::max(left, EdgeAt(t.edgeX[e], t.edgeY[e], t.edgeSlope[e], y));
+            }
+            if (t.rightEdges & (1u << e))
+            {
+                right = std::min(right, EdgeAt(t.edgeX[e], t.edgeY[e], t.edgeSlope[e], y));
+            }
+        }
+
+        // Pixel k of the row is covered if its center lies in the span.
+        const float center = tileX + 0.5f;
+        const float low = left - center;
+        const float high = right - center;
+        for (uint32_t k = 0; k < TileWidth; k++)
+        {
+            if (static_cast<float>(k) >= low && static_cast<float>(k) <= high)
+            {
+                masks[row] |= 1u << k;
+            }
+        }
+    }
+}
+
+void OcclusionBuffer::RowMasks(const Triangle& t, float tileX, float tileY, uint32_t masks[TileHeight])
+{
+#if defined(OCCLUSION_AVX2)
+    // One row per lane: intersect the half planes of the left and right
+    // edges at the row centers, then turn the span into bits with shifts.
+    const __m256 y = _mm256_add_ps(_mm256_set1_ps(tileY), _mm256_setr_ps(0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f));
+    const __m256 rowInside = _mm256_and_ps(_mm256_cmp_ps(y, _mm256_set1_ps(t.minY), _CMP_GE_OQ), _mm256_cmp_ps(y, _mm256_set1_ps(t.maxY), _CMP_LE_OQ));
+    __m256 left = _mm256_set1_ps(-Unbounded);
+    __m256 right = _mm256_set1_ps(Unbounded);
+    for (int e = 0; e < 3; e++)
+    {
+        const __m256 x = _mm256_add_ps(_mm256_set1_ps(t.edgeX[e]), _mm256_mul_ps(_mm256_sub_ps(y, _mm256_set1_ps(t.edgeY[e])), _mm256_set1_ps(t.edgeSlope[e])));
+        if (t.leftEdges & (1u << e))
+        {
+            left = _mm256_max_ps(left, x);
+        }
+        if (t.rightEdges & (1u << e))
+        {
+            right = _mm256_min_ps(right, x);
+        }
+    }
+    const __m256 center = _mm256_set1_ps(tileX + 0.5f);
+    const __m256 low = _mm256_min_ps(_mm256_max_ps(_mm256_sub_ps(left, center), _mm256_setzero_ps()), _mm256_set1_ps(static_cast<float>(TileWidth)));
+    const __m256 high = _mm256_min_ps(_mm256_max_ps(_mm256_sub_ps(right, center), _mm256_set1_ps(-1.0f)), _mm256_set1_ps(TileWidth - 1.0f));
+    const __m256i first = _mm256_cvttps_epi32(_mm256_ceil_ps(low));
+    const __m256i last = _mm256_cvttps_epi32(_mm256_floor_ps(high));
+    const __m256i ones = _mm256_set1_epi32(-1);
+    // Shifts of 32 or more give 0, which empties the rows without a span.
+    __m256i bits = _mm256_and_si256(_mm256_sllv_epi32(ones, first),
+        _mm256_srlv_epi32(ones, _mm256_sub_epi32(_mm256_set1_epi32(TileWidth - 1), last)));
+    bits = _mm256_and_si256(bits, _mm256_castps_si256(rowInside));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(masks), bits);
+#elif defined(OCCLUSION_SSE2)
+    // Four rows per lane group; SSE2 has no per lane shifts, so the bits are
+    // made one row at a time.
+    for (uint32_t half = 0; half < TileHeight; half += 4)
+    {
+        const __m128 y = _mm_add_ps(_mm_set1_ps(tileY), _mm_add_ps(_mm_set1_ps(static_cast<float>(half)), _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f)));
+        const __m128 rowInside = _mm_and_ps(_mm_cmpge_ps(y, _mm_set1_ps(t.minY)), _mm_cmple_ps(y, _mm_set1_ps(t.maxY)));
+        __m128 left = _mm_set1_ps(-Unbounded);
+        __m128 right = _mm_set1_ps(Unbounded);
+        for (int e = 0; e < 3; e++)
+        {
+            const __m128 x = _mm_add_ps(_mm_set1_ps(t.edgeX[e]), _mm_mul_ps(_mm_sub_ps(y, _mm_set1_ps(t.edgeY[e])), _mm_set1_ps(t.edgeSlope[e])));
+            if (t.leftEdges & (1u << e))
+            {
+                left = _mm_max_ps(left, x);
+            }
+            if (t.rightEdges & (1u << e))
+            {
+                right = _mm_min_ps(right, x);
+            }
+        }
+        const __m128 center = _mm_set1_ps(tileX + 0.5f);
+        const __m128 low = _mm_min_ps(_mm_max_ps(_mm_sub_ps(left, center), _mm_setzero_ps()), _mm_set1_ps(static_cast<float>(TileWidth)));
+        const __m128 high = _mm_min_ps(_mm_max_ps(_mm_sub_ps(right, center), _mm_set1_ps(-1.0f)), _mm_set1_ps(TileWidth - 1.0f));
+
+        // Ceiling and floor by truncation, corrected where it went the wrong
+        // way; the values are small, so the conversions are exact.
+        __m128i first = _mm_cvttps_epi32(low);
+        first = _mm_sub_epi32(first, _mm_castps_si128(_mm_cmplt_ps(_mm_cvtepi32_ps(first), low)));
+        __m128i last = _mm_cvttps_epi32(high);
+        last = _mm_add_epi32(last, _mm_castps_si128(_mm_cmpgt_ps(_mm_cvtepi32_ps(last), high)));
+
+        alignas(16) int32_t firsts[4];
+        alignas(16) int32_t lasts[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(firsts), first);
+        _mm_store_si128(reinterpret_cast<__m128i*>(lasts), last);
+        const int inside = _mm_movemask_ps(rowInside);
+        for (int lane = 0; lane < 4; lane++)
+        {
+            const uint64_t bits = (0xFFFFFFFFull << firsts[lane]) & (0xFFFFFFFFull >> (TileWidth - 1 - lasts[lane]));
+            masks[half + lane] = (inside & (1 << lane)) ? static_cast<uint32_t>(bits) : 0;
+        }
+    }
+#else
+    RowMasksReference(t, tileX, tileY, masks);
+#endif
+}
+
+void OcclusionBuffer::UpdateTile(uint32_t tile, const uint32_t masks[TileHeight], float nearest, float farthest)
+{
+    float& farDepth = m_farDepth[tile];
+    if (nearest >= farDepth)
+    {
+        return;
+    }
+    float& layerDepth = m_layerDepth[tile];
+    uint32_t* layerMask = &m_layerMask[tile * TileHeight];
+
+    // A triangle much nearer than the working layer would only make it
+    // cover more pixels at the layer's depth; starting the layer over from
+    // the triangle keeps its depth close.
+    if (layerDepth - farthest > farDepth - layerDepth)
+    {
+        std::fill(layerMask, layerMask + TileHeight, 0u);
+        layerDepth = 0.0f;
+    }
+    layerDepth = std::max(layerDepth, farthest);
+
+    bool full;
+#if defined(OCCLUSION_AVX2)
+    const __m256i merged = _mm256_or_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(layerMask)),
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(masks)));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(layerMask), merged);
+    full = _mm256_testc_si256(merged, _mm256_set1_epi32(-1)) != 0;
+#elif defined(OCCLUSION_SSE2)
+    const __m128i low = _mm_or_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(layerMask)),
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(masks)));
+    const __m128i high = _mm_or_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(layerMask + 4)),
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(masks + 4)));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(layerMask), low);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(layerMask + 4), high);
+    full = _mm_movemask_epi8(_mm_cmpeq_epi32(_mm_and_si128(low, high), _mm_set1_epi32(-1))) == 0xFFFF;
+#else
+    full = true;
+    for (uint32_t row = 0; row < TileHeight; row++)
+    {
+        layerMask[row] |= masks[row];
+        full &= layerMask[row] == FullRow;
+    }
+#endif
+
+    // Every pixel is now covered by the layer, so its depth bounds the tile.
+    if (full)
+    {
+        farDepth = std::min(farDepth, layerDepth);
+        std::fill(layerMask, layerMask + TileHeight, 0u);
+        layerDepth = 0.0f;
+    }
+}
+
+void OcclusionBuffer::RenderTileRow(uint32_t row, bool reference)
+{
+    const float tileY = static_cast<float>(row * TileHeight);
+    for (const Triangle& t : m_triangles)
+    {
+        if (t.maxY < tileY + 0.5f || t.minY > tileY + (TileHeight - 0.5f))
+        {
+            continue;
+        }
+        const float firstX = std::max(t.minX - 0.5f, 0.0f);
+        const float lastX = std::min(t.maxX - 0.5f, m_width - 1.0f);
+        if (firstX > lastX)
+        {
+            continue;
+        }
+
+        // Depth range of the triangle within each tile, from its plane at
+        // the corners of the tile's part of its bounds.
+        const float y0 = std::max(tileY + 0.5f, t.minY) - t.edgeY[0];
+        const float y1 = std::min(tileY + (TileHeight - 0.5f), t.maxY) - t.edgeY[0];
+        const float dy0 = t.depth[2] * y0;
+        const float dy1 = t.depth[2] * y1;
+
+        const uint32_t firstTile = static_cast<uint32_t>(firstX) / TileWidth;
+        const uint32_t lastTile = static_cast<uint32_t>(lastX) / TileWidth;
+        for (uint32_t tx = firstTile; tx <= lastTile; tx++)
+        {
+            const float tileX = static_cast<float>(tx * TileWidth);
+            uint32_t masks[TileHeight];
+            if (reference)
+            {
+                RowMasksReference(t, tileX, tileY, masks);
+            }
+            else
+            {
+                RowMasks(t, tileX, tileY, masks);
+            }
+            uint32_t any = 0;
+            for (uint32_t mask : masks)
+            {
+                any |= mask;
+            }
+            if (!any)
+            {
+                continue;
+            }
+
+            const float x0 = std::max(tileX + 0.5f, t.minX) - t.edgeX[0];
+            const float x1 = std::min(tileX + (TileWidth - 0.5f), t.maxX) - t.edgeX[0];
+            const float dx0 = t.depth[1] * x0;
+            const float dx1 = t.depth[1] * x1;
+            // The margin covers rounding in the plane, so the far depth never
+            // comes out nearer than a covered pixel.
+            const float margin = 1e-6f * (std::fabs(t.depth[0]) + std::max(std::fabs(dx0), std::fabs(dx1)) + std::max(std::fabs(dy0), std::fabs(dy1)));
+            const float nearest = std::max(t.depth[0] + std::min(dx0, dx1) + std::min(dy0, dy1) - margin, t.minDepth);
+            const float farthest = std::min(t.depth[0] + std::max(dx0, dx1) + std::max(dy0, dy1) + margin, t.maxDepth);
+            UpdateTile(row * m_tilesX + tx, masks, nearest, farthest);
+        }
+    }
+}
+
+void OcclusionBuffer::Render(const float viewProjection[4][4], const OccluderTriangle* occluders, uint32_t count, JobSystem* jobs)
+{
+    Setup(viewProjection, occluders, count);
+    auto rows = [this](size_t begin, size_t end)
+    {
+        for (size_t row = begin; row < end; row++)
+        {
+            RenderTileRow(static_cast<uint32_t>(row), false);
+        }
+    };
+    if (jobs)
+    {
+        jobs->ParallelFor(m_tilesY, 1, rows);
+    }
+    else
+    {
+        rows(0, m_tilesY);
+    }
+}
+
+void OcclusionBuffer::RenderReference(const float viewProjection[4][4], const OccluderTriangle* occluders, uint32_t count)
+{
+    Setup(viewProjection, occluders, count);
+    for (uint32_t row = 0; row < m_tilesY; row++)
+    {
+        RenderTileRow(row, true);
+    }
+}
+
+bool OcclusionBuffer::IsVisible(const float center[3], float radius) const
+{
+    // Screen bounds and nearest depth of the sphere's bounding box.
+    float minX = Unbounded, minY = Unbounded, maxX = -Unbounded, maxY = -Unbounded;
+    float nearest = Unbounded;
+    for (int corner = 0; corner < 8; corner++)
+    {
+        const float p[3] =
+        {
+            center[0] + ((corner & 1) ? radius : -radius),
+            center[1] + ((corner & 2) ? radius : -radius),
+            center[2] + ((corner & 4) ? radius : -radius),
+        };
+        float clip[4];
+        Transform(m_viewProjection, p, clip);
+        if (clip[2] < 0.0f || clip[3] <= 0.0f)
+        {
+            return true;
+        }
+        const float invW = 1.0f / clip[3];
+        const float x = (clip[0] * invW * 0.5f + 0.5f) * m_width;
+        const float y = (0.5f - clip[1] * invW * 0.5f) * m_height;
+        minX = std::min(minX, x);
+        maxX = std::max(maxX, x);
+        minY = std::min(minY, y);
+        maxY = std::max(maxY, y);
+        nearest = std::min(nearest, clip[2] * invW);
+    }
+    if (maxX < 0.0f || minX >= m_width || maxY < 0.0f || minY >= m_height)
+    {
+        return false;
+    }
+
+    const uint32_t firstX = static_cast<uint32_t>(std::max(minX, 0.0f)) / TileWidth;
+    const uint32_t lastX = static_cast<uint32_t>(std::min(maxX, m_width - 1.0f)) / TileWidth;
+    const uint32_t firstY = static_cast<uint32_t>(std::max(minY, 0.0f)) / TileHeight;
+    const uint32_t lastY = static_cast<uint32_t>(std::min(maxY, m_height - 1.0f)) / TileHeight;
+    for (uint32_t ty = firstY; ty <= lastY; ty++)
+    {
+        const float* farDepth = &m_farDepth[ty * m_tilesX];
+        uint32_t tx = firstX;
+#if defined(OCCLUSION_SSE2)
+        const __m128 depth = _mm_set1_ps(nearest);
+        for (; tx + 4 <= lastX + 1; tx += 4)
+        {
+            if (_mm_movemask_ps(_mm_cmplt_ps(depth, _mm_loadu_ps(farDepth + tx))))
+            {
+                return true;
+            }
+        }
+#endif
+        for (; tx <= lastX; tx++)
+        {
+            if (nearest < farDepth[tx])
+            {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+namespace OcclusionCulling
+{
+    std::vector<OccluderTriangle> SelectOccluders(const void* positions, size_t positionStride, uint32_t vertexCount,
+        uint32_t maxTriangles)
+    {
+        auto position = [positions, positionStride](uint32_t vertex)
+        {
+            return reinterpret_cast<const float*>(static_cast<const uint8_t*>(positions) + vertex * positionStride);
+        };
+
+        // Twice the area of each triangle, squared.
+        const uint32_t triangleCount = vertexCount / 3;
+        std::vector<float> areas(triangleCount);
+        std::vector<uint32_t> order;
+        order.reserve(triangleCount);
+        for (uint32_t t = 0; t < triangleCount; t++)
+        {
+            const float* a = position(t * 3);
+            const float* b = position(t * 3 + 1);
+            const float* c = position(t * 3 + 2);
+            const float u[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+            const float v[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+            const float n[3] = { u[1] * v[2] - u[2] * v[1], u[2] * v[0] - u[0] * v[2], u[0] * v[1] - u[1] * v[0] };
+            areas[t] = n[0] * n[0] + n[1] * n[1] + n[2] * n[2];
+            if (areas[t] > 0.0f)
+            {
+                order.push_back(t);
+            }
+        }
+
+        if (order.size() > maxTriangles)
+        {
+            std::nth_element(order.begin(), order.begin() + maxTriangles, order.end(),
+                [&areas](uint32_t a, uint32_t b) { return areas[a] > areas[b] || (areas[a] == areas[b] && a < b); });
+            order.resize(maxTriangles);
+        }
+        std::sort(order.begin(), order.end());
+
+        std::vector<OccluderTriangle> occluders(order.size());
+        for (size_t i = 0; i < order.size(); i++)
+        {
+            for (int v = 0; v < 3; v++)
+            {
+                memcpy(occluders[i].vertices[v], position(order[i] * 3 + v), sizeof(occluders[i].vertices[v]));
+            }
+        }
+        return occluders;
+    }
+}
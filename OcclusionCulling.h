@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class JobSystem;
+
+// Masked software occlusion culling, after Intel's Masked Occlusion Culling:
+// a few large occluder triangles are rasterized on the CPU into a small
+// hierarchical depth buffer, and object bounds are tested against it before
+// their draws are submitted. Nothing is read back from the GPU, so the
+// result is ready in the frame it is used.
+//
+// Matrices are row-major for row vectors (clip = p * M) and project to D3D
+// clip space (0 <= z <= w); depths are z / w, nearer is smaller.
+
+// One occluder triangle in world space.
+struct OccluderTriangle
+{
+    float vertices[3][3];
+};
+
+namespace OcclusionCulling
+{
+    // The largest maxTriangles triangles (by world space area) of a triangle
+    // list, in their original order. positions has a stride of
+    // positionStride bytes.
+    std::vector<OccluderTriangle> SelectOccluders(const void* positions, size_t positionStride, uint32_t vertexCount,
+        uint32_t maxTriangles);
+
+}
+
+// The depth buffer is made of 32x8 pixel tiles. A tile keeps no per pixel
+// depth, only two layers: a far depth that bounds every pixel of the tile,
+// and a working layer of the pixels covered since, as a coverage mask and
+// the far depth of those pixels. Once the mask is full, the working layer
+// becomes the tile's far depth. Coverage is computed 8 rows (a tile's
+// height) at a time with SIMD, from the x extent of each row's span.
+//
+// Tiles are updated in triangle order, so the buffer is the same whatever
+// the thread count. RenderReference tests each pixel center on its own, one
+// thread, and builds the same buffer, bit for bit.
+class OcclusionBuffer
+{
+public:
+    static const uint32_t TileWidth = 32;
+    static const uint32_t TileHeight = 8;
+
+    // Throws std::invalid_argument unless both sizes are non-zero multiples
+    // of the tile size.
+    void Resize(uint32_t width, uint32_t height);
+    uint32_t Width() const { return m_width; }
+    uint32_t Height() const { return m_height; }
+
+    // Clears the buffer and rasterizes the occluders as seen through
+    // viewProjection, which later tests use too. Without jobs, Render runs on
+    // the calling thread.
+    void Render(const float viewProjection[4][4], const OccluderTriangle* occluders, uint32_t count, JobSystem* jobs);
+    void RenderReference(const float viewProjection[4][4], const OccluderTriangle* occluders, uint32_t count);
+
+    // Whether any part of a sphere may be visible: false only if its screen
+    // bounds are entirely behind the occluders, or off screen. Spheres that
+    // reach the near plane are always visible.
+    bool IsVisible(const float center[3], float radius) const;
+
+    // Tiles in row order; each tile's layer mask is TileHeight rows.
+    const std::vector<float>& FarDepths() const { return m_farDepth; }
+    const std::vector<float>& LayerDepths() const { return m_layerDepth; }
+    const std::vector<uint32_t>& LayerMasks() const { return m_layerMask; }
+
+private:
+    // An occluder after clipping, in pixels; spans are bounded by its edges'
+    // x intercepts.
+    struct Triangle
+    {
+        float minX, minY, maxX, maxY;           // Bounds of the vertices.
+        float edgeX[3], edgeY[3];               // A point on each edge...
+        float edgeSlope[3];                     // ...and its change in x per row.
+        uint32_t leftEdges;                     // Bit e set if edge e bounds spans on the left.
+        uint32_t rightEdges;
+        float depth[3];                         // Plane over pixels: depth at (edgeX[0], edgeY[0]), per x and per y.
+        float minDepth, maxDepth;               // Of the vertices.
+    };
+
+    void Setup(const float viewProjection[4][4], const OccluderTriangle* occluders, uint32_t count);
+    void SetupTriangle(const float (*clip)[4]);
+    void RenderTileRow(uint32_t row, bool reference);
+    static void RowMasks(const Triangle& triangle, float tileX, float tileY, uint32_t masks[TileHeight]);
+    static void RowMasksReference(const Triangle& triangle, float tileX, float tileY, uint32_t masks[TileHeight]);
+    void UpdateTile(uint32_t tile, const uint32_t masks[TileHeight], float nearest, float farthest);
+
+    uint32_t m_width = 0;
+    uint32_t m_height = 0;
+    uint32_t m_tilesX = 0;
+    uint32_t m_tilesY = 0;
+    float m_viewProjection[4][4];
+    std::vector<Triangle> m_triangles;
+    std::vector<float> m_farDepth;              // Per tile.
+    std::vector<float> m_layerDepth;            // Far depth of the working layer's pixels.
+    std::vector<uint32_t> m_layerMask;          // TileHeight rows of TileWidth bits per tile.
+};
@@ -0,0 +1,65 @@
+#include "ParallelDrawRecorder.h"
+#include <algorithm>
+#include <exception>
+
+ParallelDrawRecorder::ParallelDrawRecorder(IRenderDevice& device, uint32_t maxLists, uint32_t minDrawsPerList, JobSystem& jobs) :
+    m_jobs(jobs),
+    m_minDrawsPerList(std::max<uint32_t>(1, minDrawsPerList))
+{
+    maxLists = std::max<uint32_t>(1, maxLists);
+    for (uint32_t i = 0; i < maxLists; i++)
+    {
+        m_lists.push_back(device.CreateCommandList());
+        m_listPointers.push_back(m_lists.back().get());
+    }
+    m_errors.resize(maxLists);
+}
+
+uint32_t ParallelDrawRecorder::Record(uint32_t frameSlot, const DrawListBindings& bindings, const DrawItem* items, size_t count,
+    const BeginListCallback& beginList)
+{
+    if (count == 0)
+        return 0;
+
+    const size_t wanted = (count + m_minDrawsPerList - 1) / m_minDrawsPerList;
+    const size_t listCount = std::min(wanted, m_lists.size());
+
+    // Spread the remainder over the first lists so chunk sizes differ by at most one.
+    const size_t baseSize = count / listCount;
+    const size_t remainder = count % listCount;
+
+    m_jobs.ParallelFor(listCount, 1, [&](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; i++)
+        {
+            const size_t first = i * baseSize + std::min(i, remainder);
+            const size_t size = baseSize + (i < remainder ? 1 : 0);
+
+            // Worker threads must not throw; hand errors back to the caller.
+            try
+            {
+                IRenderCommandList& list = *m_lists[i];
+                list.Begin(frameSlot);
+                beginList(list);
+                RecordDrawList(list, bindings, items + first, size);
+                list.End();
+            }
+            catch (...)
+            {
+                m_errors[i] = std::current_exception();
+            }
+        }
+    });
+
+    for (size_t i = 0; i < listCount; i++)
+    {
+        if (m_errors[i])
+        {
+            std::exception_ptr error = m_errors[i];
+            std::fill(m_errors.begin(), m_errors.end(), nullptr);
+            std::rethrow_exception(error);
+        }
+    }
+
+    return static_cast<uint32_t>(listCount);
+}
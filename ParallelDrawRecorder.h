@@ -0,0 +1,38 @@
+#pragma once
+
+#include <exception>
+#include <functional>
+#include "DrawList.h"
+#include "JobSystem.h"
+
+// Splits a draw list into contiguous chunks and records each chunk into its
+// own command list on the job system. The lists come back in draw order so a
+// single Submit executes them as if they had been recorded serially.
+//
+// Every command list starts without render targets or viewport, so beginList
+// runs first on each one to set them up.
+class ParallelDrawRecorder
+{
+public:
+    typedef std::function<void(IRenderCommandList&)> BeginListCallback;
+
+    // maxLists bounds both the parallelism and the number of allocators kept
+    // alive; chunks smaller than minDrawsPerList are not worth a list.
+    ParallelDrawRecorder(IRenderDevice& device, uint32_t maxLists, uint32_t minDrawsPerList = 64, JobSystem& jobs = JobSystem::Get());
+    ParallelDrawRecorder(const ParallelDrawRecorder& rhs) = delete;
+    ParallelDrawRecorder& operator=(const ParallelDrawRecorder& rhs) = delete;
+
+    // Records the items for frameSlot and returns the number of lists used;
+    // Lists() holds them in order. Zero items record zero lists.
+    uint32_t Record(uint32_t frameSlot, const DrawListBindings& bindings, const DrawItem* items, size_t count,
+        const BeginListCallback& beginList);
+
+    IRenderCommandList* const* Lists() const { return m_listPointers.data(); }
+
+private:
+    JobSystem& m_jobs;
+    uint32_t m_minDrawsPerList;
+    std::vector<std::unique_ptr<IRenderCommandList>> m_lists;
+    std::vector<IRenderCommandList*> m_listPointers;
+    std::vector<std::exception_ptr> m_errors;
+};
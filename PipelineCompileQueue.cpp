@@ -0,0 +1,171 @@
+#include "PipelineCompileQueue.h"
+#include <stdexcept>
+
+PipelineCompileQueue::PipelineCompileQueue(uint32_t capacity, unsigned workerCount, const CompileFunction& compile) :
+    m_compile(compile),
+    m_capacity(capacity),
+    m_status(new std::atomic<uint32_t>[capacity])
+{
+    for (uint32_t i = 0; i < capacity; i++)
+    {
+        m_status[i].store(static_cast<uint32_t>(Status::Pending), std::memory_order_relaxed);
+    }
+    m_started.assign(capacity, false);
+
+    for (unsigned i = 0; i < workerCount; i++)
+    {
+        m_workers.emplace_back(&PipelineCompileQueue::WorkerMain, this);
+    }
+}
+
+PipelineCompileQueue::~PipelineCompileQueue()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+    for (std::thread& worker : m_workers)
+    {
+        worker.join();
+    }
+}
+
+uint32_t PipelineCompileQueue::Request(uint64_t key, const CreateFunction& create)
+{
+    uint32_t id;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stats.requested++;
+
+        auto found = m_ids.find(key);
+        if (found != m_ids.end())
+        {
+            m_stats.deduplicated++;
+            return found->second;
+        }
+
+        id = m_count.load(std::memory_order_relaxed);
+        if (id >= m_capacity)
+        {
+            throw std::length_error("PipelineCompileQueue: capacity exceeded");
+        }
+        if (create)
+        {
+            create(id);
+        }
+        m_ids[key] = id;
+        m_count.store(id + 1, std::memory_order_release);
+
+        if (!m_workers.empty())
+        {
+            m_queue.push_back(id);
+        }
+    }
+
+    if (m_workers.empty())
+    {
+        Wait(id);
+    }
+    else
+    {
+        m_wake.notify_one();
+    }
+    return id;
+}
+
+PipelineCompileQueue::Status PipelineCompileQueue::Wait(uint32_t id)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (!m_started[id])
+    {
+        // Still queued: take it rather than wait behind everything else.
+        m_started[id] = true;
+        m_running++;
+        lock.unlock();
+        Run(id);
+        lock.lock();
+    }
+    m_done.wait(lock, [&] { return GetStatus(id) != Status::Pending; });
+    return GetStatus(id);
+}
+
+void PipelineCompileQueue::WaitAll()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done.wait(lock, [&]
+    {
+        if (m_running != 0)
+        {
+            return false;
+        }
+        for (uint32_t id : m_queue)
+        {
+            if (!m_started[id])
+            {
+                return false;
+            }
+        }
+        return true;
+    });
+}
+
+PipelineCompileQueue::Stats PipelineCompileQueue::GetStats() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
+
+void PipelineCompileQueue::WorkerMain()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (;;)
+    {
+        m_wake.wait(lock, [&] { return m_stop || !m_queue.empty(); });
+        if (m_queue.empty())
+        {
+            return;
+        }
+
+        const uint32_t id = m_queue.front();
+        m_queue.pop_front();
+        if (m_started[id])
+        {
+            continue;
+        }
+        m_started[id] = true;
+        m_running++;
+
+        lock.unlock();
+        Run(id);
+        lock.lock();
+    }
+}
+
+void PipelineCompileQueue::Run(uint32_t id)
+{
+    bool compiled = false;
+    try
+    {
+        compiled = m_compile(id);
+    }
+    catch (...)
+    {
+        compiled = false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_status[id].store(static_cast<uint32_t>(compiled ? Status::Ready : Status::Failed), std::memory_order_release);
+        if (compiled)
+        {
+            m_stats.compiled++;
+        }
+        else
+        {
+            m_stats.failed++;
+        }
+        m_running--;
+    }
+    m_done.notify_all();
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Compiles pipeline states in the background, once per distinct key.
+//
+// Request hands out a dense id per key; identical keys share an id. New ids
+// are queued for the worker threads, which call compile(id). Status can be
+// polled from any thread without locking, so render code can check whether
+// a pipeline is ready and draw with another one while it is not.
+//
+// Ids are bounded by capacity so per-id data can live in fixed arrays that
+// never move while workers and recording threads read them.
+class PipelineCompileQueue
+{
+public:
+    static const uint32_t InvalidId = ~0u;
+
+    enum class Status : uint32_t
+    {
+        Pending,
+        Ready,
+        Failed,
+    };
+
+    // Returns true on success. Runs on a worker thread, or on a thread that
+    // waits for an id nobody has started yet.
+    typedef std::function<bool(uint32_t id)> CompileFunction;
+    // Runs under the queue's lock before a new id is queued, to set up
+    // whatever compile(id) will need.
+    typedef std::function<void(uint32_t id)> CreateFunction;
+
+    struct Stats
+    {
+        uint32_t requested = 0;
+        uint32_t deduplicated = 0;
+        uint32_t compiled = 0;
+        uint32_t failed = 0;
+    };
+
+    // workerCount == 0 compiles inline in Request.
+    PipelineCompileQueue(uint32_t capacity, unsigned workerCount, const CompileFunction& compile);
+    PipelineCompileQueue(const PipelineCompileQueue& rhs) = delete;
+    PipelineCompileQueue& operator=(const PipelineCompileQueue& rhs) = delete;
+
+    // Finishes the work already queued.
+    ~PipelineCompileQueue();
+
+    // Throws std::length_error once capacity ids exist.
+    uint32_t Request(uint64_t key, const CreateFunction& create);
+
+    Status GetStatus(uint32_t id) const { return static_cast<Status>(m_status[id].load(std::memory_order_acquire)); }
+
+    // Blocks until id is compiled, compiling it here if no worker has picked
+    // it up yet.
+    Status Wait(uint32_t id);
+    void WaitAll();
+
+    uint32_t Count() const { return m_count.load(std::memory_order_acquire); }
+    Stats GetStats() const;
+
+private:
+    void WorkerMain();
+    void Run(uint32_t id);
+
+    CompileFunction m_compile;
+    uint32_t m_capacity;
+    std::unique_ptr<std::atomic<uint32_t>[]> m_status;
+    std::atomic<uint32_t> m_count{ 0 };
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_done;
+    std::unordered_map<uint64_t, uint32_t> m_ids;
+    std::deque<uint32_t> m_queue;
+    std::vector<bool> m_started;
+    uint32_t m_running = 0;
+    bool m_stop = false;
+    Stats m_stats;
+    std::vector<std::thread> m_workers;
+};
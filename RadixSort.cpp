@@ -0,0 +1,148 @@
+#include "RadixSort.h"
+#include <algorithm>
+
+namespace
+{
+    const unsigned DigitBits = 11;
+    const size_t BucketCount = 1u << DigitBits;
+    const unsigned PassCount = (64 + DigitBits - 1) / DigitBits;
+
+    // Below this a chunk is not worth handing to another thread.
+    const size_t MinChunkSize = 8 * 1024;
+
+    inline size_t Digit(uint64_t key, unsigned shift)
+    {
+        return static_cast<size_t>(key >> shift) & (BucketCount - 1);
+    }
+
+    // The loops take plain pointers so the compiler does not have to reload
+    // them after every store into destination.
+    void CountDigits(const RadixSortEntry* begin, const RadixSortEntry* end, unsigned shift, size_t* counts)
+    {
+        std::fill(counts, counts + BucketCount, 0);
+        for (const RadixSortEntry* entry = begin; entry != end; entry++)
+        {
+            counts[Digit(entry->key, shift)]++;
+        }
+    }
+
+    void ScatterDigits(const RadixSortEntry* begin, const RadixSortEntry* end, unsigned shift, size_t* next, RadixSortEntry* destination)
+    {
+        for (const RadixSortEntry* entry = begin; entry != end; entry++)
+        {
+            destination[next[Digit(entry->key, shift)]++] = *entry;
+        }
+    }
+}
+
+void RadixSort(std::vector<RadixSortEntry>& entries, RadixSortScratch& scratch, JobSystem* jobs, size_t parallelThreshold)
+{
+    const size_t count = entries.size();
+    scratch.entries.resize(count);
+    if (count < 2)
+    {
+        return;
+    }
+
+    RadixSortEntry* source = entries.data();
+    RadixSortEntry* destination = scratch.entries.data();
+
+    size_t chunkCount = 1;
+    if (jobs && count >= parallelThreshold)
+    {
+        chunkCount = std::max<size_t>(1, std::min<size_t>(jobs->ThreadCount(), count / MinChunkSize));
+    }
+
+    if (chunkCount == 1)
+    {
+        // Digit counts do not depend on the order, so a single read gives the
+        // histograms of every pass.
+        std::vector<size_t>& offsets = scratch.offsets;
+        offsets.assign(PassCount * BucketCount, 0);
+        for (size_t i = 0; i < count; i++)
+        {
+            const uint64_t key = source[i].key;
+            for (unsigned pass = 0; pass < PassCount; pass++)
+            {
+                offsets[pass * BucketCount + Digit(key, pass * DigitBits)]++;
+            }
+        }
+
+        for (unsigned pass = 0; pass < PassCount; pass++)
+        {
+            const unsigned shift = pass * DigitBits;
+            size_t* next = &offsets[pass * BucketCount];
+            if (next[Digit(source[0].key, shift)] == count)
+            {
+                continue;
+            }
+
+            size_t offset = 0;
+            for (size_t bucket = 0; bucket < BucketCount; bucket++)
+            {
+                const size_t bucketCount = next[bucket];
+                next[bucket] = offset;
+                offset += bucketCount;
+            }
+            ScatterDigits(source, source + count, shift, next, destination);
+            std::swap(source, destination);
+        }
+    }
+    else
+    {
+        // Bits that differ from the first key anywhere in the list.
+        uint64_t varying = 0;
+        const uint64_t firstKey = source[0].key;
+        for (size_t i = 0; i < count; i++)
+        {
+            varying |= source[i].key ^ firstKey;
+        }
+
+        std::vector<size_t>& offsets = scratch.offsets;
+        offsets.resize(chunkCount * BucketCount);
+        for (unsigned pass = 0; pass < PassCount; pass++)
+        {
+            const unsigned shift = pass * DigitBits;
+            if (Digit(varying, shift) == 0)
+            {
+                continue;
+            }
+
+            // Each chunk counts its own digits, ...
+            jobs->ParallelFor(chunkCount, 1, [&](size_t begin, size_t end)
+            {
+                for (size_t chunk = begin; chunk < end; chunk++)
+                {
+                    CountDigits(source + count * chunk / chunkCount, source + count * (chunk + 1) / chunkCount, shift, &offsets[chunk * BucketCount]);
+                }
+            });
+
+            // ... and writes its share of each bucket after the earlier chunks'
+            // share, which keeps the sort stable.
+            size_t offset = 0;
+            for (size_t bucket = 0; bucket < BucketCount; bucket++)
+            {
+                for (size_t chunk = 0; chunk < chunkCount; chunk++)
+                {
+                    const size_t bucketCount = offsets[chunk * BucketCount + bucket];
+                    offsets[chunk * BucketCount + bucket] = offset;
+                    offset += bucketCount;
+                }
+            }
+
+            jobs->ParallelFor(chunkCount, 1, [&](size_t begin, size_t end)
+            {
+                for (size_t chunk = begin; chunk < end; chunk++)
+                {
+                    ScatterDigits(source + count * chunk / chunkCount, source + count * (chunk + 1) / chunkCount, shift, &offsets[chunk * BucketCount], destination);
+                }
+            });
+            std::swap(source, destination);
+        }
+    }
+
+    if (source != entries.data())
+    {
+        entries.swap(scratch.entries);
+    }
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "JobSystem.h"
+
+struct RadixSortEntry
+{
+    uint64_t key;
+    uint32_t value;
+};
+
+// Working memory for RadixSort. Kept by the caller between sorts, so sorting
+// allocates nothing once it has grown to the largest list.
+struct RadixSortScratch
+{
+    std::vector<RadixSortEntry> entries;    // Second buffer, as long as the list.
+    std::vector<size_t> offsets;            // Digit histograms and bucket offsets.
+};
+
+// Stable LSD radix sort of entries by key, 11 bits per pass (at most six
+// passes). Digits that are the same in every key are skipped, so keys with
+// mostly constant fields take fewer passes.
+//
+// With jobs, lists of at least parallelThreshold entries are sorted on the
+// pool: each thread histograms and scatters its own chunk.
+void RadixSort(std::vector<RadixSortEntry>& entries, RadixSortScratch& scratch,
+    JobSystem* jobs = nullptr, size_t parallelThreshold = 32 * 1024);
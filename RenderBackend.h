@@ -0,0 +1,264 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "FramePacer.h"
+
+// Backend-neutral view of the GPU: resource creation, command recording and
+// submission. D3D12RenderDevice implements it on top of D3D12; NullRenderDevice
+// validates and records commands without a GPU so frame code can be run and
+// profiled headless. Anything the interface does not cover (swap chain,
+// render target transitions, ...) stays with the D3D12 code that owns it.
+//
+// Binding model shared by every backend, matching shaders.hlsl: one constant
+// buffer (b0, every stage), up to MaxTextureSlots textures (pixel stage,
+// indexed bindlessly on D3D12), static samplers, vertices laid out as the
+// engine's Vertex (position, normal, uv), a structured buffer of
+// InstanceData (vertex stage) that instance i of a draw reads record i of,
+// and up to MaxShaderBufferSlots structured buffers (pixel stage).
+
+template<typename Tag>
+struct RenderHandle
+{
+    static const uint32_t Invalid = ~0u;
+    uint32_t index = Invalid;
+
+    bool IsValid() const { return index != Invalid; }
+    bool operator==(const RenderHandle& rhs) const { return index == rhs.index; }
+    bool operator!=(const RenderHandle& rhs) const { return index != rhs.index; }
+};
+
+typedef RenderHandle<struct BufferHandleTag> BufferHandle;
+typedef RenderHandle<struct TextureHandleTag> TextureHandle;
+typedef RenderHandle<struct PipelineHandleTag> PipelineHandle;
+
+enum class MemoryType
+{
+    GpuOnly,    // D3D12_HEAP_TYPE_DEFAULT
+    Upload,     // CPU writable, persistently mapped.
+};
+
+enum class TextureFormat
+{
+    RGBA8,
+    RGBA8_SRGB,
+    BC1,
+    BC1_SRGB,
+    BC3,
+    BC3_SRGB,
+};
+
+struct BufferDesc
+{
+    uint64_t size = 0;
+    MemoryType memory = MemoryType::GpuOnly;
+};
+
+struct TextureDesc
+{
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t mipLevels = 1;
+    TextureFormat format = TextureFormat::RGBA8;
+};
+
+struct ShaderBytecode
+{
+    const void* data = nullptr;
+    size_t size = 0;
+};
+
+enum class VertexInput
+{
+    Vertex,         // The engine's Vertex: position, normal, uv.
+    PositionOnly,   // Position only, from the same Vertex buffers.
+    None,           // Shaders generate vertices from SV_VertexID.
+};
+
+enum class CompareFunc
+{
+    Less,
+    LessEqual,
+    Equal,
+    Always,
+};
+
+enum class DepthFormat
+{
+    None,
+    D32,
+    D24S8,
+};
+
+const uint32_t MaxRenderTargets = 4;
+
+struct PipelineDesc
+{
+    ShaderBytecode vertexShader;
+    // Optional; without one the pipeline writes depth only.
+    ShaderBytecode pixelShader;
+    VertexInput vertexInput = VertexInput::Vertex;
+
+    bool depthTest = true;
+    bool depthWrite = true;
+    CompareFunc depthFunc = CompareFunc::Less;
+    // Off clamps depth to the viewport range instead of clipping, for shadow
+    // casters in front of the light's near plane.
+    bool depthClip = true;
+    // Depth bias in units of the depth format's resolution, plus a slope
+    // scaled part; clamp 0 means unclamped.
+    int32_t depthBias = 0;
+    float depthBiasClamp = 0.0f;
+    float slopeScaledDepthBias = 0.0f;
+
+    // Color formats only (RGBA8 or RGBA8_SRGB); depth-only passes have none.
+    uint32_t renderTargetCount = 1;
+    TextureFormat renderTargetFormats[MaxRenderTargets] = { TextureFormat::RGBA8, TextureFormat::RGBA8, TextureFormat::RGBA8, TextureFormat::RGBA8 };
+    DepthFormat depthFormat = DepthFormat::D32;
+
+    // Backends that compile pipelines in the background draw with this one
+    // until the new pipeline is ready. Without it, first use waits.
+    PipelineHandle fallback;
+};
+
+// Per-instance data, as read by shaders.hlsl. world is a row-major 3x4
+// affine transform: world position = world * float4(position, 1).
+struct InstanceData
+{
+    float world[3][4];
+    // Bindless albedo slot for this instance, or DrawMaterial to use the
+    // draw's albedo texture.
+    uint32_t material;
+    uint32_t padding[3];
+
+    static const uint32_t DrawMaterial = ~0u;
+};
+static_assert(sizeof(InstanceData) == 64, "InstanceData must match shaders.hlsl");
+
+const uint32_t MaxConstantBufferSlots = 1;
+// Texture slots: 0 albedo, 1 normal map, 2 shadow map.
+const uint32_t MaxTextureSlots = 3;
+// Structured buffer slots: 0 lights, 1 light clusters, 2 light indices (see
+// ClusteredLighting.h).
+const uint32_t MaxShaderBufferSlots = 3;
+const uint32_t ConstantBufferAlignment = 256;
+
+class IRenderCommandList
+{
+public:
+    virtual ~IRenderCommandList() = default;
+
+    // Starts recording into the allocator of frameSlot. As with FramePacer, the
+    // caller guarantees the GPU has finished the frame that last used the slot.
+    virtual void Begin(uint32_t frameSlot) = 0;
+    virtual void End() = 0;
+
+    virtual void SetPipeline(PipelineHandle pipeline) = 0;
+    virtual void SetConstantBuffer(uint32_t slot, BufferHandle buffer, uint64_t offset) = 0;
+    virtual void SetTexture(uint32_t slot, TextureHandle texture) = 0;
+    virtual void SetVertexBuffer(BufferHandle buffer, uint32_t stride, uint64_t offset = 0) = 0;
+    // Indices are 32-bit.
+    virtual void SetIndexBuffer(BufferHandle buffer, uint64_t offset = 0) = 0;
+    // InstanceData records starting at offset (a multiple of sizeof(InstanceData)).
+    // Instance ids start at zero whatever firstInstance a draw passes, so each
+    // instanced draw binds its own offset.
+    virtual void SetInstanceBuffer(BufferHandle buffer, uint64_t offset = 0) = 0;
+    // A pixel stage structured buffer starting offset bytes into buffer (a
+    // multiple of 4).
+    virtual void SetShaderBuffer(uint32_t slot, BufferHandle buffer, uint64_t offset = 0) = 0;
+    // Also sets the scissor rectangle to the viewport.
+    virtual void SetViewport(float x, float y, float width, float height) = 0;
+
+    virtual void Draw(uint32_t vertexCount, uint32_t instanceCount = 1, uint32_t firstVertex = 0, uint32_t firstInstance = 0) = 0;
+    virtual void DrawIndexed(uint32_t indexCount, uint32_t instanceCount = 1, uint32_t firstIndex = 0, int32_t baseVertex = 0, uint32_t firstInstance = 0) = 0;
+
+    // Replays a closed bundle. The bundle sees the constant buffer, texture and
+    // shader buffer bindings of this list; the pipeline, vertex/index buffers and instance
+    // buffer it sets remain set afterwards.
+    virtual void ExecuteBundle(IRenderCommandList& bundle) = 0;
+};
+
+// Different command lists may record on different threads at the same time.
+// Creating or destroying resources while lists are recording is not allowed,
+// so backends can look handles up without locking.
+class IRenderDevice
+{
+public:
+    virtual ~IRenderDevice() = default;
+
+    // initialData is optional; GpuOnly buffers are filled through the backend's
+    // upload path.
+    virtual BufferHandle CreateBuffer(const BufferDesc& desc, const void* initialData = nullptr) = 0;
+    virtual TextureHandle CreateTexture(const TextureDesc& desc) = 0;
+    virtual PipelineHandle CreatePipeline(const PipelineDesc& desc) = 0;
+
+    // The caller must make sure the GPU no longer uses the resource.
+    virtual void Destroy(BufferHandle buffer) = 0;
+    virtual void Destroy(TextureHandle texture) = 0;
+    virtual void Destroy(PipelineHandle pipeline) = 0;
+
+    // Upload buffers only; the pointer stays valid until the buffer is destroyed.
+    virtual void* Map(BufferHandle buffer) = 0;
+
+    virtual std::unique_ptr<IRenderCommandList> CreateCommandList() = 0;
+    // A bundle records static draws once for replay with ExecuteBundle. It has
+    // a single allocator, so it may only be re-recorded once the GPU is done
+    // with every frame that executed it. SetViewport is not allowed in bundles.
+    virtual std::unique_ptr<IRenderCommandList> CreateBundle() = 0;
+    // Executes closed command lists in order.
+    virtual void Submit(IRenderCommandList* const* lists, uint32_t count) = 0;
+
+    // The fence of the queue Submit executes on.
+    virtual IFenceQueue& Fences() = 0;
+};
+
+// Slot storage behind the handles. Freed indices are reused.
+template<typename T>
+class RenderResourcePool
+{
+public:
+    uint32_t Add(const T& value)
+    {
+        if (!m_free.empty())
+        {
+            const uint32_t index = m_free.back();
+            m_free.pop_back();
+            m_slots[index].value = value;
+            m_slots[index].alive = true;
+            return index;
+        }
+        m_slots.push_back({ value, true });
+        return static_cast<uint32_t>(m_slots.size() - 1);
+    }
+
+    void Remove(uint32_t index)
+    {
+        if (Get(index))
+        {
+            m_slots[index].value = T();
+            m_slots[index].alive = false;
+            m_free.push_back(index);
+        }
+    }
+
+    // nullptr for invalid or destroyed handles.
+    T* Get(uint32_t index)
+    {
+        return index < m_slots.size() && m_slots[index].alive ? &m_slots[index].value : nullptr;
+    }
+
+    uint32_t SlotCount() const { return static_cast<uint32_t>(m_slots.size()); }
+    size_t LiveCount() const { return m_slots.size() - m_free.size(); }
+
+private:
+    struct Slot
+    {
+        T value;
+        bool alive;
+    };
+
+    std::vector<Slot> m_slots;
+    std::vector<uint32_t> m_free;
+};
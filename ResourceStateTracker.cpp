@@ -0,0 +1,242 @@
+#include "ResourceStateTracker.h"
+#include <stdexcept>
+
+namespace
+{
+    // True when a resource in state `current` can already be used as `wanted`.
+    bool AlreadyReadable(ResourceStates current, ResourceStates wanted)
+    {
+        return wanted != ResourceState::Common &&
+            (current & ~ResourceState::ReadOnly) == 0 &&
+            (wanted & ~current) == 0;
+    }
+}
+
+uint32_t ResourceStateTracker::Register(uint32_t subresourceCount, ResourceStates initialState)
+{
+    uint32_t resource;
+    if (!m_free.empty())
+    {
+        resource = m_free.back();
+        m_free.pop_back();
+    }
+    else
+    {
+        resource = static_cast<uint32_t>(m_resources.size());
+        m_resources.emplace_back();
+    }
+
+    Resource& data = m_resources[resource];
+    data = Resource();
+    data.alive = true;
+    data.subresourceCount = subresourceCount ? subresourceCount : 1;
+    data.state = initialState;
+    return resource;
+}
+
+void ResourceStateTracker::Unregister(uint32_t resource)
+{
+    if (resource < m_resources.size() && m_resources[resource].alive)
+    {
+        m_resources[resource] = Resource();
+        m_free.push_back(resource);
+    }
+}
+
+ResourceStates ResourceStateTracker::State(uint32_t resource, uint32_t subresource) const
+{
+    if (resource >= m_resources.size() || !m_resources[resource].alive)
+    {
+        throw std::logic_error("ResourceStateTracker: invalid resource");
+    }
+    const Resource& data = m_resources[resource];
+    return data.uniform ? data.state : data.states[subresource];
+}
+
+void ResourceStateTracker::Assume(uint32_t resource, ResourceStates state)
+{
+    State(resource);
+    Resource& data = m_resources[resource];
+    data.uniform = true;
+    data.state = state;
+    data.states.clear();
+    data.splitting = false;
+}
+
+void ResourceStateTracker::Transition(uint32_t resource, ResourceStates after, uint32_t subresource)
+{
+    State(resource);
+    Resource& data = m_resources[resource];
+    if (data.splitting)
+    {
+        EndSplit(data, resource);
+    }
+
+    if (subresource == AllSubresources)
+    {
+        if (data.uniform)
+        {
+            TransitionSubresource(data, resource, AllSubresources, data.state, after);
+        }
+        else
+        {
+            for (uint32_t i = 0; i < data.subresourceCount; i++)
+            {
+                TransitionSubresource(data, resource, i, data.states[i], after);
+            }
+            Collapse(data);
+        }
+        return;
+    }
+
+    if (subresource >= data.subresourceCount)
+    {
+        throw std::logic_error("ResourceStateTracker: subresource out of range");
+    }
+    if (data.uniform)
+    {
+        if (data.state == after || AlreadyReadable(data.state, after))
+        {
+            m_stats.elided++;
+            return;
+        }
+        data.states.assign(data.subresourceCount, data.state);
+        data.uniform = false;
+    }
+    TransitionSubresource(data, resource, subresource, data.states[subresource], after);
+    Collapse(data);
+}
+
+void ResourceStateTracker::BeginTransition(uint32_t resource, ResourceStates after)
+{
+    State(resource);
+    Resource& data = m_resources[resource];
+    if (data.splitting)
+    {
+        EndSplit(data, resource);
+    }
+
+    // Per-subresource states would need one split per subresource; not worth it.
+    if (!data.uniform)
+    {
+        Transition(resource, after);
+        return;
+    }
+    if (data.state == after || AlreadyReadable(data.state, after))
+    {
+        m_stats.elided++;
+        return;
+    }
+
+    ResourceBarrierDesc barrier = { ResourceBarrierDesc::Type::Transition, ResourceBarrierDesc::Split::BeginOnly,
+        resource, AllSubresources, data.state, after };
+    m_pending.push_back(barrier);
+    data.splitting = true;
+    data.splitBefore = data.state;
+    data.state = after;
+}
+
+void ResourceStateTracker::UnorderedAccessBarrier(uint32_t resource)
+{
+    State(resource);
+    for (const ResourceBarrierDesc& pending : m_pending)
+    {
+        if (pending.type == ResourceBarrierDesc::Type::UnorderedAccess && pending.resource == resource)
+        {
+            m_stats.elided++;
+            return;
+        }
+    }
+
+    ResourceBarrierDesc barrier = { ResourceBarrierDesc::Type::UnorderedAccess, ResourceBarrierDesc::Split::None,
+        resource, AllSubresources, 0, 0 };
+    m_pending.push_back(barrier);
+}
+
+const std::vector<ResourceBarrierDesc>& ResourceStateTracker::Flush()
+{
+    m_flushed.swap(m_pending);
+    m_pending.clear();
+    if (!m_flushed.empty())
+    {
+        m_stats.issued += m_flushed.size();
+        m_stats.batches++;
+    }
+    return m_flushed;
+}
+
+void ResourceStateTracker::TransitionSubresource(Resource& data, uint32_t resource, uint32_t subresource, ResourceStates before, ResourceStates after)
+{
+    if (before == after || AlreadyReadable(before, after))
+    {
+        m_stats.elided++;
+        return;
+    }
+
+    if (subresource == AllSubresources)
+    {
+        data.state = after;
+    }
+    else
+    {
+        data.states[subresource] = after;
+    }
+
+    // Fold into a barrier for the same subresource that has not been flushed yet.
+    for (size_t i = 0; i < m_pending.size(); i++)
+    {
+        ResourceBarrierDesc& pending = m_pending[i];
+        if (pending.type == ResourceBarrierDesc::Type::Transition && pending.split == ResourceBarrierDesc::Split::None &&
+            pending.resource == resource && pending.subresource == subresource)
+        {
+            m_stats.elided++;
+            pending.after = after;
+            if (pending.before == after)
+            {
+                // The earlier request is cancelled out as well.
+                m_stats.elided++;
+                m_pending.erase(m_pending.begin() + i);
+            }
+            return;
+        }
+    }
+
+    ResourceBarrierDesc barrier = { ResourceBarrierDesc::Type::Transition, ResourceBarrierDesc::Split::None,
+        resource, subresource, before, after };
+    m_pending.push_back(barrier);
+}
+
+void ResourceStateTracker::EndSplit(Resource& data, uint32_t resource)
+{
+    data.splitting = false;
+
+    // If the begin has not been flushed yet there is nothing to overlap with;
+    // issue it as a plain barrier instead.
+    for (ResourceBarrierDesc& pending : m_pending)
+    {
+        if (pending.split == ResourceBarrierDesc::Split::BeginOnly && pending.resource == resource)
+        {
+            pending.split = ResourceBarrierDesc::Split::None;
+            return;
+        }
+    }
+
+    ResourceBarrierDesc barrier = { ResourceBarrierDesc::Type::Transition, ResourceBarrierDesc::Split::EndOnly,
+        resource, AllSubresources, data.splitBefore, data.state };
+    m_pending.push_back(barrier);
+    m_stats.split++;
+}
+
+void ResourceStateTracker::Collapse(Resource& data)
+{
+    for (uint32_t i = 1; i < data.subresourceCount; i++)
+    {
+        if (data.states[i] != data.states[0])
+        {
+            return;
+        }
+    }
+    data.uniform = true;
+    data.state = data.states[0];
+    data.states.clear();
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Resource states, numerically identical to D3D12_RESOURCE_STATES so the
+// D3D12 side can pass them straight through.
+typedef uint32_t ResourceStates;
+
+namespace ResourceState
+{
+    const ResourceStates Common = 0x0;
+    const ResourceStates Present = 0x0;
+    const ResourceStates VertexAndConstantBuffer = 0x1;
+    const ResourceStates IndexBuffer = 0x2;
+    const ResourceStates RenderTarget = 0x4;
+    const ResourceStates UnorderedAccess = 0x8;
+    const ResourceStates DepthWrite = 0x10;
+    const ResourceStates DepthRead = 0x20;
+    const ResourceStates NonPixelShaderResource = 0x40;
+    const ResourceStates PixelShaderResource = 0x80;
+    const ResourceStates IndirectArgument = 0x200;
+    const ResourceStates CopyDest = 0x400;
+    const ResourceStates CopySource = 0x800;
+    const ResourceStates GenericRead = VertexAndConstantBuffer | IndexBuffer | NonPixelShaderResource |
+        PixelShaderResource | IndirectArgument | CopySource;
+
+    // States that may be combined; a resource in any of them can also be read
+    // as any subset without a barrier.
+    const ResourceStates ReadOnly = GenericRead | DepthRead;
+}
+
+struct ResourceBarrierDesc
+{
+    enum class Type : uint8_t
+    {
+        Transition,
+        UnorderedAccess,
+        Aliasing,       // resource takes over memory it shares with other placed resources.
+    };
+
+    // Split barriers: BeginOnly starts the transition early, EndOnly waits
+    // for it right before the resource is needed in its new state.
+    enum class Split : uint8_t
+    {
+        None,
+        BeginOnly,
+        EndOnly,
+    };
+
+    Type type;
+    Split split;
+    uint32_t resource;
+    uint32_t subresource;
+    ResourceStates before;
+    ResourceStates after;
+};
+
+// Tracks the current state of every subresource of the registered resources
+// and turns state requests into the barriers they need. Requests queue up
+// until Flush, which hands back one merged batch:
+//  - transitions to the state a resource is already in are dropped;
+//  - reads of a state the resource is already readable in are dropped;
+//  - A->B followed by B->C in the same batch becomes A->C, and A->B->A
+//    cancels out;
+//  - duplicate UAV barriers are dropped.
+// It only deals in ids and states; D3D12ResourceStates maps it onto D3D12.
+class ResourceStateTracker
+{
+public:
+    static const uint32_t AllSubresources = 0xffffffff;
+
+    struct Stats
+    {
+        uint64_t issued = 0;    // Barriers handed out by Flush.
+        uint64_t elided = 0;    // Requests that needed no barrier of their own.
+        uint64_t split = 0;     // Begin/end pairs issued.
+        uint64_t batches = 0;   // Non-empty Flush calls.
+    };
+
+    uint32_t Register(uint32_t subresourceCount, ResourceStates initialState);
+    void Unregister(uint32_t resource);
+
+    // The state the subresource will be in once the pending barriers execute.
+    ResourceStates State(uint32_t resource, uint32_t subresource = 0) const;
+
+    // Records a state change made outside the tracker, e.g. implicit decay
+    // to Common at the end of an ExecuteCommandLists.
+    void Assume(uint32_t resource, ResourceStates state);
+
+    void Transition(uint32_t resource, ResourceStates after, uint32_t subresource = AllSubresources);
+
+    // Starts a transition of the whole resource that the next Transition of it
+    // completes, letting the GPU overlap the work with whatever is recorded in
+    // between.
+    void BeginTransition(uint32_t resource, ResourceStates after);
+
+    void UnorderedAccessBarrier(uint32_t resource);
+
+    // Returns the batch of barriers requested since the previous call. The
+    // reference stays valid until the next call.
+    const std::vector<ResourceBarrierDesc>& Flush();
+
+    bool HasPendingBarriers() const { return !m_pending.empty(); }
+    const Stats& GetStats() const { return m_stats; }
+
+private:
+    struct Resource
+    {
+        bool alive = false;
+        uint32_t subresourceCount = 1;
+        bool uniform = true;                // All subresources share state.
+        ResourceStates state = 0;           // Valid when uniform.
+        std::vector<ResourceStates> states; // Valid when not uniform.
+        bool splitting = false;             // A BeginOnly barrier is outstanding.
+        ResourceStates splitBefore = 0;
+    };
+
+    void TransitionSubresource(Resource& data, uint32_t resource, uint32_t subresource, ResourceStates before, ResourceStates after);
+    void EndSplit(Resource& data, uint32_t resource);
+    void Collapse(Resource& data);
+
+    std::vector<Resource> m_resources;
+    std::vector<uint32_t> m_free;
+    std::vector<ResourceBarrierDesc> m_pending;
+    std::vector<ResourceBarrierDesc> m_flushed;
+    Stats m_stats;
+};
@@ -0,0 +1,57 @@
+#include "RingAllocator.h"
+
+RingAllocator::RingAllocator(uint64_t capacity) :
+    m_capacity(capacity)
+{
+}
+
+uint64_t RingAllocator::Allocate(uint64_t size, uint64_t alignment)
+{
+    if (size == 0 || size > m_capacity || alignment == 0)
+        return InvalidOffset;
+
+    // Once everything has retired, restart at offset 0 so that a large
+    // allocation is not refused just because the old head sits mid-buffer.
+    const uint64_t headPhysical = m_head % m_capacity;
+    if (m_head == m_tail && headPhysical != 0)
+    {
+        m_head += m_capacity - headPhysical;
+        m_tail = m_head;
+    }
+
+    uint64_t start = (m_head + alignment - 1) / alignment * alignment;
+
+    // Do not straddle the end of the buffer; wrap to the start instead.
+    const uint64_t physical = start % m_capacity;
+    if (physical + size > m_capacity)
+    {
+        start += m_capacity - physical;
+    }
+
+    if (start + size - m_tail > m_capacity)
+        return InvalidOffset;
+
+    m_head = start + size;
+    return start % m_capacity;
+}
+
+void RingAllocator::FinishFrame(uint64_t fenceValue)
+{
+    if (!m_pending.empty() && m_pending.back().fenceValue == fenceValue)
+    {
+        m_pending.back().end = m_head;
+        return;
+    }
+    m_pending.push_back({ fenceValue, m_head });
+}
+
+void RingAllocator::Retire(uint64_t completedFenceValue)
+{
+    while (!m_pending.empty() && m_pending.front().fenceValue <= completedFenceValue)
+    {
+        // A reset in Allocate may already have moved the tail past this frame.
+        if (m_pending.front().end > m_tail)
+            m_tail = m_pending.front().end;
+        m_pending.pop_front();
+    }
+}
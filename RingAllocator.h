@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+
+// Linear ring suballocator over a fixed range of offsets, with space retired by
+// fence value. It only hands out offsets, so it is backend agnostic; see
+// UploadRingBuffer for the D3D12 upload heap built on top of it.
+//
+// Offsets grow monotonically and are reduced modulo the capacity, so an
+// allocation never straddles the end of the buffer: if it would, the rest of
+// the buffer is skipped and the allocation starts again at offset 0.
+class RingAllocator
+{
+public:
+    static const uint64_t InvalidOffset = ~0ull;
+
+    // capacity should be a multiple of the largest alignment requested.
+    explicit RingAllocator(uint64_t capacity);
+
+    uint64_t Capacity() const { return m_capacity; }
+    uint64_t UsedBytes() const { return m_head - m_tail; }
+
+    // Returns the byte offset of the allocation, or InvalidOffset when the ring
+    // does not have room until more fences retire.
+    uint64_t Allocate(uint64_t size, uint64_t alignment = 256);
+
+    // Everything allocated since the previous call belongs to fenceValue.
+    void FinishFrame(uint64_t fenceValue);
+
+    // Releases all frames whose fence value is <= completedFenceValue.
+    void Retire(uint64_t completedFenceValue);
+
+private:
+    struct PendingFrame
+    {
+        uint64_t fenceValue;
+        uint64_t end;
+    };
+
+    uint64_t m_capacity;
+    uint64_t m_head = 0;    // Next free byte (monotonic).
+    uint64_t m_tail = 0;    // Oldest byte still owned by the GPU (monotonic).
+    std::deque<PendingFrame> m_pending;
+};
@@ -0,0 +1,294 @@
+#include "ShaderCache.h"
+#include <cstdio>
+#include <fstream>
+#include <set>
+#include <stdexcept>
+#include "Hash.h"
+
+#if defined(_WIN32)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#endif
+
+namespace
+{
+    const uint32_t CacheMagic = 0x43444853; // "SHDC"
+
+    uint64_t Checksum(const std::vector<uint8_t>& data)
+    {
+        Fnv1aHasher hasher;
+        hasher.Bytes(data.data(), data.size());
+        return hasher.Get();
+    }
+
+    std::string Directory(const std::string& path)
+    {
+        const size_t slash = path.find_last_of("/\\");
+        return slash == std::string::npos ? std::string() : path.substr(0, slash + 1);
+    }
+
+    // Appends the names in every #include "name" / #include <name> line.
+    void FindIncludes(const std::string& source, std::vector<std::string>& includes)
+    {
+        size_t line = 0;
+        while (line < source.size())
+        {
+            size_t end = source.find('\n', line);
+            if (end == std::string::npos)
+            {
+                end = source.size();
+            }
+
+            size_t i = source.find_first_not_of(" \t", line);
+            if (i < end && source[i] == '#')
+            {
+                i = source.find_first_not_of(" \t", i + 1);
+                if (i < end && source.compare(i, 7, "include") == 0)
+                {
+                    i = source.find_first_not_of(" \t", i + 7);
+                    if (i < end && (source[i] == '"' || source[i] == '<'))
+                    {
+                        const char close = source[i] == '"' ? '"' : '>';
+                        const size_t nameEnd = source.find(close, i + 1);
+                        if (nameEnd < end)
+                        {
+                            includes.push_back(source.substr(i + 1, nameEnd - i - 1));
+                        }
+                    }
+                }
+            }
+            line = end + 1;
+        }
+    }
+
+    // Hashes the includes of source depth first, in the order they appear.
+    void HashIncludes(const std::string& source, const std::string& path, const ShaderCache::FileReader& reader,
+        std::set<std::string>& visited, Fnv1aHasher& hasher)
+    {
+        std::vector<std::string> includes;
+        FindIncludes(source, includes);
+        for (const std::string& name : includes)
+        {
+            const std::string includePath = Directory(path) + name;
+            hasher.String(includePath);
+            if (!visited.insert(includePath).second)
+            {
+                continue;
+            }
+
+            // An include that cannot be read (commented out, or only reachable
+            // through an #if) still keys on its name; if the compiler needs it
+            // the compile fails anyway.
+            std::string contents;
+            if (!reader || !reader(includePath, contents))
+            {
+                hasher.Value(~0ull);
+                continue;
+            }
+            hasher.String(contents);
+            HashIncludes(contents, includePath, reader, visited, hasher);
+        }
+    }
+
+    template<typename T>
+    bool ReadValue(std::istream& file, T& value)
+    {
+        return static_cast<bool>(file.read(reinterpret_cast<char*>(&value), sizeof(value)));
+    }
+
+    template<typename T>
+    void WriteValue(std::ostream& file, const T& value)
+    {
+        file.write(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+}
+
+ShaderCache::ShaderCache(const std::string& path) :
+    m_path(path)
+{
+}
+
+uint64_t ShaderCache::ComputeKey(const ShaderCompileRequest& request, const FileReader& reader)
+{
+    Fnv1aHasher hasher;
+    hasher.Value(FormatVersion);
+    hasher.String(request.source);
+    hasher.Value(request.defines.size());
+    for (const ShaderDefine& define : request.defines)
+    {
+        hasher.String(define.name);
+        hasher.String(define.value);
+    }
+    hasher.String(request.entryPoint);
+    hasher.String(request.target);
+    hasher.Value(request.flags);
+
+    std::set<std::string> visited;
+    HashIncludes(request.source, request.sourcePath, reader, visited, hasher);
+    return hasher.Get();
+}
+
+std::string ShaderCache::Identity(const ShaderCompileRequest& request)
+{
+    std::string identity = request.sourcePath + "|" + request.entryPoint + "|" + request.target;
+    for (const ShaderDefine& define : request.defines)
+    {
+        identity += "|" + define.name + "=" + define.value;
+    }
+    return identity;
+}
+
+bool ShaderCache::Load()
+{
+    m_entries.clear();
+    m_dirty = false;
+
+    std::ifstream file(m_path, std::ios::binary);
+    if (!file)
+    {
+        return false;
+    }
+
+    uint32_t magic = 0;
+    uint32_t version = 0;
+    uint32_t count = 0;
+    bool ok = ReadValue(file, magic) && ReadValue(file, version) && ReadValue(file, count) &&
+        magic == CacheMagic && version == FormatVersion;
+    for (uint32_t i = 0; ok && i < count; i++)
+    {
+        uint32_t identityLength = 0;
+        ok = ReadValue(file, identityLength) && identityLength < (1u << 16);
+        std::string identity(ok ? identityLength : 0, '\0');
+        ok = ok && (identityLength == 0 || file.read(&identity[0], identityLength));
+
+        Entry entry;
+        uint32_t size = 0;
+        uint64_t checksum = 0;
+        ok = ok && ReadValue(file, entry.key) && ReadValue(file, size) && ReadValue(file, checksum) && size < (64u << 20);
+        if (ok)
+        {
+            entry.bytecode.resize(size);
+            ok = (size == 0 || file.read(reinterpret_cast<char*>(entry.bytecode.data()), size)) && Checksum(entry.bytecode) == checksum;
+        }
+        if (ok)
+        {
+            m_entries[identity] = std::move(entry);
+        }
+    }
+    file.close();
+
+    if (!ok)
+    {
+        // Damaged or from another version: start over and rewrite it on Save.
+        m_entries.clear();
+        m_dirty = true;
+    }
+    return ok;
+}
+
+bool ShaderCache::Save()
+{
+    if (!m_dirty || m_path.empty())
+    {
+        return true;
+    }
+
+    // Write a new file and move it over the old one in a single rename, so a
+    // crash leaves either the old cache or the new one, never half of one.
+    const std::string tempPath = m_path + ".tmp";
+    std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+    if (!file)
+    {
+        return false;
+    }
+
+    const uint32_t version = FormatVersion;
+    WriteValue(file, CacheMagic);
+    WriteValue(file, version);
+    WriteValue(file, static_cast<uint32_t>(m_entries.size()));
+    for (const auto& pair : m_entries)
+    {
+        const std::string& identity = pair.first;
+        const Entry& entry = pair.second;
+        WriteValue(file, static_cast<uint32_t>(identity.size()));
+        file.write(identity.data(), identity.size());
+        WriteValue(file, entry.key);
+        WriteValue(file, static_cast<uint32_t>(entry.bytecode.size()));
+        WriteValue(file, Checksum(entry.bytecode));
+        file.write(reinterpret_cast<const char*>(entry.bytecode.data()), entry.bytecode.size());
+    }
+    file.close();
+    if (!file)
+    {
+        remove(tempPath.c_str());
+        return false;
+    }
+
+#if defined(_WIN32)
+    // rename fails on Windows if the target exists.
+    const bool moved = MoveFileExA(tempPath.c_str(), m_path.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+    const bool moved = rename(tempPath.c_str(), m_path.c_str()) == 0;
+#endif
+    if (!moved)
+    {
+        remove(tempPath.c_str());
+        return false;
+    }
+    m_dirty = false;
+    return true;
+}
+
+const std::vector<uint8_t>* ShaderCache::Find(const std::string& identity, uint64_t key)
+{
+    auto found = m_entries.find(identity);
+    if (found == m_entries.end())
+    {
+        m_stats.misses++;
+        return nullptr;
+    }
+    if (found->second.key != key)
+    {
+        m_entries.erase(found);
+        m_dirty = true;
+        m_stats.misses++;
+        m_stats.invalidated++;
+        return nullptr;
+    }
+    m_stats.hits++;
+    return &found->second.bytecode;
+}
+
+void ShaderCache::Store(const std::string& identity, uint64_t key, const std::vector<uint8_t>& bytecode)
+{
+    Entry& entry = m_entries[identity];
+    entry.key = key;
+    entry.bytecode = bytecode;
+    m_dirty = true;
+}
+
+const std::vector<uint8_t>& ShaderCache::GetOrCompile(const ShaderCompileRequest& request, const FileReader& reader, const Compiler& compiler)
+{
+    const std::string identity = Identity(request);
+    const uint64_t key = ComputeKey(request, reader);
+    if (const std::vector<uint8_t>* cached = Find(identity, key))
+    {
+        return *cached;
+    }
+
+    std::vector<uint8_t> bytecode;
+    std::string errors;
+    if (!compiler(request, bytecode, errors))
+    {
+        throw std::runtime_error("Failed to compile " + identity + ":\n" + errors);
+    }
+    m_stats.compiled++;
+
+    Entry& entry = m_entries[identity];
+    entry.key = key;
+    entry.bytecode.swap(bytecode);
+    m_dirty = true;
+    return entry.bytecode;
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+struct ShaderDefine
+{
+    std::string name;
+    std::string value;
+};
+
+// Everything that determines a shader's bytecode.
+struct ShaderCompileRequest
+{
+    std::string sourcePath;                 // UTF-8; includes resolve relative to it.
+    std::string source;
+    std::vector<ShaderDefine> defines;
+    std::string entryPoint;
+    std::string target;
+    uint32_t flags = 0;
+};
+
+// Persistent cache of compiled shader bytecode, kept in a single file.
+//
+// Entries are indexed by shader identity (source path, entry point, target
+// and defines) and carry a 64-bit key hashing every compile input: source,
+// the contents of every file it includes, defines, entry point, target and
+// flags. A lookup whose key no longer matches the stored one means an input
+// changed, so the stale entry is dropped and the shader is compiled again.
+//
+// Compilation itself is left to the caller, so this has no D3D dependency.
+class ShaderCache
+{
+public:
+    // Returns false if path cannot be read.
+    typedef std::function<bool(const std::string& path, std::string& contents)> FileReader;
+    typedef std::function<bool(const ShaderCompileRequest& request, std::vector<uint8_t>& bytecode, std::string& errors)> Compiler;
+
+    struct Stats
+    {
+        uint32_t hits = 0;
+        uint32_t misses = 0;
+        uint32_t invalidated = 0;   // Misses caused by a changed input.
+        uint32_t compiled = 0;
+    };
+
+    // Bumped whenever the key or file layout changes, discarding old caches.
+    static const uint32_t FormatVersion = 1;
+
+    explicit ShaderCache(const std::string& path = std::string());
+
+    // Reads the cache file; a missing or damaged file leaves the cache empty.
+    bool Load();
+    // Writes the cache file if anything changed since Load.
+    bool Save();
+
+    // The key for request, reading #included files through reader.
+    static uint64_t ComputeKey(const ShaderCompileRequest& request, const FileReader& reader);
+    static std::string Identity(const ShaderCompileRequest& request);
+
+    // Bytecode cached for identity under key, or nullptr. A stored entry
+    // with a different key is evicted.
+    const std::vector<uint8_t>* Find(const std::string& identity, uint64_t key);
+    void Store(const std::string& identity, uint64_t key, const std::vector<uint8_t>& bytecode);
+
+    // Looks the shader up and compiles it on a miss. Throws std::runtime_error
+    // with the compiler's output if compilation fails.
+    const std::vector<uint8_t>& GetOrCompile(const ShaderCompileRequest& request, const FileReader& reader, const Compiler& compiler);
+
+    size_t EntryCount() const { return m_entries.size(); }
+    const Stats& GetStats() const { return m_stats; }
+
+private:
+    struct Entry
+    {
+        uint64_t key;
+        std::vector<uint8_t> bytecode;
+    };
+
+    std::string m_path;
+    std::map<std::string, Entry> m_entries;
+    bool m_dirty = false;
+    Stats m_stats;
+};
@@ -0,0 +1,25 @@
+#include "ShaderPermutation.h"
+
+namespace
+{
+    // Indexed by bit position in ShaderFeature.
+    const char* const FeatureDefines[ShaderPermutationKey::FeatureCount] =
+    {
+        "TEXTURED",
+        "METAL",
+        "SHADOWED",
+        "NORMAL_MAPPED",
+    };
+}
+
+std::vector<ShaderDefine> ShaderPermutationKey::Defines() const
+{
+    std::vector<ShaderDefine> defines;
+    defines.reserve(FeatureCount);
+    for (uint32_t bit = 0; bit < FeatureCount; bit++)
+    {
+        ShaderDefine define = { FeatureDefines[bit], (m_bits & (1u << bit)) ? "1" : "0" };
+        defines.push_back(define);
+    }
+    return defines;
+}
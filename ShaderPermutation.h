@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+#include "ShaderCache.h"
+
+// Material features a shader is specialised for. Each one becomes a
+// preprocessor define, so a variant only contains the code it needs.
+enum class ShaderFeature : uint32_t
+{
+    Textured = 1u << 0,         // TEXTURED: albedo from texture slot 0 instead of a constant.
+    Metal = 1u << 1,            // METAL: specular tinted by the albedo.
+    Shadowed = 1u << 2,         // SHADOWED: direct light attenuated by the shadow map in texture slot 2.
+    NormalMapped = 1u << 3,     // NORMAL_MAPPED: tangent-space normals from texture slot 1.
+};
+
+// Selects one precompiled shader variant. Keys are built at compile time:
+//
+//     constexpr ShaderPermutationKey key = ShaderFeature::Textured | ShaderFeature::Metal;
+//     pipelines[key.Index()] ...
+//
+// and Index() is dense, so variants can live in a plain array.
+class ShaderPermutationKey
+{
+public:
+    static const uint32_t FeatureCount = 4;
+    static const uint32_t PermutationCount = 1u << FeatureCount;
+
+    constexpr ShaderPermutationKey() : m_bits(0) {}
+    constexpr ShaderPermutationKey(ShaderFeature feature) : m_bits(static_cast<uint32_t>(feature)) {}
+
+    // Fails to compile when evaluated at compile time with unknown bits.
+    static constexpr ShaderPermutationKey FromIndex(uint32_t index)
+    {
+        return index < PermutationCount ? ShaderPermutationKey(index, 0) :
+            throw std::out_of_range("ShaderPermutationKey: index out of range");
+    }
+
+    constexpr bool Has(ShaderFeature feature) const { return (m_bits & static_cast<uint32_t>(feature)) != 0; }
+    constexpr ShaderPermutationKey With(ShaderFeature feature) const { return ShaderPermutationKey(m_bits | static_cast<uint32_t>(feature), 0); }
+    constexpr ShaderPermutationKey Without(ShaderFeature feature) const { return ShaderPermutationKey(m_bits & ~static_cast<uint32_t>(feature), 0); }
+    constexpr uint32_t Index() const { return m_bits; }
+
+    constexpr ShaderPermutationKey operator|(ShaderPermutationKey rhs) const { return ShaderPermutationKey(m_bits | rhs.m_bits, 0); }
+    constexpr bool operator==(ShaderPermutationKey rhs) const { return m_bits == rhs.m_bits; }
+    constexpr bool operator!=(ShaderPermutationKey rhs) const { return m_bits != rhs.m_bits; }
+
+    // Every feature define, set to 0 or 1, so shaders can use plain #if.
+    std::vector<ShaderDefine> Defines() const;
+
+private:
+    constexpr ShaderPermutationKey(uint32_t bits, int) : m_bits(bits) {}
+
+    uint32_t m_bits;
+};
+
+constexpr ShaderPermutationKey operator|(ShaderFeature lhs, ShaderFeature rhs)
+{
+    return ShaderPermutationKey(lhs) | ShaderPermutationKey(rhs);
+}
+
+static_assert((ShaderFeature::Textured | ShaderFeature::NormalMapped).Index() == 9, "Feature bits must match the define order");
+static_assert(ShaderPermutationKey(ShaderFeature::NormalMapped).Index() < ShaderPermutationKey::PermutationCount, "Every feature needs a bit");
@@ -1,54 +1,155 @@
-#include "stdafx.h"
-#include "ShadowMap.h"
-
-ShadowMap::ShadowMap(ID3D12Device* device, UINT width,
-	UINT height)
-{
-	md3dDevice = device;
-	mWidth = width;
-	mHeight = height;
-	mViewport = { 0.0f, 0.0f, (float)width,
-	(float)height, 0.0f, 1.0f };
-	mScissorRect = { 0, 0, (int)width, (int)height };
-	BuildResource();
-}
-void ShadowMap::BuildResource()
-{
-	D3D12_RESOURCE_DESC texDesc;
-	ZeroMemory(&texDesc, sizeof(D3D12_RESOURCE_DESC));
-	texDesc.Dimension =
-		D3D12_RESOURCE_DIMENSION_TEXTURE2D;
-	texDesc.Alignment = 0;
-	texDesc.Width = mWidth;
-	texDesc.Height = mHeight;
-	texDesc.DepthOrArraySize = 1;
-	texDesc.MipLevels = 1;
-	texDesc.Format = mFormat;
-	texDesc.SampleDesc.Count = 1;
-	texDesc.SampleDesc.Quality = 0;
-	texDesc.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN;
-	texDesc.Flags =
-		D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL;
-	D3D12_CLEAR_VALUE optClear;
-	optClear.Format = DXGI_FORMAT_D24_UNORM_S8_UINT;
-	optClear.DepthStencil.Depth = 1.0f;
-	optClear.DepthStencil.Stencil = 0;
-	ThrowIfFailed(md3dDevice->CreateCommittedResource(
-		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
-		D3D12_HEAP_FLAG_NONE,
-		&texDesc,
-		D3D12_RESOURCE_STATE_GENERIC_READ,
-		&optClear,
-		IID_PPV_ARGS(&mShadowMap)));
-}ID3D12Resource* ShadowMap::Resource()
-{
-	return mShadowMap.Get();
-}CD3DX12_GPU_DESCRIPTOR_HANDLE ShadowMap::Srv() const
-{
-	return mhGpuSrv;
-}
-
-CD3DX12_CPU_DESCRIPTOR_HANDLE ShadowMap::Dsv() const
-{
-	return mhCpuDsv;
-}
\ No newline at end of file
+#include "stdafx.h"
+#include "ShadowMap.h"
+
+ShadowMap::ShadowMap(ID3D12Device* device, UINT width,
+	UINT height, UINT cascadeCount)
+{
+	md3dDevice = device;
+	mWidth = width;
+	mHeight = height;
+	mCascadeCount = cascadeCount;
+	mViewport = { 0.0f, 0.0f, (float)width,
+	(float)height, 0.0f, 1.0f };
+	mScissorRect = { 0, 0, (int)width, (int)height };
+
+	D3D12_DESCRIPTOR_HEAP_DESC dsvHeapDesc = {};
+	dsvHeapDesc.NumDescriptors = cascadeCount;
+	dsvHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_DSV;
+	dsvHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
+	ThrowIfFailed(md3dDevice->CreateDescriptorHeap(&dsvHeapDesc, IID_PPV_ARGS(&mDsvHeap)));
+	mDsvDescriptorSize = md3dDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_DSV);
+
+	BuildResource();
+}
+
+ShadowMap::~ShadowMap()
+{
+	if (mSrvHeap && mSrvSlot != DescriptorAllocator::InvalidSlot)
+	{
+		mSrvHeap->Free(mSrvSlot);
+	}
+}
+
+void ShadowMap::BuildResource()
+{
+	D3D12_RESOURCE_DESC texDesc;
+	ZeroMemory(&texDesc, sizeof(D3D12_RESOURCE_DESC));
+	texDesc.Dimension =
+		D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+	texDesc.Alignment = 0;
+	texDesc.Width = mWidth;
+	texDesc.Height = mHeight;
+	texDesc.DepthOrArraySize = (UINT16)mCascadeCount;
+	texDesc.MipLevels = 1;
+	texDesc.Format = mFormat;
+	texDesc.SampleDesc.Count = 1;
+	texDesc.SampleDesc.Quality = 0;
+	texDesc.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN;
+	texDesc.Flags =
+		D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL;
+	D3D12_CLEAR_VALUE optClear;
+	optClear.Format = DXGI_FORMAT_D24_UNORM_S8_UINT;
+	optClear.DepthStencil.Depth = 1.0f;
+	optClear.DepthStencil.Stencil = 0;
+	ThrowIfFailed(md3dDevice->CreateCommittedResource(
+		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
+		D3D12_HEAP_FLAG_NONE,
+		&texDesc,
+		D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE,
+		&optClear,
+		IID_PPV_ARGS(&mShadowMap)));
+}
+
+void ShadowMap::BuildDescriptors(D3D12DescriptorHeap& srvHeap)
+{
+	mSrvHeap = &srvHeap;
+	BuildDescriptors();
+}
+
+void ShadowMap::BuildDescriptors()
+{
+	D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+	srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+	srvDesc.Format = DXGI_FORMAT_R24_UNORM_X8_TYPELESS;
+	srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2DARRAY;
+	srvDesc.Texture2DArray.MostDetailedMip = 0;
+	srvDesc.Texture2DArray.MipLevels = 1;
+	srvDesc.Texture2DArray.FirstArraySlice = 0;
+	srvDesc.Texture2DArray.ArraySize = mCascadeCount;
+	srvDesc.Texture2DArray.PlaneSlice = 0;
+	srvDesc.Texture2DArray.ResourceMinLODClamp = 0.0f;
+	if (mSrvSlot != DescriptorAllocator::InvalidSlot)
+	{
+		mSrvHeap->Free(mSrvSlot);
+	}
+	mSrvSlot = mSrvHeap->CreateShaderResourceView(mShadowMap.Get(), &srvDesc);
+
+	for (UINT cascade = 0; cascade < mCascadeCount; cascade++)
+	{
+		D3D12_DEPTH_STENCIL_VIEW_DESC dsvDesc = {};
+		dsvDesc.Flags = D3D12_DSV_FLAG_NONE;
+		dsvDesc.ViewDimension = D3D12_DSV_DIMENSION_TEXTURE2DARRAY;
+		dsvDesc.Format = DXGI_FORMAT_D24_UNORM_S8_UINT;
+		dsvDesc.Texture2DArray.MipSlice = 0;
+		dsvDesc.Texture2DArray.FirstArraySlice = cascade;
+		dsvDesc.Texture2DArray.ArraySize = 1;
+		md3dDevice->CreateDepthStencilView(mShadowMap.Get(), &dsvDesc, Dsv(cascade));
+	}
+}
+
+void ShadowMap::OnResize(UINT newWidth, UINT newHeight)
+{
+	if ((mWidth != newWidth) || (mHeight != newHeight))
+	{
+		mWidth = newWidth;
+		mHeight = newHeight;
+		mViewport = { 0.0f, 0.0f, (float)newWidth,
+		(float)newHeight, 0.0f, 1.0f };
+		mScissorRect = { 0, 0, (int)newWidth, (int)newHeight };
+		BuildResource();
+		if (mSrvHeap)
+		{
+			BuildDescriptors();
+		}
+	}
+}
+
+UINT ShadowMap::Width() const
+{
+	return mWidth;
+}
+
+UINT ShadowMap::Height() const
+{
+	return mHeight;
+}
+
+UINT ShadowMap::CascadeCount() const
+{
+	return mCascadeCount;
+}
+
+ID3D12Resource* ShadowMap::Resource()
+{
+	return mShadowMap.Get();
+}
+
+UINT ShadowMap::SrvSlot() const
+{
+	return mSrvSlot;
+}
+
+CD3DX12_CPU_DESCRIPTOR_HANDLE ShadowMap::Dsv(UINT cascade) const
+{
+	return CD3DX12_CPU_DESCRIPTOR_HANDLE(mDsvHeap->GetCPUDescriptorHandleForHeapStart(), cascade, mDsvDescriptorSize);
+}
+
+D3D12_VIEWPORT ShadowMap::Viewport() const
+{
+	return mViewport;
+}
+
+D3D12_RECT ShadowMap::ScissorRect() const
+{
+	return mScissorRect;
+}
@@ -1,27 +1,31 @@
 #pragma once
 #include "stdafx.h"
 #include "DXSample.h"
+#include "D3D12DescriptorHeap.h"
 #include <wtypes.h>
 
+// Depth texture array with one slice per shadow cascade. Cascades are
+// rendered through their own DSV and sampled together as a Texture2DArray
+// through the bindless heap. The map rests in PIXEL_SHADER_RESOURCE.
 class ShadowMap
 {
 public:
-	ShadowMap(ID3D12Device* device, UINT width, UINT height);
+	ShadowMap(ID3D12Device* device, UINT width, UINT height, UINT cascadeCount);
 	ShadowMap(const ShadowMap& rhs) = delete;
 	ShadowMap& operator=(const ShadowMap& rhs) = delete;
-	~ShadowMap() = default;
+	~ShadowMap();
 
 	UINT Width() const;
 	UINT Height() const;
+	UINT CascadeCount() const;
 	ID3D12Resource* Resource();
-	CD3DX12_GPU_DESCRIPTOR_HANDLE Srv() const;
-	CD3DX12_CPU_DESCRIPTOR_HANDLE Dsv() const;
+	UINT SrvSlot() const;
+	CD3DX12_CPU_DESCRIPTOR_HANDLE Dsv(UINT cascade) const;
 	D3D12_VIEWPORT Viewport() const;
 	D3D12_RECT ScissorRect() const;
-	void BuildDescriptors(
-		CD3DX12_CPU_DESCRIPTOR_HANDLE hCpuSrv,
-		CD3DX12_GPU_DESCRIPTOR_HANDLE hGpuSrv,
-		CD3DX12_CPU_DESCRIPTOR_HANDLE hCpuDsv);
+	// Creates the array SRV in srvHeap and a DSV per cascade.
+	void BuildDescriptors(D3D12DescriptorHeap& srvHeap);
+	// Recreates the map and its views; the GPU must be done with the old one.
 	void OnResize(UINT newWidth, UINT newHeight);
 private:
 	void BuildDescriptors();
@@ -32,9 +36,11 @@ private:
 	D3D12_RECT mScissorRect;
 	UINT mWidth = 0;
 	UINT mHeight = 0;
+	UINT mCascadeCount = 0;
 	DXGI_FORMAT mFormat = DXGI_FORMAT_R24G8_TYPELESS;
-	CD3DX12_CPU_DESCRIPTOR_HANDLE mhCpuSrv;
-	CD3DX12_GPU_DESCRIPTOR_HANDLE mhGpuSrv;
-	CD3DX12_CPU_DESCRIPTOR_HANDLE mhCpuDsv;
+	D3D12DescriptorHeap* mSrvHeap = nullptr;
+	UINT mSrvSlot = DescriptorAllocator::InvalidSlot;
+	Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> mDsvHeap;
+	UINT mDsvDescriptorSize = 0;
 	Microsoft::WRL::ComPtr<ID3D12Resource> mShadowMap = nullptr;
 };
@@ -0,0 +1,770 @@
+#include "StrictFloat.h"
+#include "SoftwareRasterizer.h"
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#if defined(__AVX2__)
+#define RASTER_AVX2 1
+#endif
+#if defined(_M_X64) || defined(__x86_64__) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define RASTER_SSE2 1
+#include <immintrin.h>
+#endif
+
+struct SoftwareRasterizer::ClipVertex
+{
+    float position[4];
+    float normal[3];
+    float uv[2];
+};
+
+namespace
+{
+    // Lighting constants of shaders.hlsl, and the engine's clear color.
+    const float Kd = 0.4f;
+    const float Ka = 0.1f;
+    const float LightIntensity = 1.2f;
+    const float UntexturedAlbedo = 0.8f;
+    const uint32_t ClearColor = 0xFF663300;         // (0, 0.2, 0.4, 1)
+
+    const int32_t SubpixelScale = 16;
+    const int32_t BlockSize = 8;
+    const uint32_t BlocksPerRow = SoftwareRasterizer::TileSize / BlockSize;
+    // Input triangles per setup job. Fixed, so triangles reach each tile in
+    // the same order whatever the thread count.
+    const uint32_t ChunkTriangles = 2048;
+    // Triangles are clipped to GuardBand half viewports around the center,
+    // which keeps the fixed point coordinates within 18 bits.
+    const float GuardBand = 2.0f;
+    const int ClipPlaneCount = 5;
+    const uint32_t MaxClipVertices = 3 + ClipPlaneCount;
+    // Pixel ids are a chunk and a triangle within it.
+    const uint32_t LocalIdBits = 20;
+    const uint32_t InvalidId = ~0u;
+
+    float Saturate(float value)
+    {
+        return std::min(std::max(value, 0.0f), 1.0f);
+    }
+
+    int32_t FloorDiv(int32_t value, int32_t divisor)
+    {
+        return value >= 0 ? value / divisor : -((-value + divisor - 1) / divisor);
+    }
+
+    // value + dx * plane[1] + dy * plane[2], in the order the SIMD depth test
+    // adds them, so it gets exactly the same depths.
+    float DepthAt(const float plane[3], float dx, float dy)
+    {
+        return (plane[0] + plane[1] * dx) + plane[2] * dy;
+    }
+
+    float PlaneAt(const float plane[3], float dx, float dy)
+    {
+        return plane[0] + plane[1] * dx + plane[2] * dy;
+    }
+
+    // Bilinear, wrapping, like g_sampler at the top mip.
+    void SampleAlbedo(const RasterTexture& texture, float u, float v, float rgb[3])
+    {
+        const float x = u * texture.width - 0.5f;
+        const float y = v * texture.height - 0.5f;
+        const float fx = std::floor(x);
+        const float fy = std::floor(y);
+        const float wx = x - fx;
+        const float wy = y - fy;
+
+        auto wrap = [](float coordinate, uint32_t size)
+        {
+            const float wrapped = coordinate - std::floor(coordinate / size) * size;
+            const uint32_t i = static_cast<uint32_t>(wrapped);
+            return i < size ? i : 0;
+        };
+        const uint32_t x0 = wrap(fx, texture.width);
+        const uint32_t y0 = wrap(fy, texture.height);
+        const uint32_t x1 = x0 + 1 < texture.width ? x0 + 1 : 0;
+        const uint32_t y1 = y0 + 1 < texture.height ? y0 + 1 : 0;
+
+        const uint8_t* row0 = texture.texels + static_cast<size_t>(y0) * texture.rowPitch;
+        const uint8_t* row1 = texture.texels + static_cast<size_t>(y1) * texture.rowPitch;
+        for (int c = 0; c < 3; c++)
+        {
+            const float top = row0[x0 * 4 + c] + (row0[x1 * 4 + c] - row0[x0 * 4 + c]) * wx;
+            const float bottom = row1[x0 * 4 + c] + (row1[x1 * 4 + c] - row1[x0 * 4 + c]) * wx;
+            rgb[c] = (top + (bottom - top) * wy) / 255.0f;
+        }
+    }
+
+    // Signed distance to clip plane: near (z >= 0), then the guard band.
+    float PlaneDistance(const float p[4], int plane)
+    {
+        switch (plane)
+        {
+        case 0: return p[2];
+        case 1: return GuardBand * p[3] + p[0];
+        case 2: return GuardBand * p[3] - p[0];
+        case 3: return GuardBand * p[3] + p[1];
+        default: return GuardBand * p[3] - p[1];
+        }
+    }
+}
+
+void SoftwareRasterizer::Resize(uint32_t width, uint32_t height)
+{
+    if (width == 0 || height == 0 || width > MaxSize || height > MaxSize)
+    {
+        throw std::invalid_argument("SoftwareRasterizer: unsupported size");
+    }
+    m_width = width;
+    m_height = height;
+    m_tilesX = (width + TileSize - 1) / TileSize;
+    m_tilesY = (height + TileSize - 1) / TileSize;
+    m_color.assign(static_cast<size_t>(width) * height, ClearColor);
+    m_depth.assign(static_cast<size_t>(width) * height, 1.0f);
+}
+
+void SoftwareRasterizer::Prepare(const RasterScene& scene)
+{
+    if (m_width == 0)
+    {
+        throw std::logic_error("SoftwareRasterizer: Resize before rendering");
+    }
+
+    m_drawStarts.resize(scene.drawCount);
+    m_triangleCount = 0;
+    for (uint32_t d = 0; d < scene.drawCount; d++)
+    {
+        m_drawStarts[d] = m_triangleCount;
+        m_triangleCount += scene.draws[d].vertexCount / 3;
+    }
+
+    const uint32_t chunkCount = (m_triangleCount + ChunkTriangles - 1) / ChunkTriangles;
+    if (chunkCount > (1u << (32 - LocalIdBits)) - 1)
+    {
+        throw std::invalid_argument("SoftwareRasterizer: too many triangles");
+    }
+    m_chunks.resize(chunkCount);
+    const uint32_t tileCount = m_tilesX * m_tilesY;
+    for (Chunk& chunk : m_chunks)
+    {
+        chunk.triangles.clear();
+        chunk.bins.resize(tileCount);
+        for (std::vector<uint32_t>& bin : chunk.bins)
+        {
+            bin.clear();
+        }
+        chunk.clipped = 0;
+    }
+}
+
+void SoftwareRasterizer::SetupChunk(const RasterScene& scene, uint32_t chunkIndex, bool bin)
+{
+    Chunk& chunk = m_chunks[chunkIndex];
+    const uint32_t first = chunkIndex * ChunkTriangles;
+    const uint32_t last = std::min(first + ChunkTriangles, m_triangleCount);
+    const float (&m)[4][4] = scene.viewProjection;
+
+    uint32_t draw = static_cast<uint32_t>(std::upper_bound(m_drawStarts.begin(), m_drawStarts.end(), first) - m_drawStarts.begin()) - 1;
+    for (uint32_t t = first; t < last; t++)
+    {
+        while (draw + 1 < scene.drawCount && t >= m_drawStarts[draw + 1])
+        {
+            draw++;
+        }
+        const RasterVertex* source = scene.vertices + scene.draws[draw].firstVertex + (t - m_drawStarts[draw]) * 3;
+
+        ClipVertex polygon[2][MaxClipVertices];
+        uint32_t outsideView[6] = {};
+        bool needsClipping = false;
+        for (int i = 0; i < 3; i++)
+        {
+            ClipVertex& v = polygon[0][i];
+            const float* p = source[i].position;
+            for (int j = 0; j < 4; j++)
+            {
+                v.position[j] = p[0] * m[0][j] + p[1] * m[1][j] + p[2] * m[2][j] + m[3][j];
+            }
+            memcpy(v.normal, source[i].normal, sizeof(v.normal));
+            memcpy(v.uv, source[i].uv, sizeof(v.uv));
+
+            const float* c = v.position;
+            outsideView[0] += c[0] < -c[3];
+            outsideView[1] += c[0] > c[3];
+            outsideView[2] += c[1] < -c[3];
+            outsideView[3] += c[1] > c[3];
+            outsideView[4] += c[2] < 0.0f;
+            outsideView[5] += c[2] > c[3];
+            for (int plane = 0; plane < ClipPlaneCount; plane++)
+            {
+                needsClipping |= PlaneDistance(c, plane) < 0.0f;
+            }
+        }
+        if (std::find(outsideView, outsideView + 6, 3u) != outsideView + 6)
+        {
+            continue;
+        }
+
+        uint32_t count = 3;
+        int current = 0;
+        if (needsClipping)
+        {
+            chunk.clipped++;
+            for (int plane = 0; plane < ClipPlaneCount && count >= 3; plane++)
+            {
+                const ClipVertex* in = polygon[current];
+                ClipVertex* out = polygon[1 - current];
+                uint32_t outCount = 0;
+                for (uint32_t i = 0; i < count; i++)
+                {
+                    const ClipVertex& a = in[i];
+                    const ClipVertex& b = in[(i + 1) % count];
+                    const float da = PlaneDistance(a.position, plane);
+                    const float db = PlaneDistance(b.position, plane);
+                    if (da >= 0.0f)
+                    {
+                        out[outCount++] = a;
+                    }
+                    if ((da >= 0.0f) != (db >= 0.0f))
+                    {
+                        const float s = da / (da - db);
+                        ClipVertex& v = out[outCount++];
+                        for (int j = 0; j < 4; j++)
+                            v.position[j] = a.position[j] + (b.position[j] - a.position[j]) * s;
+                        for (int j = 0; j < 3; j++)
+                            v.normal[j] = a.normal[j] + (b.normal[j] - a.normal[j]) * s;
+                        for (int j = 0; j < 2; j++)
+                            v.uv[j] = a.uv[j] + (b.uv[j] - a.uv[j]) * s;
+                    }
+                }
+                count = outCount;
+                current = 1 - current;
+            }
+        }
+
+        const size_t before = chunk.triangles.size();
+        for (uint32_t i = 1; i + 1 < count; i++)
+        {
+            const ClipVertex fan[3] = { polygon[current][0], polygon[current][i], polygon[current][i + 1] };
+            SetupTriangle(fan, draw, chunk);
+        }
+
+        if (!bin)
+        {
+            continue;
+        }
+        for (size_t i = before; i < chunk.triangles.size(); i++)
+        {
+            const Triangle& triangle = chunk.triangles[i];
+            const uint32_t id = static_cast<uint32_t>(i);
+            for (int32_t ty = triangle.minY / static_cast<int32_t>(TileSize); ty <= triangle.maxY / static_cast<int32_t>(TileSize); ty++)
+            {
+                for (int32_t tx = triangle.minX / static_cast<int32_t>(TileSize); tx <= triangle.maxX / static_cast<int32_t>(TileSize); tx++)
+                {
+                    // Tiles in the bounds that an edge misses entirely are
+                    // never binned.
+                    const int32_t x0 = std::max(triangle.minX, tx * static_cast<int32_t>(TileSize));
+                    const int32_t y0 = std::max(triangle.minY, ty * static_cast<int32_t>(TileSize));
+                    const int32_t x1 = std::min(triangle.maxX, (tx + 1) * static_cast<int32_t>(TileSize) - 1);
+                    const int32_t y1 = std::min(triangle.maxY, (ty + 1) * static_cast<int32_t>(TileSize) - 1);
+                    bool missed = false;
+                    for (int e = 0; e < 3 && !missed; e++)
+                    {
+                        int64_t low, high;
+                        EdgeRange(triangle, e, x0, y0, x1, y1, low, high);
+                        missed = high < 0;
+                    }
+                    if (!missed)
+                    {
+                        chunk.bins[ty * m_tilesX + tx].push_back(id);
+                    }
+                }
+            }
+        }
+    }
+}
+
+void SoftwareRasterizer::SetupTriangle(const ClipVertex* v, uint32_t draw, Chunk& chunk)
+{
+    // To pixels, y down, snapped to 1/16 pixel.
+    int32_t x[3], y[3];
+    float invW[3];
+    for (int i = 0; i < 3; i++)
+    {
+        invW[i] = 1.0f / v[i].position[3];
+        const float sx = (v[i].position[0] * invW[i] * 0.5f + 0.5f) * m_width;
+        const float sy = (0.5f - v[i].position[1] * invW[i] * 0.5f) * m_height;
+        x[i] = static_cast<int32_t>(std::floor(sx * SubpixelScale + 0.5f));
+        y[i] = static_cast<int32_t>(std::floor(sy * SubpixelScale + 0.5f));
+    }
+
+    // Counterclockwise on screen, so every edge function is positive inside.
+    int64_t area = static_cast<int64_t>(x[1] - x[0]) * (y[2] - y[0]) - static_cast<int64_t>(y[1] - y[0]) * (x[2] - x[0]);
+    if (area == 0)
+    {
+        return;
+    }
+    int order[3] = { 0, 1, 2 };
+    if (area < 0)
+    {
+        std::swap(order[1], order[2]);
+    }
+
+    Triangle t;
+    const int32_t minX = std::min(x[0], std::min(x[1], x[2]));
+    const int32_t maxX = std::max(x[0], std::max(x[1], x[2]));
+    const int32_t minY = std::min(y[0], std::min(y[1], y[2]));
+    const int32_t maxY = std::max(y[0], std::max(y[1], y[2]));
+    t.minX = std::max(-FloorDiv(-(minX - SubpixelScale / 2), SubpixelScale), 0);
+    t.minY = std::max(-FloorDiv(-(minY - SubpixelScale / 2), SubpixelScale), 0);
+    t.maxX = std::min(FloorDiv(maxX - SubpixelScale / 2, SubpixelScale), static_cast<int32_t>(m_width) - 1);
+    t.maxY = std::min(FloorDiv(maxY - SubpixelScale / 2, SubpixelScale), static_cast<int32_t>(m_height) - 1);
+    if (t.minX > t.maxX || t.minY > t.maxY)
+    {
+        return;
+    }
+
+    for (int e = 0; e < 3; e++)
+    {
+        const int i = order[e];
+        const int j = order[(e + 1) % 3];
+        const int32_t dx = x[j] - x[i];
+        const int32_t dy = y[j] - y[i];
+        t.a[e] = -dy;
+        t.b[e] = dx;
+        t.c[e] = static_cast<int64_t>(dy) * x[i] - static_cast<int64_t>(dx) * y[i];
+        // Top-left rule: pixels exactly on an edge only belong to the
+        // triangle if it is a top or a left edge.
+        const bool topLeft = dy < 0 || (dy == 0 && dx > 0);
+        if (!topLeft)
+        {
+            t.c[e] -= 1;
+        }
+    }
+
+    // Attribute planes through the snapped vertices.
+    t.x0 = static_cast<float>(x[0]) / SubpixelScale;
+    t.y0 = static_cast<float>(y[0]) / SubpixelScale;
+    const double d1x = static_cast<double>(x[1] - x[0]) / SubpixelScale;
+    const double d1y = static_cast<double>(y[1] - y[0]) / SubpixelScale;
+    const double d2x = static_cast<double>(x[2] - x[0]) / SubpixelScale;
+    const double d2y = static_cast<double>(y[2] - y[0]) / SubpixelScale;
+    const double determinant = d1x * d2y - d2x * d1y;
+    for (int p = 0; p < 7; p++)
+    {
+        double f[3];
+        for (int i = 0; i < 3; i++)
+        {
+            switch (p)
+            {
+            case 0: f[i] = v[i].position[2] * invW[i]; break;
+            case 1: f[i] = invW[i]; break;
+            case 2: f[i] = v[i].uv[0] * invW[i]; break;
+            case 3: f[i] = v[i].uv[1] * invW[i]; break;
+            default: f[i] = v[i].normal[p - 4] * invW[i]; break;
+            }
+        }
+        t.planes[p][0] = static_cast<float>(f[0]);
+        t.planes[p][1] = static_cast<float>(((f[1] - f[0]) * d2y - (f[2] - f[0]) * d1y) / determinant);
+        t.planes[p][2] = static_cast<float>(((f[2] - f[0]) * d1x - (f[1] - f[0]) * d2x) / determinant);
+    }
+    t.draw = draw;
+    chunk.triangles.push_back(t);
+}
+
+void SoftwareRasterizer::EdgeRange(const Triangle& t, int e, int32_t x0, int32_t y0, int32_t x1, int32_t y1, int64_t& low, int64_t& high)
+{
+    const int64_t corner = static_cast<int64_t>(t.a[e]) * (x0 * SubpixelScale + SubpixelScale / 2) +
+        static_cast<int64_t>(t.b[e]) * (y0 * SubpixelScale + SubpixelScale / 2) + t.c[e];
+    const int64_t spanX = static_cast<int64_t>(t.a[e]) * SubpixelScale * (x1 - x0);
+    const int64_t spanY = static_cast<int64_t>(t.b[e]) * SubpixelScale * (y1 - y0);
+    low = corner + std::min<int64_t>(spanX, 0) + std::min<int64_t>(spanY, 0);
+    high = corner + std::max<int64_t>(spanX, 0) + std::max<int64_t>(spanY, 0);
+}
+
+const SoftwareRasterizer::Triangle& SoftwareRasterizer::Lookup(uint32_t id) const
+{
+    return m_chunks[id >> LocalIdBits].triangles[id & ((1u << LocalIdBits) - 1)];
+}
+
+void SoftwareRasterizer::RasterTriangle(const Triangle& t, uint32_t id, int32_t tileX, int32_t tileY, float* depth, uint32_t* ids, float* blockDepth) const
+{
+    const int32_t rx0 = std::max(t.minX, tileX);
+    const int32_t ry0 = std::max(t.minY, tileY);
+    const int32_t rx1 = std::min(t.maxX, tileX + static_cast<int32_t>(TileSize) - 1);
+    const int32_t ry1 = std::min(t.maxY, tileY + static_cast<int32_t>(TileSize) - 1);
+    if (rx0 > rx1 || ry0 > ry1)
+    {
+        return;
+    }
+
+    // Edges that are positive over the whole of the triangle's part of the
+    // tile need no further tests.
+    bool tileEdges[3];
+    for (int e = 0; e < 3; e++)
+    {
+        int64_t low, high;
+        EdgeRange(t, e, rx0, ry0, rx1, ry1, low, high);
+        if (high < 0)
+        {
+            return;
+        }
+        tileEdges[e] = low < 0;
+    }
+
+    for (int32_t by = tileY + (ry0 - tileY) / BlockSize * BlockSize; by <= ry1; by += BlockSize)
+    {
+        const int32_t y0 = std::max(by, ry0);
+        const int32_t y1 = std::min(by + BlockSize - 1, ry1);
+        for (int32_t bx = tileX + (rx0 - tileX) / BlockSize * BlockSize; bx <= rx1; bx += BlockSize)
+        {
+            const int32_t x0 = std::max(bx, rx0);
+            const int32_t x1 = std::min(bx + BlockSize - 1, rx1);
+
+            // Hidden if the triangle's nearest depth in the block is behind
+            // everything there. The margin covers rounding in the per pixel
+            // depths, so no pixel that would pass the depth test is skipped.
+            float& farthest = blockDepth[((by - tileY) / BlockSize) * BlocksPerRow + (bx - tileX) / BlockSize];
+            {
+                const float* plane = t.planes[0];
+                const float dx0 = plane[1] * ((static_cast<float>(x0) + 0.5f) - t.x0);
+                const float dx1 = plane[1] * ((static_cast<float>(x1) + 0.5f) - t.x0);
+                const float dy0 = plane[2] * ((static_cast<float>(y0) + 0.5f) - t.y0);
+                const float dy1 = plane[2] * ((static_cast<float>(y1) + 0.5f) - t.y0);
+                const float nearest = plane[0] + std::min(dx0, dx1) + std::min(dy0, dy1);
+                const float margin = 1e-6f * (std::fabs(plane[0]) + std::max(std::fabs(dx0), std::fabs(dx1)) + std::max(std::fabs(dy0), std::fabs(dy1)));
+                if (nearest - margin >= farthest)
+                {
+                    continue;
+                }
+            }
+
+            // Same again for the block; inside it every edge value fits in
+            // 32 bits.
+            bool blockEdges[3] = {};
+            bool missed = false;
+            for (int e = 0; e < 3 && !missed; e++)
+            {
+                if (tileEdges[e])
+                {
+                    int64_t low, high;
+                    EdgeRange(t, e, x0, y0, x1, y1, low, high);
+                    missed = high < 0;
+                    blockEdges[e] = low < 0;
+                }
+            }
+            if (missed)
+            {
+                continue;
+            }
+
+            int32_t step[3] = {};
+            for (int e = 0; e < 3; e++)
+            {
+                step[e] = blockEdges[e] ? t.a[e] * SubpixelScale : 0;
+            }
+
+            int written = 0;
+            for (int32_t y = y0; y <= y1; y++)
+            {
+                // Edge values at the block's first pixel of the row; zero for
+                // edges that need no test.
+                int32_t rowEdge[3] = {};
+                for (int e = 0; e < 3; e++)
+                {
+                    if (blockEdges[e])
+                    {
+                        rowEdge[e] = static_cast<int32_t>(static_cast<int64_t>(t.a[e]) * (bx * SubpixelScale + SubpixelScale / 2) +
+                            static_cast<int64_t>(t.b[e]) * (y * SubpixelScale + SubpixelScale / 2) + t.c[e]);
+                    }
+                }
+                const float dy = (static_cast<float>(y) + 0.5f) - t.y0;
+                float* depthRow = depth + (y - tileY) * TileSize + (bx - tileX);
+                uint32_t* idRow = ids + (y - tileY) * TileSize + (bx - tileX);
+
+#if defined(RASTER_AVX2)
+                const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+                const __m256i column = _mm256_add_epi32(_mm256_set1_epi32(bx), lanes);
+                // Negative outside: columns beyond the rectangle, then each edge.
+                __m256i outside = _mm256_or_si256(_mm256_cmpgt_epi32(_mm256_set1_epi32(x0), column),
+                    _mm256_cmpgt_epi32(column, _mm256_set1_epi32(x1)));
+                for (int e = 0; e < 3; e++)
+                {
+                    outside = _mm256_or_si256(outside, _mm256_add_epi32(_mm256_set1_epi32(rowEdge[e]), _mm256_mullo_epi32(_mm256_set1_epi32(step[e]), lanes)));
+                }
+                const __m256 inside = _mm256_castsi256_ps(_mm256_cmpgt_epi32(outside, _mm256_set1_epi32(-1)));
+                if (_mm256_movemask_ps(inside) == 0)
+                {
+                    continue;
+                }
+                const __m256 px = _mm256_add_ps(_mm256_set1_ps(static_cast<float>(bx)), _mm256_setr_ps(0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f));
+                const __m256 dx = _mm256_sub_ps(px, _mm256_set1_ps(t.x0));
+                const __m256 z = _mm256_add_ps(_mm256_add_ps(_mm256_set1_ps(t.planes[0][0]), _mm256_mul_ps(_mm256_set1_ps(t.planes[0][1]), dx)),
+                    _mm256_mul_ps(_mm256_set1_ps(t.planes[0][2]), _mm256_set1_ps(dy)));
+                const __m256 oldDepth = _mm256_loadu_ps(depthRow);
+                const __m256 pass = _mm256_and_ps(_mm256_cmp_ps(z, oldDepth, _CMP_LT_OQ), inside);
+                written |= _mm256_movemask_ps(pass);
+                _mm256_storeu_ps(depthRow, _mm256_blendv_ps(oldDepth, z, pass));
+                const __m256i oldIds = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(idRow));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(idRow),
+                    _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(oldIds), _mm256_castsi256_ps(_mm256_set1_epi32(static_cast<int>(id))), pass)));
+#elif defined(RASTER_SSE2)
+                // Eight pixels as two halves of four.
+                for (int32_t half = 0; half < BlockSize; half += 4)
+                {
+                    const int32_t hx = bx + half;
+                    const __m128i column = _mm_add_epi32(_mm_set1_epi32(hx), _mm_setr_epi32(0, 1, 2, 3));
+                    __m128i outside = _mm_or_si128(_mm_cmplt_epi32(column, _mm_set1_epi32(x0)), _mm_cmpgt_epi32(column, _mm_set1_epi32(x1)));
+                    for (int e = 0; e < 3; e++)
+                    {
+                        const int32_t start = rowEdge[e] + step[e] * half;
+                        outside = _mm_or_si128(outside, _mm_setr_epi32(start, start + step[e], start + 2 * step[e], start + 3 * step[e]));
+                    }
+                    const __m128 inside = _mm_castsi128_ps(_mm_cmpgt_epi32(outside, _mm_set1_epi32(-1)));
+                    if (_mm_movemask_ps(inside) == 0)
+                    {
+                        continue;
+                    }
+                    const __m128 px = _mm_add_ps(_mm_set1_ps(static_cast<float>(hx)), _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f));
+                    const __m128 dx = _mm_sub_ps(px, _mm_set1_ps(t.x0));
+                    const __m128 z = _mm_add_ps(_mm_add_ps(_mm_set1_ps(t.planes[0][0]), _mm_mul_ps(_mm_set1_ps(t.planes[0][1]), dx)),
+                        _mm_mul_ps(_mm_set1_ps(t.planes[0][2]), _mm_set1_ps(dy)));
+                    const __m128 oldDepth = _mm_loadu_ps(depthRow + half);
+                    const __m128 pass = _mm_and_ps(_mm_cmplt_ps(z, oldDepth), inside);
+                    written |= _mm_movemask_ps(pass);
+                    _mm_storeu_ps(depthRow + half, _mm_or_ps(_mm_and_ps(pass, z), _mm_andnot_ps(pass, oldDepth)));
+                    const __m128 oldIds = _mm_loadu_ps(reinterpret_cast<const float*>(idRow + half));
+                    const __m128 newIds = _mm_castsi128_ps(_mm_set1_epi32(static_cast<int>(id)));
+                    _mm_storeu_ps(reinterpret_cast<float*>(idRow + half), _mm_or_ps(_mm_and_ps(pass, newIds), _mm_andnot_ps(pass, oldIds)));
+                }
+#else
+                for (int32_t lane = 0; lane < BlockSize; lane++)
+                {
+                    const int32_t px = bx + lane;
+                    int32_t outside = (px < x0 || px > x1) ? -1 : 0;
+                    for (int e = 0; e < 3; e++)
+                    {
+                        outside |= rowEdge[e] + step[e] * lane;
+                    }
+                    if (outside < 0)
+                    {
+                        continue;
+                    }
+                    const float z = DepthAt(t.planes[0], (static_cast<float>(px) + 0.5f) - t.x0, dy);
+                    if (z < depthRow[lane])
+                    {
+                        depthRow[lane] = z;
+                        idRow[lane] = id;
+                        written = 1;
+                    }
+                }
+#endif
+            }
+
+            if (written)
+            {
+                const float* block = depth + (by - tileY) * TileSize + (bx - tileX);
+                float blockFarthest = 0.0f;
+                for (int32_t y = 0; y < BlockSize; y++)
+                {
+                    for (int32_t x = 0; x < BlockSize; x++)
+                    {
+                        blockFarthest = std::max(blockFarthest, block[y * TileSize + x]);
+                    }
+                }
+                farthest = blockFarthest;
+            }
+        }
+    }
+}
+
+uint32_t SoftwareRasterizer::ShadePixel(const RasterScene& scene, const Triangle& t, int32_t x, int32_t y)
+{
+    const float dx = (static_cast<float>(x) + 0.5f) - t.x0;
+    const float dy = (static_cast<float>(y) + 0.5f) - t.y0;
+    const float w = 1.0f / PlaneAt(t.planes[1], dx, dy);
+    const float u = PlaneAt(t.planes[2], dx, dy) * w;
+    const float v = PlaneAt(t.planes[3], dx, dy) * w;
+    float n[3];
+    for (int i = 0; i < 3; i++)
+    {
+        n[i] = PlaneAt(t.planes[4 + i], dx, dy) * w;
+    }
+    const float length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+    const float nDotL = length > 0.0f ? (n[0] * scene.toLight[0] + n[1] * scene.toLight[1] + n[2] * scene.toLight[2]) / length : 0.0f;
+    const float lighting = (Kd * Saturate(nDotL) + Ka) * LightIntensity;
+
+    float albedo[3] = { UntexturedAlbedo, UntexturedAlbedo, UntexturedAlbedo };
+    const RasterTexture* texture = scene.draws[t.draw].albedo;
+    if (texture && texture->texels)
+    {
+        // Texture rows run the other way from the model's v.
+        SampleAlbedo(*texture, u, 1.0f - v, albedo);
+    }
+
+    uint32_t color = 0xFF000000;
+    for (int c = 0; c < 3; c++)
+    {
+        color |= static_cast<uint32_t>(Saturate(albedo[c] * lighting) * 255.0f + 0.5f) << (8 * c);
+    }
+    return color;
+}
+
+void SoftwareRasterizer::RasterTile(const RasterScene& scene, uint32_t tile)
+{
+    const int32_t tileX = static_cast<int32_t>((tile % m_tilesX) * TileSize);
+    const int32_t tileY = static_cast<int32_t>((tile / m_tilesX) * TileSize);
+    const int32_t width = std::min(static_cast<int32_t>(TileSize), static_cast<int32_t>(m_width) - tileX);
+    const int32_t height = std::min(static_cast<int32_t>(TileSize), static_cast<int32_t>(m_height) - tileY);
+
+    float depth[TileSize * TileSize];
+    uint32_t ids[TileSize * TileSize];
+    std::fill(depth, depth + TileSize * TileSize, 1.0f);
+    std::fill(ids, ids + TileSize * TileSize, InvalidId);
+    float blockDepth[BlocksPerRow * BlocksPerRow];
+    std::fill(blockDepth, blockDepth + BlocksPerRow * BlocksPerRow, 1.0f);
+
+    for (uint32_t c = 0; c < m_chunks.size(); c++)
+    {
+        const Chunk& chunk = m_chunks[c];
+        for (uint32_t local : chunk.bins[tile])
+        {
+            RasterTriangle(chunk.triangles[local], (c << LocalIdBits) | local, tileX, tileY, depth, ids, blockDepth);
+        }
+    }
+
+    // Each covered pixel is shaded once, by its nearest triangle.
+    for (int32_t y = 0; y < height; y++)
+    {
+        const size_t row = static_cast<size_t>(tileY + y) * m_width + tileX;
+        for (int32_t x = 0; x < width; x++)
+        {
+            const uint32_t id = ids[y * TileSize + x];
+            m_color[row + x] = id == InvalidId ? ClearColor : ShadePixel(scene, Lookup(id), tileX + x, tileY + y);
+            m_depth[row + x] = depth[y * TileSize + x];
+        }
+    }
+}
+
+void SoftwareRasterizer::Render(const RasterScene& scene, JobSystem* jobs)
+{
+    Prepare(scene);
+    const uint32_t chunkCount = static_cast<uint32_t>(m_chunks.size());
+    const uint32_t tileCount = m_tilesX * m_tilesY;
+    auto setup = [&](size_t begin, size_t end)
+    {
+        for (size_t c = begin; c < end; c++)
+        {
+            SetupChunk(scene, static_cast<uint32_t>(c), true);
+        }
+    };
+    auto raster = [&](size_t begin, size_t end)
+    {
+        for (size_t tile = begin; tile < end; tile++)
+        {
+            RasterTile(scene, static_cast<uint32_t>(tile));
+        }
+    };
+    if (jobs)
+    {
+        jobs->ParallelFor(chunkCount, 1, setup);
+        jobs->ParallelFor(tileCount, 1, raster);
+    }
+    else
+    {
+        setup(0, chunkCount);
+        raster(0, tileCount);
+    }
+
+    m_stats = Stats();
+    m_stats.triangles = m_triangleCount;
+    for (const Chunk& chunk : m_chunks)
+    {
+        m_stats.clippedTriangles += chunk.clipped;
+        m_stats.setupTriangles += static_cast<uint32_t>(chunk.triangles.size());
+        for (const std::vector<uint32_t>& bin : chunk.bins)
+        {
+            m_stats.binnedTriangles += bin.size();
+        }
+    }
+}
+
+void SoftwareRasterizer::RenderReference(const RasterScene& scene)
+{
+    Prepare(scene);
+    std::fill(m_depth.begin(), m_depth.end(), 1.0f);
+    std::vector<uint32_t> ids(m_color.size(), InvalidId);
+
+    m_stats = Stats();
+    m_stats.triangles = m_triangleCount;
+    for (uint32_t c = 0; c < m_chunks.size(); c++)
+    {
+        SetupChunk(scene, c, false);
+        const Chunk& chunk = m_chunks[c];
+        m_stats.clippedTriangles += chunk.clipped;
+        m_stats.setupTriangles += static_cast<uint32_t>(chunk.triangles.size());
+        for (uint32_t local = 0; local < chunk.triangles.size(); local++)
+        {
+            const Triangle& t = chunk.triangles[local];
+            for (int32_t y = t.minY; y <= t.maxY; y++)
+            {
+                for (int32_t x = t.minX; x <= t.maxX; x++)
+                {
+                    bool inside = true;
+                    for (int e = 0; e < 3; e++)
+                    {
+                        inside &= static_cast<int64_t>(t.a[e]) * (x * SubpixelScale + SubpixelScale / 2) +
+                            static_cast<int64_t>(t.b[e]) * (y * SubpixelScale + SubpixelScale / 2) + t.c[e] >= 0;
+                    }
+                    const size_t pixel = static_cast<size_t>(y) * m_width + x;
+                    if (!inside)
+                    {
+                        continue;
+                    }
+                    const float z = DepthAt(t.planes[0], (static_cast<float>(x) + 0.5f) - t.x0, (static_cast<float>(y) + 0.5f) - t.y0);
+                    if (z < m_depth[pixel])
+                    {
+                        m_depth[pixel] = z;
+                        ids[pixel] = (c << LocalIdBits) | local;
+                    }
+                }
+            }
+        }
+    }
+
+    for (uint32_t y = 0; y < m_height; y++)
+    {
+        for (uint32_t x = 0; x < m_width; x++)
+        {
+            const size_t pixel = static_cast<size_t>(y) * m_width + x;
+            m_color[pixel] = ids[pixel] == InvalidId ? ClearColor : ShadePixel(scene, Lookup(ids[pixel]), x, y);
+        }
+    }
+}
+
+bool SoftwareRasterizer::SavePpm(const std::string& path) const
+{
+    std::ofstream file(path, std::ios::binary);
+    if (!file)
+    {
+        return false;
+    }
+    file << "P6\n" << m_width << " " << m_height << "\n255\n";
+    std::vector<uint8_t> row(static_cast<size_t>(m_width) * 3);
+    for (uint32_t y = 0; y < m_height; y++)
+    {
+        for (uint32_t x = 0; x < m_width; x++)
+        {
+            const uint32_t color = m_color[static_cast<size_t>(y) * m_width + x];
+            row[x * 3 + 0] = static_cast<uint8_t>(color);
+            row[x * 3 + 1] = static_cast<uint8_t>(color >> 8);
+            row[x * 3 + 2] = static_cast<uint8_t>(color >> 16);
+        }
+        file.write(reinterpret_cast<const char*>(row.data()), row.size());
+    }
+    return static_cast<bool>(file);
+}
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class JobSystem;
+
+// CPU rendering of the scene, for machines without a GPU: headless golden
+// image tests and thumbnails. It draws what shaders.hlsl's TEXTURED
+// permutation draws under the directional light alone (no shadows or
+// clustered lights): albedo * (kd * N.L + ka) * lightIntensity, over the
+// engine's clear color.
+
+// The engine's Vertex.
+struct RasterVertex
+{
+    float position[3];
+    float normal[3];
+    float uv[2];
+};
+static_assert(sizeof(RasterVertex) == 32, "RasterVertex must match Vertex");
+
+// RGBA8 texels, sampled bilinearly with wrapping at the top mip, like the
+// scene's sampler.
+struct RasterTexture
+{
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t rowPitch = 0;      // Bytes.
+    const uint8_t* texels = nullptr;
+};
+
+// A range of the triangle list with one albedo texture; untextured without.
+struct RasterDraw
+{
+    uint32_t firstVertex = 0;
+    uint32_t vertexCount = 0;
+    const RasterTexture* albedo = nullptr;
+};
+
+struct RasterScene
+{
+    const RasterVertex* vertices = nullptr;
+    const RasterDraw* draws = nullptr;          // In drawing order.
+    uint32_t drawCount = 0;
+    float viewProjection[4][4];                 // World to clip space for row vectors, as PV.
+    float toLight[3];                           // Unit vector towards the directional light.
+};
+
+// Renders in two parallel stages. Setup transforms, clips and sets up fixed
+// size chunks of triangles and bins each into the screen tiles it touches,
+// after rejecting the tiles its edges miss. Raster then takes a tile at a
+// time: it walks the tile's bins in triangle order, skips the 8x8 blocks a
+// triangle misses or is behind everything in (by each block's farthest
+// depth), tests edges and depth 8 pixels at a time with SIMD and
+// keeps the nearest triangle of each pixel; then it shades each covered
+// pixel once. Coverage uses fixed point edge functions with the top-left
+// fill rule, so adjacent triangles never share or miss a pixel.
+//
+// The chunks are the same whatever the thread count, so the image is too.
+// RenderReference sets up the same triangles but tests every pixel of each
+// one's bounds on its own, and gives the same image and depth, bit for bit;
+// both are built without fused multiply-adds (StrictFloat.h), so that holds
+// for every compiler and instruction set.
+class SoftwareRasterizer
+{
+public:
+    static const uint32_t TileSize = 64;
+    static const uint32_t MaxSize = 4096;
+
+    struct Stats
+    {
+        uint32_t triangles = 0;                 // In the draws.
+        uint32_t clippedTriangles = 0;          // That crossed the near plane or the guard band.
+        uint32_t setupTriangles = 0;            // Left to rasterize after clipping and culling.
+        uint64_t binnedTriangles = 0;           // Summed over tiles.
+    };
+
+    // Throws std::invalid_argument for sizes of 0 or beyond MaxSize.
+    void Resize(uint32_t width, uint32_t height);
+    uint32_t Width() const { return m_width; }
+    uint32_t Height() const { return m_height; }
+
+    // Without jobs, Render runs on the calling thread.
+    void Render(const RasterScene& scene, JobSystem* jobs);
+    void RenderReference(const RasterScene& scene);
+
+    // RGBA8 pixels (red in the low byte) and depth, top row first.
+    const std::vector<uint32_t>& Color() const { return m_color; }
+    const std::vector<float>& Depth() const { return m_depth; }
+    const Stats& GetStats() const { return m_stats; }
+
+    // Writes the image as a binary PPM.
+    bool SavePpm(const std::string& path) const;
+
+private:
+    struct ClipVertex;
+
+    // A triangle ready to rasterize. Edge functions take pixel coordinates
+    // in 1/16 pixels and are non-negative inside; the fill rule is folded
+    // into c. Attributes are planes over pixel coordinates relative to
+    // (x0, y0): value, change per pixel in x and in y.
+    struct Triangle
+    {
+        int32_t a[3];
+        int32_t b[3];
+        int64_t c[3];
+        int32_t minX, minY, maxX, maxY;         // Pixels whose centers it may cover.
+        float x0, y0;
+        float planes[7][3];                     // Depth, 1/w, then u, v and the normal over w.
+        uint32_t draw;
+    };
+
+    struct Chunk
+    {
+        std::vector<Triangle> triangles;
+        std::vector<std::vector<uint32_t>> bins;    // Triangles per tile, in order.
+        uint32_t clipped = 0;
+    };
+
+    void Prepare(const RasterScene& scene);
+    void SetupChunk(const RasterScene& scene, uint32_t chunk, bool bin);
+    void SetupTriangle(const ClipVertex* vertices, uint32_t draw, Chunk& chunk);
+    void RasterTile(const RasterScene& scene, uint32_t tile);
+    void RasterTriangle(const Triangle& triangle, uint32_t id, int32_t tileX, int32_t tileY, float* depth, uint32_t* ids, float* blockDepth) const;
+    const Triangle& Lookup(uint32_t id) const;
+    static void EdgeRange(const Triangle& triangle, int edge, int32_t x0, int32_t y0, int32_t x1, int32_t y1, int64_t& low, int64_t& high);
+    static uint32_t ShadePixel(const RasterScene& scene, const Triangle& triangle, int32_t x, int32_t y);
+
+    uint32_t m_width = 0;
+    uint32_t m_height = 0;
+    uint32_t m_tilesX = 0;
+    uint32_t m_tilesY = 0;
+    std::vector<uint32_t> m_drawStarts;         // First triangle of each draw.
+    uint32_t m_triangleCount = 0;
+    std::vector<Chunk> m_chunks;
+    std::vector<uint32_t> m_color;
+    std::vector<float> m_depth;
+    Stats m_stats;
+};
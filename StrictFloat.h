@@ -0,0 +1,17 @@
+#pragma once
+
+// Stops the compiler from contracting a * b + c into a fused multiply-add,
+// which rounds once instead of twice, for the rest of the source file. GCC
+// contracts by default whenever FMA is available, and MSVC may with
+// /arch:AVX2, so without this a SIMD path and its scalar reference, or a CPU
+// reference and HLSL marked precise, stop agreeing bit for bit.
+//
+// Include it before anything else, so that GCC compiles the inline functions
+// of other headers the same way and can still inline them.
+#if defined(_MSC_VER) && !defined(__clang__)
+#pragma fp_contract(off)
+#elif defined(__clang__)
+#pragma STDC FP_CONTRACT OFF
+#elif defined(__GNUC__)
+#pragma GCC optimize("fp-contract=off")
+#endif
@@ -0,0 +1,671 @@
+#include "SupercompressedTexture.h"
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(_M_X64) || defined(__x86_64__) || defined(__SSE2__)
+#define STC_SSE2 1
+#include <emmintrin.h>
+#endif
+
+using namespace SupercompressedTexture;
+
+namespace
+{
+    const char kMagic[4] = { 'S', 'T', 'C', '1' };
+    const size_t kHeaderSize = 24;
+
+    enum PlaneCoding : uint8_t
+    {
+        PLANE_STORED = 0,
+        PLANE_RANS = 1,
+    };
+
+    //-------------------------------------------------------------------------------------
+    // Little endian helpers
+    //-------------------------------------------------------------------------------------
+    void Put32(std::vector<uint8_t>& out, uint32_t v)
+    {
+        for (int i = 0; i < 4; i++)
+            out.push_back(static_cast<uint8_t>(v >> (i * 8)));
+    }
+
+    void Put16(std::vector<uint8_t>& out, uint32_t v)
+    {
+        out.push_back(static_cast<uint8_t>(v));
+        out.push_back(static_cast<uint8_t>(v >> 8));
+    }
+
+    uint32_t Get32(const uint8_t* p)
+    {
+        return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24);
+    }
+
+    uint32_t Get16(const uint8_t* p)
+    {
+        return uint32_t(p[0]) | (uint32_t(p[1]) << 8);
+    }
+
+    //-------------------------------------------------------------------------------------
+    // Interleaved order-0 rANS over bytes (two states for instruction level parallelism)
+    //-------------------------------------------------------------------------------------
+    const uint32_t kProbBits = 12;
+    const uint32_t kProbScale = 1u << kProbBits;
+    const uint32_t kRansL = 1u << 23;
+
+    struct SymbolTable
+    {
+        uint32_t freq[256];
+        uint32_t cum[257];
+    };
+
+    void NormalizeFrequencies(const uint8_t* data, size_t count, SymbolTable& table)
+    {
+        uint64_t counts[256] = {};
+        for (size_t i = 0; i < count; i++)
+            counts[data[i]]++;
+
+        uint32_t sum = 0;
+        int largest = 0;
+        for (int s = 0; s < 256; s++)
+        {
+            table.freq[s] = counts[s] ? std::max<uint32_t>(1, static_cast<uint32_t>(counts[s] * kProbScale / count)) : 0;
+            sum += table.freq[s];
+            if (table.freq[s] > table.freq[largest])
+                largest = s;
+        }
+
+        // Give the rounding error to the most frequent symbol, or steal it back
+        // one unit at a time from the largest ones.
+        if (sum < kProbScale)
+        {
+            table.freq[largest] += kProbScale - sum;
+        }
+        while (sum > kProbScale)
+        {
+            int victim = 0;
+            for (int s = 1; s < 256; s++)
+            {
+                if (table.freq[s] > table.freq[victim])
+                    victim = s;
+            }
+            const uint32_t take = std::min(sum - kProbScale, table.freq[victim] - 1);
+            table.freq[victim] -= take;
+            sum -= take;
+        }
+
+        table.cum[0] = 0;
+        for (int s = 0; s < 256; s++)
+            table.cum[s + 1] = table.cum[s] + table.freq[s];
+    }
+
+    inline void RansPut(uint32_t& x, uint8_t*& ptr, uint32_t start, uint32_t freq)
+    {
+        const uint32_t xMax = ((kRansL >> kProbBits) << 8) * freq;
+        while (x >= xMax)
+        {
+            *--ptr = static_cast<uint8_t>(x);
+            x >>= 8;
+        }
+        x = ((x / freq) << kProbBits) + (x % freq) + start;
+    }
+
+    inline void RansFlush(uint32_t x, uint8_t*& ptr)
+    {
+        ptr -= 4;
+        ptr[0] = static_cast<uint8_t>(x);
+        ptr[1] = static_cast<uint8_t>(x >> 8);
+        ptr[2] = static_cast<uint8_t>(x >> 16);
+        ptr[3] = static_cast<uint8_t>(x >> 24);
+    }
+
+    // Payload: u16 symbolCount, symbolCount * (u8 symbol, u16 freq), rANS bytes.
+    std::vector<uint8_t> RansEncode(const uint8_t* data, size_t count)
+    {
+        SymbolTable table;
+        NormalizeFrequencies(data, count, table);
+
+        std::vector<uint8_t> payload;
+        uint32_t symbols = 0;
+        for (int s = 0; s < 256; s++)
+            symbols += table.freq[s] ? 1 : 0;
+        Put16(payload, symbols);
+        for (int s = 0; s < 256; s++)
+        {
+            if (table.freq[s])
+            {
+                payload.push_back(static_cast<uint8_t>(s));
+                Put16(payload, table.freq[s]);
+            }
+        }
+
+        // A symbol never costs more than kProbBits bits, plus the two flushed states.
+        std::vector<uint8_t> buffer(count * 2 + 16);
+        uint8_t* end = buffer.data() + buffer.size();
+        uint8_t* ptr = end;
+        uint32_t states[2] = { kRansL, kRansL };
+        for (size_t i = count; i-- > 0;)
+        {
+            const uint8_t s = data[i];
+            RansPut(states[i & 1], ptr, table.cum[s], table.freq[s]);
+        }
+        RansFlush(states[1], ptr);
+        RansFlush(states[0], ptr);
+
+        payload.insert(payload.end(), ptr, end);
+        return payload;
+    }
+
+    bool RansDecode(const uint8_t* payload, size_t payloadSize, uint8_t* out, size_t count)
+    {
+        if (payloadSize < 2)
+            return false;
+
+        const uint8_t* ptr = payload;
+        const uint8_t* end = payload + payloadSize;
+        const uint32_t symbols = Get16(ptr);
+        ptr += 2;
+        if (symbols == 0 || symbols > 256 || size_t(end - ptr) < symbols * 3 + 8)
+            return false;
+
+        SymbolTable table = {};
+        uint8_t cumToSymbol[kProbScale];
+        uint32_t cum = 0;
+        for (uint32_t i = 0; i < symbols; i++, ptr += 3)
+        {
+            const uint8_t s = ptr[0];
+            const uint32_t freq = Get16(ptr + 1);
+            if (freq == 0 || cum + freq > kProbScale)
+                return false;
+            table.freq[s] = freq;
+            table.cum[s] = cum;
+            memset(cumToSymbol + cum, s, freq);
+            cum += freq;
+        }
+        if (cum != kProbScale)
+            return false;
+
+        uint32_t states[2] = { Get32(ptr), Get32(ptr + 4) };
+        ptr += 8;
+
+        const uint32_t mask = kProbScale - 1;
+        for (size_t i = 0; i < count; i++)
+        {
+            uint32_t& x = states[i & 1];
+            const uint32_t slot = x & mask;
+            const uint8_t s = cumToSymbol[slot];
+            out[i] = s;
+            x = table.freq[s] * (x >> kProbBits) + slot - table.cum[s];
+            while (x < kRansL)
+            {
+                if (ptr == end)
+                    return false;
+                x = (x << 8) | *ptr++;
+            }
+        }
+        return true;
+    }
+
+    //-------------------------------------------------------------------------------------
+    // Plane layout
+    //-------------------------------------------------------------------------------------
+
+    // Endpoint bytes are smooth across neighbouring blocks, selectors are not.
+    bool IsDeltaPlane(BlockFormat format, uint32_t plane)
+    {
+        if (format == BlockFormat::BC1)
+            return plane < 4;
+        return plane < 2 || (plane >= 8 && plane < 12);
+    }
+
+    void DeltaEncode(uint8_t* plane, size_t count)
+    {
+        for (size_t i = count; i-- > 1;)
+            plane[i] = static_cast<uint8_t>(plane[i] - plane[i - 1]);
+    }
+
+    // Inclusive byte prefix sum, undoing DeltaEncode.
+    void DeltaDecode(uint8_t* plane, size_t count)
+    {
+        size_t i = 0;
+#if defined(STC_SSE2)
+        __m128i carry = _mm_setzero_si128();
+        for (; i + 16 <= count; i += 16)
+        {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(plane + i));
+            v = _mm_add_epi8(v, _mm_slli_si128(v, 1));
+            v = _mm_add_epi8(v, _mm_slli_si128(v, 2));
+            v = _mm_add_epi8(v, _mm_slli_si128(v, 4));
+            v = _mm_add_epi8(v, _mm_slli_si128(v, 8));
+            v = _mm_add_epi8(v, carry);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(plane + i), v);
+
+            // Broadcast byte 15 as the carry into the next 16 bytes.
+            carry = _mm_shuffle_epi32(_mm_shufflehi_epi16(_mm_unpackhi_epi8(v, v), 0xFF), 0xFF);
+        }
+#endif
+        for (; i < count; i++)
+        {
+            if (i > 0)
+                plane[i] = static_cast<uint8_t>(plane[i] + plane[i - 1]);
+        }
+    }
+
+    // Gathers eight planes back into 8-byte groups at block + offset.
+    void InterleavePlanes8(const uint8_t* const* planes, size_t blocks, uint8_t* out, size_t stride, size_t offset)
+    {
+        size_t b = 0;
+#if defined(STC_SSE2)
+        for (; b + 16 <= blocks; b += 16)
+        {
+            __m128i p[8];
+            for (int k = 0; k < 8; k++)
+                p[k] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(planes[k] + b));
+
+            const __m128i a01lo = _mm_unpacklo_epi8(p[0], p[1]), a01hi = _mm_unpackhi_epi8(p[0], p[1]);
+            const __m128i a23lo = _mm_unpacklo_epi8(p[2], p[3]), a23hi = _mm_unpackhi_epi8(p[2], p[3]);
+            const __m128i a45lo = _mm_unpacklo_epi8(p[4], p[5]), a45hi = _mm_unpackhi_epi8(p[4], p[5]);
+            const __m128i a67lo = _mm_unpacklo_epi8(p[6], p[7]), a67hi = _mm_unpackhi_epi8(p[6], p[7]);
+
+            const __m128i lo[4] = {
+                _mm_unpacklo_epi16(a01lo, a23lo), _mm_unpackhi_epi16(a01lo, a23lo),
+                _mm_unpacklo_epi16(a01hi, a23hi), _mm_unpackhi_epi16(a01hi, a23hi) };
+            const __m128i hi[4] = {
+                _mm_unpacklo_epi16(a45lo, a67lo), _mm_unpackhi_epi16(a45lo, a67lo),
+                _mm_unpacklo_epi16(a45hi, a67hi), _mm_unpackhi_epi16(a45hi, a67hi) };
+
+            for (int q = 0; q < 4; q++)
+            {
+                const __m128i first = _mm_unpacklo_epi32(lo[q], hi[q]);
+                const __m128i second = _mm_unpackhi_epi32(lo[q], hi[q]);
+                uint8_t* dst = out + (b + q * 4) * stride + offset;
+                _mm_storel_epi64(reinterpret_cast<__m128i*>(dst), first);
+                _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + stride), _mm_unpackhi_epi64(first, first));
+                _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + stride * 2), second);
+                _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + stride * 3), _mm_unpackhi_epi64(second, second));
+            }
+        }
+#endif
+        for (; b < blocks; b++)
+        {
+            for (int k = 0; k < 8; k++)
+                out[b * stride + offset + k] = planes[k][b];
+        }
+    }
+
+    //-------------------------------------------------------------------------------------
+    // Mip layout shared by the encoder and transcoder
+    //-------------------------------------------------------------------------------------
+    size_t BuildMipLayout(BlockFormat format, uint32_t width, uint32_t height, uint32_t mipCount, std::vector<MipLevel>& mips)
+    {
+        mips.clear();
+        size_t offset = 0;
+        for (uint32_t mip = 0; mip < mipCount; mip++)
+        {
+            MipLevel level;
+            level.width = std::max<uint32_t>(width >> mip, 1);
+            level.height = std::max<uint32_t>(height >> mip, 1);
+            level.rowPitch = size_t((level.width + 3) / 4) * BlockBytes(format);
+            level.size = level.rowPitch * ((level.height + 3) / 4);
+            level.offset = offset;
+            offset += level.size;
+            mips.push_back(level);
+        }
+        return offset;
+    }
+
+    uint32_t FullMipCount(uint32_t width, uint32_t height)
+    {
+        uint32_t count = 1;
+        while (width > 1 || height > 1)
+        {
+            width = std::max<uint32_t>(width >> 1, 1);
+            height = std::max<uint32_t>(height >> 1, 1);
+            count++;
+        }
+        return count;
+    }
+
+    //-------------------------------------------------------------------------------------
+    // Block encoding helpers
+    //-------------------------------------------------------------------------------------
+    uint32_t Pack565(int r, int g, int b)
+    {
+        return (uint32_t((r * 31 + 127) / 255) << 11) | (uint32_t((g * 63 + 127) / 255) << 5) | uint32_t((b * 31 + 127) / 255);
+    }
+
+    void Unpack565(uint32_t c, int rgb[3])
+    {
+        const int r = (c >> 11) & 31, g = (c >> 5) & 63, b = c & 31;
+        rgb[0] = (r << 3) | (r >> 2);
+        rgb[1] = (g << 2) | (g >> 4);
+        rgb[2] = (b << 3) | (b >> 2);
+    }
+
+    void EncodeColorBlock(const uint8_t rgba[64], uint8_t block[8])
+    {
+        int lo[3] = { 255, 255, 255 }, hi[3] = { 0, 0, 0 };
+        int mean[3] = {};
+        for (int i = 0; i < 16; i++)
+        {
+            for (int c = 0; c < 3; c++)
+            {
+                lo[c] = std::min<int>(lo[c], rgba[i * 4 + c]);
+                hi[c] = std::max<int>(hi[c], rgba[i * 4 + c]);
+                mean[c] += rgba[i * 4 + c];
+            }
+        }
+
+        // Orient the bounding box diagonal along the colour distribution: channels
+        // that are anti-correlated with the widest one run the other way.
+        int axis = 0;
+        for (int c = 1; c < 3; c++)
+        {
+            if (hi[c] - lo[c] > hi[axis] - lo[axis])
+                axis = c;
+        }
+        for (int c = 0; c < 3; c++)
+        {
+            if (c == axis)
+                continue;
+            int covariance = 0;
+            for (int i = 0; i < 16; i++)
+                covariance += (rgba[i * 4 + axis] * 16 - mean[axis]) * (rgba[i * 4 + c] * 16 - mean[c]);
+            if (covariance < 0)
+                std::swap(lo[c], hi[c]);
+        }
+
+        // Inset the box slightly; the extremes are rarely worth a palette entry.
+        for (int c = 0; c < 3; c++)
+        {
+            const int inset = (hi[c] - lo[c]) / 16;
+            hi[c] -= inset;
+            lo[c] += inset;
+        }
+
+        uint32_t c0 = Pack565(hi[0], hi[1], hi[2]);
+        uint32_t c1 = Pack565(lo[0], lo[1], lo[2]);
+        if (c0 < c1)
+            std::swap(c0, c1);
+
+        uint32_t selectors = 0;
+        if (c0 != c1)
+        {
+            int palette[4][3];
+            Unpack565(c0, palette[0]);
+            Unpack565(c1, palette[1]);
+            for (int c = 0; c < 3; c++)
+            {
+                palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+                palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+            }
+
+            for (int i = 0; i < 16; i++)
+            {
+                int best = 0, bestError = INT32_MAX;
+                for (int p = 0; p < 4; p++)
+                {
+                    int error = 0;
+                    for (int c = 0; c < 3; c++)
+                    {
+                        const int d = rgba[i * 4 + c] - palette[p][c];
+                        error += d * d;
+                    }
+                    if (error < bestError)
+                    {
+                        bestError = error;
+                        best = p;
+                    }
+                }
+                selectors |= uint32_t(best) << (i * 2);
+            }
+        }
+
+        block[0] = static_cast<uint8_t>(c0);
+        block[1] = static_cast<uint8_t>(c0 >> 8);
+        block[2] = static_cast<uint8_t>(c1);
+        block[3] = static_cast<uint8_t>(c1 >> 8);
+        for (int i = 0; i < 4; i++)
+            block[4 + i] = static_cast<uint8_t>(selectors >> (i * 8));
+    }
+
+    void EncodeAlphaBlock(const uint8_t rgba[64], uint8_t block[8])
+    {
+        int a0 = 0, a1 = 255;
+        for (int i = 0; i < 16; i++)
+        {
+            a0 = std::max<int>(a0, rgba[i * 4 + 3]);
+            a1 = std::min<int>(a1, rgba[i * 4 + 3]);
+        }
+
+        uint64_t selectors = 0;
+        if (a0 != a1)
+        {
+            // Eight value mode (a0 > a1): a0, a1, then six interpolated steps.
+            int palette[8] = { a0, a1 };
+            for (int k = 1; k < 7; k++)
+                palette[k + 1] = ((7 - k) * a0 + k * a1) / 7;
+
+            for (int i = 0; i < 16; i++)
+            {
+                int best = 0, bestError = INT32_MAX;
+                for (int p = 0; p < 8; p++)
+                {
+                    const int error = std::abs(rgba[i * 4 + 3] - palette[p]);
+                    if (error < bestError)
+                    {
+                        bestError = error;
+                        best = p;
+                    }
+                }
+                selectors |= uint64_t(best) << (i * 3);
+            }
+        }
+
+        block[0] = static_cast<uint8_t>(a0);
+        block[1] = static_cast<uint8_t>(a1);
+        for (int i = 0; i < 6; i++)
+            block[2 + i] = static_cast<uint8_t>(selectors >> (i * 8));
+    }
+
+    // Gathers a 4x4 block, clamping at the edges of small mips.
+    void FetchBlock(const uint8_t* pixels, uint32_t width, uint32_t height, uint32_t bx, uint32_t by, uint8_t rgba[64])
+    {
+        for (uint32_t y = 0; y < 4; y++)
+        {
+            const uint32_t sy = std::min(by * 4 + y, height - 1);
+            for (uint32_t x = 0; x < 4; x++)
+            {
+                const uint32_t sx = std::min(bx * 4 + x, width - 1);
+                memcpy(rgba + (y * 4 + x) * 4, pixels + (size_t(sy) * width + sx) * 4, 4);
+            }
+        }
+    }
+}
+
+size_t SupercompressedTexture::BlockBytes(BlockFormat format)
+{
+    return format == BlockFormat::BC1 ? 8 : 16;
+}
+
+void SupercompressedTexture::EncodeBC1Block(const uint8_t rgba[64], uint8_t block[8])
+{
+    EncodeColorBlock(rgba, block);
+}
+
+void SupercompressedTexture::EncodeBC3Block(const uint8_t rgba[64], uint8_t block[16])
+{
+    EncodeAlphaBlock(rgba, block);
+    EncodeColorBlock(rgba, block + 8);
+}
+
+bool SupercompressedTexture::Encode(const ImageResampler::ImageView& image, BlockFormat format, bool generateMips,
+    std::vector<uint8_t>& file)
+{
+    if (image.layout == ImageResampler::PixelLayout::RGBA32F)
+        return false;
+
+    // D3D12 wants the top level of a BC texture in whole blocks.
+    const uint32_t width = (image.width + 3) & ~3u;
+    const uint32_t height = (image.height + 3) & ~3u;
+
+    const uint32_t mipCount = generateMips ? FullMipCount(width, height) : 1;
+    std::vector<MipLevel> mips;
+    const size_t blockDataSize = BuildMipLayout(format, width, height, mipCount, mips);
+    const size_t blockBytes = BlockBytes(format);
+    std::vector<uint8_t> blocks(blockDataSize);
+
+    // Level 0 is the source in RGBA order, every further level is resampled from it.
+    std::vector<uint8_t> level(size_t(width) * height * 4);
+    const ImageResampler::MutableImageView level0 = { level.data(), width, height,
+        size_t(width) * 4, ImageResampler::PixelLayout::RGBA8, image.srgb };
+    if (!ImageResampler::Resize(image, level0, ImageResampler::Filter::Mitchell))
+        return false;
+
+    std::vector<uint8_t> mipPixels;
+    for (uint32_t mip = 0; mip < mipCount; mip++)
+    {
+        const MipLevel& m = mips[mip];
+        const uint8_t* pixels = level.data();
+        if (mip > 0)
+        {
+            mipPixels.resize(size_t(m.width) * m.height * 4);
+            const ImageResampler::ImageView src = { level.data(), width, height,
+                size_t(width) * 4, ImageResampler::PixelLayout::RGBA8, image.srgb };
+            const ImageResampler::MutableImageView dst = { mipPixels.data(), m.width, m.height,
+                size_t(m.width) * 4, ImageResampler::PixelLayout::RGBA8, image.srgb };
+            if (!ImageResampler::Resize(src, dst, ImageResampler::Filter::Box))
+                return false;
+            pixels = mipPixels.data();
+        }
+
+        const uint32_t blocksX = (m.width + 3) / 4;
+        const uint32_t blocksY = (m.height + 3) / 4;
+        JobSystem::Get().ParallelFor(blocksY, 4, [&](size_t begin, size_t end)
+        {
+            uint8_t rgba[64];
+            for (size_t by = begin; by < end; by++)
+            {
+                for (uint32_t bx = 0; bx < blocksX; bx++)
+                {
+                    FetchBlock(pixels, m.width, m.height, bx, static_cast<uint32_t>(by), rgba);
+                    uint8_t* block = blocks.data() + m.offset + by * m.rowPitch + bx * blockBytes;
+                    if (format == BlockFormat::BC1)
+                        EncodeBC1Block(rgba, block);
+                    else
+                        EncodeBC3Block(rgba, block);
+                }
+            }
+        });
+    }
+
+    file.assign(kMagic, kMagic + 4);
+    Put32(file, static_cast<uint32_t>(format));
+    Put32(file, image.srgb ? FLAG_SRGB : FLAG_NONE);
+    Put32(file, width);
+    Put32(file, height);
+    Put32(file, mipCount);
+
+    const size_t blockCount = blockDataSize / blockBytes;
+    std::vector<uint8_t> plane(blockCount);
+    for (uint32_t p = 0; p < blockBytes; p++)
+    {
+        for (size_t b = 0; b < blockCount; b++)
+            plane[b] = blocks[b * blockBytes + p];
+        if (IsDeltaPlane(format, p))
+            DeltaEncode(plane.data(), blockCount);
+
+        const std::vector<uint8_t> coded = RansEncode(plane.data(), blockCount);
+        const bool stored = coded.size() >= blockCount;
+
+        Put32(file, static_cast<uint32_t>(blockCount));
+        Put32(file, static_cast<uint32_t>(stored ? blockCount : coded.size()));
+        file.push_back(stored ? PLANE_STORED : PLANE_RANS);
+        if (stored)
+            file.insert(file.end(), plane.begin(), plane.end());
+        else
+            file.insert(file.end(), coded.begin(), coded.end());
+    }
+    return true;
+}
+
+bool SupercompressedTexture::Transcode(const uint8_t* file, size_t fileSize, TranscodedTexture& texture)
+{
+    if (fileSize < kHeaderSize || memcmp(file, kMagic, 4) != 0)
+        return false;
+
+    const uint32_t format = Get32(file + 4);
+    if (format != static_cast<uint32_t>(BlockFormat::BC1) && format != static_cast<uint32_t>(BlockFormat::BC3))
+        return false;
+
+    texture.format = static_cast<BlockFormat>(format);
+    texture.srgb = (Get32(file + 8) & FLAG_SRGB) != 0;
+    texture.width = Get32(file + 12);
+    texture.height = Get32(file + 16);
+    const uint32_t mipCount = Get32(file + 20);
+    if (texture.width == 0 || texture.height == 0 || texture.width > 16384 || texture.height > 16384
+        || mipCount == 0 || mipCount > FullMipCount(texture.width, texture.height))
+        return false;
+
+    texture.dataSize = BuildMipLayout(texture.format, texture.width, texture.height, mipCount, texture.mips);
+    const size_t blockBytes = BlockBytes(texture.format);
+    const size_t blockCount = texture.dataSize / blockBytes;
+
+    // Locate every plane first so they can be decoded independently.
+    struct Plane
+    {
+        const uint8_t* payload;
+        size_t size;
+        uint8_t coding;
+    };
+    std::vector<Plane> planes(blockBytes);
+    size_t offset = kHeaderSize;
+    for (size_t p = 0; p < blockBytes; p++)
+    {
+        if (fileSize - offset < 9)
+            return false;
+        const uint32_t rawSize = Get32(file + offset);
+        const uint32_t payloadSize = Get32(file + offset + 4);
+        planes[p].coding = file[offset + 8];
+        offset += 9;
+        if (rawSize != blockCount || payloadSize > fileSize - offset)
+            return false;
+        planes[p].payload = file + offset;
+        planes[p].size = payloadSize;
+        offset += payloadSize;
+    }
+
+    std::unique_ptr<uint8_t[]> planeData(new uint8_t[blockCount * blockBytes]);
+    std::atomic<bool> ok{ true };
+    JobSystem::Get().ParallelFor(blockBytes, 1, [&](size_t begin, size_t end)
+    {
+        for (size_t p = begin; p < end; p++)
+        {
+            uint8_t* out = planeData.get() + p * blockCount;
+            const Plane& plane = planes[p];
+            if (plane.coding == PLANE_STORED && plane.size == blockCount)
+                memcpy(out, plane.payload, blockCount);
+            else if (plane.coding != PLANE_RANS || !RansDecode(plane.payload, plane.size, out, blockCount))
+                ok = false;
+
+            if (IsDeltaPlane(texture.format, static_cast<uint32_t>(p)))
+                DeltaDecode(out, blockCount);
+        }
+    });
+    if (!ok)
+        return false;
+
+    texture.data.reset(new uint8_t[texture.dataSize]);
+    for (size_t group = 0; group < blockBytes; group += 8)
+    {
+        const uint8_t* groupPlanes[8];
+        for (int k = 0; k < 8; k++)
+            groupPlanes[k] = planeData.get() + (group + k) * blockCount;
+        InterleavePlanes8(groupPlanes, blockCount, texture.data.get(), blockBytes, group);
+    }
+    return true;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "ImageResampler.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Supercompressed texture container (.stc).
+//
+// The cooker encodes RGBA8 images into BC1/BC3 blocks, splits the blocks into
+// byte planes (endpoint planes are delta coded against the previous block) and
+// entropy codes every plane with interleaved rANS. At load time Transcode()
+// undoes the entropy coding and re-interleaves the planes, so the loader still
+// uploads GPU-native blocks while reading a fraction of the bytes from disk.
+//
+// Layout (little endian):
+//   char[4] "STC1", u32 format, u32 flags, u32 width, u32 height, u32 mipCount
+//   per plane: u32 rawSize, u32 payloadSize, u8 coding, payload
+namespace SupercompressedTexture
+{
+    enum class BlockFormat : uint32_t
+    {
+        BC1 = 1,    // Opaque RGB, 8 bytes per 4x4 block.
+        BC3 = 3,    // RGBA, 16 bytes per 4x4 block.
+    };
+
+    enum Flags : uint32_t
+    {
+        FLAG_NONE = 0,
+        FLAG_SRGB = 0x1,
+    };
+
+    struct MipLevel
+    {
+        uint32_t width;
+        uint32_t height;
+        size_t offset;      // Byte offset of the level in TranscodedTexture::data.
+        size_t rowPitch;    // Bytes per row of blocks.
+        size_t size;
+    };
+
+    struct TranscodedTexture
+    {
+        BlockFormat format;
+        bool srgb;
+        uint32_t width;
+        uint32_t height;
+        std::vector<MipLevel> mips;
+        std::unique_ptr<uint8_t[]> data;
+        size_t dataSize;
+    };
+
+    size_t BlockBytes(BlockFormat format);
+
+    // Cooker side (see Cooker/TextureCooker.cpp). The source must be
+    // RGBA8/BGRA8; it is resampled up to whole blocks if needed and mips are
+    // generated with ImageResampler on request. Returns false if the source
+    // or any level cannot be resampled.
+    bool Encode(const ImageResampler::ImageView& image, BlockFormat format, bool generateMips,
+        std::vector<uint8_t>& file);
+
+    // Runtime side. Returns false for truncated or malformed files.
+    bool Transcode(const uint8_t* file, size_t fileSize, TranscodedTexture& texture);
+
+    // Block encoders, exposed for tools that already have their own containers.
+    void EncodeBC1Block(const uint8_t rgba[64], uint8_t block[8]);
+    void EncodeBC3Block(const uint8_t rgba[64], uint8_t block[16]);
+}
@@ -0,0 +1,220 @@
+#include "Test.h"
+#include "CascadedShadows.h"
+
+#include <cmath>
+#include <string>
+
+namespace
+{
+    const float ToLight[3] = { 0.520266f, 0.780399f, 0.346844f };     // (6, 9, 4), normalized.
+    const uint32_t Resolution = 2048;
+
+    CascadedShadows::View MakeView(const float eye[3], float yaw, float pitch)
+    {
+        CascadedShadows::View view;
+        for (int i = 0; i < 3; i++)
+        {
+            view.eye[i] = eye[i];
+        }
+        view.forward[0] = std::sin(yaw) * std::cos(pitch);
+        view.forward[1] = std::sin(pitch);
+        view.forward[2] = -std::cos(yaw) * std::cos(pitch);
+        view.tanHalfFovY = 0.4142f;    // 45 degrees vertical.
+        view.aspect = 16.0f / 9.0f;
+        view.nearZ = 0.1f;
+        view.farZ = 100.0f;
+        return view;
+    }
+
+    void Transform(const float m[4][4], const float p[3], float clip[4])
+    {
+        for (int c = 0; c < 4; c++)
+        {
+            clip[c] = p[0] * m[0][c] + p[1] * m[1][c] + p[2] * m[2][c] + m[3][c];
+        }
+    }
+
+    // The light space axis that row c of the projection scales, as a unit
+    // vector.
+    void Axis(const ShadowCascade& cascade, int c, float axis[3])
+    {
+        float length = 0.0f;
+        for (int i = 0; i < 3; i++)
+        {
+            axis[i] = cascade.viewProjection[i][c];
+            length += axis[i] * axis[i];
+        }
+        for (int i = 0; i < 3; i++)
+        {
+            axis[i] /= std::sqrt(length);
+        }
+    }
+
+    // Where in its texel a world point lands, in [0, 1).
+    float TexelPhase(float clip)
+    {
+        const float texels = (clip + 1.0f) * 0.5f * Resolution;
+        return texels - std::floor(texels);
+    }
+
+    float PhaseDistance(float a, float b)
+    {
+        const float d = std::fabs(a - b);
+        return std::fmin(d, 1.0f - d);
+    }
+}
+
+TEST_CASE(CascadedShadowsSplitsBlendUniformAndLogarithmic)
+{
+    const float nearZ = 0.1f, farZ = 100.0f;
+    float splits[CascadedShadows::MaxCascades];
+
+    CascadedShadows::ComputeSplits(nearZ, farZ, 4, 0.0f, splits);
+    for (uint32_t i = 0; i < 3; i++)
+    {
+        CHECK(std::fabs(splits[i] - (nearZ + (farZ - nearZ) * (i + 1) / 4.0f)) < 1e-4f);
+    }
+
+    CascadedShadows::ComputeSplits(nearZ, farZ, 4, 1.0f, splits);
+    for (uint32_t i = 0; i < 3; i++)
+    {
+        // Each cascade is the same multiple of the previous one deep.
+        const float previous = i == 0 ? nearZ : splits[i - 1];
+        CHECK(std::fabs(splits[i] / previous - std::pow(farZ / nearZ, 0.25f)) < 1e-3f);
+    }
+
+    for (float lambda : { 0.0f, 0.3f, 0.7f, 1.0f })
+    {
+        for (uint32_t count = 1; count <= CascadedShadows::MaxCascades; count++)
+        {
+            CascadedShadows::ComputeSplits(nearZ, farZ, count, lambda, splits);
+            CHECK(splits[count - 1] == farZ);
+            for (uint32_t i = 0; i < count; i++)
+            {
+                CHECK(splits[i] > (i == 0 ? nearZ : splits[i - 1]));
+            }
+        }
+    }
+}
+
+TEST_CASE(CascadedShadowsCascadeCoversItsSlice)
+{
+    const float eye[3] = { 3.0f, 2.0f, -5.0f };
+    const CascadedShadows::View view = MakeView(eye, 0.6f, -0.3f);
+    ShadowCascade cascades[CascadedShadows::MaxCascades];
+    CascadedShadows::FitCascades(view, ToLight, CascadedShadows::MaxCascades, 0.7f, Resolution, cascades);
+
+    float right[3] = { -view.forward[2], 0.0f, view.forward[0] };   // cross(forward, (0, 1, 0))
+    const float rightLength = std::sqrt(right[0] * right[0] + right[2] * right[2]);
+    right[0] /= rightLength;
+    right[2] /= rightLength;
+    const float up[3] = {
+        right[1] * view.forward[2] - right[2] * view.forward[1],
+        right[2] * view.forward[0] - right[0] * view.forward[2],
+        right[0] * view.forward[1] - right[1] * view.forward[0] };
+
+    for (uint32_t c = 0; c < CascadedShadows::MaxCascades; c++)
+    {
+        const ShadowCascade& cascade = cascades[c];
+        CHECK(cascade.splitNear == (c == 0 ? view.nearZ : cascades[c - 1].splitFar));
+        for (float depth : { cascade.splitNear, cascade.splitFar })
+        {
+            for (int corner = 0; corner < 4; corner++)
+            {
+                const float sx = (corner & 1 ? 1.0f : -1.0f) * depth * view.tanHalfFovY * view.aspect;
+                const float sy = (corner & 2 ? 1.0f : -1.0f) * depth * view.tanHalfFovY;
+                float p[3], clip[4];
+                for (int i = 0; i < 3; i++)
+                {
+                    p[i] = view.eye[i] + view.forward[i] * depth + right[i] * sx + up[i] * sy;
+                }
+                Transform(cascade.viewProjection, p, clip);
+                const std::string context = "cascade " + std::to_string(c);
+                CHECK_MESSAGE(std::fabs(clip[0]) <= 1.0f && std::fabs(clip[1]) <= 1.0f, context);
+                CHECK_MESSAGE(clip[2] >= 0.0f && clip[2] <= 1.0f, context);
+                CHECK_MESSAGE(clip[3] == 1.0f, context);
+            }
+        }
+    }
+}
+
+TEST_CASE(CascadedShadowsSnappingKeepsTexelsStill)
+{
+    // As the camera moves, a fixed world point may only move across the map
+    // in whole texels, and turning the camera must not resize the cascade.
+    const float point[3] = { 1.25f, 0.5f, -3.75f };
+    for (uint32_t c = 0; c < CascadedShadows::MaxCascades; c++)
+    {
+        float splits[CascadedShadows::MaxCascades];
+        CascadedShadows::ComputeSplits(0.1f, 100.0f, CascadedShadows::MaxCascades, 0.7f, splits);
+        const float splitNear = c == 0 ? 0.1f : splits[c - 1];
+
+        const float startEye[3] = { 0.0f, 2.0f, 7.0f };
+        const ShadowCascade first = CascadedShadows::FitCascade(MakeView(startEye, 0.0f, -0.2f), splitNear, splits[c], ToLight, Resolution);
+        float firstClip[4];
+        Transform(first.viewProjection, point, firstClip);
+
+        for (int step = 1; step <= 50; step++)
+        {
+            // A walk and a turn; the steps are not multiples of a texel.
+            const float eye[3] = { startEye[0] + 0.0371f * step, startEye[1] + 0.0113f * step, startEye[2] - 0.0529f * step };
+            const ShadowCascade cascade = CascadedShadows::FitCascade(MakeView(eye, 0.031f * step, -0.2f), splitNear, splits[c], ToLight,
+                Resolution);
+            const std::string context = "cascade " + std::to_string(c) + ", step " + std::to_string(step);
+            CHECK_MESSAGE(std::fabs(cascade.radius - first.radius) <= 1e-5f * first.radius, context);
+
+            float clip[4];
+            Transform(cascade.viewProjection, point, clip);
+            CHECK_MESSAGE(PhaseDistance(TexelPhase(clip[0]), TexelPhase(firstClip[0])) < 0.01f, context);
+            CHECK_MESSAGE(PhaseDistance(TexelPhase(clip[1]), TexelPhase(firstClip[1])) < 0.01f, context);
+        }
+    }
+}
+
+TEST_CASE(CascadedShadowsCasterVisibilityIgnoresOnlyTheNearPlane)
+{
+    const float eye[3] = { 0.0f, 2.0f, 7.0f };
+    const ShadowCascade cascade = CascadedShadows::FitCascade(MakeView(eye, 0.0f, -0.2f), 0.1f, 10.0f, ToLight, Resolution);
+    const Frustum casters = CascadedShadows::CasterFrustum(cascade);
+    float right[3], up[3];
+    Axis(cascade, 0, right);
+    Axis(cascade, 1, up);
+
+    struct Case
+    {
+        float towardLight;  // Offsets from the cascade's center, in radii.
+        float across;
+        float radius;
+        bool visible;
+    };
+    const Case cases[] = {
+        { 0.0f, 0.0f, 0.1f, true },
+        { 10.0f, 0.0f, 0.1f, true },        // Between the cascade and the light.
+        { -1.2f, 0.0f, 0.1f, false },       // Beyond the far plane.
+        { -1.2f, 0.0f, 0.3f, true },        // Reaching back over it.
+        { 0.0f, 1.2f, 0.1f, false },        // Off to the side.
+        { 0.0f, 1.2f, 0.3f, true },
+        { 10.0f, 1.2f, 0.1f, false },       // Toward the light, but to the side.
+    };
+    for (const Case& test : cases)
+    {
+        for (const float* axis : { right, up })
+        {
+            float center[3];
+            for (int i = 0; i < 3; i++)
+            {
+                center[i] = cascade.center[i] + (ToLight[i] * test.towardLight + axis[i] * test.across) * cascade.radius;
+            }
+            const float radius = test.radius * cascade.radius;
+            CHECK(CascadedShadows::IsCasterVisible(cascade, center, radius) == test.visible);
+
+            // CasterFrustum culls the same spheres with all six planes.
+            bool inside = true;
+            for (const float* plane : casters.planes)
+            {
+                inside = inside && plane[0] * center[0] + plane[1] * center[1] + plane[2] * center[2] + plane[3] >= -radius;
+            }
+            CHECK(inside == test.visible);
+        }
+    }
+}
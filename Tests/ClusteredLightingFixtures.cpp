@@ -0,0 +1,260 @@
+#include "ClusteredLightingFixtures.h"
+#include "TestRandom.h"
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+namespace
+{
+    float Dot(const float a[3], const float b[3])
+    {
+        return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+    }
+
+    void Normalize(float v[3])
+    {
+        const float length = std::sqrt(Dot(v, v));
+        for (int i = 0; i < 3; i++)
+        {
+            v[i] /= length;
+        }
+    }
+
+    // View space bounds of a cluster, with depth as the third coordinate,
+    // grown and wrapped in a sphere as LightBinner::SetGrid does.
+    struct Cluster
+    {
+        float low[3];
+        float high[3];
+        float center[3];
+        float radius;
+    };
+
+    Cluster MakeCluster(const ClusteredLighting::GridDesc& grid, uint32_t x, uint32_t y, uint32_t slice)
+    {
+        const float tanHalfFovX = grid.tanHalfFovY * grid.aspect;
+        const float nearDepth = slice == 0 ? grid.nearZ :
+            grid.nearZ * std::pow(grid.farZ / grid.nearZ, static_cast<float>(slice) / grid.slices);
+        const float farDepth = slice + 1 == grid.slices ? grid.farZ :
+            grid.nearZ * std::pow(grid.farZ / grid.nearZ, static_cast<float>(slice + 1) / grid.slices);
+        const float bottom = (1.0f - 2.0f * (y + 1) / grid.tilesY) * grid.tanHalfFovY;
+        const float top = (1.0f - 2.0f * y / grid.tilesY) * grid.tanHalfFovY;
+        const float left = (2.0f * x / grid.tilesX - 1.0f) * tanHalfFovX;
+        const float right = (2.0f * (x + 1) / grid.tilesX - 1.0f) * tanHalfFovX;
+
+        Cluster cluster;
+        cluster.low[0] = std::min(left * nearDepth, left * farDepth);
+        cluster.high[0] = std::max(right * nearDepth, right * farDepth);
+        cluster.low[1] = std::min(bottom * nearDepth, bottom * farDepth);
+        cluster.high[1] = std::max(top * nearDepth, top * farDepth);
+        cluster.low[2] = nearDepth;
+        cluster.high[2] = farDepth;
+
+        float radiusSquared = 0.0f;
+        for (int axis = 0; axis < 3; axis++)
+        {
+            const float margin = 1e-3f * (cluster.high[axis] - cluster.low[axis]);
+            cluster.low[axis] -= margin;
+            cluster.high[axis] += margin;
+            cluster.center[axis] = 0.5f * (cluster.low[axis] + cluster.high[axis]);
+            const float half = cluster.high[axis] - cluster.center[axis];
+            radiusSquared += half * half;
+        }
+        cluster.radius = std::sqrt(radiusSquared);
+        return cluster;
+    }
+
+    // A light in view space, with depth (-z) as the third coordinate.
+    struct ViewLight
+    {
+        float center[3];
+        float range;
+        float rangeSquared;
+        float direction[3];
+        float cosAngle;
+        float sinAngle;
+        bool spot;
+    };
+
+    ViewLight ToView(const float view[4][4], const ClusterLight& light)
+    {
+        ViewLight viewLight;
+        for (int axis = 0; axis < 3; axis++)
+        {
+            viewLight.center[axis] = light.position[0] * view[0][axis] + light.position[1] * view[1][axis] +
+                light.position[2] * view[2][axis] + view[3][axis];
+            viewLight.direction[axis] = light.direction[0] * view[0][axis] + light.direction[1] * view[1][axis] +
+                light.direction[2] * view[2][axis];
+        }
+        viewLight.center[2] = -viewLight.center[2];
+        viewLight.direction[2] = -viewLight.direction[2];
+        viewLight.range = light.range;
+        viewLight.rangeSquared = light.range * light.range;
+        viewLight.spot = light.spotCosAngle > -1.0f;
+        viewLight.cosAngle = light.spotCosAngle;
+        viewLight.sinAngle = viewLight.spot ? std::sqrt(std::max(1.0f - light.spotCosAngle * light.spotCosAngle, 0.0f)) : 1.0f;
+        return viewLight;
+    }
+
+    float AxisDistance(float low, float high, float value)
+    {
+        return std::max(std::max(low - value, 0.0f), value - high);
+    }
+
+    bool TouchesCone(const ViewLight& light, const Cluster& cluster)
+    {
+        const float toCluster[3] = {
+            cluster.center[0] - light.center[0],
+            cluster.center[1] - light.center[1],
+            cluster.center[2] - light.center[2] };
+        const float lengthSquared = Dot(toCluster, toCluster);
+        const float along = Dot(toCluster, light.direction);
+        const float closest = light.cosAngle * std::sqrt(std::max(lengthSquared - along * along, 0.0f)) - along * light.sinAngle;
+        return !(closest > cluster.radius || along > cluster.radius + light.range || along < -cluster.radius);
+    }
+}
+
+namespace ClusteredLightingFixtures
+{
+    TestScene MakeTestScene(uint32_t lightCount, uint32_t seed)
+    {
+        TestScene scene;
+
+        // Looking slightly to the right and down from (0, 2, 7).
+        const float eye[3] = { 0.0f, 2.0f, 7.0f };
+        float forward[3] = { 0.3f, -0.2f, -1.0f };
+        Normalize(forward);
+        const float axisZ[3] = { -forward[0], -forward[1], -forward[2] };
+        float axisX[3] = { axisZ[2], 0.0f, -axisZ[0] };     // cross((0, 1, 0), axisZ)
+        Normalize(axisX);
+        const float axisY[3] = {
+            axisZ[1] * axisX[2] - axisZ[2] * axisX[1],
+            axisZ[2] * axisX[0] - axisZ[0] * axisX[2],
+            axisZ[0] * axisX[1] - axisZ[1] * axisX[0] };
+        for (int i = 0; i < 3; i++)
+        {
+            scene.view[i][0] = axisX[i];
+            scene.view[i][1] = axisY[i];
+            scene.view[i][2] = axisZ[i];
+            scene.view[i][3] = 0.0f;
+        }
+        scene.view[3][0] = -Dot(axisX, eye);
+        scene.view[3][1] = -Dot(axisY, eye);
+        scene.view[3][2] = -Dot(axisZ, eye);
+        scene.view[3][3] = 1.0f;
+
+        // Spread around and beyond the frustum, so some lights are culled
+        // entirely; a quarter are spot lights.
+        TestRandom random(seed);
+        scene.lights.resize(lightCount);
+        for (uint32_t i = 0; i < lightCount; i++)
+        {
+            ClusterLight& light = scene.lights[i];
+            light.position[0] = random.Range(-40.0f, 40.0f);
+            light.position[1] = random.Range(-15.0f, 25.0f);
+            light.position[2] = random.Range(-95.0f, 10.0f);
+            light.range = random.Range(0.5f, 6.0f);
+            for (int c = 0; c < 3; c++)
+            {
+                light.color[c] = random.Range(0.2f, 1.0f);
+            }
+            light.spotCosAngle = ClusteredLighting::PointLight;
+            light.direction[0] = 0.0f;
+            light.direction[1] = -1.0f;
+            light.direction[2] = 0.0f;
+            light.padding = 0.0f;
+            if (i % 4 == 3)
+            {
+                const float halfAngle = random.Range(0.17f, 1.05f);
+                light.spotCosAngle = std::cos(halfAngle);
+                light.direction[0] = random.Range(-1.0f, 1.0f);
+                light.direction[1] = random.Range(-1.0f, -0.1f);
+                light.direction[2] = random.Range(-1.0f, 1.0f);
+                Normalize(light.direction);
+            }
+        }
+        return scene;
+    }
+
+    void BinReference(const ClusteredLighting::GridDesc& grid, const float view[4][4], const ClusterLight* lights, uint32_t count,
+        Bins& bins)
+    {
+        std::vector<ViewLight> viewLights(count);
+        for (uint32_t i = 0; i < count; i++)
+        {
+            viewLights[i] = ToView(view, lights[i]);
+        }
+
+        bins.clusters.resize(static_cast<size_t>(grid.tilesX) * grid.tilesY * grid.slices);
+        bins.indices.clear();
+        for (uint32_t slice = 0; slice < grid.slices; slice++)
+        {
+            for (uint32_t y = 0; y < grid.tilesY; y++)
+            {
+                for (uint32_t x = 0; x < grid.tilesX; x++)
+                {
+                    const Cluster cluster = MakeCluster(grid, x, y, slice);
+                    const uint32_t offset = static_cast<uint32_t>(bins.indices.size());
+                    for (uint32_t i = 0; i < count; i++)
+                    {
+                        const ViewLight& light = viewLights[i];
+                        const float dx = AxisDistance(cluster.low[0], cluster.high[0], light.center[0]);
+                        const float dy = AxisDistance(cluster.low[1], cluster.high[1], light.center[1]);
+                        const float dz = AxisDistance(cluster.low[2], cluster.high[2], light.center[2]);
+                        // Rounded after every step, like the SIMD path; each
+                        // product goes through its own volatile, so the
+                        // compiler cannot fuse it into the sum.
+                        volatile float xx = dx * dx;
+                        volatile float yy = dy * dy;
+                        volatile float zz = dz * dz;
+                        volatile float distance = xx + yy;
+                        distance = distance + zz;
+                        if (distance <= light.rangeSquared && (!light.spot || TouchesCone(light, cluster)))
+                        {
+                            bins.indices.push_back(i);
+                        }
+                    }
+                    LightCluster& bin = bins.clusters[(static_cast<size_t>(slice) * grid.tilesY + y) * grid.tilesX + x];
+                    bin.offset = offset;
+                    bin.count = static_cast<uint32_t>(bins.indices.size()) - offset;
+                }
+            }
+        }
+    }
+
+    bool Compare(const Bins& expected, const LightBinner& actual, std::string& message)
+    {
+        const std::vector<LightCluster>& clusters = actual.Clusters();
+        const std::vector<uint32_t>& indices = actual.LightIndices();
+        std::ostringstream stream;
+        if (expected.clusters.size() != clusters.size())
+        {
+            stream << "cluster count " << clusters.size() << ", expected " << expected.clusters.size();
+            message = stream.str();
+            return false;
+        }
+        for (size_t c = 0; c < expected.clusters.size(); c++)
+        {
+            const LightCluster& e = expected.clusters[c];
+            const LightCluster& a = clusters[c];
+            if (e.count != a.count)
+            {
+                stream << "cluster " << c << " has " << a.count << " lights, expected " << e.count;
+                message = stream.str();
+                return false;
+            }
+            for (uint32_t i = 0; i < e.count; i++)
+            {
+                if (expected.indices[e.offset + i] != indices[a.offset + i])
+                {
+                    stream << "cluster " << c << " entry " << i << " is light " << indices[a.offset + i]
+                        << ", expected " << expected.indices[e.offset + i];
+                    message = stream.str();
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+}
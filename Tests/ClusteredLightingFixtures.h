@@ -0,0 +1,35 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "ClusteredLighting.h"
+
+// Scenes and a brute force reference for checking LightBinner, shared by the
+// tests and the benchmarks.
+namespace ClusteredLightingFixtures
+{
+    // Random point and spot lights in front of a camera.
+    struct TestScene
+    {
+        ClusteredLighting::GridDesc grid;
+        float view[4][4];
+        std::vector<ClusterLight> lights;
+    };
+    TestScene MakeTestScene(uint32_t lightCount, uint32_t seed);
+
+    // The clusters and light index list a binner should produce.
+    struct Bins
+    {
+        std::vector<LightCluster> clusters;
+        std::vector<uint32_t> indices;
+    };
+
+    // Tests every light against every cluster one at a time, with the same
+    // float operations as LightBinner, so the result matches it exactly.
+    void BinReference(const ClusteredLighting::GridDesc& grid, const float view[4][4], const ClusterLight* lights, uint32_t count,
+        Bins& bins);
+
+    // On a mismatch, returns false and describes the first difference in
+    // message.
+    bool Compare(const Bins& expected, const LightBinner& actual, std::string& message);
+}
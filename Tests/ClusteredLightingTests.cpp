@@ -0,0 +1,85 @@
+#include "Test.h"
+#include "ClusteredLightingFixtures.h"
+#include "JobSystem.h"
+
+#include <stdexcept>
+
+namespace
+{
+    void CheckMatchesReference(const ClusteredLightingFixtures::TestScene& scene, JobSystem* jobs)
+    {
+        const uint32_t count = static_cast<uint32_t>(scene.lights.size());
+        ClusteredLightingFixtures::Bins reference;
+        ClusteredLightingFixtures::BinReference(scene.grid, scene.view, scene.lights.data(), count, reference);
+
+        LightBinner binner;
+        binner.SetGrid(scene.grid);
+        binner.Bin(scene.view, scene.lights.data(), count, jobs);
+
+        std::string mismatch;
+        CHECK_MESSAGE(ClusteredLightingFixtures::Compare(reference, binner, mismatch), mismatch);
+    }
+}
+
+TEST_CASE(LightBinnerMatchesReference)
+{
+    for (uint32_t seed = 1; seed <= 4; seed++)
+    {
+        const ClusteredLightingFixtures::TestScene scene = ClusteredLightingFixtures::MakeTestScene(1024, seed);
+        CheckMatchesReference(scene, nullptr);
+    }
+}
+
+TEST_CASE(LightBinnerMatchesReferenceOnJobSystem)
+{
+    JobSystem jobs(3);
+    for (uint32_t seed = 1; seed <= 4; seed++)
+    {
+        const ClusteredLightingFixtures::TestScene scene = ClusteredLightingFixtures::MakeTestScene(1024, seed);
+        CheckMatchesReference(scene, &jobs);
+    }
+}
+
+TEST_CASE(LightBinnerMatchesReferenceOnOddGrids)
+{
+    // Tile counts that do not divide evenly, and light counts that leave the
+    // SIMD candidate lists padded.
+    JobSystem jobs(2);
+    for (uint32_t lights = 0; lights <= 9; lights++)
+    {
+        ClusteredLightingFixtures::TestScene scene = ClusteredLightingFixtures::MakeTestScene(lights * 7, lights + 1);
+        scene.grid.tilesX = 7;
+        scene.grid.tilesY = 5;
+        scene.grid.slices = 11;
+        scene.grid.aspect = 1.0f;
+        CheckMatchesReference(scene, lights % 2 ? &jobs : nullptr);
+    }
+}
+
+TEST_CASE(LightBinnerWithoutLightsLeavesEveryClusterEmpty)
+{
+    const ClusteredLightingFixtures::TestScene scene = ClusteredLightingFixtures::MakeTestScene(0, 1);
+    LightBinner binner;
+    binner.SetGrid(scene.grid);
+    binner.Bin(scene.view, nullptr, 0, nullptr);
+    CHECK(binner.ClusterCount() == scene.grid.tilesX * scene.grid.tilesY * scene.grid.slices);
+    CHECK(binner.LightIndices().empty());
+    for (const LightCluster& cluster : binner.Clusters())
+    {
+        CHECK(cluster.count == 0);
+    }
+}
+
+TEST_CASE(LightBinnerRejectsBadGrids)
+{
+    LightBinner binner;
+    const ClusteredLightingFixtures::TestScene scene = ClusteredLightingFixtures::MakeTestScene(4, 1);
+    CHECK_THROWS(binner.Bin(scene.view, scene.lights.data(), 4, nullptr), std::logic_error);
+
+    ClusteredLighting::GridDesc grid;
+    grid.slices = 0;
+    CHECK_THROWS(binner.SetGrid(grid), std::invalid_argument);
+    grid = ClusteredLighting::GridDesc();
+    grid.farZ = grid.nearZ;
+    CHECK_THROWS(binner.SetGrid(grid), std::invalid_argument);
+}
@@ -0,0 +1,25 @@
+#include "CullingFixtures.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace CullingFixtures
+{
+    float PlaneDistance(const float plane[4], const float center[3])
+    {
+        // Each product goes through its own volatile, so it is rounded before
+        // it is added.
+        volatile float x = plane[0] * center[0];
+        volatile float y = plane[1] * center[1];
+        volatile float z = plane[2] * center[2];
+        volatile float distance = x + y;
+        distance = distance + z;
+        return distance + plane[3];
+    }
+
+    float TouchingRadius(const float planes[6][4], const float center[3], bool hairShort, TestRandom& random)
+    {
+        const float radius = std::max(0.0f, -PlaneDistance(planes[random.Next() % 6], center));
+        return hairShort ? std::nextafter(radius, 0.0f) : radius;
+    }
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include "TestRandom.h"
+
+// Helpers for the culling fixtures, which all place spheres exactly on the
+// planes of a frustum, where a differently rounded test would disagree.
+namespace CullingFixtures
+{
+    // Signed distance from a plane with every product and sum rounded on its
+    // own, as the SIMD lanes and IndirectCull.hlsl's precise arithmetic
+    // compute it, whatever the compiler's contraction settings.
+    float PlaneDistance(const float plane[4], const float center[3]);
+
+    // The radius of a sphere at center that exactly touches one of the six
+    // planes, picked at random, or with hairShort, is a hair short of
+    // touching it: the two sides of the comparison. 0 for a center outside
+    // the plane.
+    float TouchingRadius(const float planes[6][4], const float center[3], bool hairShort, TestRandom& random);
+}
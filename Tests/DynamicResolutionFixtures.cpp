@@ -0,0 +1,93 @@
+#include "DynamicResolutionFixtures.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace DynamicResolutionFixtures
+{
+    SimulationResult Simulate(DynamicResolutionController& controller, const std::vector<float>& fullResolutionMilliseconds, uint32_t latency)
+    {
+        SimulationResult result;
+        const size_t frames = fullResolutionMilliseconds.size();
+        result.scales.resize(frames);
+        result.gpuMilliseconds.resize(frames);
+        for (size_t i = 0; i < frames; i++)
+        {
+            const float scale = controller.Scale();
+            const float milliseconds = fullResolutionMilliseconds[i] * scale * scale;
+            result.scales[i] = scale;
+            result.gpuMilliseconds[i] = milliseconds;
+            if (milliseconds > controller.Settings().budgetMilliseconds)
+            {
+                result.framesOverBudget++;
+            }
+            result.worstMilliseconds = std::max(result.worstMilliseconds, milliseconds);
+
+            controller.Update(i >= latency ? result.gpuMilliseconds[i - latency] : -1.0f);
+        }
+
+        const size_t settledStart = frames - frames / 4;
+        double settled = 0.0;
+        for (size_t i = settledStart; i < frames; i++)
+        {
+            settled += result.gpuMilliseconds[i];
+        }
+        result.settledMilliseconds = frames > settledStart ? static_cast<float>(settled / (frames - settledStart)) : 0.0f;
+        return result;
+    }
+
+    std::vector<float> StepTrace(uint32_t frames, float before, float after, uint32_t stepFrame)
+    {
+        std::vector<float> trace(frames);
+        for (uint32_t i = 0; i < frames; i++)
+        {
+            trace[i] = i < stepFrame ? before : after;
+        }
+        return trace;
+    }
+
+    std::vector<float> NoisyTrace(uint32_t frames, float milliseconds, float noise, uint32_t seed)
+    {
+        std::vector<float> trace(frames);
+        uint32_t state = seed ? seed : 1;
+        for (uint32_t i = 0; i < frames; i++)
+        {
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            const float random = static_cast<float>(state >> 8) / 16777216.0f;
+            trace[i] = milliseconds * (1.0f + noise * (2.0f * random - 1.0f));
+        }
+        return trace;
+    }
+
+    uint32_t SettlingFrames(const SimulationResult& result, uint32_t start, float target, float tolerance)
+    {
+        const uint32_t frames = static_cast<uint32_t>(result.gpuMilliseconds.size());
+        uint32_t settled = start;
+        for (uint32_t i = start; i < frames; i++)
+        {
+            if (std::fabs(result.gpuMilliseconds[i] - target) > tolerance * target)
+            {
+                settled = i + 1;
+            }
+        }
+        return settled - start;
+    }
+
+    float Overshoot(const SimulationResult& result, uint32_t start, float target)
+    {
+        const size_t frames = result.gpuMilliseconds.size();
+        if (start >= frames)
+        {
+            return 0.0f;
+        }
+        const float side = result.gpuMilliseconds[start] > target ? 1.0f : -1.0f;
+        float overshoot = 0.0f;
+        for (size_t i = start; i < frames; i++)
+        {
+            overshoot = std::max(overshoot, side * (target - result.gpuMilliseconds[i]) / target);
+        }
+        return overshoot;
+    }
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <vector>
+#include "DynamicResolution.h"
+
+// Synthetic GPU frame time traces and a model of the render loop for
+// checking DynamicResolutionController.
+namespace DynamicResolutionFixtures
+{
+    struct SimulationResult
+    {
+        std::vector<float> scales;              // Per frame, the scale it was rendered at.
+        std::vector<float> gpuMilliseconds;     // Per frame, its modelled GPU time.
+        uint32_t framesOverBudget = 0;
+        float worstMilliseconds = 0.0f;
+        float settledMilliseconds = 0.0f;       // Mean GPU time over the last quarter of the trace.
+    };
+
+    // Drives controller with a frame time trace. Frame i costs
+    // fullResolutionMilliseconds[i] times the area it is rendered at, and its
+    // time reaches the controller latency frames later, as GPU timestamps of
+    // a pipelined renderer do.
+    SimulationResult Simulate(DynamicResolutionController& controller, const std::vector<float>& fullResolutionMilliseconds, uint32_t latency);
+
+    // Synthetic traces: a load that jumps from before to after at frame
+    // stepFrame, and a steady load with uniform noise of +-noise (relative),
+    // from a fixed seed.
+    std::vector<float> StepTrace(uint32_t frames, float before, float after, uint32_t stepFrame);
+    std::vector<float> NoisyTrace(uint32_t frames, float milliseconds, float noise, uint32_t seed);
+
+    // Frames from frame start until the GPU time enters target +-tolerance
+    // (relative) and stays there to the end of the trace; the number of
+    // frames left when it never does.
+    uint32_t SettlingFrames(const SimulationResult& result, uint32_t start, float target, float tolerance);
+
+    // How far, relative to target, the GPU time swings past target from frame
+    // start on, on the side opposite to where it starts; 0 when it never
+    // crosses.
+    float Overshoot(const SimulationResult& result, uint32_t start, float target);
+}
@@ -0,0 +1,129 @@
+#include "Test.h"
+#include "DynamicResolutionFixtures.h"
+
+#include <cmath>
+#include <string>
+
+namespace
+{
+    const DynamicResolutionSettings Settings;
+
+    // The renderer reads GPU times back this many frames late, depending on
+    // how many frames are in flight.
+    const uint32_t Latencies[] = { 1, 2, 3 };
+
+    std::string Describe(uint32_t latency, float load)
+    {
+        return "latency " + std::to_string(latency) + ", " + std::to_string(load) + " ms";
+    }
+}
+
+TEST_CASE(DynamicResolutionSettlesAtBudgetAfterLoadIncrease)
+{
+    // From 10 ms, under budget at full scale, to loads that need the area cut
+    // to between 78% and 35%.
+    const uint32_t step = 60;
+    for (uint32_t latency : Latencies)
+    {
+        for (float load : { 18.0f, 24.0f, 40.0f })
+        {
+            DynamicResolutionController controller(Settings);
+            const DynamicResolutionFixtures::SimulationResult result =
+                DynamicResolutionFixtures::Simulate(controller, DynamicResolutionFixtures::StepTrace(240, 10.0f, load, step), latency);
+            const std::string context = Describe(latency, load);
+            CHECK_MESSAGE(result.scales[step] == Settings.maxScale, context);
+            CHECK_MESSAGE(DynamicResolutionFixtures::SettlingFrames(result, step, Settings.budgetMilliseconds, 0.05f) <= 20, context);
+            CHECK_MESSAGE(DynamicResolutionFixtures::Overshoot(result, step, Settings.budgetMilliseconds) <= 0.2f, context);
+            CHECK_MESSAGE(std::fabs(result.settledMilliseconds - Settings.budgetMilliseconds) < 0.01f * Settings.budgetMilliseconds, context);
+        }
+    }
+}
+
+TEST_CASE(DynamicResolutionReturnsToFullScaleAfterLoadDrop)
+{
+    const uint32_t step = 120;
+    for (uint32_t latency : Latencies)
+    {
+        for (float load : { 18.0f, 24.0f, 40.0f })
+        {
+            DynamicResolutionController controller(Settings);
+            const DynamicResolutionFixtures::SimulationResult result =
+                DynamicResolutionFixtures::Simulate(controller, DynamicResolutionFixtures::StepTrace(240, load, 10.0f, step), latency);
+            const std::string context = Describe(latency, load);
+            CHECK_MESSAGE(DynamicResolutionFixtures::SettlingFrames(result, step, 10.0f, 0.05f) <= 20, context);
+            CHECK_MESSAGE(result.scales.back() == Settings.maxScale, context);
+
+            // Growing back must not push a frame over the budget.
+            for (size_t i = step; i < result.gpuMilliseconds.size(); i++)
+            {
+                CHECK_MESSAGE(result.gpuMilliseconds[i] <= Settings.budgetMilliseconds, context);
+            }
+        }
+    }
+}
+
+TEST_CASE(DynamicResolutionStopsAtMinimumScale)
+{
+    // 60 ms at full scale is still 15 ms at half scale.
+    for (uint32_t latency : Latencies)
+    {
+        DynamicResolutionController controller(Settings);
+        const DynamicResolutionFixtures::SimulationResult result =
+            DynamicResolutionFixtures::Simulate(controller, DynamicResolutionFixtures::StepTrace(120, 10.0f, 60.0f, 20), latency);
+        for (float scale : result.scales)
+        {
+            CHECK(scale >= Settings.minScale && scale <= Settings.maxScale);
+        }
+        CHECK(result.scales.back() == Settings.minScale);
+        CHECK(std::fabs(result.settledMilliseconds - 15.0f) < 1e-3f);
+    }
+}
+
+TEST_CASE(DynamicResolutionHoldsScaleSteadyUnderNoise)
+{
+    // Frame to frame noise of +-10% should move the scale little, and the
+    // mean GPU time should stay at the budget.
+    const uint32_t frames = 600, warmup = 60;
+    for (uint32_t latency : Latencies)
+    {
+        for (uint32_t seed = 1; seed <= 3; seed++)
+        {
+            const std::vector<float> trace = DynamicResolutionFixtures::NoisyTrace(frames, 20.0f, 0.1f, seed);
+            CHECK(trace == DynamicResolutionFixtures::NoisyTrace(frames, 20.0f, 0.1f, seed));
+            for (float milliseconds : trace)
+            {
+                CHECK(milliseconds >= 18.0f && milliseconds <= 22.0f);
+            }
+
+            DynamicResolutionController controller(Settings);
+            const DynamicResolutionFixtures::SimulationResult result = DynamicResolutionFixtures::Simulate(controller, trace, latency);
+            const std::string context = "latency " + std::to_string(latency) + ", seed " + std::to_string(seed);
+            CHECK_MESSAGE(std::fabs(result.settledMilliseconds - Settings.budgetMilliseconds) < 0.01f * Settings.budgetMilliseconds, context);
+
+            double sum = 0.0, sumSquares = 0.0;
+            for (uint32_t i = warmup; i < frames; i++)
+            {
+                sum += result.scales[i];
+                sumSquares += result.scales[i] * result.scales[i];
+                CHECK_MESSAGE(result.gpuMilliseconds[i] <= 1.2f * Settings.budgetMilliseconds, context);
+            }
+            const double mean = sum / (frames - warmup);
+            CHECK_MESSAGE(std::sqrt(sumSquares / (frames - warmup) - mean * mean) < 0.02, context);
+        }
+    }
+}
+
+TEST_CASE(DynamicResolutionIgnoresMissingTimes)
+{
+    DynamicResolutionController controller(Settings);
+    controller.Update(28.0f);
+    const float scale = controller.Scale();
+    CHECK(scale < Settings.maxScale);
+    CHECK(controller.Update(-1.0f) == scale);
+
+    uint32_t width, height;
+    DynamicResolutionController::ScaledSize(1280, 720, 0.5f, width, height);
+    CHECK(width == 640 && height == 360);
+    DynamicResolutionController::ScaledSize(1280, 720, 0.0f, width, height);
+    CHECK(width == 1 && height == 1);
+}
@@ -0,0 +1,401 @@
+#include "Test.h"
+#include "FrameGraph.h"
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace
+{
+    FrameGraphTextureDesc MakeDesc(uint32_t width, uint32_t height)
+    {
+        FrameGraphTextureDesc desc;
+        desc.width = width;
+        desc.height = height;
+        return desc;
+    }
+
+    std::vector<std::string> ScheduledNames(const FrameGraph& graph)
+    {
+        std::vector<std::string> names;
+        for (uint32_t pass : graph.Schedule())
+        {
+            names.push_back(graph.PassName(pass));
+        }
+        return names;
+    }
+
+    bool HasBarrier(const std::vector<ResourceBarrierDesc>& barriers, ResourceBarrierDesc::Type type, ResourceBarrierDesc::Split split,
+        FrameGraphResource resource, ResourceStates before, ResourceStates after)
+    {
+        for (const ResourceBarrierDesc& barrier : barriers)
+        {
+            if (barrier.type == type && barrier.resource == resource &&
+                (type != ResourceBarrierDesc::Type::Transition || (barrier.split == split && barrier.before == before && barrier.after == after)))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool HasTransition(const std::vector<ResourceBarrierDesc>& barriers, FrameGraphResource resource, ResourceStates before, ResourceStates after,
+        ResourceBarrierDesc::Split split = ResourceBarrierDesc::Split::None)
+    {
+        return HasBarrier(barriers, ResourceBarrierDesc::Type::Transition, split, resource, before, after);
+    }
+
+    // Transients alive during a common pass must not share memory.
+    bool PlacementsAreDisjoint(const FrameGraph& graph, std::string& message)
+    {
+        for (FrameGraphResource a = 0; a < graph.ResourceCount(); a++)
+        {
+            const FrameGraph::ResourceInfo& lhs = graph.Resource(a);
+            if (lhs.imported || !lhs.used)
+            {
+                continue;
+            }
+            if (lhs.heapOffset + lhs.size > graph.HeapSize())
+            {
+                message = lhs.name + " ends past the heap";
+                return false;
+            }
+            for (FrameGraphResource b = a + 1; b < graph.ResourceCount(); b++)
+            {
+                const FrameGraph::ResourceInfo& rhs = graph.Resource(b);
+                const bool alive = !rhs.imported && rhs.used && lhs.firstPass <= rhs.lastPass && rhs.firstPass <= lhs.lastPass;
+                if (alive && lhs.heapOffset < rhs.heapOffset + rhs.size && rhs.heapOffset < lhs.heapOffset + lhs.size)
+                {
+                    message = lhs.name + " and " + rhs.name + " are alive together in the same memory";
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+}
+
+TEST_CASE(FrameGraphCullsPassesNothingUses)
+{
+    FrameGraph graph;
+    const FrameGraphResource backBuffer = graph.Import("BackBuffer", ResourceState::Present, ResourceState::Present);
+    FrameGraphResource shadows = FrameGraph::InvalidResource;
+    FrameGraphResource debug = FrameGraph::InvalidResource;
+    FrameGraphResource debugInput = FrameGraph::InvalidResource;
+
+    graph.AddPass("Unused", [&](FrameGraph::Builder& builder)
+    {
+        builder.Write(builder.Create("Scratch", MakeDesc(64, 64)), ResourceState::RenderTarget);
+    }, nullptr);
+    graph.AddPass("Shadows", [&](FrameGraph::Builder& builder)
+    {
+        shadows = builder.Create("Shadows", MakeDesc(1024, 1024));
+        builder.Write(shadows, ResourceState::DepthWrite);
+    }, nullptr);
+    graph.AddPass("DebugInput", [&](FrameGraph::Builder& builder)
+    {
+        debugInput = builder.Create("DebugInput", MakeDesc(64, 64));
+        builder.Write(debugInput, ResourceState::RenderTarget);
+    }, nullptr);
+    graph.AddPass("Debug", [&](FrameGraph::Builder& builder)
+    {
+        // Nothing reads what it writes, so it goes, and takes DebugInput
+        // with it.
+        builder.Read(debugInput, ResourceState::PixelShaderResource);
+        builder.Read(shadows, ResourceState::PixelShaderResource);
+        debug = builder.Create("Debug", MakeDesc(64, 64));
+        builder.Write(debug, ResourceState::RenderTarget);
+    }, nullptr);
+    graph.AddPass("Scene", [&](FrameGraph::Builder& builder)
+    {
+        builder.Read(shadows, ResourceState::PixelShaderResource);
+        builder.Write(backBuffer, ResourceState::RenderTarget);
+    }, nullptr);
+    graph.AddPass("Capture", [&](FrameGraph::Builder& builder)
+    {
+        builder.SideEffect();
+    }, nullptr);
+    graph.Compile();
+
+    const std::vector<std::string> expected = { "Shadows", "Scene", "Capture" };
+    CHECK(ScheduledNames(graph) == expected);
+    CHECK(graph.GetStats().passes == 3);
+    CHECK(graph.GetStats().culledPasses == 3);
+
+    CHECK(graph.Resource(shadows).used);
+    CHECK(!graph.Resource(debug).used);
+    CHECK(!graph.Resource(debugInput).used);
+    CHECK(graph.GetStats().transientResources == 1);
+
+    // Recompiling after a reset starts from an empty graph.
+    graph.Reset();
+    graph.Compile();
+    CHECK(graph.Schedule().empty());
+    CHECK(graph.ResourceCount() == 0);
+    CHECK(graph.HeapSize() == 0);
+}
+
+TEST_CASE(FrameGraphSchedulesInDeclarationOrderAndExecutesIt)
+{
+    FrameGraph graph;
+    const FrameGraphResource backBuffer = graph.Import("BackBuffer", ResourceState::Present, ResourceState::Present);
+    FrameGraphResource color = FrameGraph::InvalidResource;
+    std::vector<uint32_t> executed;
+    std::vector<size_t> barrierCounts;
+    const FrameGraph::ExecuteCallback record = [&](const FrameGraph::PassContext& context)
+    {
+        executed.push_back(context.pass);
+        barrierCounts.push_back(context.barrierCount);
+    };
+
+    const uint32_t scene = graph.AddPass("Scene", [&](FrameGraph::Builder& builder)
+    {
+        color = builder.Create("SceneColor", MakeDesc(1280, 720));
+        builder.Write(color, ResourceState::RenderTarget);
+    }, record);
+    graph.AddPass("Culled", [&](FrameGraph::Builder& builder)
+    {
+        builder.Read(color, ResourceState::PixelShaderResource);
+    }, record);
+    const uint32_t upscale = graph.AddPass("Upscale", [&](FrameGraph::Builder& builder)
+    {
+        builder.Read(color, ResourceState::PixelShaderResource);
+        builder.Write(backBuffer, ResourceState::RenderTarget);
+    }, record);
+    const uint32_t ui = graph.AddPass("UI", [&](FrameGraph::Builder& builder)
+    {
+        builder.Write(backBuffer, ResourceState::RenderTarget);
+    }, record);
+    graph.Compile();
+
+    const std::vector<uint32_t> schedule = { scene, upscale, ui };
+    CHECK(graph.Schedule() == schedule);
+
+    // Lifetimes are schedule indices, not pass indices.
+    CHECK(graph.Resource(color).firstPass == 0);
+    CHECK(graph.Resource(color).lastPass == 1);
+    CHECK(graph.Resource(color).restState == ResourceState::RenderTarget);
+    CHECK(graph.Resource(color).usage == (ResourceState::RenderTarget | ResourceState::PixelShaderResource));
+    CHECK(graph.Resource(backBuffer).firstPass == 1);
+    CHECK(graph.Resource(backBuffer).lastPass == 2);
+
+    graph.Execute();
+    CHECK(executed == schedule);
+    for (uint32_t i = 0; i < barrierCounts.size(); i++)
+    {
+        CHECK(barrierCounts[i] == graph.PassBarriers(i).size());
+    }
+}
+
+TEST_CASE(FrameGraphInfersBarriers)
+{
+    FrameGraph graph;
+    const FrameGraphResource backBuffer = graph.Import("BackBuffer", ResourceState::Present, ResourceState::Present);
+    FrameGraphResource color = FrameGraph::InvalidResource;
+    FrameGraphResource depth = FrameGraph::InvalidResource;
+    FrameGraphResource particles = FrameGraph::InvalidResource;
+
+    graph.AddPass("Simulate", [&](FrameGraph::Builder& builder)
+    {
+        particles = builder.Create("Particles", MakeDesc(4096, 1));
+        builder.Write(particles, ResourceState::UnorderedAccess);
+    }, nullptr);
+    graph.AddPass("Integrate", [&](FrameGraph::Builder& builder)
+    {
+        builder.Write(particles, ResourceState::UnorderedAccess);
+    }, nullptr);
+    graph.AddPass("GBuffer", [&](FrameGraph::Builder& builder)
+    {
+        color = builder.Create("Color", MakeDesc(1280, 720));
+        depth = builder.Create("Depth", MakeDesc(1280, 720));
+        builder.Read(particles, ResourceState::NonPixelShaderResource);
+        builder.Write(color, ResourceState::RenderTarget);
+        builder.Write(depth, ResourceState::DepthWrite);
+    }, nullptr);
+    graph.AddPass("Lighting", [&](FrameGraph::Builder& builder)
+    {
+        builder.Read(color, ResourceState::PixelShaderResource);
+        builder.Read(depth, ResourceState::DepthRead);
+        builder.Write(backBuffer, ResourceState::RenderTarget);
+    }, nullptr);
+    graph.AddPass("UI", [&](FrameGraph::Builder& builder)
+    {
+        builder.Write(backBuffer, ResourceState::RenderTarget);
+    }, nullptr);
+    graph.Compile();
+    CHECK(graph.Schedule().size() == 5);
+
+    // Transients start in the state of their first use: nothing to do.
+    CHECK(graph.PassBarriers(0).empty());
+
+    // Back to back unordered access writes wait for each other.
+    CHECK(graph.PassBarriers(1).size() == 1);
+    CHECK(HasBarrier(graph.PassBarriers(1), ResourceBarrierDesc::Type::UnorderedAccess, ResourceBarrierDesc::Split::None, particles, 0, 0));
+
+    CHECK(HasTransition(graph.PassBarriers(2), particles, ResourceState::UnorderedAccess, ResourceState::NonPixelShaderResource));
+
+    const std::vector<ResourceBarrierDesc>& lighting = graph.PassBarriers(3);
+    CHECK(HasTransition(lighting, color, ResourceState::RenderTarget, ResourceState::PixelShaderResource));
+    CHECK(HasTransition(lighting, depth, ResourceState::DepthWrite, ResourceState::DepthRead));
+    CHECK(HasTransition(lighting, backBuffer, ResourceState::Present, ResourceState::RenderTarget));
+
+    // Nothing shares their memory, so once done the transients start back to
+    // their rest state while UI runs and finish at the end of the frame.
+    const std::vector<ResourceBarrierDesc>& ui = graph.PassBarriers(4);
+    CHECK(HasTransition(ui, color, ResourceState::PixelShaderResource, ResourceState::RenderTarget, ResourceBarrierDesc::Split::BeginOnly));
+    CHECK(HasTransition(ui, depth, ResourceState::DepthRead, ResourceState::DepthWrite, ResourceBarrierDesc::Split::BeginOnly));
+
+    const std::vector<ResourceBarrierDesc>& final = graph.FinalBarriers();
+    CHECK(HasTransition(final, backBuffer, ResourceState::RenderTarget, ResourceState::Present));
+    CHECK(HasTransition(final, color, ResourceState::PixelShaderResource, ResourceState::RenderTarget, ResourceBarrierDesc::Split::EndOnly));
+    CHECK(HasTransition(final, depth, ResourceState::DepthRead, ResourceState::DepthWrite, ResourceBarrierDesc::Split::EndOnly));
+
+    size_t total = final.size();
+    for (uint32_t i = 0; i < graph.Schedule().size(); i++)
+    {
+        total += graph.PassBarriers(i).size();
+    }
+    CHECK(graph.GetStats().barriers == total);
+    CHECK(graph.GetStats().aliasingBarriers == 0);
+}
+
+TEST_CASE(FrameGraphAliasesTransientsByLifetime)
+{
+    // A blur chain: each target is read by the next pass only, so the first
+    // and the last can share memory while the middle one overlaps both.
+    FrameGraph graph;
+    const FrameGraphResource backBuffer = graph.Import("BackBuffer", ResourceState::Present, ResourceState::Present);
+    FrameGraphResource targets[3] = { FrameGraph::InvalidResource, FrameGraph::InvalidResource, FrameGraph::InvalidResource };
+    const char* names[3] = { "BlurH", "BlurV", "Tonemap" };
+    for (int i = 0; i < 3; i++)
+    {
+        graph.AddPass(names[i], [&](FrameGraph::Builder& builder)
+        {
+            if (i > 0)
+            {
+                builder.Read(targets[i - 1], ResourceState::PixelShaderResource);
+            }
+            targets[i] = builder.Create(names[i], MakeDesc(1280, 720));
+            builder.Write(targets[i], ResourceState::RenderTarget);
+        }, nullptr);
+    }
+    graph.AddPass("Present", [&](FrameGraph::Builder& builder)
+    {
+        builder.Read(targets[2], ResourceState::PixelShaderResource);
+        builder.Write(backBuffer, ResourceState::RenderTarget);
+    }, nullptr);
+    graph.Compile();
+
+    // 1280 * 720 * 4 bytes, rounded up to 64KB.
+    const uint64_t size = 3735552;
+    for (FrameGraphResource target : targets)
+    {
+        CHECK(graph.Resource(target).size == size);
+        CHECK(graph.Resource(target).heapOffset % (64 * 1024) == 0);
+    }
+    CHECK(graph.Resource(targets[0]).heapOffset == graph.Resource(targets[2]).heapOffset);
+    CHECK(graph.Resource(targets[1]).heapOffset != graph.Resource(targets[0]).heapOffset);
+    std::string message;
+    CHECK_MESSAGE(PlacementsAreDisjoint(graph, message), message);
+
+    const FrameGraph::Stats& stats = graph.GetStats();
+    CHECK(stats.transientResources == 3);
+    CHECK(stats.unaliasedBytes == 3 * size);
+    CHECK(stats.heapBytes == 2 * size);
+    CHECK(graph.HeapSize() == 2 * size);
+    CHECK(stats.SavedBytes() == size);
+
+    // Whatever takes over shared memory gets an aliasing barrier before its
+    // first pass, and the memory's previous occupant leaves its rest state
+    // with a whole transition instead of a split one.
+    CHECK(stats.aliasingBarriers == 2);
+    CHECK(HasBarrier(graph.PassBarriers(0), ResourceBarrierDesc::Type::Aliasing, ResourceBarrierDesc::Split::None, targets[0], 0, 0));
+    CHECK(!HasBarrier(graph.PassBarriers(1), ResourceBarrierDesc::Type::Aliasing, ResourceBarrierDesc::Split::None, targets[1], 0, 0));
+    CHECK(HasBarrier(graph.PassBarriers(2), ResourceBarrierDesc::Type::Aliasing, ResourceBarrierDesc::Split::None, targets[2], 0, 0));
+    CHECK(HasTransition(graph.PassBarriers(2), targets[0], ResourceState::PixelShaderResource, ResourceState::RenderTarget));
+}
+
+TEST_CASE(FrameGraphPlacesWithTheMemoryQuery)
+{
+    // Many short lived targets of mixed sizes and alignments, as a backend
+    // reports them.
+    FrameGraph graph;
+    const FrameGraphResource backBuffer = graph.Import("BackBuffer", ResourceState::Present, ResourceState::Present);
+    const uint32_t count = 24;
+    std::vector<FrameGraphResource> targets(count);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        graph.AddPass("Pass", [&](FrameGraph::Builder& builder)
+        {
+            // Each pass reads the two targets before it, so three are alive
+            // at a time.
+            for (uint32_t back = 1; back <= 2 && back <= i; back++)
+            {
+                builder.Read(targets[i - back], ResourceState::PixelShaderResource);
+            }
+            targets[i] = builder.Create("Target", MakeDesc(64 << (i % 5), 64 << (i % 3)));
+            builder.Write(targets[i], i % 4 == 0 ? ResourceState::UnorderedAccess : ResourceState::RenderTarget);
+        }, nullptr);
+    }
+    graph.AddPass("Present", [&](FrameGraph::Builder& builder)
+    {
+        builder.Read(targets[count - 2], ResourceState::PixelShaderResource);
+        builder.Read(targets[count - 1], ResourceState::PixelShaderResource);
+        builder.Write(backBuffer, ResourceState::RenderTarget);
+    }, nullptr);
+
+    uint32_t queries = 0;
+    graph.Compile([&](const FrameGraphTextureDesc& desc, ResourceStates usage)
+    {
+        queries++;
+        CHECK((usage & ResourceState::PixelShaderResource) != 0);
+        const uint64_t alignment = (usage & ResourceState::UnorderedAccess) != 0 ? 4 * 1024 * 1024 : 64 * 1024;
+        const FrameGraphMemoryInfo info = { static_cast<uint64_t>(desc.width) * desc.height * 4 + 1000, alignment };
+        return info;
+    });
+    CHECK(queries == count);
+
+    std::string message;
+    CHECK_MESSAGE(PlacementsAreDisjoint(graph, message), message);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        const FrameGraph::ResourceInfo& target = graph.Resource(targets[i]);
+        CHECK(target.size == static_cast<uint64_t>(target.desc.width) * target.desc.height * 4 + 1000);
+        CHECK(target.heapOffset % (i % 4 == 0 ? 4 * 1024 * 1024 : 64 * 1024) == 0);
+    }
+    const FrameGraph::Stats& stats = graph.GetStats();
+    CHECK(stats.heapBytes < stats.unaliasedBytes / 2);
+    CHECK(stats.SavedBytes() == stats.unaliasedBytes - stats.heapBytes);
+}
+
+TEST_CASE(FrameGraphRejectsMalformedGraphs)
+{
+    FrameGraph graph;
+    CHECK_THROWS(graph.AddPass("Unknown", [](FrameGraph::Builder& builder) { builder.Read(7, ResourceState::PixelShaderResource); }, nullptr),
+        std::logic_error);
+
+    graph.Reset();
+    CHECK_THROWS(graph.AddPass("TwoWrites", [](FrameGraph::Builder& builder)
+    {
+        const FrameGraphResource target = builder.Create("Target", MakeDesc(64, 64));
+        builder.Write(target, ResourceState::RenderTarget);
+        builder.Write(target, ResourceState::UnorderedAccess);
+    }, nullptr), std::logic_error);
+
+    graph.Reset();
+    CHECK_THROWS(graph.AddPass("TwoReads", [](FrameGraph::Builder& builder)
+    {
+        const FrameGraphResource target = builder.Create("Target", MakeDesc(64, 64));
+        builder.Read(target, ResourceState::PixelShaderResource);
+        builder.Read(target, ResourceState::UnorderedAccess);
+    }, nullptr), std::logic_error);
+
+    // Reading a transient nothing wrote first.
+    graph.Reset();
+    graph.AddPass("ReadFirst", [](FrameGraph::Builder& builder)
+    {
+        builder.Read(builder.Create("Target", MakeDesc(64, 64)), ResourceState::PixelShaderResource);
+        builder.SideEffect();
+    }, nullptr);
+    CHECK_THROWS(graph.Compile(), std::logic_error);
+}
@@ -0,0 +1,94 @@
+#include "Test.h"
+#include "FramePacer.h"
+
+#include <vector>
+
+namespace
+{
+    // A fence whose GPU completes signals only when told to; waiting runs it
+    // up to the value waited for.
+    class MockFenceQueue : public IFenceQueue
+    {
+    public:
+        std::vector<uint64_t> signals;
+        std::vector<uint64_t> waits;
+        uint64_t completed = 0;
+
+        void Signal(uint64_t value) override { signals.push_back(value); }
+        uint64_t CompletedValue() override { return completed; }
+
+        void WaitForValue(uint64_t value) override
+        {
+            waits.push_back(value);
+            CHECK(!signals.empty() && value <= signals.back());
+            completed = value > completed ? value : completed;
+        }
+    };
+}
+
+TEST_CASE(FramePacerWaitsOnlyForPendingSlots)
+{
+    MockFenceQueue queue;
+    FramePacer pacer(queue, 3);
+    CHECK(pacer.FramesInFlight() == 3);
+    CHECK(pacer.CurrentFenceValue() == 1);
+
+    // The first frames move into unused slots.
+    CHECK(!pacer.EndFrame(1));
+    CHECK(!pacer.EndFrame(2));
+    CHECK(queue.signals == std::vector<uint64_t>({ 1, 2 }));
+    CHECK(pacer.SlotFenceValue(0) == 1);
+    CHECK(pacer.SlotFenceValue(1) == 2);
+    CHECK(pacer.FrameSlot() == 2);
+
+    // Slot 0 still holds frame 1, which the GPU has not finished.
+    CHECK(pacer.EndFrame(0));
+    CHECK(queue.waits == std::vector<uint64_t>({ 1 }));
+    CHECK(pacer.FrameSlot() == 0);
+
+    // Frame 2 is done by the time slot 1 comes around again.
+    queue.completed = 2;
+    CHECK(!pacer.EndFrame(1));
+    CHECK(queue.waits.size() == 1);
+
+    // The slot wraps; a frame that completed late still counts.
+    CHECK(pacer.EndFrame(5));
+    CHECK(pacer.FrameSlot() == 2);
+    CHECK(queue.waits.back() == 3);
+    CHECK(pacer.CurrentFenceValue() == 6);
+    CHECK(pacer.CompletedFenceValue() == 3);
+}
+
+TEST_CASE(FramePacerWaitForIdleRetiresEverySlot)
+{
+    MockFenceQueue queue;
+    FramePacer pacer(queue, 2);
+    pacer.EndFrame(1);
+    queue.completed = 1;
+    pacer.EndFrame(0);
+
+    pacer.WaitForIdle();
+    CHECK(queue.signals.back() == 3);
+    CHECK(queue.waits.back() == 3);
+    CHECK(pacer.CompletedFenceValue() == 3);
+    CHECK(pacer.SlotFenceValue(0) == 3);
+    CHECK(pacer.SlotFenceValue(1) == 3);
+
+    // Nothing is pending afterwards, so the next frame does not wait.
+    const size_t waits = queue.waits.size();
+    CHECK(!pacer.EndFrame(1));
+    CHECK(queue.waits.size() == waits);
+    CHECK(pacer.CurrentFenceValue() == 5);
+}
+
+TEST_CASE(FramePacerKeepsAtLeastOneSlot)
+{
+    MockFenceQueue queue;
+    FramePacer pacer(queue, 0);
+    CHECK(pacer.FramesInFlight() == 1);
+
+    // With one slot every frame waits for the one before it.
+    CHECK(pacer.EndFrame(0));
+    CHECK(pacer.EndFrame(7));
+    CHECK(queue.waits == std::vector<uint64_t>({ 1, 2 }));
+}
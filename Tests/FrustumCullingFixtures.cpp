@@ -0,0 +1,140 @@
+#include "FrustumCullingFixtures.h"
+#include "CullingFixtures.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <sstream>
+
+namespace
+{
+    // The engine's projection, 60 degrees vertically at 16:9 from 0.1 to
+    // 100, right-handed, looking down -z from the origin.
+    void TestProjection(float projection[4][4])
+    {
+        const float nearZ = 0.1f;
+        const float farZ = 100.0f;
+        const float yScale = 1.0f / std::tan(3.14159265f / 6.0f);
+        std::memset(projection, 0, sizeof(float) * 16);
+        projection[0][0] = yScale * 9.0f / 16.0f;
+        projection[1][1] = yScale;
+        projection[2][2] = farZ / (nearZ - farZ);
+        projection[2][3] = -1.0f;
+        projection[3][2] = nearZ * farZ / (nearZ - farZ);
+    }
+}
+
+namespace FrustumCullingFixtures
+{
+    TestScene MakeTestScene(uint32_t count, uint32_t seed)
+    {
+        float projection[4][4];
+        TestProjection(projection);
+
+        TestScene scene;
+        scene.frustum = Frustum::FromViewProjection(projection);
+        scene.bounds.Reserve(count);
+
+        TestRandom random(seed);
+        for (uint32_t i = 0; i < count; i++)
+        {
+            const float center[3] = { random.Range(-150.0f, 150.0f), random.Range(-100.0f, 100.0f), random.Range(-130.0f, 20.0f) };
+            const float extents[3] = { random.Range(0.0f, 5.0f), random.Range(0.0f, 5.0f), random.Range(0.0f, 5.0f) };
+            float radius = 0.0f;
+            switch (i % 4)
+            {
+            case 0:
+                radius = std::sqrt(extents[0] * extents[0] + extents[1] * extents[1] + extents[2] * extents[2]);
+                break;
+            case 1:
+                break;
+            default:
+                radius = CullingFixtures::TouchingRadius(scene.frustum.planes, center, i % 4 == 3, random);
+                break;
+            }
+            scene.bounds.Add(center, extents, radius);
+        }
+        return scene;
+    }
+
+    std::vector<Frustum> MakeTestViews(uint32_t viewCount, uint32_t seed)
+    {
+        float projection[4][4];
+        TestProjection(projection);
+
+        std::vector<Frustum> views;
+        TestRandom random(seed);
+        for (uint32_t v = 0; v < viewCount; v++)
+        {
+            // World to view: move the eye to the origin, then turn by the
+            // heading about y.
+            const float eye[3] = { random.Range(-20.0f, 20.0f), random.Range(-5.0f, 5.0f), random.Range(-40.0f, 0.0f) };
+            const float heading = random.Range(-3.14159265f, 3.14159265f);
+            const float c = std::cos(heading);
+            const float s = std::sin(heading);
+            float view[4][4] = {
+                { c, 0.0f, s, 0.0f },
+                { 0.0f, 1.0f, 0.0f, 0.0f },
+                { -s, 0.0f, c, 0.0f },
+                { 0.0f, 0.0f, 0.0f, 1.0f },
+            };
+            for (int column = 0; column < 3; column++)
+            {
+                view[3][column] = -(eye[0] * view[0][column] + eye[1] * view[1][column] + eye[2] * view[2][column]);
+            }
+
+            float viewProjection[4][4];
+            for (int row = 0; row < 4; row++)
+            {
+                for (int column = 0; column < 4; column++)
+                {
+                    viewProjection[row][column] = 0.0f;
+                    for (int k = 0; k < 4; k++)
+                    {
+                        viewProjection[row][column] += view[row][k] * projection[k][column];
+                    }
+                }
+            }
+            views.push_back(Frustum::FromViewProjection(viewProjection));
+        }
+        return views;
+    }
+
+    bool Compare(const uint32_t* expected, uint32_t expectedCount, const uint32_t* actual, uint32_t actualCount, std::string& message)
+    {
+        const uint32_t count = std::min(expectedCount, actualCount);
+        for (uint32_t i = 0; i < count; i++)
+        {
+            if (expected[i] != actual[i])
+            {
+                std::ostringstream stream;
+                stream << "visible entry " << i << " is " << actual[i] << ", expected " << expected[i];
+                message = stream.str();
+                return false;
+            }
+        }
+        if (expectedCount != actualCount)
+        {
+            std::ostringstream stream;
+            stream << actualCount << " visible, expected " << expectedCount;
+            message = stream.str();
+            return false;
+        }
+        return true;
+    }
+
+    bool CompareViewMasks(const uint16_t* expected, const uint16_t* actual, uint32_t count, std::string& message)
+    {
+        for (uint32_t i = 0; i < count; i++)
+        {
+            if (expected[i] != actual[i])
+            {
+                std::ostringstream stream;
+                stream << "volume " << i << " has view mask 0x" << std::hex << actual[i] << ", expected 0x" << expected[i];
+                message = stream.str();
+                return false;
+            }
+        }
+        return true;
+    }
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "FrustumCulling.h"
+
+// Scenes and comparisons for checking FrustumCuller against
+// FrustumCulling::CullReference, shared by the tests and the benchmarks.
+namespace FrustumCullingFixtures
+{
+    // Random spheres and boxes around a frustum, plus spheres placed exactly
+    // on its planes (see CullingFixtures::TouchingRadius).
+    struct TestScene
+    {
+        Frustum frustum;
+        CullingBounds bounds;
+    };
+    TestScene MakeTestScene(uint32_t count, uint32_t seed);
+
+    // The test scene's projection, seen from viewCount random positions and
+    // headings around its origin.
+    std::vector<Frustum> MakeTestViews(uint32_t viewCount, uint32_t seed);
+
+    // Compares two lists of visible indices. On a mismatch, returns false and
+    // describes the first difference in message.
+    bool Compare(const uint32_t* expected, uint32_t expectedCount, const uint32_t* actual, uint32_t actualCount, std::string& message);
+    bool CompareViewMasks(const uint16_t* expected, const uint16_t* actual, uint32_t count, std::string& message);
+}
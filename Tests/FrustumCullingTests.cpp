@@ -0,0 +1,149 @@
+#include "Test.h"
+#include "CullingFixtures.h"
+#include "FrustumCullingFixtures.h"
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+
+namespace
+{
+    const FrustumCulling::Shape Shapes[] = { FrustumCulling::Shape::Sphere, FrustumCulling::Shape::Box };
+}
+
+TEST_CASE(FrustumCullMatchesReferenceOnUnalignedRanges)
+{
+    // Ranges that start and end inside a group of 8 take the scalar path at
+    // both ends.
+    const FrustumCullingFixtures::TestScene scene = FrustumCullingFixtures::MakeTestScene(4099, 1);
+    const uint32_t ranges[][2] = { { 0, 4099 }, { 3, 4096 }, { 5, 6 }, { 13, 29 }, { 4098, 4099 } };
+    std::vector<uint32_t> expected(4099), actual(4099 + 7);
+    for (FrustumCulling::Shape shape : Shapes)
+    {
+        for (const uint32_t* range : ranges)
+        {
+            const uint32_t expectedCount = FrustumCulling::CullReference(scene.frustum, scene.bounds, shape, range[0], range[1], expected.data());
+            const uint32_t actualCount = FrustumCulling::Cull(scene.frustum, scene.bounds, shape, range[0], range[1], actual.data());
+            std::string mismatch;
+            CHECK_MESSAGE(FrustumCullingFixtures::Compare(expected.data(), expectedCount, actual.data(), actualCount, mismatch), mismatch);
+        }
+    }
+}
+
+TEST_CASE(FrustumCullRoundsEveryStep)
+{
+    // Spheres that touch a plane by the rounding of each step stay visible,
+    // and a hair less does not. With fused multiply-adds the distances round
+    // differently and some of these flip, in Cull and CullReference alike.
+    const FrustumCullingFixtures::TestScene scene = FrustumCullingFixtures::MakeTestScene(4096, 7);
+    const CullingBounds& source = scene.bounds;
+    const float extents[3] = {};
+    for (uint32_t p = 0; p < 6; p++)
+    {
+        // Only plane p; the others pass everything.
+        Frustum frustum = {};
+        for (float* plane : frustum.planes)
+        {
+            plane[3] = 1.0f;
+        }
+        std::copy(scene.frustum.planes[p], scene.frustum.planes[p] + 4, frustum.planes[p]);
+
+        CullingBounds bounds;
+        for (uint32_t i = 0; i < source.Count(); i++)
+        {
+            const float center[3] = { source.CenterX()[i], source.CenterY()[i], source.CenterZ()[i] };
+            const float distance = CullingFixtures::PlaneDistance(frustum.planes[p], center);
+            if (distance < 0.0f)
+            {
+                bounds.Add(center, extents, -distance);
+                bounds.Add(center, extents, std::nextafter(-distance, 0.0f));
+            }
+        }
+        CHECK(bounds.Count() > 1000);
+
+        std::vector<uint32_t> expected;
+        for (uint32_t i = 0; i < bounds.Count(); i += 2)
+        {
+            expected.push_back(i);
+        }
+        std::vector<uint32_t> visible(bounds.Count() + 7);
+        std::string mismatch;
+        uint32_t count = FrustumCulling::CullReference(frustum, bounds, FrustumCulling::Shape::Sphere, 0, bounds.Count(), visible.data());
+        CHECK_MESSAGE(FrustumCullingFixtures::Compare(expected.data(), static_cast<uint32_t>(expected.size()), visible.data(), count, mismatch),
+            "plane " + std::to_string(p) + ", reference: " + mismatch);
+        count = FrustumCulling::Cull(frustum, bounds, FrustumCulling::Shape::Sphere, 0, bounds.Count(), visible.data());
+        CHECK_MESSAGE(FrustumCullingFixtures::Compare(expected.data(), static_cast<uint32_t>(expected.size()), visible.data(), count, mismatch),
+            "plane " + std::to_string(p) + ": " + mismatch);
+    }
+}
+
+TEST_CASE(FrustumCullerMatchesReference)
+{
+    // Several chunks, the last one partial, with and without workers.
+    const uint32_t count = 3 * FrustumCuller::ChunkSize + 1001;
+    JobSystem jobs(3);
+    std::vector<uint32_t> expected(count);
+    for (uint32_t seed = 1; seed <= 2; seed++)
+    {
+        const FrustumCullingFixtures::TestScene scene = FrustumCullingFixtures::MakeTestScene(count, seed);
+        for (FrustumCulling::Shape shape : Shapes)
+        {
+            const uint32_t expectedCount = FrustumCulling::CullReference(scene.frustum, scene.bounds, shape, 0, count, expected.data());
+            CHECK(expectedCount > 0 && expectedCount < count);
+            for (JobSystem* pool : { static_cast<JobSystem*>(nullptr), &jobs })
+            {
+                FrustumCuller culler;
+                culler.Cull(scene.frustum, scene.bounds, shape, pool);
+                std::string mismatch;
+                CHECK_MESSAGE(FrustumCullingFixtures::Compare(expected.data(), expectedCount, culler.Visible(), culler.VisibleCount(), mismatch),
+                    mismatch);
+            }
+        }
+    }
+}
+
+TEST_CASE(FrustumCullerViewMasksMatchReference)
+{
+    const uint32_t count = 2 * FrustumCuller::ChunkSize + 77;
+    const FrustumCullingFixtures::TestScene scene = FrustumCullingFixtures::MakeTestScene(count, 3);
+    JobSystem jobs(3);
+    for (uint32_t viewCount : { 1u, 5u, FrustumCulling::MaxViews })
+    {
+        const std::vector<Frustum> views = FrustumCullingFixtures::MakeTestViews(viewCount, viewCount);
+        std::vector<uint16_t> expected(count);
+        FrustumCulling::CullViewsReference(views.data(), viewCount, scene.bounds, FrustumCulling::Shape::Box, 0, count, expected.data());
+
+        FrustumCuller culler;
+        culler.CullViews(views.data(), viewCount, scene.bounds, FrustumCulling::Shape::Box, &jobs);
+        std::string mismatch;
+        CHECK_MESSAGE(FrustumCullingFixtures::CompareViewMasks(expected.data(), culler.ViewMasks(), count, mismatch), mismatch);
+
+        // Bit v picks out the same volumes as culling view v on its own.
+        for (uint32_t v = 0; v < viewCount; v++)
+        {
+            std::vector<uint32_t> visible;
+            for (uint32_t i = 0; i < count; i++)
+            {
+                if (expected[i] & (1u << v))
+                {
+                    visible.push_back(i);
+                }
+            }
+            FrustumCuller single;
+            single.Cull(views[v], scene.bounds, FrustumCulling::Shape::Box, nullptr);
+            CHECK_MESSAGE(FrustumCullingFixtures::Compare(visible.data(), static_cast<uint32_t>(visible.size()), single.Visible(),
+                single.VisibleCount(), mismatch), mismatch);
+        }
+    }
+}
+
+TEST_CASE(FrustumCullViewsRejectsTooManyViews)
+{
+    const FrustumCullingFixtures::TestScene scene = FrustumCullingFixtures::MakeTestScene(16, 1);
+    const std::vector<Frustum> views = FrustumCullingFixtures::MakeTestViews(FrustumCulling::MaxViews + 1, 1);
+    FrustumCuller culler;
+    CHECK_THROWS(culler.CullViews(views.data(), FrustumCulling::MaxViews + 1, scene.bounds, FrustumCulling::Shape::Box, nullptr),
+        std::invalid_argument);
+}
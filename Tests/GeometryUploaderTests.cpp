@@ -0,0 +1,256 @@
+#include "Test.h"
+#include "GeometryUploader.h"
+#include "TestRandom.h"
+
+#include <algorithm>
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace
+{
+    // A copy queue whose GPU only runs when told to: a batch's copies read
+    // the staging buffer when the batch completes, not when it is recorded,
+    // so staging overwritten too early shows up as wrong destination bytes,
+    // and is counted as it happens.
+    class MockCopyQueue : public ICopyQueue
+    {
+    public:
+        struct Copy
+        {
+            uint32_t destination;
+            uint64_t destinationOffset;
+            uint64_t stagingOffset;
+            uint64_t size;
+        };
+
+        std::vector<uint8_t> staging;
+        std::map<uint32_t, std::vector<uint8_t>> destinations;
+        std::vector<Copy> recorded;         // Since the last Execute.
+        std::vector<uint64_t> waits;
+        uint32_t overwrites = 0;            // Staging written while a copy still reads it.
+        uint32_t badWaits = 0;              // Waits for values never signaled.
+
+        explicit MockCopyQueue(uint64_t stagingSize) : staging(static_cast<size_t>(stagingSize)) {}
+
+        void WriteStaging(uint64_t stagingOffset, const void* data, uint64_t size) override
+        {
+            CHECK(stagingOffset + size <= staging.size());
+            for (const Batch& batch : m_batches)
+            {
+                overwrites += Overlaps(batch.copies, stagingOffset, size);
+            }
+            overwrites += Overlaps(m_executed, stagingOffset, size) + Overlaps(recorded, stagingOffset, size);
+            std::copy(static_cast<const uint8_t*>(data), static_cast<const uint8_t*>(data) + size, staging.begin() + stagingOffset);
+        }
+
+        void CopyToBuffer(uint32_t destination, uint64_t destinationOffset, uint64_t stagingOffset, uint64_t size) override
+        {
+            Copy copy = { destination, destinationOffset, stagingOffset, size };
+            recorded.push_back(copy);
+        }
+
+        void Execute() override
+        {
+            m_executed.insert(m_executed.end(), recorded.begin(), recorded.end());
+            recorded.clear();
+        }
+
+        void Signal(uint64_t value) override
+        {
+            Batch batch = { value, m_executed };
+            m_batches.push_back(batch);
+            m_executed.clear();
+            m_signaled = value;
+        }
+
+        uint64_t CompletedValue() override { return m_completed; }
+
+        void WaitForValue(uint64_t value) override
+        {
+            waits.push_back(value);
+            badWaits += value > m_signaled;
+            Complete(value);
+        }
+
+        // Runs the GPU up to the batch signaling value.
+        void Complete(uint64_t value)
+        {
+            while (!m_batches.empty() && m_batches.front().fenceValue <= value)
+            {
+                for (const Copy& copy : m_batches.front().copies)
+                {
+                    std::vector<uint8_t>& destination = destinations[copy.destination];
+                    destination.resize(std::max<size_t>(destination.size(), static_cast<size_t>(copy.destinationOffset + copy.size)));
+                    std::copy(staging.begin() + copy.stagingOffset, staging.begin() + copy.stagingOffset + copy.size,
+                        destination.begin() + copy.destinationOffset);
+                }
+                m_completed = std::max(m_completed, m_batches.front().fenceValue);
+                m_batches.pop_front();
+            }
+        }
+
+        size_t BatchesInFlight() const { return m_batches.size(); }
+
+    private:
+        struct Batch
+        {
+            uint64_t fenceValue;
+            std::vector<Copy> copies;
+        };
+
+        static uint32_t Overlaps(const std::vector<Copy>& copies, uint64_t offset, uint64_t size)
+        {
+            uint32_t count = 0;
+            for (const Copy& copy : copies)
+            {
+                count += copy.stagingOffset < offset + size && offset < copy.stagingOffset + copy.size;
+            }
+            return count;
+        }
+
+        std::vector<Copy> m_executed;       // Submitted, not yet signaled.
+        std::deque<Batch> m_batches;
+        uint64_t m_signaled = 0;
+        uint64_t m_completed = 0;
+    };
+
+    std::vector<uint8_t> MakeData(uint64_t size, uint32_t seed)
+    {
+        std::vector<uint8_t> data(static_cast<size_t>(size));
+        TestRandom random(seed);
+        for (uint8_t& byte : data)
+        {
+            byte = static_cast<uint8_t>(random.Next());
+        }
+        return data;
+    }
+}
+
+TEST_CASE(GeometryUploaderSplitsLargeUploadsIntoChunks)
+{
+    MockCopyQueue queue(4096);
+    GeometryUploader uploader(queue, 4096, 1000);
+    const std::vector<uint8_t> data = MakeData(3500, 1);
+    uploader.Upload(7, 100, data.data(), data.size());
+
+    // Chunks of at most 1000 bytes, in order, at 64 byte aligned staging
+    // offsets, and nothing submitted until Flush.
+    CHECK(queue.recorded.size() == 4);
+    uint64_t destinationOffset = 100;
+    for (const MockCopyQueue::Copy& copy : queue.recorded)
+    {
+        CHECK(copy.destination == 7);
+        CHECK(copy.destinationOffset == destinationOffset);
+        CHECK(copy.stagingOffset % 64 == 0);
+        CHECK(copy.size == (destinationOffset - 100 < 3000 ? 1000 : 500));
+        destinationOffset += copy.size;
+    }
+    CHECK(queue.BatchesInFlight() == 0);
+
+    const uint64_t fenceValue = uploader.Flush();
+    CHECK(fenceValue == 1);
+    CHECK(uploader.Flush() == 1);   // Nothing new to submit.
+    queue.Complete(fenceValue);
+    const std::vector<uint8_t>& destination = queue.destinations[7];
+    CHECK(destination.size() == 3600);
+    CHECK(std::equal(data.begin(), data.end(), destination.begin() + 100));
+
+    const GeometryUploader::Stats& stats = uploader.GetStats();
+    CHECK(stats.bytes == 3500);
+    CHECK(stats.chunks == 4);
+    CHECK(stats.submissions == 1);
+    CHECK(stats.stalls == 0);
+    CHECK(queue.overwrites == 0);
+}
+
+TEST_CASE(GeometryUploaderStallsOnlyWhenTheRingIsFull)
+{
+    // The GPU never catches up on its own, so once four chunks fill the ring
+    // the next one has to submit them and wait for that batch.
+    MockCopyQueue queue(4096);
+    GeometryUploader uploader(queue, 4096, 1024);
+    const std::vector<uint8_t> small = MakeData(4096, 2);
+    uploader.Upload(0, 0, small.data(), small.size());
+    CHECK(uploader.GetStats().stalls == 0);
+    CHECK(queue.waits.empty());
+
+    const std::vector<uint8_t> large = MakeData(10 * 1024, 3);
+    uploader.Upload(1, 0, large.data(), large.size());
+    const GeometryUploader::Stats& stats = uploader.GetStats();
+    CHECK(stats.stalls == 3);
+    CHECK(stats.submissions == 3);
+    CHECK(queue.waits.size() == 3);
+    for (size_t i = 0; i < queue.waits.size(); i++)
+    {
+        // Oldest first, and only for batches already submitted.
+        CHECK(queue.waits[i] == i + 1);
+    }
+    CHECK(queue.badWaits == 0);
+
+    // When the GPU is done before staging runs out, nothing waits.
+    queue.Complete(uploader.Flush());
+    uploader.Upload(2, 0, small.data(), small.size());
+    CHECK(stats.stalls == 3);
+
+    queue.Complete(uploader.Flush());
+    CHECK(queue.destinations[0] == small);
+    CHECK(queue.destinations[1] == large);
+    CHECK(queue.destinations[2] == small);
+    CHECK(queue.overwrites == 0);
+}
+
+TEST_CASE(GeometryUploaderNeverOverwritesStagingInFlight)
+{
+    // Random uploads into a few buffers while the GPU falls 0 to 3 batches
+    // behind; Retire runs at random too, as a frame loop would call it.
+    const uint64_t capacity = 16 * 1024;
+    MockCopyQueue queue(capacity);
+    GeometryUploader uploader(queue, capacity, 3000);
+    std::map<uint32_t, std::vector<uint8_t>> expected;
+    TestRandom random(2024);
+
+    for (uint32_t step = 0; step < 2000; step++)
+    {
+        const uint32_t destination = random.Next() % 4;
+        const uint64_t size = 1 + random.Next() % 9000;
+        const uint64_t offset = random.Next() % 20000;
+        const std::vector<uint8_t> data = MakeData(size, random.Next());
+        uploader.Upload(destination, offset, data.data(), size);
+
+        std::vector<uint8_t>& buffer = expected[destination];
+        buffer.resize(std::max<size_t>(buffer.size(), static_cast<size_t>(offset + size)));
+        std::copy(data.begin(), data.end(), buffer.begin() + offset);
+
+        switch (random.Next() % 4)
+        {
+        case 0:
+            uploader.Flush();
+            break;
+        case 1:
+            uploader.Retire();
+            break;
+        default:
+            break;
+        }
+        const uint64_t lag = random.Next() % 4;
+        const uint64_t submitted = uploader.LastSubmittedFenceValue();
+        if (submitted > lag)
+        {
+            queue.Complete(submitted - lag);
+        }
+    }
+
+    queue.Complete(uploader.Flush());
+    CHECK(queue.overwrites == 0);
+    CHECK(queue.badWaits == 0);
+    CHECK(uploader.GetStats().stalls > 0);
+    for (const auto& buffer : expected)
+    {
+        // Bytes no upload covered are zero on both sides.
+        std::vector<uint8_t> actual = queue.destinations[buffer.first];
+        actual.resize(buffer.second.size());
+        CHECK_MESSAGE(actual == buffer.second, "destination " + std::to_string(buffer.first));
+    }
+}
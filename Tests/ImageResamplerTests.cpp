@@ -0,0 +1,387 @@
+#include "Test.h"
+#include "ImageResampler.h"
+#include "TestRandom.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace ImageResampler;
+
+namespace
+{
+    const Filter Filters[] = { Filter::Box, Filter::Mitchell, Filter::Lanczos3 };
+    const char* const FilterNames[] = { "Box", "Mitchell", "Lanczos3" };
+
+    double ExactSrgbToLinear(double c)
+    {
+        return c <= 0.04045 ? c / 12.92 : std::pow((c + 0.055) / 1.055, 2.4);
+    }
+
+    double ExactLinearToSrgb(double l)
+    {
+        return l <= 0.0031308 ? l * 12.92 : 1.055 * std::pow(l, 1.0 / 2.4) - 0.055;
+    }
+
+    std::vector<uint8_t> RandomBytes(size_t count, uint32_t seed)
+    {
+        std::vector<uint8_t> pixels(count);
+        TestRandom random(seed);
+        for (uint8_t& byte : pixels)
+        {
+            byte = static_cast<uint8_t>(random.Next() >> 24);
+        }
+        return pixels;
+    }
+
+    // The kernels as the resampler defines them, in double.
+    double Kernel(Filter filter, double x)
+    {
+        x = std::fabs(x);
+        switch (filter)
+        {
+        case Filter::Box:
+            return x < 0.5 ? 1.0 : 0.0;
+        case Filter::Mitchell:
+        {
+            const double B = 1.0 / 3.0, C = 1.0 / 3.0;
+            if (x < 1.0)
+                return ((12 - 9 * B - 6 * C) * x * x * x + (-18 + 12 * B + 6 * C) * x * x + (6 - 2 * B)) / 6.0;
+            if (x < 2.0)
+                return ((-B - 6 * C) * x * x * x + (6 * B + 30 * C) * x * x + (-12 * B - 48 * C) * x + (8 * B + 24 * C)) / 6.0;
+            return 0.0;
+        }
+        case Filter::Lanczos3:
+        {
+            const double pi = 3.14159265358979323846;
+            auto sinc = [pi](double v) { return std::fabs(v) < 1e-9 ? 1.0 : std::sin(pi * v) / (pi * v); };
+            return x < 3.0 ? sinc(x) * sinc(x / 3.0) : 0.0;
+        }
+        }
+        return 0.0;
+    }
+
+    // Normalized weights of every source tap for each destination coordinate
+    // on one axis. Tap positions are found in float, as the resampler finds
+    // them, so that both pick the same taps at the edges of the support.
+    std::vector<std::vector<double>> Weights(uint32_t srcSize, uint32_t dstSize, Filter filter)
+    {
+        const float scale = float(srcSize) / float(dstSize);
+        const float filterScale = std::max(scale, 1.0f);
+        const float support = filter == Filter::Box ? 0.5f : (filter == Filter::Mitchell ? 2.0f : 3.0f);
+        const float radius = support * filterScale;
+
+        std::vector<std::vector<double>> weights(dstSize, std::vector<double>(srcSize, 0.0));
+        for (uint32_t i = 0; i < dstSize; i++)
+        {
+            const float center = (i + 0.5f) * scale;
+            const int first = std::max(0, static_cast<int>(std::floor(center - radius)));
+            const int last = std::min(int(srcSize) - 1, static_cast<int>(std::ceil(center + radius)));
+            double sum = 0.0;
+            for (int j = first; j <= last; j++)
+            {
+                weights[i][j] = Kernel(filter, (j + 0.5f - center) / filterScale);
+                sum += weights[i][j];
+            }
+            if (sum == 0.0)
+            {
+                weights[i][std::min(int(srcSize) - 1, static_cast<int>(center))] = 1.0;
+                sum = 1.0;
+            }
+            for (double& w : weights[i])
+            {
+                w /= sum;
+            }
+        }
+        return weights;
+    }
+
+    // Scalar resize of linear RGBA in double: the reference for the SIMD
+    // passes.
+    std::vector<double> ResizeReference(const std::vector<double>& src, uint32_t srcWidth, uint32_t srcHeight, uint32_t dstWidth,
+        uint32_t dstHeight, Filter filter)
+    {
+        const std::vector<std::vector<double>> horizontal = Weights(srcWidth, dstWidth, filter);
+        const std::vector<std::vector<double>> vertical = Weights(srcHeight, dstHeight, filter);
+        std::vector<double> dst(size_t(dstWidth) * dstHeight * 4, 0.0);
+        for (uint32_t y = 0; y < dstHeight; y++)
+        {
+            for (uint32_t x = 0; x < dstWidth; x++)
+            {
+                for (uint32_t sy = 0; sy < srcHeight; sy++)
+                {
+                    for (uint32_t sx = 0; sx < srcWidth; sx++)
+                    {
+                        const double w = vertical[y][sy] * horizontal[x][sx];
+                        for (int c = 0; c < 4 && w != 0.0; c++)
+                        {
+                            dst[(size_t(y) * dstWidth + x) * 4 + c] += w * src[(size_t(sy) * srcWidth + sx) * 4 + c];
+                        }
+                    }
+                }
+            }
+        }
+        return dst;
+    }
+
+    std::string Describe(Filter filter, uint32_t srcWidth, uint32_t srcHeight, uint32_t dstWidth, uint32_t dstHeight)
+    {
+        return std::string(FilterNames[static_cast<int>(filter)]) + " " + std::to_string(srcWidth) + "x" + std::to_string(srcHeight) +
+            " to " + std::to_string(dstWidth) + "x" + std::to_string(dstHeight);
+    }
+
+    // Reductions, enlargements, ratios that are not whole numbers, single
+    // rows and columns, and widths that leave remainders after the 8 and 4
+    // wide SIMD loops.
+    const uint32_t Sizes[][4] = {
+        { 16, 16, 8, 8 }, { 16, 16, 32, 32 }, { 37, 23, 11, 29 }, { 5, 7, 19, 3 },
+        { 1, 9, 6, 1 }, { 13, 1, 1, 4 }, { 64, 3, 21, 3 }, { 3, 3, 3, 17 },
+    };
+}
+
+TEST_CASE(ImageResamplerSrgbTablesMatchTheTransferFunction)
+{
+    // Every sRGB byte decodes to the exact curve and encodes back to itself.
+    uint8_t bytes[256];
+    float linear[256];
+    uint8_t encoded[256];
+    for (int i = 0; i < 256; i++)
+    {
+        bytes[i] = static_cast<uint8_t>(i);
+    }
+    SrgbToLinear(bytes, linear, 256);
+    LinearToSrgb(linear, encoded, 256);
+    for (int i = 0; i < 256; i++)
+    {
+        CHECK_MESSAGE(std::fabs(linear[i] - ExactSrgbToLinear(i / 255.0)) < 1e-6, std::to_string(i));
+        CHECK_MESSAGE(encoded[i] == i, std::to_string(i) + " encodes to " + std::to_string(encoded[i]));
+    }
+
+    // Between the codes, the encoding is monotonic, less than a code from the
+    // curve, and clamps values out of range.
+    const size_t count = 100001;
+    std::vector<float> values(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        values[i] = static_cast<float>(i) / (count - 1);
+    }
+    std::vector<uint8_t> srgb(count);
+    LinearToSrgb(values.data(), srgb.data(), count);
+    for (size_t i = 0; i < count; i++)
+    {
+        CHECK_MESSAGE(std::fabs(srgb[i] - 255.0 * ExactLinearToSrgb(values[i])) < 1.0, std::to_string(values[i]));
+        CHECK(i == 0 || srgb[i] >= srgb[i - 1]);
+    }
+    const float outOfRange[4] = { -1.0f, -1e-9f, 1.0f + 1e-6f, 1e9f };
+    uint8_t clamped[4];
+    LinearToSrgb(outOfRange, clamped, 4);
+    CHECK(clamped[0] == 0 && clamped[1] == 0 && clamped[2] == 255 && clamped[3] == 255);
+}
+
+TEST_CASE(ImageResamplerPreservesConstantImages)
+{
+    // Weights are normalized, so a flat colour stays exactly that colour
+    // through every kernel, including at the edges where taps are cut off
+    // and in Lanczos' negative lobes.
+    const uint8_t colors[][4] = { { 0, 0, 0, 0 }, { 255, 255, 255, 255 }, { 1, 128, 254, 77 }, { 200, 3, 90, 255 } };
+    for (Filter filter : Filters)
+    {
+        for (const auto& size : Sizes)
+        {
+            for (const auto& color : colors)
+            {
+                for (bool srgb : { false, true })
+                {
+                    std::vector<uint8_t> src(size_t(size[0]) * size[1] * 4);
+                    for (size_t i = 0; i < src.size(); i++)
+                    {
+                        src[i] = color[i % 4];
+                    }
+                    std::vector<uint8_t> dst(size_t(size[2]) * size[3] * 4, 0xcd);
+                    const ImageView srcView = { src.data(), size[0], size[1], size_t(size[0]) * 4, PixelLayout::RGBA8, srgb };
+                    const MutableImageView dstView = { dst.data(), size[2], size[3], size_t(size[2]) * 4, PixelLayout::RGBA8, srgb };
+                    CHECK(Resize(srcView, dstView, filter));
+                    for (size_t i = 0; i < dst.size(); i++)
+                    {
+                        CHECK_MESSAGE(dst[i] == color[i % 4], Describe(filter, size[0], size[1], size[2], size[3]) + " byte " + std::to_string(i));
+                    }
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE(ImageResamplerIdentityResizeConverts)
+{
+    // Same size is a copy, whatever the filter, and honours row pitches.
+    const uint32_t width = 29, height = 7;
+    const size_t srcPitch = width * 4 + 12;
+    const std::vector<uint8_t> src = RandomBytes(srcPitch * height, 1);
+    for (Filter filter : Filters)
+    {
+        std::vector<uint8_t> copy(size_t(width) * 4 * height);
+        const ImageView srcView = { src.data(), width, height, srcPitch, PixelLayout::RGBA8, true };
+        const MutableImageView copyView = { copy.data(), width, height, size_t(width) * 4, PixelLayout::RGBA8, true };
+        CHECK(Resize(srcView, copyView, filter));
+        for (uint32_t y = 0; y < height; y++)
+        {
+            CHECK(std::memcmp(copy.data() + y * width * 4, src.data() + y * srcPitch, width * 4) == 0);
+        }
+    }
+
+    // RGBA8 <-> BGRA8 swaps red and blue, on every width the SIMD loops can
+    // leave a remainder for.
+    for (uint32_t w = 1; w <= 40; w++)
+    {
+        const std::vector<uint8_t> rgba = RandomBytes(size_t(w) * 4 * 3, w);
+        std::vector<uint8_t> bgra(rgba.size());
+        std::vector<uint8_t> back(rgba.size());
+        const ImageView rgbaView = { rgba.data(), w, 3, size_t(w) * 4, PixelLayout::RGBA8, false };
+        const MutableImageView bgraView = { bgra.data(), w, 3, size_t(w) * 4, PixelLayout::BGRA8, false };
+        CHECK(Resize(rgbaView, bgraView, Filter::Lanczos3));
+        for (size_t i = 0; i < rgba.size(); i += 4)
+        {
+            CHECK_MESSAGE(bgra[i] == rgba[i + 2] && bgra[i + 1] == rgba[i + 1] && bgra[i + 2] == rgba[i] && bgra[i + 3] == rgba[i + 3],
+                "width " + std::to_string(w) + " pixel " + std::to_string(i / 4));
+        }
+        const ImageView bgraSource = { bgra.data(), w, 3, size_t(w) * 4, PixelLayout::BGRA8, false };
+        const MutableImageView backView = { back.data(), w, 3, size_t(w) * 4, PixelLayout::RGBA8, false };
+        CHECK(Convert(bgraSource, backView));
+        CHECK(back == rgba);
+    }
+
+    // sRGB through linear float and back is lossless.
+    std::vector<float> linear(size_t(width) * height * 4);
+    std::vector<uint8_t> back(size_t(width) * height * 4);
+    const ImageView srcView = { src.data(), width, height, srcPitch, PixelLayout::RGBA8, true };
+    const MutableImageView linearView = { reinterpret_cast<uint8_t*>(linear.data()), width, height, size_t(width) * 16, PixelLayout::RGBA32F, false };
+    CHECK(Resize(srcView, linearView, Filter::Mitchell));
+    const ImageView linearSource = { reinterpret_cast<const uint8_t*>(linear.data()), width, height, size_t(width) * 16, PixelLayout::RGBA32F, false };
+    const MutableImageView backView = { back.data(), width, height, size_t(width) * 4, PixelLayout::RGBA8, true };
+    CHECK(Resize(linearSource, backView, Filter::Mitchell));
+    for (uint32_t y = 0; y < height; y++)
+    {
+        CHECK(std::memcmp(back.data() + y * width * 4, src.data() + y * srcPitch, width * 4) == 0);
+    }
+}
+
+TEST_CASE(ImageResamplerMatchesScalarReference)
+{
+    // Float in and out, so the SIMD filter passes can be compared with the
+    // double precision reference directly; then 8-bit sRGB, within a code.
+    for (Filter filter : Filters)
+    {
+        for (const auto& size : Sizes)
+        {
+            const uint32_t srcWidth = size[0], srcHeight = size[1], dstWidth = size[2], dstHeight = size[3];
+            const std::string context = Describe(filter, srcWidth, srcHeight, dstWidth, dstHeight);
+            const std::vector<uint8_t> bytes = RandomBytes(size_t(srcWidth) * srcHeight * 4, srcWidth * 100 + dstWidth);
+
+            std::vector<float> src(bytes.size());
+            std::vector<double> linear(bytes.size());
+            for (size_t i = 0; i < bytes.size(); i++)
+            {
+                src[i] = bytes[i] / 255.0f;
+                linear[i] = i % 4 == 3 ? bytes[i] / 255.0 : ExactSrgbToLinear(bytes[i] / 255.0);
+            }
+
+            std::vector<float> dst(size_t(dstWidth) * dstHeight * 4);
+            const ImageView srcView = { reinterpret_cast<const uint8_t*>(src.data()), srcWidth, srcHeight, size_t(srcWidth) * 16, PixelLayout::RGBA32F, false };
+            const MutableImageView dstView = { reinterpret_cast<uint8_t*>(dst.data()), dstWidth, dstHeight, size_t(dstWidth) * 16, PixelLayout::RGBA32F, false };
+            CHECK(Resize(srcView, dstView, filter));
+            std::vector<double> unorm(src.begin(), src.end());
+            const std::vector<double> expected = ResizeReference(unorm, srcWidth, srcHeight, dstWidth, dstHeight, filter);
+            for (size_t i = 0; i < dst.size(); i++)
+            {
+                CHECK_MESSAGE(std::fabs(dst[i] - expected[i]) < 1e-5, context + " float " + std::to_string(i) + ": " +
+                    std::to_string(dst[i]) + ", expected " + std::to_string(expected[i]));
+            }
+
+            std::vector<uint8_t> dstBytes(size_t(dstWidth) * dstHeight * 4);
+            const ImageView byteView = { bytes.data(), srcWidth, srcHeight, size_t(srcWidth) * 4, PixelLayout::RGBA8, true };
+            const MutableImageView dstByteView = { dstBytes.data(), dstWidth, dstHeight, size_t(dstWidth) * 4, PixelLayout::RGBA8, true };
+            CHECK(Resize(byteView, dstByteView, filter));
+            const std::vector<double> expectedLinear = ResizeReference(linear, srcWidth, srcHeight, dstWidth, dstHeight, filter);
+            for (size_t i = 0; i < dstBytes.size(); i++)
+            {
+                const double v = std::min(std::max(expectedLinear[i], 0.0), 1.0);
+                const double code = 255.0 * (i % 4 == 3 ? v : ExactLinearToSrgb(v));
+                CHECK_MESSAGE(std::fabs(dstBytes[i] - code) < 1.0, context + " byte " + std::to_string(i) + ": " +
+                    std::to_string(dstBytes[i]) + ", expected " + std::to_string(code));
+            }
+        }
+    }
+}
+
+TEST_CASE(ImageResamplerKernelsHaveTheirShape)
+{
+    // A 2:1 box reduction is the plain average of each 2x2 block.
+    const uint32_t width = 18, height = 10;
+    const std::vector<uint8_t> src = RandomBytes(size_t(width) * height * 4, 3);
+    std::vector<uint8_t> half(size_t(width / 2) * (height / 2) * 4);
+    const ImageView srcView = { src.data(), width, height, size_t(width) * 4, PixelLayout::RGBA8, false };
+    const MutableImageView halfView = { half.data(), width / 2, height / 2, size_t(width / 2) * 4, PixelLayout::RGBA8, false };
+    CHECK(Resize(srcView, halfView, Filter::Box));
+    for (uint32_t y = 0; y < height / 2; y++)
+    {
+        for (uint32_t x = 0; x < width / 2; x++)
+        {
+            for (uint32_t c = 0; c < 4; c++)
+            {
+                const auto at = [&](uint32_t sx, uint32_t sy) { return src[(sy * width + sx) * 4 + c]; };
+                const double average = (at(2 * x, 2 * y) + at(2 * x + 1, 2 * y) + at(2 * x, 2 * y + 1) + at(2 * x + 1, 2 * y + 1)) / 4.0;
+                CHECK(std::fabs(half[(y * (width / 2) + x) * 4 + c] - average) <= 0.5);
+            }
+        }
+    }
+
+    // Enlarging a hard edge: Box repeats the two levels, Mitchell's small
+    // negative lobes overshoot them a little, Lanczos3's larger ones ring
+    // further.
+    const uint32_t edgeWidth = 8, wideWidth = 64;
+    std::vector<float> edge(edgeWidth * 4);
+    for (uint32_t x = 0; x < edgeWidth; x++)
+    {
+        std::fill(edge.begin() + x * 4, edge.begin() + x * 4 + 4, x < edgeWidth / 2 ? 0.25f : 0.75f);
+    }
+    float overshoot[3];
+    for (Filter filter : Filters)
+    {
+        std::vector<float> wide(wideWidth * 4);
+        const ImageView edgeView = { reinterpret_cast<const uint8_t*>(edge.data()), edgeWidth, 1, edgeWidth * 16, PixelLayout::RGBA32F, false };
+        const MutableImageView wideView = { reinterpret_cast<uint8_t*>(wide.data()), wideWidth, 1, wideWidth * 16, PixelLayout::RGBA32F, false };
+        CHECK(Resize(edgeView, wideView, filter));
+        const float low = *std::min_element(wide.begin(), wide.end());
+        const float high = *std::max_element(wide.begin(), wide.end());
+        overshoot[static_cast<int>(filter)] = std::max(0.25f - low, high - 0.75f);
+        if (filter == Filter::Box)
+        {
+            for (float v : wide)
+            {
+                CHECK(v == 0.25f || v == 0.75f);
+            }
+        }
+    }
+    CHECK(overshoot[0] <= 0.0f);
+    CHECK(overshoot[1] > 0.005f && overshoot[1] < 0.025f);
+    CHECK(overshoot[2] > overshoot[1] * 1.5f);
+}
+
+TEST_CASE(ImageResamplerRejectsInvalidViews)
+{
+    uint8_t pixels[64] = {};
+    const ImageView src = { pixels, 4, 4, 16, PixelLayout::RGBA8, false };
+    const MutableImageView dst = { pixels, 2, 2, 8, PixelLayout::RGBA8, false };
+    ImageView empty = src;
+    empty.width = 0;
+    CHECK(!Resize(empty, dst, Filter::Box));
+    ImageView narrowPitch = src;
+    narrowPitch.rowPitch = 15;
+    CHECK(!Resize(narrowPitch, dst, Filter::Box));
+    MutableImageView floatPitch = dst;
+    floatPitch.layout = PixelLayout::RGBA32F;
+    CHECK(!Resize(src, floatPitch, Filter::Box));
+    CHECK(!Convert(src, dst));
+}
@@ -0,0 +1,96 @@
+#include "IndirectCullingFixtures.h"
+#include "CullingFixtures.h"
+
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+    // Left-handed perspective for row vectors, looking down +z from the origin.
+    void PerspectiveMatrix(float fovY, float aspect, float nearZ, float farZ, float m[4][4])
+    {
+        std::memset(m, 0, sizeof(float) * 16);
+        const float yScale = 1.0f / std::tan(fovY * 0.5f);
+        m[0][0] = yScale / aspect;
+        m[1][1] = yScale;
+        m[2][2] = farZ / (farZ - nearZ);
+        m[2][3] = 1.0f;
+        m[3][2] = -nearZ * farZ / (farZ - nearZ);
+    }
+}
+
+namespace IndirectCullingFixtures
+{
+    TestCase MakeTestCase(uint32_t objectCount, uint32_t seed)
+    {
+        float viewProjection[4][4];
+        PerspectiveMatrix(1.0f, 16.0f / 9.0f, 1.0f, 100.0f, viewProjection);
+
+        TestCase test;
+        test.constants = IndirectCulling::MakeConstants(Frustum::FromViewProjection(viewProjection), objectCount);
+        test.objects.resize(objectCount);
+
+        TestRandom random(seed);
+        for (uint32_t i = 0; i < objectCount; i++)
+        {
+            IndirectObject& object = test.objects[i];
+            object.center[0] = random.Range(-150.0f, 150.0f);
+            object.center[1] = random.Range(-100.0f, 100.0f);
+            object.center[2] = random.Range(-20.0f, 130.0f);
+            object.vertexCount = 3 * (1 + random.Next() % 512);
+            object.firstVertex = random.Next() % (1u << 20);
+            object.textureSlot = random.Next() % 4096;
+            object.padding = 0;
+
+            switch (i % 4)
+            {
+            case 0:
+                object.radius = random.Range(0.0f, 10.0f);
+                break;
+            case 1:
+                object.radius = 0.0f;
+                break;
+            default:
+                object.radius = CullingFixtures::TouchingRadius(test.constants.planes, object.center, i % 4 == 3, random);
+                break;
+            }
+        }
+        return test;
+    }
+
+    bool Compare(const IndirectDrawCommand* expected, uint32_t expectedCount,
+        const IndirectDrawCommand* actual, uint32_t actualCount, std::string& message)
+    {
+        if (expectedCount != actualCount)
+        {
+            message = "draw count " + std::to_string(actualCount) + ", expected " + std::to_string(expectedCount);
+            return false;
+        }
+
+        static const char* const FieldNames[] =
+        {
+            "textureSlot", "vertexCountPerInstance", "instanceCount", "startVertexLocation", "startInstanceLocation"
+        };
+        for (uint32_t i = 0; i < expectedCount; i++)
+        {
+            if (std::memcmp(&expected[i], &actual[i], sizeof(IndirectDrawCommand)) == 0)
+            {
+                continue;
+            }
+
+            const uint32_t* expectedFields = &expected[i].textureSlot;
+            const uint32_t* actualFields = &actual[i].textureSlot;
+            for (int field = 0; field < 5; field++)
+            {
+                if (expectedFields[field] != actualFields[field])
+                {
+                    message = "command " + std::to_string(i) + " " + FieldNames[field] + " is " +
+                        std::to_string(actualFields[field]) + ", expected " + std::to_string(expectedFields[field]);
+                    break;
+                }
+            }
+            return false;
+        }
+        return true;
+    }
+}
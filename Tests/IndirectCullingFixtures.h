@@ -0,0 +1,24 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "IndirectCulling.h"
+
+// A scene and a comparison for checking IndirectCull.hlsl against
+// IndirectCulling::CullAndCompact, shared by the CPU and GPU tests.
+namespace IndirectCullingFixtures
+{
+    // Random spheres around a frustum, plus spheres placed exactly on its
+    // planes (see CullingFixtures::TouchingRadius).
+    struct TestCase
+    {
+        IndirectCullConstants constants;
+        std::vector<IndirectObject> objects;
+    };
+    TestCase MakeTestCase(uint32_t objectCount, uint32_t seed);
+
+    // Compares command lists byte for byte. On a mismatch, returns false and
+    // describes the first difference in message.
+    bool Compare(const IndirectDrawCommand* expected, uint32_t expectedCount,
+        const IndirectDrawCommand* actual, uint32_t actualCount, std::string& message);
+}
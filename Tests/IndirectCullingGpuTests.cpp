@@ -0,0 +1,128 @@
+#include "Test.h"
+
+// The GPU side of IndirectCulling needs D3D12, so it is only tested on
+// Windows; it runs on WARP, which every machine has, so no GPU is needed.
+#if defined(_WIN32)
+
+#include "IndirectCullingFixtures.h"
+#include "D3D12IndirectDraw.h"
+
+#include <cstring>
+
+namespace
+{
+    // Several chunks of IndirectCull.hlsl's group, and a partial one.
+    const UINT ObjectCount = 10000;
+
+    std::wstring ShaderPath()
+    {
+        const std::string source = __FILE__;
+        const size_t slash = source.find_last_of("/\\");
+        const std::string tests = slash == std::string::npos ? std::string() : source.substr(0, slash + 1);
+        return std::wstring(tests.begin(), tests.end()) + L"..\\IndirectCull.hlsl";
+    }
+
+    // Runs commandList on queue and waits for it.
+    void ExecuteAndWait(ID3D12Device* device, ID3D12CommandQueue* queue, ID3D12GraphicsCommandList* commandList)
+    {
+        ThrowIfFailed(commandList->Close());
+        ID3D12CommandList* lists[] = { commandList };
+        queue->ExecuteCommandLists(_countof(lists), lists);
+
+        ComPtr<ID3D12Fence> fence;
+        ThrowIfFailed(device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&fence)));
+        ThrowIfFailed(queue->Signal(fence.Get(), 1));
+        const HANDLE fenceEvent = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+        if (!fenceEvent)
+        {
+            ThrowIfFailed(HRESULT_FROM_WIN32(GetLastError()));
+        }
+        ThrowIfFailed(fence->SetEventOnCompletion(1, fenceEvent));
+        WaitForSingleObject(fenceEvent, INFINITE);
+        CloseHandle(fenceEvent);
+    }
+}
+
+TEST_CASE(IndirectCullShaderMatchesReference)
+{
+    ComPtr<IDXGIFactory4> factory;
+    ThrowIfFailed(CreateDXGIFactory2(0, IID_PPV_ARGS(&factory)));
+    ComPtr<IDXGIAdapter> warpAdapter;
+    ThrowIfFailed(factory->EnumWarpAdapter(IID_PPV_ARGS(&warpAdapter)));
+    ComPtr<ID3D12Device> device;
+    ThrowIfFailed(D3D12CreateDevice(warpAdapter.Get(), D3D_FEATURE_LEVEL_11_0, IID_PPV_ARGS(&device)));
+
+    D3D12_COMMAND_QUEUE_DESC queueDesc = {};
+    queueDesc.Type = D3D12_COMMAND_LIST_TYPE_DIRECT;
+    ComPtr<ID3D12CommandQueue> queue;
+    ThrowIfFailed(device->CreateCommandQueue(&queueDesc, IID_PPV_ARGS(&queue)));
+    ComPtr<ID3D12CommandAllocator> allocator;
+    ThrowIfFailed(device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&allocator)));
+    ComPtr<ID3D12GraphicsCommandList> commandList;
+    ThrowIfFailed(device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, allocator.Get(), nullptr, IID_PPV_ARGS(&commandList)));
+    ThrowIfFailed(commandList->Close());
+
+    // The commands set a root constant, so the command signature needs a
+    // graphics root signature with one.
+    ComPtr<ID3D12RootSignature> graphicsRootSignature;
+    {
+        CD3DX12_ROOT_PARAMETER textureSlot;
+        textureSlot.InitAsConstants(1, 0);
+        CD3DX12_ROOT_SIGNATURE_DESC rootSignatureDesc;
+        rootSignatureDesc.Init(1, &textureSlot, 0, nullptr, D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT);
+        ComPtr<ID3DBlob> signature;
+        ComPtr<ID3DBlob> error;
+        ThrowIfFailed(D3D12SerializeRootSignature(&rootSignatureDesc, D3D_ROOT_SIGNATURE_VERSION_1, &signature, &error));
+        ThrowIfFailed(device->CreateRootSignature(0, signature->GetBufferPointer(), signature->GetBufferSize(),
+            IID_PPV_ARGS(&graphicsRootSignature)));
+    }
+
+    ComPtr<ID3D12Resource> readback;
+    ThrowIfFailed(device->CreateCommittedResource(
+        &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_READBACK),
+        D3D12_HEAP_FLAG_NONE,
+        &CD3DX12_RESOURCE_DESC::Buffer(D3D12IndirectDraw::ReadbackCommandsOffset + ObjectCount * sizeof(IndirectDrawCommand)),
+        D3D12_RESOURCE_STATE_COPY_DEST,
+        nullptr,
+        IID_PPV_ARGS(&readback)));
+
+    // As the engine compiles it in release and in debug builds.
+    const UINT flagSets[] = { 0, D3DCOMPILE_DEBUG | D3DCOMPILE_SKIP_OPTIMIZATION };
+    D3D12ShaderCompiler compiler;
+    for (UINT flags : flagSets)
+    {
+        D3D12IndirectDraw indirectDraw;
+        indirectDraw.Initialize(device.Get(), compiler, ShaderPath(), flags, graphicsRootSignature.Get(), 0, ObjectCount);
+        for (uint32_t seed = 1; seed <= 3; seed++)
+        {
+            const IndirectCullingFixtures::TestCase test = IndirectCullingFixtures::MakeTestCase(ObjectCount, seed);
+            std::vector<IndirectDrawCommand> expected(ObjectCount);
+            const uint32_t expectedCount = IndirectCulling::CullAndCompact(test.constants, test.objects.data(), expected.data());
+
+            ThrowIfFailed(allocator->Reset());
+            ThrowIfFailed(commandList->Reset(allocator.Get(), nullptr));
+            indirectDraw.SetObjects(test.objects.data(), ObjectCount);
+            Frustum frustum;
+            memcpy(frustum.planes, test.constants.planes, sizeof(frustum.planes));
+            indirectDraw.Cull(commandList.Get(), frustum);
+            indirectDraw.CopyResults(commandList.Get(), readback.Get());
+            ExecuteAndWait(device.Get(), queue.Get(), commandList.Get());
+
+            uint8_t* data = nullptr;
+            ThrowIfFailed(readback->Map(0, nullptr, reinterpret_cast<void**>(&data)));
+            uint32_t actualCount;
+            memcpy(&actualCount, data, sizeof(actualCount));
+            std::vector<IndirectDrawCommand> actual(ObjectCount);
+            memcpy(actual.data(), data + D3D12IndirectDraw::ReadbackCommandsOffset, ObjectCount * sizeof(IndirectDrawCommand));
+            CD3DX12_RANGE writeRange(0, 0);
+            readback->Unmap(0, &writeRange);
+
+            // A count past the buffer would be a bug in itself; don't read beyond it.
+            CHECK(actualCount <= ObjectCount);
+            std::string mismatch;
+            CHECK_MESSAGE(IndirectCullingFixtures::Compare(expected.data(), expectedCount, actual.data(), actualCount, mismatch), mismatch);
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,122 @@
+#include "Test.h"
+#include "CullingFixtures.h"
+#include "IndirectCullingFixtures.h"
+
+#include <cmath>
+#include <stdexcept>
+
+namespace
+{
+    // Constants whose third plane is (a, b, c, d); nothing is behind the
+    // other five.
+    IndirectCullConstants MakeOnePlane(float a, float b, float c, float d)
+    {
+        IndirectCullConstants constants = {};
+        for (float* plane : constants.planes)
+        {
+            plane[3] = 1.0f;
+        }
+        constants.planes[2][0] = a;
+        constants.planes[2][1] = b;
+        constants.planes[2][2] = c;
+        constants.planes[2][3] = d;
+        constants.objectCount = 1;
+        return constants;
+    }
+}
+
+TEST_CASE(IndirectCullWritesVisibleObjectsInOrder)
+{
+    const IndirectCullingFixtures::TestCase test = IndirectCullingFixtures::MakeTestCase(10000, 1);
+    std::vector<IndirectDrawCommand> commands(10000);
+    const uint32_t count = IndirectCulling::CullAndCompact(test.constants, test.objects.data(), commands.data());
+    CHECK(count > 0 && count < 10000);
+
+    // Rebuilt from IsVisible one object at a time.
+    std::vector<IndirectDrawCommand> expected;
+    for (const IndirectObject& object : test.objects)
+    {
+        if (IndirectCulling::IsVisible(test.constants, object))
+        {
+            const IndirectDrawCommand command = { object.textureSlot, object.vertexCount, 1, object.firstVertex, 0 };
+            expected.push_back(command);
+        }
+    }
+    std::string mismatch;
+    CHECK_MESSAGE(IndirectCullingFixtures::Compare(expected.data(), static_cast<uint32_t>(expected.size()), commands.data(), count, mismatch),
+        mismatch);
+}
+
+TEST_CASE(IndirectCullKeepsSpheresTouchingAPlane)
+{
+    // The center is exactly 5 behind the plane: a radius of 5 touches it, the
+    // next float below does not.
+    const IndirectCullConstants constants = MakeOnePlane(0.6f, 0.8f, 0.0f, -5.0f);
+    IndirectObject object = {};
+    object.radius = 5.0f;
+    CHECK(IndirectCulling::IsVisible(constants, object));
+    object.radius = std::nextafter(5.0f, 0.0f);
+    CHECK(!IndirectCulling::IsVisible(constants, object));
+
+    object.center[0] = 10.0f;
+    object.radius = 0.0f;
+    CHECK(IndirectCulling::IsVisible(constants, object));
+}
+
+TEST_CASE(IndirectCullRoundsLikeThePreciseShader)
+{
+    // Spheres that touch a plane by the shader's rounding stay visible, and
+    // a hair less does not. With fused multiply-adds the distances round
+    // differently and some of these flip.
+    const IndirectCullingFixtures::TestCase test = IndirectCullingFixtures::MakeTestCase(4096, 7);
+    uint32_t checked = 0;
+    for (uint32_t i = 0; i < test.objects.size(); i++)
+    {
+        const float* plane = test.constants.planes[i % 6];
+        IndirectObject object = test.objects[i];
+        const float distance = CullingFixtures::PlaneDistance(plane, object.center);
+        if (!(distance < 0.0f))
+        {
+            continue;
+        }
+        const IndirectCullConstants constants = MakeOnePlane(plane[0], plane[1], plane[2], plane[3]);
+        object.radius = -distance;
+        CHECK_MESSAGE(IndirectCulling::IsVisible(constants, object), "object " + std::to_string(i));
+        object.radius = std::nextafter(-distance, 0.0f);
+        CHECK_MESSAGE(!IndirectCulling::IsVisible(constants, object), "object " + std::to_string(i));
+        checked++;
+    }
+    CHECK(checked > 1000);
+}
+
+TEST_CASE(IndirectCullSplitsTriangleListsIntoBoundedObjects)
+{
+    // 10 triangles along a diagonal, in objects of 3 triangles (10 vertices
+    // round down to 9).
+    std::vector<float> positions;
+    for (int vertex = 0; vertex < 30; vertex++)
+    {
+        positions.push_back(static_cast<float>(vertex));
+        positions.push_back(static_cast<float>(vertex % 3));
+        positions.push_back(-0.5f * vertex);
+    }
+    const std::vector<IndirectObject> objects = IndirectCulling::BuildObjects(positions.data(), 3 * sizeof(float), 30, 10, 7);
+    CHECK(objects.size() == 4);
+    for (size_t i = 0; i < objects.size(); i++)
+    {
+        const IndirectObject& object = objects[i];
+        CHECK(object.firstVertex == i * 9);
+        CHECK(object.vertexCount == (i < 3 ? 9u : 3u));
+        CHECK(object.textureSlot == 7);
+        for (uint32_t vertex = object.firstVertex; vertex < object.firstVertex + object.vertexCount; vertex++)
+        {
+            const float* p = &positions[vertex * 3];
+            const float dx = p[0] - object.center[0];
+            const float dy = p[1] - object.center[1];
+            const float dz = p[2] - object.center[2];
+            CHECK(std::sqrt(dx * dx + dy * dy + dz * dz) <= object.radius);
+        }
+    }
+
+    CHECK_THROWS(IndirectCulling::BuildObjects(positions.data(), 3 * sizeof(float), 30, 2, 0), std::invalid_argument);
+}
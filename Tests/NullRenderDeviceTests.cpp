@@ -0,0 +1,88 @@
+#include "Test.h"
+#include "NullRenderDevice.h"
+
+#include <stdexcept>
+
+namespace
+{
+    PipelineHandle CreateTestPipeline(NullRenderDevice& device)
+    {
+        static const uint8_t bytecode[4] = {};
+        PipelineDesc desc;
+        desc.vertexShader = { bytecode, sizeof(bytecode) };
+        desc.pixelShader = { bytecode, sizeof(bytecode) };
+        return device.CreatePipeline(desc);
+    }
+
+    BufferHandle CreateTestBuffer(NullRenderDevice& device, uint64_t size)
+    {
+        BufferDesc desc;
+        desc.size = size;
+        return device.CreateBuffer(desc);
+    }
+}
+
+TEST_CASE(NullBundleSurvivesBufferPoolGrowth)
+{
+    // A bundle recorded once is replayed every frame while other buffers come
+    // and go. Growing the buffer pool must not invalidate what it bound.
+    NullRenderDevice device;
+    const PipelineHandle pipeline = CreateTestPipeline(device);
+    const BufferHandle vertices = CreateTestBuffer(device, 3 * 32);
+    const BufferHandle instances = CreateTestBuffer(device, sizeof(InstanceData));
+
+    std::unique_ptr<IRenderCommandList> bundle = device.CreateBundle();
+    bundle->Begin(0);
+    bundle->SetPipeline(pipeline);
+    bundle->SetVertexBuffer(vertices, 32);
+    bundle->SetInstanceBuffer(instances);
+    bundle->Draw(3);
+    bundle->End();
+
+    for (int i = 0; i < 1000; i++)
+    {
+        CreateTestBuffer(device, 256);
+    }
+
+    std::unique_ptr<IRenderCommandList> list = device.CreateCommandList();
+    list->Begin(0);
+    list->ExecuteBundle(*bundle);
+    list->Draw(3);
+    list->End();
+    IRenderCommandList* lists[] = { list.get() };
+    device.Submit(lists, 1);
+    CHECK(device.GetStats().draws == 2);
+}
+
+TEST_CASE(NullDrawRejectsDestroyedBuffers)
+{
+    NullRenderDevice device;
+    const PipelineHandle pipeline = CreateTestPipeline(device);
+    const BufferHandle vertices = CreateTestBuffer(device, 3 * 32);
+    const BufferHandle instances = CreateTestBuffer(device, sizeof(InstanceData));
+
+    std::unique_ptr<IRenderCommandList> list = device.CreateCommandList();
+    list->Begin(0);
+    list->SetPipeline(pipeline);
+    list->SetVertexBuffer(vertices, 32);
+    list->SetInstanceBuffer(instances);
+    list->Draw(3);
+    device.Destroy(instances);
+    CHECK_THROWS(list->Draw(3), std::logic_error);
+    device.Destroy(vertices);
+    CHECK_THROWS(list->Draw(3), std::logic_error);
+}
+
+TEST_CASE(NullPipelineAcceptsDepthOnly)
+{
+    static const uint8_t bytecode[4] = {};
+    NullRenderDevice device;
+    PipelineDesc desc;
+    desc.vertexShader = { bytecode, sizeof(bytecode) };
+    desc.vertexInput = VertexInput::PositionOnly;
+    desc.renderTargetCount = 0;
+    CHECK(device.CreatePipeline(desc).IsValid());
+
+    desc.depthFormat = DepthFormat::None;
+    CHECK_THROWS(device.CreatePipeline(desc), std::logic_error);
+}
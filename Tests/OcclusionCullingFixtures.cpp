@@ -0,0 +1,139 @@
+#include "OcclusionCullingFixtures.h"
+#include "TestRandom.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <sstream>
+
+namespace
+{
+    // A width by height wall, split into a grid of cells x rows quads.
+    // along is the unit direction of its width.
+    void AddWall(std::vector<OccluderTriangle>& occluders, const float base[3], const float along[3], float width, float height,
+        uint32_t cells, uint32_t rows)
+    {
+        for (uint32_t row = 0; row < rows; row++)
+        {
+            for (uint32_t cell = 0; cell < cells; cell++)
+            {
+                float corners[4][3];
+                for (int k = 0; k < 4; k++)
+                {
+                    const float s = width * (cell + ((k == 1 || k == 2) ? 1.0f : 0.0f)) / cells;
+                    const float h = height * (row + (k >= 2 ? 1.0f : 0.0f)) / rows;
+                    corners[k][0] = base[0] + along[0] * s;
+                    corners[k][1] = base[1] + h;
+                    corners[k][2] = base[2] + along[2] * s;
+                }
+                const int indices[2][3] = { { 0, 1, 2 }, { 0, 2, 3 } };
+                for (const int* triangle : indices)
+                {
+                    OccluderTriangle occluder;
+                    for (int v = 0; v < 3; v++)
+                    {
+                        memcpy(occluder.vertices[v], corners[triangle[v]], sizeof(occluder.vertices[v]));
+                    }
+                    occluders.push_back(occluder);
+                }
+            }
+        }
+    }
+}
+
+namespace OcclusionCullingFixtures
+{
+    TestScene MakeTestScene(uint32_t sphereCount, uint32_t seed)
+    {
+        TestScene scene;
+        TestRandom random(seed);
+
+        // 64 walls of 64 triangles, facing the camera or running away from
+        // it, and a ground plane that reaches behind the camera.
+        const float ground[4][3] = { { -100.0f, 0.0f, 25.0f }, { 100.0f, 0.0f, 25.0f }, { 100.0f, 0.0f, -95.0f }, { -100.0f, 0.0f, -95.0f } };
+        const int groundIndices[2][3] = { { 0, 1, 2 }, { 0, 2, 3 } };
+        for (const int* triangle : groundIndices)
+        {
+            OccluderTriangle occluder;
+            for (int v = 0; v < 3; v++)
+            {
+                memcpy(occluder.vertices[v], ground[triangle[v]], sizeof(occluder.vertices[v]));
+            }
+            scene.occluders.push_back(occluder);
+        }
+        for (uint32_t wall = 0; wall < 64; wall++)
+        {
+            const bool facing = random.Next() % 3 != 0;
+            const float along[3] = { facing ? 1.0f : 0.0f, 0.0f, facing ? 0.0f : -1.0f };
+            const float width = random.Range(3.0f, 12.0f);
+            const float base[3] = { random.Range(-30.0f, 30.0f) - (facing ? width * 0.5f : 0.0f), 0.0f, random.Range(-70.0f, -6.0f) };
+            AddWall(scene.occluders, base, along, width, random.Range(2.0f, 8.0f), 8, 4);
+        }
+
+        for (uint32_t i = 0; i < sphereCount; i++)
+        {
+            scene.spheres.push_back(random.Range(-35.0f, 35.0f));
+            scene.spheres.push_back(random.Range(0.0f, 6.0f));
+            scene.spheres.push_back(random.Range(-90.0f, -2.0f));
+            scene.spheres.push_back(random.Range(0.2f, 1.5f));
+        }
+
+        // Camera at (0, 1.7, 5) looking down -z with the engine's projection:
+        // 60 degrees vertically, 16:9, 0.1 to 100.
+        const float eye[3] = { 0.0f, 1.7f, 5.0f };
+        const float nearZ = 0.1f;
+        const float farZ = 100.0f;
+        const float yScale = 1.0f / std::tan(3.14159265f / 6.0f);
+        float view[4][4] = { { 1.0f, 0.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 1.0f, 0.0f },
+            { -eye[0], -eye[1], -eye[2], 1.0f } };
+        float projection[4][4] = {};
+        projection[0][0] = yScale * 9.0f / 16.0f;
+        projection[1][1] = yScale;
+        projection[2][2] = farZ / (nearZ - farZ);
+        projection[2][3] = -1.0f;
+        projection[3][2] = nearZ * farZ / (nearZ - farZ);
+        for (int i = 0; i < 4; i++)
+        {
+            for (int j = 0; j < 4; j++)
+            {
+                scene.viewProjection[i][j] = 0.0f;
+                for (int k = 0; k < 4; k++)
+                {
+                    scene.viewProjection[i][j] += view[i][k] * projection[k][j];
+                }
+            }
+        }
+        return scene;
+    }
+
+    bool Compare(const OcclusionBuffer& expected, const OcclusionBuffer& actual, std::string& message)
+    {
+        std::ostringstream stream;
+        if (expected.Width() != actual.Width() || expected.Height() != actual.Height())
+        {
+            stream << "size " << actual.Width() << "x" << actual.Height() << ", expected " << expected.Width() << "x" << expected.Height();
+            message = stream.str();
+            return false;
+        }
+        const uint32_t tilesX = expected.Width() / OcclusionBuffer::TileWidth;
+        const uint32_t rows = OcclusionBuffer::TileHeight;
+        for (size_t tile = 0; tile < expected.FarDepths().size(); tile++)
+        {
+            const float expectedFar = expected.FarDepths()[tile];
+            const float actualFar = actual.FarDepths()[tile];
+            const float expectedLayer = expected.LayerDepths()[tile];
+            const float actualLayer = actual.LayerDepths()[tile];
+            const bool sameDepth = memcmp(&expectedFar, &actualFar, sizeof(float)) == 0 && memcmp(&expectedLayer, &actualLayer, sizeof(float)) == 0;
+            const bool sameMask = std::equal(expected.LayerMasks().begin() + tile * rows, expected.LayerMasks().begin() + (tile + 1) * rows,
+                actual.LayerMasks().begin() + tile * rows);
+            if (!sameDepth || !sameMask)
+            {
+                stream << "tile (" << tile % tilesX << ", " << tile / tilesX << ") has far depth " << actualFar << " and layer depth "
+                    << actualLayer << ", expected " << expectedFar << " and " << expectedLayer << (sameMask ? "" : "; the coverage differs");
+                message = stream.str();
+                return false;
+            }
+        }
+        return true;
+    }
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "OcclusionCulling.h"
+
+// A scene and a comparison for checking OcclusionBuffer::Render against
+// OcclusionBuffer::RenderReference, shared by the tests and the benchmarks.
+namespace OcclusionCullingFixtures
+{
+    // A street of walls in front of a camera, with spheres scattered behind
+    // and between them.
+    struct TestScene
+    {
+        float viewProjection[4][4];
+        std::vector<OccluderTriangle> occluders;
+        std::vector<float> spheres;             // Center and radius, four floats per sphere.
+    };
+    TestScene MakeTestScene(uint32_t sphereCount, uint32_t seed);
+
+    // Compares the tiles of two renders, far depth, layer depth and coverage.
+    // On a mismatch, returns false and describes the first difference in
+    // message.
+    bool Compare(const OcclusionBuffer& expected, const OcclusionBuffer& actual, std::string& message);
+}
@@ -0,0 +1,95 @@
+#include "Test.h"
+#include "OcclusionCullingFixtures.h"
+#include "JobSystem.h"
+
+#include <stdexcept>
+
+namespace
+{
+    // A 200x200 wall across the view of the test scene's camera, 15 units
+    // in front of it.
+    std::vector<OccluderTriangle> MakeWall()
+    {
+        const float corners[4][3] = { { -100.0f, -100.0f, -10.0f }, { 100.0f, -100.0f, -10.0f }, { 100.0f, 100.0f, -10.0f },
+            { -100.0f, 100.0f, -10.0f } };
+        const int indices[2][3] = { { 0, 1, 2 }, { 0, 2, 3 } };
+        std::vector<OccluderTriangle> wall(2);
+        for (int t = 0; t < 2; t++)
+        {
+            for (int v = 0; v < 3; v++)
+            {
+                for (int axis = 0; axis < 3; axis++)
+                {
+                    wall[t].vertices[v][axis] = corners[indices[t][v]][axis];
+                }
+            }
+        }
+        return wall;
+    }
+}
+
+TEST_CASE(OcclusionRenderMatchesReference)
+{
+    JobSystem jobs(3);
+    for (uint32_t seed = 1; seed <= 3; seed++)
+    {
+        const OcclusionCullingFixtures::TestScene scene = OcclusionCullingFixtures::MakeTestScene(1000, seed);
+        const uint32_t count = static_cast<uint32_t>(scene.occluders.size());
+        OcclusionBuffer reference;
+        reference.Resize(320, 192);
+        reference.RenderReference(scene.viewProjection, scene.occluders.data(), count);
+
+        uint32_t culled = 0;
+        for (uint32_t i = 0; i < 1000; i++)
+        {
+            culled += reference.IsVisible(&scene.spheres[i * 4], scene.spheres[i * 4 + 3]) ? 0 : 1;
+        }
+        CHECK(culled > 0 && culled < 1000);
+
+        for (JobSystem* pool : { static_cast<JobSystem*>(nullptr), &jobs })
+        {
+            OcclusionBuffer buffer;
+            buffer.Resize(320, 192);
+            buffer.Render(scene.viewProjection, scene.occluders.data(), count, pool);
+            std::string mismatch;
+            CHECK_MESSAGE(OcclusionCullingFixtures::Compare(reference, buffer, mismatch), mismatch);
+            for (uint32_t i = 0; i < 1000; i++)
+            {
+                CHECK(buffer.IsVisible(&scene.spheres[i * 4], scene.spheres[i * 4 + 3]) ==
+                    reference.IsVisible(&scene.spheres[i * 4], scene.spheres[i * 4 + 3]));
+            }
+        }
+    }
+}
+
+TEST_CASE(OcclusionWallHidesWhatIsBehindIt)
+{
+    const OcclusionCullingFixtures::TestScene scene = OcclusionCullingFixtures::MakeTestScene(0, 1);
+    const std::vector<OccluderTriangle> wall = MakeWall();
+    OcclusionBuffer buffer;
+    buffer.Resize(64, 32);
+    buffer.Render(scene.viewProjection, wall.data(), 2, nullptr);
+
+    const float behind[3] = { 0.0f, 1.7f, -30.0f };
+    const float inFront[3] = { 0.0f, 1.7f, -5.0f };
+    const float offScreen[3] = { 200.0f, 1.7f, -30.0f };
+    const float atEye[3] = { 0.0f, 1.7f, 5.0f };
+    CHECK(!buffer.IsVisible(behind, 1.0f));
+    CHECK(buffer.IsVisible(inFront, 1.0f));
+    CHECK(!buffer.IsVisible(offScreen, 1.0f));
+    CHECK(buffer.IsVisible(atEye, 1.0f));
+
+    // Without occluders only what is off screen is culled.
+    buffer.Render(scene.viewProjection, nullptr, 0, nullptr);
+    CHECK(buffer.IsVisible(behind, 1.0f));
+    CHECK(!buffer.IsVisible(offScreen, 1.0f));
+}
+
+TEST_CASE(OcclusionBufferRejectsBadSizes)
+{
+    OcclusionBuffer buffer;
+    const OcclusionCullingFixtures::TestScene scene = OcclusionCullingFixtures::MakeTestScene(0, 1);
+    CHECK_THROWS(buffer.Render(scene.viewProjection, nullptr, 0, nullptr), std::logic_error);
+    CHECK_THROWS(buffer.Resize(0, OcclusionBuffer::TileHeight), std::invalid_argument);
+    CHECK_THROWS(buffer.Resize(OcclusionBuffer::TileWidth + 1, OcclusionBuffer::TileHeight), std::invalid_argument);
+}
@@ -0,0 +1,105 @@
+#include "Test.h"
+#include "RadixSort.h"
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+    // Entries numbered in submission order, so ties can be told apart.
+    template <typename MakeKey>
+    std::vector<RadixSortEntry> MakeEntries(size_t count, MakeKey makeKey)
+    {
+        std::vector<RadixSortEntry> entries(count);
+        for (size_t i = 0; i < count; i++)
+        {
+            entries[i].key = makeKey();
+            entries[i].value = static_cast<uint32_t>(i);
+        }
+        return entries;
+    }
+
+    // Sorts entries with RadixSort and with std::stable_sort and compares the
+    // two orders entry for entry.
+    bool SortsLikeStableSort(std::vector<RadixSortEntry> entries, RadixSortScratch& scratch, JobSystem* jobs, size_t parallelThreshold,
+        std::string& message)
+    {
+        std::vector<RadixSortEntry> expected = entries;
+        std::stable_sort(expected.begin(), expected.end(), [](const RadixSortEntry& a, const RadixSortEntry& b) { return a.key < b.key; });
+
+        RadixSort(entries, scratch, jobs, parallelThreshold);
+        if (entries.size() != expected.size())
+        {
+            message = "sorted " + std::to_string(entries.size()) + " entries, expected " + std::to_string(expected.size());
+            return false;
+        }
+        for (size_t i = 0; i < entries.size(); i++)
+        {
+            if (entries[i].key != expected[i].key || entries[i].value != expected[i].value)
+            {
+                message = "entry " + std::to_string(i) + " is " + std::to_string(entries[i].value) + ", expected " + std::to_string(expected[i].value);
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+TEST_CASE(RadixSortMatchesStableSort)
+{
+    std::mt19937_64 random(1);
+    RadixSortScratch scratch;
+    std::string message;
+
+    // Full width keys, then keys from a small range, so many of them tie.
+    CHECK_MESSAGE(SortsLikeStableSort(MakeEntries(10000, [&]() { return random(); }), scratch, nullptr, 0, message), message);
+    CHECK_MESSAGE(SortsLikeStableSort(MakeEntries(10000, [&]() { return random() % 64; }), scratch, nullptr, 0, message), message);
+
+    // The scratch is reused for shorter and longer lists.
+    for (size_t count : { 0, 1, 2, 7, 3000, 20000 })
+    {
+        CHECK_MESSAGE(SortsLikeStableSort(MakeEntries(count, [&]() { return random() >> (random() % 64); }), scratch, nullptr, 0, message),
+            std::to_string(count) + " entries: " + message);
+    }
+}
+
+TEST_CASE(RadixSortMatchesStableSortOnJobs)
+{
+    // Over the 32K default threshold, split into a chunk per thread; ties
+    // must keep submission order across chunks too.
+    JobSystem jobs(3);
+    std::mt19937_64 random(2);
+    RadixSortScratch scratch;
+    std::string message;
+    CHECK_MESSAGE(SortsLikeStableSort(MakeEntries(100000, [&]() { return random(); }), scratch, &jobs, 32 * 1024, message), message);
+    CHECK_MESSAGE(SortsLikeStableSort(MakeEntries(100000, [&]() { return random() % 1000; }), scratch, &jobs, 32 * 1024, message), message);
+
+    // Uneven chunks, and lists just under the threshold on the calling
+    // thread.
+    CHECK_MESSAGE(SortsLikeStableSort(MakeEntries(40001, [&]() { return random() % 100000; }), scratch, &jobs, 32 * 1024, message), message);
+    CHECK_MESSAGE(SortsLikeStableSort(MakeEntries(32 * 1024 - 1, [&]() { return random(); }), scratch, &jobs, 32 * 1024, message), message);
+}
+
+TEST_CASE(RadixSortSkipsConstantDigits)
+{
+    // Draw keys with a single pass and pipeline and depth left at zero: most
+    // digits are the same in every key, and the passes over them are
+    // skipped, serially and on jobs. Keys that are all equal skip every pass
+    // and must come back in submission order.
+    JobSystem jobs(3);
+    std::mt19937_64 random(3);
+    RadixSortScratch scratch;
+    std::string message;
+    const auto drawKey = [&]() { return (uint64_t(1) << 60) | (uint64_t(5) << 48) | ((random() % 4) << 32) | (random() % 16); };
+    const auto highBits = [&]() { return (random() % 8) << 61; };
+    const auto constant = []() { return uint64_t(0x123456789abcdefull); };
+    for (JobSystem* pool : { static_cast<JobSystem*>(nullptr), &jobs })
+    {
+        const std::string context = pool ? "jobs: " : "serial: ";
+        CHECK_MESSAGE(SortsLikeStableSort(MakeEntries(50000, drawKey), scratch, pool, 32 * 1024, message), context + message);
+        CHECK_MESSAGE(SortsLikeStableSort(MakeEntries(50000, highBits), scratch, pool, 32 * 1024, message), context + message);
+        CHECK_MESSAGE(SortsLikeStableSort(MakeEntries(50000, constant), scratch, pool, 32 * 1024, message), context + message);
+    }
+}
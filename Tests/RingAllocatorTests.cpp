@@ -0,0 +1,104 @@
+#include "Test.h"
+#include "RingAllocator.h"
+#include "TestRandom.h"
+
+#include <deque>
+#include <vector>
+
+namespace
+{
+    struct Allocation
+    {
+        uint64_t offset;
+        uint64_t size;
+    };
+}
+
+TEST_CASE(RingAllocatorStressWrapsAndRetiresByFence)
+{
+    // Frames allocate random sizes and alignments while the GPU completes
+    // them 0 to 3 frames late. Every byte handed out is owned by its frame
+    // until that frame's fence retires, so no two live allocations overlap.
+    const uint64_t capacity = 64 * 1024;
+    const uint64_t alignments[] = { 1, 16, 256 };
+    RingAllocator ring(capacity);
+    std::vector<uint64_t> owner(capacity, 0);
+    std::deque<std::vector<Allocation>> inFlight;
+    uint64_t completed = 0;
+    uint64_t wraps = 0, refusals = 0;
+    uint64_t previousOffset = 0;
+    TestRandom random(12345);
+
+    for (uint64_t fence = 1; fence <= 20000; fence++)
+    {
+        std::vector<Allocation> frame;
+        const uint32_t count = 1 + random.Next() % 24;
+        for (uint32_t i = 0; i < count; i++)
+        {
+            const uint64_t size = 1 + random.Next() % 4096;
+            const uint64_t alignment = alignments[random.Next() % 3];
+            const uint64_t offset = ring.Allocate(size, alignment);
+            if (offset == RingAllocator::InvalidOffset)
+            {
+                refusals++;
+                break;
+            }
+
+            CHECK(offset % alignment == 0);
+            CHECK(offset + size <= capacity);
+            for (uint64_t byte = offset; byte < offset + size; byte++)
+            {
+                CHECK(owner[byte] == 0);
+                owner[byte] = fence;
+            }
+            wraps += offset < previousOffset;
+            previousOffset = offset;
+            frame.push_back({ offset, size });
+        }
+        ring.FinishFrame(fence);
+        inFlight.push_back(frame);
+
+        // The GPU catches up to somewhere between 3 frames behind and now.
+        const uint64_t lag = random.Next() % 4;
+        const uint64_t target = fence > lag ? fence - lag : 0;
+        while (completed < target)
+        {
+            completed++;
+            for (const Allocation& allocation : inFlight.front())
+            {
+                for (uint64_t byte = allocation.offset; byte < allocation.offset + allocation.size; byte++)
+                {
+                    CHECK(owner[byte] == completed);
+                    owner[byte] = 0;
+                }
+            }
+            inFlight.pop_front();
+        }
+        ring.Retire(completed);
+    }
+
+    CHECK(wraps > 100);
+    CHECK(refusals > 0);
+
+    // Once everything has retired the whole ring is available again.
+    ring.Retire(~0ull);
+    CHECK(ring.UsedBytes() == 0);
+    CHECK(ring.Allocate(capacity, 256) == 0);
+}
+
+TEST_CASE(RingAllocatorRefusesUntilTheFenceRetires)
+{
+    RingAllocator ring(1024);
+    CHECK(ring.Allocate(768) == 0);
+    ring.FinishFrame(1);
+    CHECK(ring.Allocate(512) == RingAllocator::InvalidOffset);
+    CHECK(ring.Allocate(256) == 768);
+    ring.FinishFrame(2);
+
+    // The next allocation would straddle the end, so it starts at 0 once
+    // frame 1 is done.
+    CHECK(ring.Allocate(256) == RingAllocator::InvalidOffset);
+    ring.Retire(1);
+    CHECK(ring.Allocate(512) == 0);
+    CHECK(ring.UsedBytes() == 768);
+}
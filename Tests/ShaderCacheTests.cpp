@@ -0,0 +1,262 @@
+#include "Test.h"
+#include "ShaderCache.h"
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <stdexcept>
+
+namespace
+{
+    // Shader sources and includes in memory, by path.
+    class Files
+    {
+    public:
+        std::map<std::string, std::string> contents;
+
+        ShaderCache::FileReader Reader() const
+        {
+            return [this](const std::string& path, std::string& result)
+            {
+                auto found = contents.find(path);
+                if (found == contents.end())
+                {
+                    return false;
+                }
+                result = found->second;
+                return true;
+            };
+        }
+    };
+
+    // Counts compiles; the bytecode is the source, so a stale hit shows up
+    // as the wrong bytes.
+    struct CountingCompiler
+    {
+        uint32_t calls = 0;
+
+        ShaderCache::Compiler Function()
+        {
+            return [this](const ShaderCompileRequest& request, std::vector<uint8_t>& bytecode, std::string&)
+            {
+                calls++;
+                bytecode.assign(request.source.begin(), request.source.end());
+                return true;
+            };
+        }
+    };
+
+    ShaderCompileRequest MakeRequest(const std::string& source)
+    {
+        ShaderCompileRequest request;
+        request.sourcePath = "shaders/Scene.hlsl";
+        request.source = source;
+        request.defines = { { "SHADOWS", "1" } };
+        request.entryPoint = "PSMain";
+        request.target = "ps_5_1";
+        return request;
+    }
+
+    std::vector<uint8_t> Bytes(const std::string& text)
+    {
+        return std::vector<uint8_t>(text.begin(), text.end());
+    }
+
+    // A cache file next to the test binary, removed again when done.
+    struct TempPath
+    {
+        std::string path;
+
+        explicit TempPath(const char* name) : path(name) { Clear(); }
+        ~TempPath() { Clear(); }
+
+        void Clear()
+        {
+            std::remove(path.c_str());
+            std::remove((path + ".tmp").c_str());
+        }
+    };
+}
+
+TEST_CASE(ShaderCacheKeyCoversEveryCompileInput)
+{
+    Files files;
+    files.contents["shaders/Common.hlsli"] = "float4 Tint;";
+    const ShaderCompileRequest request = MakeRequest("#include \"Common.hlsli\"\nfloat4 PSMain() : SV_Target { return Tint; }");
+    const uint64_t key = ShaderCache::ComputeKey(request, files.Reader());
+    CHECK(ShaderCache::ComputeKey(request, files.Reader()) == key);
+
+    ShaderCompileRequest changed = request;
+    changed.source += "\n";
+    CHECK(ShaderCache::ComputeKey(changed, files.Reader()) != key);
+    changed = request;
+    changed.defines[0].value = "0";
+    CHECK(ShaderCache::ComputeKey(changed, files.Reader()) != key);
+    changed = request;
+    changed.entryPoint = "PSMainAlpha";
+    CHECK(ShaderCache::ComputeKey(changed, files.Reader()) != key);
+    changed = request;
+    changed.target = "ps_6_0";
+    CHECK(ShaderCache::ComputeKey(changed, files.Reader()) != key);
+    changed = request;
+    changed.flags = 1;
+    CHECK(ShaderCache::ComputeKey(changed, files.Reader()) != key);
+
+    files.contents["shaders/Common.hlsli"] = "float4 Tint = 1;";
+    CHECK(ShaderCache::ComputeKey(request, files.Reader()) != key);
+    files.contents.erase("shaders/Common.hlsli");
+    CHECK(ShaderCache::ComputeKey(request, files.Reader()) != key);
+}
+
+TEST_CASE(ShaderCacheKeyFollowsNestedAndCyclicIncludes)
+{
+    // Includes resolve relative to the including file, and a cycle is
+    // hashed once instead of recursing forever.
+    Files files;
+    files.contents["shaders/A.hlsli"] = "  #  include <lib/B.hlsli>\n";
+    files.contents["shaders/lib/B.hlsli"] = "#include \"C.hlsli\"\n";
+    files.contents["shaders/lib/C.hlsli"] = "#include \"C.hlsli\"\nfloat c;";
+    const ShaderCompileRequest request = MakeRequest("#include \"A.hlsli\"\n");
+    const uint64_t key = ShaderCache::ComputeKey(request, files.Reader());
+
+    files.contents["shaders/lib/C.hlsli"] = "#include \"C.hlsli\"\nfloat c2;";
+    CHECK(ShaderCache::ComputeKey(request, files.Reader()) != key);
+
+    // A path the include does not resolve to is never read.
+    files.contents["shaders/C.hlsli"] = "unrelated";
+    files.contents["shaders/lib/C.hlsli"] = "#include \"C.hlsli\"\nfloat c;";
+    CHECK(ShaderCache::ComputeKey(request, files.Reader()) == key);
+}
+
+TEST_CASE(ShaderCacheIdentitySeparatesPermutations)
+{
+    const ShaderCompileRequest request = MakeRequest("");
+    ShaderCompileRequest other = request;
+    other.defines[0].value = "0";
+    CHECK(ShaderCache::Identity(request) != ShaderCache::Identity(other));
+    other = request;
+    other.target = "vs_5_1";
+    CHECK(ShaderCache::Identity(request) != ShaderCache::Identity(other));
+
+    // The source text is in the key, not the identity, so an edit replaces
+    // the entry instead of adding one.
+    other = request;
+    other.source = "changed";
+    CHECK(ShaderCache::Identity(request) == ShaderCache::Identity(other));
+}
+
+TEST_CASE(ShaderCacheFindEvictsStaleEntries)
+{
+    ShaderCache cache;
+    cache.Store("shader", 1, Bytes("one"));
+    CHECK(cache.EntryCount() == 1);
+
+    const std::vector<uint8_t>* found = cache.Find("shader", 1);
+    CHECK(found && *found == Bytes("one"));
+    CHECK(!cache.Find("other", 1));
+    CHECK(cache.EntryCount() == 1);
+
+    CHECK(!cache.Find("shader", 2));
+    CHECK(cache.EntryCount() == 0);
+    CHECK(!cache.Find("shader", 1));
+
+    const ShaderCache::Stats& stats = cache.GetStats();
+    CHECK(stats.hits == 1);
+    CHECK(stats.misses == 3);
+    CHECK(stats.invalidated == 1);
+}
+
+TEST_CASE(ShaderCacheGetOrCompileRecompilesWhenAnIncludeChanges)
+{
+    Files files;
+    files.contents["shaders/Common.hlsli"] = "float4 Tint;";
+    const ShaderCompileRequest request = MakeRequest("#include \"Common.hlsli\"\n");
+    ShaderCache cache;
+    CountingCompiler compiler;
+
+    CHECK(cache.GetOrCompile(request, files.Reader(), compiler.Function()) == Bytes(request.source));
+    CHECK(cache.GetOrCompile(request, files.Reader(), compiler.Function()) == Bytes(request.source));
+    CHECK(compiler.calls == 1);
+
+    files.contents["shaders/Common.hlsli"] = "float4 Tint = 1;";
+    cache.GetOrCompile(request, files.Reader(), compiler.Function());
+    CHECK(compiler.calls == 2);
+    CHECK(cache.EntryCount() == 1);
+
+    const ShaderCache::Stats& stats = cache.GetStats();
+    CHECK(stats.hits == 1);
+    CHECK(stats.misses == 2);
+    CHECK(stats.invalidated == 1);
+    CHECK(stats.compiled == 2);
+}
+
+TEST_CASE(ShaderCacheGetOrCompileThrowsCompilerErrors)
+{
+    ShaderCache cache;
+    const ShaderCache::Compiler failing = [](const ShaderCompileRequest&, std::vector<uint8_t>&, std::string& errors)
+    {
+        errors = "error X3000: syntax error";
+        return false;
+    };
+    CHECK_THROWS(cache.GetOrCompile(MakeRequest("}"), nullptr, failing), std::runtime_error);
+    CHECK(cache.EntryCount() == 0);
+}
+
+TEST_CASE(ShaderCacheSaveReplacesTheFileAndLoadReadsItBack)
+{
+    TempPath file("ShaderCacheTests.bin");
+    {
+        ShaderCache cache(file.path);
+        CHECK(!cache.Load());
+        cache.Store("a", 1, Bytes("first"));
+        cache.Store("b", 2, std::vector<uint8_t>());
+        CHECK(cache.Save());
+    }
+    {
+        // Saving over an existing cache replaces it.
+        ShaderCache cache(file.path);
+        CHECK(cache.Load());
+        CHECK(cache.EntryCount() == 2);
+        cache.Store("a", 3, Bytes("second"));
+        CHECK(cache.Save());
+        CHECK(!std::ifstream(file.path + ".tmp"));
+    }
+
+    ShaderCache cache(file.path);
+    CHECK(cache.Load());
+    CHECK(cache.EntryCount() == 2);
+    const std::vector<uint8_t>* a = cache.Find("a", 3);
+    CHECK(a && *a == Bytes("second"));
+    const std::vector<uint8_t>* b = cache.Find("b", 2);
+    CHECK(b && b->empty());
+}
+
+TEST_CASE(ShaderCacheDiscardsDamagedFiles)
+{
+    TempPath file("ShaderCacheDamaged.bin");
+    {
+        ShaderCache cache(file.path);
+        cache.Store("a", 1, Bytes("bytecode"));
+        CHECK(cache.Save());
+    }
+
+    // Flip the last bytecode byte, so the checksum no longer matches.
+    std::string contents;
+    {
+        std::ifstream in(file.path, std::ios::binary);
+        contents.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+    CHECK(!contents.empty());
+    contents.back() ^= 1;
+    std::ofstream(file.path, std::ios::binary | std::ios::trunc).write(contents.data(), contents.size());
+
+    ShaderCache cache(file.path);
+    CHECK(!cache.Load());
+    CHECK(cache.EntryCount() == 0);
+
+    // The empty cache is written back, and loads cleanly from then on.
+    CHECK(cache.Save());
+    CHECK(cache.Load());
+    CHECK(cache.EntryCount() == 0);
+}
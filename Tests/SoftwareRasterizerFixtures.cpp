@@ -0,0 +1,303 @@
+#include "StrictFloat.h"
+#include "SoftwareRasterizerFixtures.h"
+#include "TestRandom.h"
+
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+namespace
+{
+    // Appends the 12 triangles of a box, rotated about y by the angle with
+    // cosine c and sine s, with each face mapped to the whole texture.
+    void AddBox(std::vector<RasterVertex>& vertices, const float center[3], const float halfSize[3], float c, float s)
+    {
+        auto rotate = [c, s](const float v[3], float out[3])
+        {
+            out[0] = c * v[0] + s * v[2];
+            out[1] = v[1];
+            out[2] = -s * v[0] + c * v[2];
+        };
+
+        // Per face: normal axis and sign; the other two axes span it.
+        for (int axis = 0; axis < 3; axis++)
+        {
+            for (int sign = -1; sign <= 1; sign += 2)
+            {
+                const int u = (axis + 1) % 3;
+                const int v = (axis + 2) % 3;
+                float normal[3] = {};
+                normal[axis] = static_cast<float>(sign);
+                RasterVertex corners[4];
+                for (int k = 0; k < 4; k++)
+                {
+                    float local[3];
+                    local[axis] = sign * halfSize[axis];
+                    local[u] = (k == 1 || k == 2 ? 1.0f : -1.0f) * halfSize[u];
+                    local[v] = (k >= 2 ? 1.0f : -1.0f) * halfSize[v];
+                    float rotated[3];
+                    rotate(local, rotated);
+                    for (int i = 0; i < 3; i++)
+                    {
+                        corners[k].position[i] = center[i] + rotated[i];
+                    }
+                    rotate(normal, corners[k].normal);
+                    corners[k].uv[0] = k == 1 || k == 2 ? 1.0f : 0.0f;
+                    corners[k].uv[1] = k >= 2 ? 1.0f : 0.0f;
+                }
+                const int indices[6] = { 0, 1, 2, 0, 2, 3 };
+                for (int i : indices)
+                {
+                    vertices.push_back(corners[i]);
+                }
+            }
+        }
+    }
+
+    void Cross(const float a[3], const float b[3], float result[3])
+    {
+        result[0] = a[1] * b[2] - a[2] * b[1];
+        result[1] = a[2] * b[0] - a[0] * b[2];
+        result[2] = a[0] * b[1] - a[1] * b[0];
+    }
+
+    void Normalize(float v[3])
+    {
+        const float length = std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+        for (int i = 0; i < 3; i++)
+        {
+            v[i] /= length;
+        }
+    }
+
+    // A 64x64 checkerboard of 8x8 squares, and the ground, tiled with it,
+    // as the first triangles.
+    std::unique_ptr<SoftwareRasterizerFixtures::TestScene> MakeGround()
+    {
+        std::unique_ptr<SoftwareRasterizerFixtures::TestScene> test(new SoftwareRasterizerFixtures::TestScene());
+        const uint32_t size = 64;
+        test->texels.resize(size * size * 4);
+        for (uint32_t y = 0; y < size; y++)
+        {
+            for (uint32_t x = 0; x < size; x++)
+            {
+                const bool light = ((x / 8) + (y / 8)) % 2 == 0;
+                uint8_t* texel = &test->texels[(y * size + x) * 4];
+                texel[0] = light ? 230 : 40;
+                texel[1] = light ? 200 : 60;
+                texel[2] = light ? 150 : 90;
+                texel[3] = 255;
+            }
+        }
+        test->checkerboard.width = size;
+        test->checkerboard.height = size;
+        test->checkerboard.rowPitch = size * 4;
+        test->checkerboard.texels = test->texels.data();
+
+        const float ground[4][2] = { { -200.0f, -200.0f }, { 200.0f, -200.0f }, { 200.0f, 200.0f }, { -200.0f, 200.0f } };
+        const int groundIndices[6] = { 0, 1, 2, 0, 2, 3 };
+        for (int i : groundIndices)
+        {
+            RasterVertex vertex = { { ground[i][0], 0.0f, ground[i][1] }, { 0.0f, 1.0f, 0.0f }, { ground[i][0] / 4.0f, ground[i][1] / 4.0f } };
+            test->vertices.push_back(vertex);
+        }
+        return test;
+    }
+
+    // Splits the triangles into a textured draw of the first texturedCount
+    // vertices and an untextured one of the rest.
+    void AddDraws(SoftwareRasterizerFixtures::TestScene& test, uint32_t texturedCount)
+    {
+        RasterDraw textured;
+        textured.vertexCount = texturedCount;
+        textured.albedo = &test.checkerboard;
+        test.draws.push_back(textured);
+        if (texturedCount < test.vertices.size())
+        {
+            RasterDraw untextured;
+            untextured.firstVertex = texturedCount;
+            untextured.vertexCount = static_cast<uint32_t>(test.vertices.size()) - texturedCount;
+            test.draws.push_back(untextured);
+        }
+    }
+
+    // Camera at (0, 2, 7) looking slightly down the -z axis, with the
+    // engine's projection: 60 degrees vertically, 0.1 to 100. Also points
+    // the scene at the test's members.
+    void SetCamera(SoftwareRasterizerFixtures::TestScene& test, float aspect)
+    {
+        const float eye[3] = { 0.0f, 2.0f, 7.0f };
+        float forward[3] = { 0.0f, -0.15f, -1.0f };
+        Normalize(forward);
+        const float up[3] = { 0.0f, 1.0f, 0.0f };
+        float back[3] = { -forward[0], -forward[1], -forward[2] };
+        float right[3], trueUp[3];
+        Cross(up, back, right);
+        Normalize(right);
+        Cross(back, right, trueUp);
+
+        float view[4][4] = {};
+        for (int i = 0; i < 3; i++)
+        {
+            view[i][0] = right[i];
+            view[i][1] = trueUp[i];
+            view[i][2] = back[i];
+        }
+        view[3][0] = -(right[0] * eye[0] + right[1] * eye[1] + right[2] * eye[2]);
+        view[3][1] = -(trueUp[0] * eye[0] + trueUp[1] * eye[1] + trueUp[2] * eye[2]);
+        view[3][2] = -(back[0] * eye[0] + back[1] * eye[1] + back[2] * eye[2]);
+        view[3][3] = 1.0f;
+
+        const float nearZ = 0.1f;
+        const float farZ = 100.0f;
+        const float yScale = 1.7320508f;        // 1 / tan(30 degrees)
+        float projection[4][4] = {};
+        projection[0][0] = yScale / aspect;
+        projection[1][1] = yScale;
+        projection[2][2] = farZ / (nearZ - farZ);
+        projection[2][3] = -1.0f;
+        projection[3][2] = nearZ * farZ / (nearZ - farZ);
+
+        RasterScene& scene = test.scene;
+        for (int i = 0; i < 4; i++)
+        {
+            for (int j = 0; j < 4; j++)
+            {
+                scene.viewProjection[i][j] = 0.0f;
+                for (int k = 0; k < 4; k++)
+                {
+                    scene.viewProjection[i][j] += view[i][k] * projection[k][j];
+                }
+            }
+        }
+        float toLight[3] = { 6.0f, 9.0f, 4.0f };
+        Normalize(toLight);
+        memcpy(scene.toLight, toLight, sizeof(toLight));
+        scene.vertices = test.vertices.data();
+        scene.draws = test.draws.data();
+        scene.drawCount = static_cast<uint32_t>(test.draws.size());
+    }
+}
+
+namespace SoftwareRasterizerFixtures
+{
+    std::unique_ptr<TestScene> MakeTestScene(uint32_t boxCount, uint32_t seed, float aspect)
+    {
+        std::unique_ptr<TestScene> test = MakeGround();
+        TestRandom random(seed);
+
+        // Textured: the ground and the first half of the boxes.
+        uint32_t texturedCount = static_cast<uint32_t>(test->vertices.size());
+        for (uint32_t box = 0; box < boxCount; box++)
+        {
+            if (box == boxCount / 2)
+            {
+                texturedCount = static_cast<uint32_t>(test->vertices.size());
+            }
+            const float center[3] = { random.Range(-30.0f, 30.0f), random.Range(0.0f, 6.0f), random.Range(-60.0f, 2.0f) };
+            const float halfSize[3] = { random.Range(0.2f, 1.5f), random.Range(0.2f, 1.5f), random.Range(0.2f, 1.5f) };
+            const float angle = random.Range(0.0f, 6.2831853f);
+            AddBox(test->vertices, center, halfSize, std::cos(angle), std::sin(angle));
+        }
+        AddDraws(*test, texturedCount);
+        SetCamera(*test, aspect);
+        return test;
+    }
+
+    std::unique_ptr<TestScene> MakeGoldenScene(float aspect)
+    {
+        std::unique_ptr<TestScene> test = MakeGround();
+
+        // Textured: the ground, a cube and a slab turned 45 degrees. Then a
+        // tall pillar in the distance, and a small box beside the camera that
+        // crosses the near plane and the guard band.
+        const float halfTurn = 0.70710678f;
+        const float cubeCenter[3] = { -2.0f, 0.75f, -4.0f };
+        const float cubeHalfSize[3] = { 0.75f, 0.75f, 0.75f };
+        AddBox(test->vertices, cubeCenter, cubeHalfSize, 1.0f, 0.0f);
+        const float slabCenter[3] = { 1.5f, 1.0f, -6.0f };
+        const float slabHalfSize[3] = { 1.0f, 1.0f, 0.5f };
+        AddBox(test->vertices, slabCenter, slabHalfSize, halfTurn, halfTurn);
+        const uint32_t texturedCount = static_cast<uint32_t>(test->vertices.size());
+
+        const float pillarCenter[3] = { 4.0f, 2.0f, -15.0f };
+        const float pillarHalfSize[3] = { 0.5f, 2.0f, 0.5f };
+        AddBox(test->vertices, pillarCenter, pillarHalfSize, halfTurn, -halfTurn);
+        const float nearCenter[3] = { -0.6f, 1.6f, 6.5f };
+        const float nearHalfSize[3] = { 0.3f, 0.3f, 0.3f };
+        AddBox(test->vertices, nearCenter, nearHalfSize, 1.0f, 0.0f);
+
+        AddDraws(*test, texturedCount);
+        SetCamera(*test, aspect);
+        return test;
+    }
+
+    bool LoadPpm(const std::string& path, uint32_t& width, uint32_t& height, std::vector<uint32_t>& pixels)
+    {
+        std::ifstream file(path, std::ios::binary);
+        std::string magic;
+        uint32_t maxValue = 0;
+        if (!(file >> magic >> width >> height >> maxValue) || magic != "P6" || maxValue != 255 || file.get() != '\n')
+        {
+            return false;
+        }
+        pixels.resize(static_cast<size_t>(width) * height);
+        std::vector<uint8_t> row(static_cast<size_t>(width) * 3);
+        for (uint32_t y = 0; y < height; y++)
+        {
+            if (!file.read(reinterpret_cast<char*>(row.data()), row.size()))
+            {
+                return false;
+            }
+            for (uint32_t x = 0; x < width; x++)
+            {
+                pixels[static_cast<size_t>(y) * width + x] = 0xFF000000u | row[x * 3] | (row[x * 3 + 1] << 8) | (row[x * 3 + 2] << 16);
+            }
+        }
+        return true;
+    }
+
+    bool Compare(const SoftwareRasterizer& expected, const SoftwareRasterizer& actual, std::string& message)
+    {
+        if (!CompareImage(expected.Width(), expected.Height(), expected.Color(), actual, message))
+        {
+            return false;
+        }
+        for (size_t pixel = 0; pixel < expected.Depth().size(); pixel++)
+        {
+            if (memcmp(&expected.Depth()[pixel], &actual.Depth()[pixel], sizeof(float)) != 0)
+            {
+                std::ostringstream stream;
+                stream << "pixel (" << pixel % expected.Width() << ", " << pixel / expected.Width() << ") has depth "
+                    << actual.Depth()[pixel] << ", expected " << expected.Depth()[pixel];
+                message = stream.str();
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool CompareImage(uint32_t width, uint32_t height, const std::vector<uint32_t>& expected, const SoftwareRasterizer& actual,
+        std::string& message)
+    {
+        std::ostringstream stream;
+        if (width != actual.Width() || height != actual.Height())
+        {
+            stream << "size " << actual.Width() << "x" << actual.Height() << ", expected " << width << "x" << height;
+            message = stream.str();
+            return false;
+        }
+        for (size_t pixel = 0; pixel < expected.size(); pixel++)
+        {
+            if (expected[pixel] != actual.Color()[pixel])
+            {
+                stream << "pixel (" << pixel % width << ", " << pixel / width << ") is color " << std::hex << actual.Color()[pixel]
+                    << ", expected " << expected[pixel];
+                message = stream.str();
+                return false;
+            }
+        }
+        return true;
+    }
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "SoftwareRasterizer.h"
+
+// Scenes, a golden image reader and a comparison for checking
+// SoftwareRasterizer, shared by the tests and the benchmarks.
+namespace SoftwareRasterizerFixtures
+{
+    // Boxes on a ground plane that reaches behind the camera, the ground and
+    // half of the boxes textured with a checkerboard.
+    struct TestScene
+    {
+        std::vector<RasterVertex> vertices;
+        std::vector<uint8_t> texels;
+        RasterTexture checkerboard;
+        std::vector<RasterDraw> draws;
+        RasterScene scene;                      // Points into the members above.
+    };
+
+    // boxCount random boxes, for comparing the renderers and timing them.
+    std::unique_ptr<TestScene> MakeTestScene(uint32_t boxCount, uint32_t seed, float aspect);
+
+    // A few boxes placed by hand, one of them crossing the near plane, for
+    // the golden image. Built without any C library math beyond sqrt, so it
+    // is the same with every compiler.
+    std::unique_ptr<TestScene> MakeGoldenScene(float aspect);
+
+    // Reads a binary PPM as SoftwareRasterizer::SavePpm writes it, as RGBA8
+    // pixels with full alpha. Returns false if the file is missing or not
+    // such a PPM.
+    bool LoadPpm(const std::string& path, uint32_t& width, uint32_t& height, std::vector<uint32_t>& pixels);
+
+    // Compares the images and depth of two renders. On a mismatch, returns
+    // false and describes the first difference in message.
+    bool Compare(const SoftwareRasterizer& expected, const SoftwareRasterizer& actual, std::string& message);
+
+    // Compares a render's image to a golden one, the same way.
+    bool CompareImage(uint32_t width, uint32_t height, const std::vector<uint32_t>& expected, const SoftwareRasterizer& actual,
+        std::string& message);
+}
@@ -0,0 +1,92 @@
+#include "Test.h"
+#include "SoftwareRasterizerFixtures.h"
+#include "JobSystem.h"
+
+#include <stdexcept>
+
+namespace
+{
+    const float Aspect = 16.0f / 9;
+
+    // Golden images live in Tests/Golden, found from this file's path as the
+    // compiler gives it; the project compiles with full paths, so the tests
+    // run from any directory.
+    std::string GoldenPath(const char* name)
+    {
+        const std::string source = __FILE__;
+        const size_t slash = source.find_last_of("/\\");
+        return (slash == std::string::npos ? std::string() : source.substr(0, slash + 1)) + "Golden/" + name;
+    }
+
+    // On a mismatch, saves the render next to the golden image, with
+    // .actual.ppm in place of .ppm, so the two can be looked at side by side;
+    // copy it over the golden image once a change to the image is intended.
+    void CheckMatchesGolden(const std::string& path, const SoftwareRasterizer& rasterizer)
+    {
+        uint32_t width = 0, height = 0;
+        std::vector<uint32_t> golden;
+        const bool loaded = SoftwareRasterizerFixtures::LoadPpm(path, width, height, golden);
+        std::string mismatch = "cannot read " + path;
+        if (!loaded || !SoftwareRasterizerFixtures::CompareImage(width, height, golden, rasterizer, mismatch))
+        {
+            const std::string actualPath = path.substr(0, path.size() - 4) + ".actual.ppm";
+            rasterizer.SavePpm(actualPath);
+            CHECK_MESSAGE(false, mismatch + "; the image is in " + actualPath);
+        }
+    }
+}
+
+TEST_CASE(SoftwareRasterizerMatchesGoldenImage)
+{
+    const std::unique_ptr<SoftwareRasterizerFixtures::TestScene> scene = SoftwareRasterizerFixtures::MakeGoldenScene(Aspect);
+    const std::string path = GoldenPath("SoftwareRasterizer.ppm");
+    JobSystem jobs(3);
+
+    SoftwareRasterizer reference;
+    reference.Resize(192, 108);
+    reference.RenderReference(scene->scene);
+    CheckMatchesGolden(path, reference);
+    CHECK(reference.GetStats().clippedTriangles > 0);
+
+    for (JobSystem* pool : { static_cast<JobSystem*>(nullptr), &jobs })
+    {
+        SoftwareRasterizer rasterizer;
+        rasterizer.Resize(192, 108);
+        rasterizer.Render(scene->scene, pool);
+        CheckMatchesGolden(path, rasterizer);
+    }
+}
+
+TEST_CASE(SoftwareRasterizerMatchesReference)
+{
+    // Sizes with whole and partial tiles, and a scene of several chunks.
+    const uint32_t sizes[][2] = { { 320, 180 }, { 97, 61 } };
+    JobSystem jobs(3);
+    for (uint32_t seed = 1; seed <= 2; seed++)
+    {
+        const std::unique_ptr<SoftwareRasterizerFixtures::TestScene> scene = SoftwareRasterizerFixtures::MakeTestScene(500, seed, Aspect);
+        for (const uint32_t* size : sizes)
+        {
+            SoftwareRasterizer reference;
+            reference.Resize(size[0], size[1]);
+            reference.RenderReference(scene->scene);
+            for (JobSystem* pool : { static_cast<JobSystem*>(nullptr), &jobs })
+            {
+                SoftwareRasterizer rasterizer;
+                rasterizer.Resize(size[0], size[1]);
+                rasterizer.Render(scene->scene, pool);
+                std::string mismatch;
+                CHECK_MESSAGE(SoftwareRasterizerFixtures::Compare(reference, rasterizer, mismatch), mismatch);
+            }
+        }
+    }
+}
+
+TEST_CASE(SoftwareRasterizerRejectsBadSizes)
+{
+    const std::unique_ptr<SoftwareRasterizerFixtures::TestScene> scene = SoftwareRasterizerFixtures::MakeGoldenScene(Aspect);
+    SoftwareRasterizer rasterizer;
+    CHECK_THROWS(rasterizer.Render(scene->scene, nullptr), std::logic_error);
+    CHECK_THROWS(rasterizer.Resize(0, 1), std::invalid_argument);
+    CHECK_THROWS(rasterizer.Resize(1, SoftwareRasterizer::MaxSize + 1), std::invalid_argument);
+}
@@ -0,0 +1,237 @@
+#include "SupercompressedTextureFixtures.h"
+#include "TestRandom.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <sstream>
+
+using namespace SupercompressedTexture;
+
+namespace
+{
+    void Unpack565(uint32_t c, int rgb[3])
+    {
+        const int r = (c >> 11) & 31, g = (c >> 5) & 63, b = c & 31;
+        rgb[0] = (r << 3) | (r >> 2);
+        rgb[1] = (g << 2) | (g >> 4);
+        rgb[2] = (b << 3) | (b >> 2);
+    }
+
+    // BC1 blocks with c0 <= c1 have three colours and transparent black; the
+    // colour half of a BC3 block always has four.
+    void DecodeColorBlock(const uint8_t block[8], bool punchThrough, uint8_t rgba[64])
+    {
+        const uint32_t c0 = block[0] | (block[1] << 8);
+        const uint32_t c1 = block[2] | (block[3] << 8);
+        const bool threeColor = punchThrough && c0 <= c1;
+        int palette[4][4];
+        Unpack565(c0, palette[0]);
+        Unpack565(c1, palette[1]);
+        palette[0][3] = palette[1][3] = palette[2][3] = palette[3][3] = 255;
+        for (int c = 0; c < 3; c++)
+        {
+            if (threeColor)
+            {
+                palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+                palette[3][c] = 0;
+            }
+            else
+            {
+                palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+                palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+            }
+        }
+        if (threeColor)
+        {
+            palette[3][3] = 0;
+        }
+
+        const uint32_t selectors = block[4] | (block[5] << 8) | (block[6] << 16) | (uint32_t(block[7]) << 24);
+        for (int i = 0; i < 16; i++)
+        {
+            const int* color = palette[(selectors >> (i * 2)) & 3];
+            for (int c = 0; c < 4; c++)
+            {
+                rgba[i * 4 + c] = static_cast<uint8_t>(color[c]);
+            }
+        }
+    }
+}
+
+namespace SupercompressedTextureFixtures
+{
+    std::vector<uint8_t> MakeTestImage(uint32_t width, uint32_t height, uint32_t seed)
+    {
+        TestRandom random(seed);
+        const float cx = random.Range(0.2f, 0.8f) * width;
+        const float cy = random.Range(0.2f, 0.8f) * height;
+        const float radius = random.Range(0.1f, 0.3f) * std::min(width, height);
+
+        std::vector<uint8_t> pixels(size_t(width) * height * 4);
+        for (uint32_t y = 0; y < height; y++)
+        {
+            for (uint32_t x = 0; x < width; x++)
+            {
+                uint8_t* p = pixels.data() + (size_t(y) * width + x) * 4;
+                const int noise = static_cast<int>(random.Next() % 9) - 4;
+                const float dx = x - cx, dy = y - cy;
+                const bool disc = dx * dx + dy * dy < radius * radius;
+                const bool stripe = ((x / 8) + (y / 16)) % 5 == 0;
+
+                int rgb[3] = { static_cast<int>(255 * x / std::max(width - 1, 1u)), static_cast<int>(255 * y / std::max(height - 1, 1u)), 96 };
+                if (disc)
+                {
+                    rgb[0] = 230;
+                    rgb[1] = 40;
+                    rgb[2] = 255 - rgb[2];
+                }
+                else if (stripe)
+                {
+                    rgb[2] = 200;
+                }
+                for (int c = 0; c < 3; c++)
+                {
+                    p[c] = static_cast<uint8_t>(std::min(std::max(rgb[c] + noise, 0), 255));
+                }
+                p[3] = disc ? 255 : static_cast<uint8_t>(stripe ? 0 : 128 + (x * 7 + y * 3) % 128);
+            }
+        }
+        return pixels;
+    }
+
+    std::vector<uint8_t> EncodeReference(const ImageResampler::ImageView& image, BlockFormat format, bool generateMips)
+    {
+        const uint32_t width = (image.width + 3) & ~3u;
+        const uint32_t height = (image.height + 3) & ~3u;
+        std::vector<uint8_t> level0(size_t(width) * height * 4);
+        const ImageResampler::MutableImageView level0View = { level0.data(), width, height, size_t(width) * 4,
+            ImageResampler::PixelLayout::RGBA8, image.srgb };
+        if (!ImageResampler::Resize(image, level0View, ImageResampler::Filter::Mitchell))
+        {
+            return std::vector<uint8_t>();
+        }
+
+        const size_t blockBytes = BlockBytes(format);
+        std::vector<uint8_t> blocks;
+        std::vector<uint8_t> pixels;
+        for (uint32_t mipWidth = width, mipHeight = height; ; mipWidth = std::max(mipWidth / 2, 1u), mipHeight = std::max(mipHeight / 2, 1u))
+        {
+            // Every level below the first is reduced from the first.
+            if (mipWidth == width && mipHeight == height)
+            {
+                pixels = level0;
+            }
+            else
+            {
+                pixels.resize(size_t(mipWidth) * mipHeight * 4);
+                const ImageResampler::ImageView src = { level0.data(), width, height, size_t(width) * 4,
+                    ImageResampler::PixelLayout::RGBA8, image.srgb };
+                const ImageResampler::MutableImageView dst = { pixels.data(), mipWidth, mipHeight, size_t(mipWidth) * 4,
+                    ImageResampler::PixelLayout::RGBA8, image.srgb };
+                if (!ImageResampler::Resize(src, dst, ImageResampler::Filter::Box))
+                {
+                    return std::vector<uint8_t>();
+                }
+            }
+
+            // Blocks past the edge of small mips repeat the last row and column.
+            for (uint32_t by = 0; by < (mipHeight + 3) / 4; by++)
+            {
+                for (uint32_t bx = 0; bx < (mipWidth + 3) / 4; bx++)
+                {
+                    uint8_t rgba[64];
+                    for (uint32_t i = 0; i < 16; i++)
+                    {
+                        const uint32_t sx = std::min(bx * 4 + i % 4, mipWidth - 1);
+                        const uint32_t sy = std::min(by * 4 + i / 4, mipHeight - 1);
+                        std::memcpy(rgba + i * 4, pixels.data() + (size_t(sy) * mipWidth + sx) * 4, 4);
+                    }
+                    uint8_t block[16];
+                    if (format == BlockFormat::BC1)
+                    {
+                        EncodeBC1Block(rgba, block);
+                    }
+                    else
+                    {
+                        EncodeBC3Block(rgba, block);
+                    }
+                    blocks.insert(blocks.end(), block, block + blockBytes);
+                }
+            }
+
+            if (!generateMips || (mipWidth == 1 && mipHeight == 1))
+            {
+                break;
+            }
+        }
+        return blocks;
+    }
+
+    bool Compare(const std::vector<uint8_t>& expected, const TranscodedTexture& texture, std::string& message)
+    {
+        std::ostringstream stream;
+        if (texture.dataSize != expected.size() || !texture.data)
+        {
+            stream << "transcoded " << texture.dataSize << " bytes, expected " << expected.size();
+            message = stream.str();
+            return false;
+        }
+
+        const size_t blockBytes = BlockBytes(texture.format);
+        for (size_t mip = 0; mip < texture.mips.size(); mip++)
+        {
+            const MipLevel& level = texture.mips[mip];
+            for (size_t offset = 0; offset < level.size; offset += blockBytes)
+            {
+                const size_t at = level.offset + offset;
+                if (std::memcmp(texture.data.get() + at, expected.data() + at, blockBytes) != 0)
+                {
+                    stream << "mip " << mip << " block (" << offset % level.rowPitch / blockBytes << ", " << offset / level.rowPitch << ") differs";
+                    message = stream.str();
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    void DecodeBC1Block(const uint8_t block[8], uint8_t rgba[64])
+    {
+        DecodeColorBlock(block, true, rgba);
+    }
+
+    void DecodeBC3Block(const uint8_t block[16], uint8_t rgba[64])
+    {
+        DecodeColorBlock(block + 8, false, rgba);
+
+        const int a0 = block[0], a1 = block[1];
+        int palette[8] = { a0, a1 };
+        if (a0 > a1)
+        {
+            for (int k = 1; k < 7; k++)
+            {
+                palette[k + 1] = ((7 - k) * a0 + k * a1) / 7;
+            }
+        }
+        else
+        {
+            for (int k = 1; k < 5; k++)
+            {
+                palette[k + 1] = ((5 - k) * a0 + k * a1) / 5;
+            }
+            palette[6] = 0;
+            palette[7] = 255;
+        }
+
+        uint64_t selectors = 0;
+        for (int i = 0; i < 6; i++)
+        {
+            selectors |= uint64_t(block[2 + i]) << (i * 8);
+        }
+        for (int i = 0; i < 16; i++)
+        {
+            rgba[i * 4 + 3] = static_cast<uint8_t>(palette[(selectors >> (i * 3)) & 7]);
+        }
+    }
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "SupercompressedTexture.h"
+
+// Images and comparisons for checking SupercompressedTexture::Transcode
+// against plain block encoding, shared by the tests and the benchmarks.
+namespace SupercompressedTextureFixtures
+{
+    // RGBA8 pixels, tightly packed: smooth gradients with a few hard edged
+    // shapes and a little noise, and alpha that varies like a cutout's.
+    std::vector<uint8_t> MakeTestImage(uint32_t width, uint32_t height, uint32_t seed);
+
+    // The block data Transcode should return for Encode(image, format,
+    // generateMips): the same resampling, then EncodeBC1Block/EncodeBC3Block
+    // block by block, without the byte planes, delta coding or rANS.
+    std::vector<uint8_t> EncodeReference(const ImageResampler::ImageView& image, SupercompressedTexture::BlockFormat format,
+        bool generateMips);
+
+    // Compares transcoded block data against expected. On a mismatch, returns
+    // false and describes the first differing block in message.
+    bool Compare(const std::vector<uint8_t>& expected, const SupercompressedTexture::TranscodedTexture& texture, std::string& message);
+
+    // Decodes a block to 16 RGBA8 pixels in row order, as the GPU would.
+    void DecodeBC1Block(const uint8_t block[8], uint8_t rgba[64]);
+    void DecodeBC3Block(const uint8_t block[16], uint8_t rgba[64]);
+}
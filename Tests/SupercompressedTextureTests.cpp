@@ -0,0 +1,331 @@
+#include "Test.h"
+#include "SupercompressedTexture.h"
+#include "SupercompressedTextureFixtures.h"
+#include "TestRandom.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace SupercompressedTexture;
+
+namespace
+{
+    // Offsets of every plane header (u32 rawSize, u32 payloadSize, u8 coding)
+    // of a well formed file.
+    std::vector<size_t> PlaneHeaders(const std::vector<uint8_t>& file, BlockFormat format)
+    {
+        std::vector<size_t> headers;
+        size_t offset = 24;
+        for (size_t p = 0; p < BlockBytes(format); p++)
+        {
+            headers.push_back(offset);
+            uint32_t payloadSize;
+            std::memcpy(&payloadSize, file.data() + offset + 4, 4);
+            offset += 9 + payloadSize;
+        }
+        CHECK(offset == file.size());
+        return headers;
+    }
+
+    void Put32(std::vector<uint8_t>& file, size_t offset, uint32_t value)
+    {
+        for (int i = 0; i < 4; i++)
+        {
+            file[offset + i] = static_cast<uint8_t>(value >> (i * 8));
+        }
+    }
+
+    bool Transcodes(const std::vector<uint8_t>& file)
+    {
+        TranscodedTexture texture;
+        return Transcode(file.data(), file.size(), texture);
+    }
+
+    // Encodes image and checks that Transcode returns exactly the blocks of
+    // plain block encoding.
+    void CheckRoundTrip(const std::vector<uint8_t>& pixels, uint32_t width, uint32_t height, bool srgb, BlockFormat format,
+        bool generateMips, std::vector<uint8_t>& file)
+    {
+        const ImageResampler::ImageView image = { pixels.data(), width, height, size_t(width) * 4, ImageResampler::PixelLayout::RGBA8, srgb };
+        CHECK(Encode(image, format, generateMips, file));
+
+        TranscodedTexture texture;
+        CHECK(Transcode(file.data(), file.size(), texture));
+        CHECK(texture.format == format);
+        CHECK(texture.srgb == srgb);
+        CHECK(texture.width == ((width + 3) & ~3u));
+        CHECK(texture.height == ((height + 3) & ~3u));
+        CHECK(!texture.mips.empty());
+        if (generateMips)
+        {
+            CHECK(texture.mips.back().width == 1 && texture.mips.back().height == 1);
+        }
+        else
+        {
+            CHECK(texture.mips.size() == 1);
+        }
+
+        std::string message;
+        const std::vector<uint8_t> expected = SupercompressedTextureFixtures::EncodeReference(image, format, generateMips);
+        CHECK_MESSAGE(SupercompressedTextureFixtures::Compare(expected, texture, message), message);
+    }
+}
+
+TEST_CASE(SupercompressedTextureRoundTrips)
+{
+    // Sizes that are not whole blocks are padded, and their small mips are
+    // narrower than a block. Enough blocks to take the SIMD delta decoding
+    // and interleaving paths, plus a remainder.
+    const uint32_t sizes[][2] = { { 64, 64 }, { 61, 45 }, { 256, 8 }, { 1, 1 }, { 3, 70 } };
+    for (const auto& size : sizes)
+    {
+        const std::vector<uint8_t> pixels = SupercompressedTextureFixtures::MakeTestImage(size[0], size[1], size[0] * 1000 + size[1]);
+        for (BlockFormat format : { BlockFormat::BC1, BlockFormat::BC3 })
+        {
+            std::vector<uint8_t> file;
+            CheckRoundTrip(pixels, size[0], size[1], true, format, true, file);
+            CheckRoundTrip(pixels, size[0], size[1], false, format, false, file);
+        }
+    }
+}
+
+TEST_CASE(SupercompressedTextureEntropyCodesSmoothPlanes)
+{
+    // A smooth image codes most planes with rANS and the file ends up well
+    // under the block data it carries.
+    const std::vector<uint8_t> pixels = SupercompressedTextureFixtures::MakeTestImage(256, 256, 7);
+    std::vector<uint8_t> file;
+    CheckRoundTrip(pixels, 256, 256, true, BlockFormat::BC3, true, file);
+
+    TranscodedTexture texture;
+    CHECK(Transcode(file.data(), file.size(), texture));
+    CHECK(file.size() < texture.dataSize * 3 / 4);
+    uint32_t rans = 0;
+    for (size_t header : PlaneHeaders(file, BlockFormat::BC3))
+    {
+        rans += file[header + 8] == 1;
+    }
+    CHECK(rans >= 12);
+
+    // A constant image leaves one symbol per plane, which codes to little
+    // more than the symbol table and the two rANS states.
+    const std::vector<uint8_t> flat(64 * 64 * 4, 0x5a);
+    CheckRoundTrip(flat, 64, 64, false, BlockFormat::BC1, true, file);
+    CHECK(file.size() < 24 + 8 * (9 + 16));
+}
+
+TEST_CASE(SupercompressedTextureStoresNoisyPlanes)
+{
+    // Noise does not compress, so its planes are stored as they are and
+    // still round trip.
+    std::vector<uint8_t> noise(128 * 128 * 4);
+    TestRandom random(11);
+    for (uint8_t& byte : noise)
+    {
+        byte = static_cast<uint8_t>(random.Next() >> 24);
+    }
+    std::vector<uint8_t> file;
+    CheckRoundTrip(noise, 128, 128, false, BlockFormat::BC1, false, file);
+
+    uint32_t stored = 0;
+    for (size_t header : PlaneHeaders(file, BlockFormat::BC1))
+    {
+        stored += file[header + 8] == 0;
+    }
+    CHECK(stored > 0);
+}
+
+TEST_CASE(SupercompressedTextureBlocksDecodeCloseToTheSource)
+{
+    // Solid blocks come back as their colour rounded to 5:6:5, and alpha
+    // exactly.
+    for (uint32_t i = 0; i < 64; i++)
+    {
+        const uint8_t color[4] = { static_cast<uint8_t>(i * 4), static_cast<uint8_t>(255 - i * 3), static_cast<uint8_t>(i * 37), static_cast<uint8_t>(i * 5) };
+        uint8_t rgba[64];
+        for (int p = 0; p < 16; p++)
+        {
+            std::memcpy(rgba + p * 4, color, 4);
+        }
+
+        uint8_t block[16];
+        uint8_t decoded[64];
+        EncodeBC3Block(rgba, block);
+        SupercompressedTextureFixtures::DecodeBC3Block(block, decoded);
+        for (int p = 0; p < 16; p++)
+        {
+            CHECK(std::abs(decoded[p * 4 + 0] - color[0]) <= 4);
+            CHECK(std::abs(decoded[p * 4 + 1] - color[1]) <= 2);
+            CHECK(std::abs(decoded[p * 4 + 2] - color[2]) <= 4);
+            CHECK(decoded[p * 4 + 3] == color[3]);
+        }
+    }
+
+    // Across a whole image, the average error stays small and no pixel is far
+    // off; alpha is opaque in BC1.
+    const uint32_t size = 128;
+    const std::vector<uint8_t> pixels = SupercompressedTextureFixtures::MakeTestImage(size, size, 3);
+    for (BlockFormat format : { BlockFormat::BC1, BlockFormat::BC3 })
+    {
+        uint64_t totalError = 0;
+        int maxError = 0;
+        for (uint32_t by = 0; by < size / 4; by++)
+        {
+            for (uint32_t bx = 0; bx < size / 4; bx++)
+            {
+                uint8_t rgba[64];
+                for (uint32_t y = 0; y < 4; y++)
+                {
+                    std::memcpy(rgba + y * 16, pixels.data() + ((by * 4 + y) * size + bx * 4) * 4, 16);
+                }
+
+                uint8_t block[16];
+                uint8_t decoded[64];
+                if (format == BlockFormat::BC1)
+                {
+                    EncodeBC1Block(rgba, block);
+                    SupercompressedTextureFixtures::DecodeBC1Block(block, decoded);
+                }
+                else
+                {
+                    EncodeBC3Block(rgba, block);
+                    SupercompressedTextureFixtures::DecodeBC3Block(block, decoded);
+                }
+                for (int i = 0; i < 64; i++)
+                {
+                    const int error = i % 4 == 3 && format == BlockFormat::BC1 ? 255 - decoded[i] : std::abs(decoded[i] - rgba[i]);
+                    totalError += error;
+                    maxError = std::max(maxError, error);
+                }
+            }
+        }
+        CHECK(totalError < uint64_t(size) * size * 4 * 3);
+        CHECK(maxError <= 32);
+    }
+}
+
+TEST_CASE(SupercompressedTextureRejectsTruncatedFiles)
+{
+    const std::vector<uint8_t> pixels = SupercompressedTextureFixtures::MakeTestImage(32, 32, 5);
+    for (BlockFormat format : { BlockFormat::BC1, BlockFormat::BC3 })
+    {
+        std::vector<uint8_t> file;
+        CheckRoundTrip(pixels, 32, 32, false, format, true, file);
+
+        // Copies, so that the sanitizers see reads past the end.
+        for (size_t size = 0; size < file.size(); size++)
+        {
+            const std::vector<uint8_t> truncated(file.begin(), file.begin() + size);
+            CHECK_MESSAGE(!Transcodes(truncated), std::to_string(size) + " of " + std::to_string(file.size()) + " bytes");
+        }
+    }
+}
+
+TEST_CASE(SupercompressedTextureRejectsCorruptFiles)
+{
+    const std::vector<uint8_t> pixels = SupercompressedTextureFixtures::MakeTestImage(64, 32, 9);
+    std::vector<uint8_t> file;
+    CheckRoundTrip(pixels, 64, 32, false, BlockFormat::BC1, true, file);
+
+    // The largest rANS coded plane.
+    size_t rans = 0;
+    uint32_t payloadSize = 0;
+    for (size_t header : PlaneHeaders(file, BlockFormat::BC1))
+    {
+        uint32_t size;
+        std::memcpy(&size, file.data() + header + 4, 4);
+        if (file[header + 8] == 1 && size > payloadSize)
+        {
+            rans = header;
+            payloadSize = size;
+        }
+    }
+    CHECK(payloadSize > 64);
+
+    std::vector<uint8_t> corrupt = file;
+    corrupt[3] = '2';                                                       // Magic.
+    CHECK(!Transcodes(corrupt));
+    corrupt = file;
+    Put32(corrupt, 4, 2);                                                   // BC2 is not supported.
+    CHECK(!Transcodes(corrupt));
+    corrupt = file;
+    Put32(corrupt, 12, 0);                                                  // Width.
+    CHECK(!Transcodes(corrupt));
+    corrupt = file;
+    Put32(corrupt, 16, 16385);                                              // Height.
+    CHECK(!Transcodes(corrupt));
+    corrupt = file;
+    Put32(corrupt, 20, 8);                                                  // More mips than 64x32 has.
+    CHECK(!Transcodes(corrupt));
+    corrupt = file;
+    Put32(corrupt, 20, 0);
+    CHECK(!Transcodes(corrupt));
+    corrupt = file;
+    Put32(corrupt, 20, 6);                                                  // Fewer mips, so the planes are too long.
+    CHECK(!Transcodes(corrupt));
+    corrupt = file;
+    Put32(corrupt, 24, 1);                                                  // Plane size.
+    CHECK(!Transcodes(corrupt));
+    corrupt = file;
+    Put32(corrupt, 28, static_cast<uint32_t>(file.size()));                 // Payload past the end.
+    CHECK(!Transcodes(corrupt));
+    corrupt = file;
+    corrupt[rans + 8] = 2;                                                  // Unknown coding.
+    CHECK(!Transcodes(corrupt));
+    corrupt = file;
+    corrupt[rans + 8] = 0;                                                  // Stored, with a compressed size.
+    CHECK(!Transcodes(corrupt));
+
+    // The rANS payload: u16 symbol count, (u8 symbol, u16 frequency) each,
+    // then the states.
+    corrupt = file;
+    corrupt[rans + 9] = 0;                                                  // No symbols.
+    corrupt[rans + 10] = 0;
+    CHECK(!Transcodes(corrupt));
+    corrupt = file;
+    corrupt[rans + 9] = 0xff;                                               // More symbols than there are.
+    corrupt[rans + 10] = 0xff;
+    CHECK(!Transcodes(corrupt));
+    const uint32_t frequency = file[rans + 12] | (file[rans + 13] << 8);
+    CHECK(frequency > 1);
+    corrupt = file;
+    corrupt[rans + 12] = static_cast<uint8_t>(frequency - 1);               // Frequencies that sum to less than 4096...
+    corrupt[rans + 13] = static_cast<uint8_t>((frequency - 1) >> 8);
+    CHECK(!Transcodes(corrupt));
+    corrupt = file;
+    corrupt[rans + 12] = static_cast<uint8_t>(frequency + 1);               // ...or more.
+    corrupt[rans + 13] = static_cast<uint8_t>((frequency + 1) >> 8);
+    CHECK(!Transcodes(corrupt));
+    corrupt = file;
+    corrupt[rans + 12] = 0;                                                 // A zero frequency.
+    corrupt[rans + 13] = 0;
+    CHECK(!Transcodes(corrupt));
+
+    // A rANS plane cut short runs out of bytes before its last symbol. The
+    // later planes move up, so the file stays consistent otherwise.
+    corrupt = file;
+    corrupt.erase(corrupt.begin() + rans + 9 + payloadSize - 16, corrupt.begin() + rans + 9 + payloadSize);
+    Put32(corrupt, rans + 4, payloadSize - 16);
+    CHECK(!Transcodes(corrupt));
+
+    // Random damage may or may not be detected, but never reads or writes out
+    // of bounds (run under the sanitizers), and a file that still transcodes
+    // has the layout its header describes.
+    TestRandom random(13);
+    for (int i = 0; i < 2000; i++)
+    {
+        corrupt = file;
+        for (uint32_t flips = 1 + random.Next() % 4; flips > 0; flips--)
+        {
+            corrupt[random.Next() % corrupt.size()] ^= static_cast<uint8_t>(1u << (random.Next() % 8));
+        }
+        TranscodedTexture texture;
+        if (Transcode(corrupt.data(), corrupt.size(), texture))
+        {
+            CHECK(texture.mips.back().offset + texture.mips.back().size == texture.dataSize);
+        }
+    }
+}
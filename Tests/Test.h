@@ -0,0 +1,58 @@
+#pragma once
+
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// A minimal test runner for the engine's portable modules. Tests register
+// themselves with TEST_CASE; the CHECK macros throw on the first failed
+// condition, and the runner reports it and exits with a non-zero status.
+namespace Test
+{
+    struct Case
+    {
+        const char* name;
+        void (*function)();
+    };
+
+    std::vector<Case>& Registry();
+
+    struct Registrar
+    {
+        Registrar(const char* name, void (*function)()) { Registry().push_back({ name, function }); }
+    };
+
+    class Failure : public std::runtime_error
+    {
+    public:
+        explicit Failure(const std::string& message) : std::runtime_error(message) {}
+    };
+
+    [[noreturn]] inline void Fail(const char* file, int line, const std::string& message)
+    {
+        std::ostringstream stream;
+        stream << file << "(" << line << "): " << message;
+        throw Failure(stream.str());
+    }
+}
+
+#define TEST_CASE(name) \
+    static void name(); \
+    static const Test::Registrar name##Registrar(#name, name); \
+    static void name()
+
+#define CHECK(condition) \
+    do { if (!(condition)) Test::Fail(__FILE__, __LINE__, "CHECK(" #condition ") failed"); } while (0)
+
+// Fails with message, a string built by the caller (a mismatch description).
+#define CHECK_MESSAGE(condition, message) \
+    do { if (!(condition)) Test::Fail(__FILE__, __LINE__, std::string("CHECK(" #condition ") failed: ") + (message)); } while (0)
+
+#define CHECK_THROWS(expression, exception) \
+    do \
+    { \
+        bool thrown = false; \
+        try { expression; } catch (const exception&) { thrown = true; } \
+        if (!thrown) Test::Fail(__FILE__, __LINE__, #expression " did not throw " #exception); \
+    } while (0)
@@ -0,0 +1,47 @@
+#include "Test.h"
+
+#include <cstdio>
+#include <cstring>
+#include <exception>
+
+std::vector<Test::Case>& Test::Registry()
+{
+    static std::vector<Case> s_cases;
+    return s_cases;
+}
+
+// Runs every test, or those whose names contain the first argument. Returns
+// the number of failures, so a build step or script fails with the tests.
+int main(int argc, char** argv)
+{
+    const char* filter = argc > 1 ? argv[1] : nullptr;
+    int run = 0;
+    int failed = 0;
+    for (const Test::Case& test : Test::Registry())
+    {
+        if (filter && !std::strstr(test.name, filter))
+        {
+            continue;
+        }
+
+        run++;
+        try
+        {
+            test.function();
+            std::printf("[  OK  ] %s\n", test.name);
+        }
+        catch (const std::exception& e)
+        {
+            failed++;
+            std::printf("[ FAIL ] %s\n         %s\n", test.name, e.what());
+        }
+        catch (...)
+        {
+            failed++;
+            std::printf("[ FAIL ] %s\n         unknown exception\n", test.name);
+        }
+    }
+
+    std::printf("%d of %d tests passed\n", run - failed, run);
+    return failed;
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdint>
+
+// xorshift32, so a seed gives the same test data with every standard
+// library.
+class TestRandom
+{
+public:
+    explicit TestRandom(uint32_t seed) : m_state(seed ? seed : 0x9E3779B9u) {}
+
+    uint32_t Next()
+    {
+        m_state ^= m_state << 13;
+        m_state ^= m_state >> 17;
+        m_state ^= m_state << 5;
+        return m_state;
+    }
+
+    // Uniform in [low, high), from the top 24 bits.
+    float Range(float low, float high)
+    {
+        return low + (high - low) * static_cast<float>(Next() >> 8) / static_cast<float>(1u << 24);
+    }
+
+private:
+    uint32_t m_state;
+};
@@ -0,0 +1,66 @@
+#include "Test.h"
+#include "VirtualTexture.h"
+
+using namespace VirtualTexture;
+
+TEST_CASE(VirtualTextureResidentAncestorStopsAtLastMip)
+{
+    // 16 mips is the most the page id holds; walking up from any page must
+    // stop at mip 15 rather than wrap to mip 0.
+    PageTable table(Desc{ 256, 256, 128, 16 });
+    CHECK(table.MipCount() == 16);
+    CHECK(table.ResidentAncestor(PackPage(0, 1, 1)) == kInvalidPage);
+    CHECK(table.Parent(PackPage(15, 0, 0)) == kInvalidPage);
+
+    table.Map(PackPage(15, 0, 0), 3);
+    CHECK(table.ResidentAncestor(PackPage(0, 1, 1)) == PackPage(15, 0, 0));
+}
+
+TEST_CASE(VirtualTextureAnalyzeRequestsEveryMissingAncestor)
+{
+    PageTable table(Desc{ 256, 256, 128, 16 });
+    FeedbackAnalyzer analyzer;
+    std::vector<uint32_t> residentHits;
+    std::vector<PageRequest> requests;
+    const uint32_t feedback[] = { PackPage(0, 1, 1), PackPage(0, 1, 1), kInvalidPage };
+    analyzer.Analyze(table, feedback, 3, residentHits, requests);
+
+    CHECK(residentHits.empty());
+    CHECK(requests.size() == 16);
+    CHECK(requests.front().page == PackPage(15, 0, 0));
+    CHECK(requests.back().page == PackPage(0, 1, 1));
+    CHECK(requests.back().hits == 2);
+}
+
+TEST_CASE(VirtualTextureRejectsDescsOutsideThePageId)
+{
+    CHECK_THROWS(PageTable(Desc{ 256, 256, 128, 17 }), std::invalid_argument);
+    CHECK_THROWS(PageTable(Desc{ kMaxPagesPerSide * 2 + 1, 64, 2, 1 }), std::invalid_argument);
+    CHECK_THROWS(PageTable(Desc{ 64, kMaxPagesPerSide * 2 + 1, 2, 1 }), std::invalid_argument);
+
+    // The widest table still accepted, and its last page is valid.
+    PageTable table(Desc{ kMaxPagesPerSide, 1, 1, 1 });
+    CHECK(table.PagesX(0) == kMaxPagesPerSide);
+    CHECK(table.IsValid(PackPage(0, kMaxPagesPerSide - 1, 0)));
+}
+
+TEST_CASE(VirtualTexturePinnedMipTailIsNeverEvicted)
+{
+    PageManager manager(Desc{ 1024, 1024, 128, 0 }, 4, 8);
+    CHECK(manager.PinMipTail().size() == 1);
+    const uint32_t tail = PackPage(manager.Table().MipCount() - 1, 0, 0);
+
+    std::vector<uint32_t> feedback;
+    for (uint32_t y = 0; y < 8; y++)
+    {
+        for (uint32_t x = 0; x < 8; x++)
+        {
+            feedback.push_back(PackPage(0, x, y));
+        }
+    }
+    for (int frame = 0; frame < 4; frame++)
+    {
+        manager.Update(feedback.data(), feedback.size());
+        CHECK(manager.Table().Slot(tail) != kNotResident);
+    }
+}
@@ -0,0 +1,43 @@
+#include "stdafx.h"
+#include "UploadRingBuffer.h"
+
+UploadRingBuffer::~UploadRingBuffer()
+{
+    if (m_buffer && m_cpuBase)
+    {
+        m_buffer->Unmap(0, nullptr);
+    }
+}
+
+void UploadRingBuffer::Initialize(ID3D12Device* device, UINT64 capacity)
+{
+    ThrowIfFailed(device->CreateCommittedResource(
+        &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
+        D3D12_HEAP_FLAG_NONE,
+        &CD3DX12_RESOURCE_DESC::Buffer(capacity),
+        D3D12_RESOURCE_STATE_GENERIC_READ,
+        nullptr,
+        IID_PPV_ARGS(&m_buffer)));
+
+    // Keep the buffer mapped for its whole lifetime; the CPU never reads it back.
+    CD3DX12_RANGE readRange(0, 0);
+    ThrowIfFailed(m_buffer->Map(0, &readRange, reinterpret_cast<void**>(&m_cpuBase)));
+    m_gpuBase = m_buffer->GetGPUVirtualAddress();
+    m_allocator = RingAllocator(capacity);
+}
+
+UploadRingBuffer::Allocation UploadRingBuffer::Allocate(UINT64 size, UINT64 alignment)
+{
+    const UINT64 offset = m_allocator.Allocate(size, alignment);
+    if (offset == RingAllocator::InvalidOffset)
+    {
+        ThrowIfFailed(E_OUTOFMEMORY);
+    }
+
+    Allocation allocation;
+    allocation.cpuAddress = m_cpuBase + offset;
+    allocation.gpuAddress = m_gpuBase + offset;
+    allocation.resource = m_buffer.Get();
+    allocation.offset = offset;
+    return allocation;
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include "stdafx.h"
+#include "DXSampleHelper.h"
+#include "RingAllocator.h"
+
+// One large, persistently mapped UPLOAD heap buffer carved up by a
+// RingAllocator. Per-frame data (constants, dynamic vertices) is written
+// straight into the returned CPU pointer and read by the GPU through the
+// matching virtual address; space comes back once the frame's fence retires.
+class UploadRingBuffer
+{
+public:
+    struct Allocation
+    {
+        UINT8* cpuAddress;
+        D3D12_GPU_VIRTUAL_ADDRESS gpuAddress;
+        ID3D12Resource* resource;
+        UINT64 offset;
+    };
+
+    UploadRingBuffer() = default;
+    UploadRingBuffer(const UploadRingBuffer& rhs) = delete;
+    UploadRingBuffer& operator=(const UploadRingBuffer& rhs) = delete;
+    ~UploadRingBuffer();
+
+    void Initialize(ID3D12Device* device, UINT64 capacity);
+
+    // Throws if the ring is full; size it for the frames in flight.
+    Allocation Allocate(UINT64 size, UINT64 alignment = D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT);
+
+    ID3D12Resource* Resource() const { return m_buffer.Get(); }
+
+    void FinishFrame(UINT64 fenceValue) { m_allocator.FinishFrame(fenceValue); }
+    void Retire(UINT64 completedFenceValue) { m_allocator.Retire(completedFenceValue); }
+
+private:
+    RingAllocator m_allocator{ 0 };
+    ComPtr<ID3D12Resource> m_buffer;
+    UINT8* m_cpuBase = nullptr;
+    D3D12_GPU_VIRTUAL_ADDRESS m_gpuBase = 0;
+};
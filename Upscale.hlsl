@@ -0,0 +1,41 @@
+// Dynamic resolution upscale: a fullscreen triangle that stretches the
+// rendered top left part of the scene color target over the back buffer.
+// See DynamicResolution.h.
+
+// Shares the engine's root signature; the texture slot constants hold the
+// source instead.
+cbuffer UpscaleConstants : register(b1)
+{
+    uint sourceSlot;
+    float2 uvScale;     // Rendered fraction of the source, per axis.
+};
+
+Texture2D g_textures[] : register(t0, space1);
+SamplerState g_sampler : register(s0);
+
+struct PSInput
+{
+    float4 position : SV_POSITION;
+    float2 uv : UV;
+};
+
+PSInput VSMain(uint vertexID : SV_VertexID)
+{
+    PSInput vOut;
+    vOut.uv = float2((vertexID << 1) & 2, vertexID & 2);
+    vOut.position = float4(vOut.uv * float2(2, -2) + float2(-1, 1), 0, 1);
+    return vOut;
+}
+
+float4 PSMain(PSInput vsOut) : SV_TARGET
+{
+    Texture2D source = g_textures[sourceSlot];
+    float width, height;
+    source.GetDimensions(width, height);
+
+    // Bilinear taps stay half a texel inside the rendered part, so nothing
+    // from outside it bleeds in at the edges.
+    float2 halfTexel = 0.5f / float2(width, height);
+    float2 uv = clamp(vsOut.uv * uvScale, halfTexel, uvScale - halfTexel);
+    return source.SampleLevel(g_sampler, uv, 0);
+}
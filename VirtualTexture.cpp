@@ -0,0 +1,292 @@
+#include "VirtualTexture.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+using namespace VirtualTexture;
+
+//-------------------------------------------------------------------------------------
+// PageTable
+//-------------------------------------------------------------------------------------
+PageTable::PageTable(const Desc& desc)
+{
+    const uint32_t pageSize = std::max<uint32_t>(desc.pageSize, 1);
+    if (desc.mipCount > kMaxMips)
+        throw std::invalid_argument("VirtualTexture: too many mips for the page id");
+    if ((std::max<uint32_t>(desc.width, 1) - 1) / pageSize + 1 > kMaxPagesPerSide
+        || (std::max<uint32_t>(desc.height, 1) - 1) / pageSize + 1 > kMaxPagesPerSide)
+        throw std::invalid_argument("VirtualTexture: too many pages for the page id");
+
+    for (uint32_t mip = 0; mip < kMaxMips; mip++)
+    {
+        const uint32_t width = std::max<uint32_t>(desc.width >> mip, 1);
+        const uint32_t height = std::max<uint32_t>(desc.height >> mip, 1);
+
+        Mip level;
+        level.pagesX = (width + pageSize - 1) / pageSize;
+        level.pagesY = (height + pageSize - 1) / pageSize;
+        level.slots.assign(size_t(level.pagesX) * level.pagesY, kNotResident);
+        m_mips.push_back(std::move(level));
+
+        const bool lastRequested = desc.mipCount != 0 && mip + 1 == desc.mipCount;
+        const bool singlePage = m_mips.back().pagesX == 1 && m_mips.back().pagesY == 1;
+        if (lastRequested || (desc.mipCount == 0 && singlePage))
+            break;
+    }
+}
+
+bool PageTable::IsValid(uint32_t page) const
+{
+    const uint32_t mip = PageMip(page);
+    return page != kInvalidPage && mip < m_mips.size()
+        && PageX(page) < m_mips[mip].pagesX && PageY(page) < m_mips[mip].pagesY;
+}
+
+uint32_t PageTable::Parent(uint32_t page) const
+{
+    if (PageMip(page) + 1 >= MipCount())
+        return kInvalidPage;
+    return ParentPage(page);
+}
+
+uint32_t PageTable::Slot(uint32_t page) const
+{
+    const Mip& level = m_mips[PageMip(page)];
+    return level.slots[size_t(PageY(page)) * level.pagesX + PageX(page)];
+}
+
+void PageTable::Map(uint32_t page, uint32_t slot)
+{
+    Mip& level = m_mips[PageMip(page)];
+    level.slots[size_t(PageY(page)) * level.pagesX + PageX(page)] = slot;
+}
+
+void PageTable::Unmap(uint32_t page)
+{
+    Map(page, kNotResident);
+}
+
+uint32_t PageTable::ResidentAncestor(uint32_t page) const
+{
+    while (IsValid(page))
+    {
+        if (Slot(page) != kNotResident)
+            return page;
+        page = Parent(page);
+    }
+    return kInvalidPage;
+}
+
+//-------------------------------------------------------------------------------------
+// PageCache
+//-------------------------------------------------------------------------------------
+PageCache::PageCache(uint32_t slotCount) :
+    m_slots(slotCount)
+{
+    for (uint32_t slot = 0; slot < slotCount; slot++)
+    {
+        PushBack(slot);
+    }
+}
+
+void PageCache::Unlink(uint32_t slot)
+{
+    Slot& s = m_slots[slot];
+    if (s.prev != kNotResident) m_slots[s.prev].next = s.next; else m_head = s.next;
+    if (s.next != kNotResident) m_slots[s.next].prev = s.prev; else m_tail = s.prev;
+    s.prev = s.next = kNotResident;
+}
+
+void PageCache::PushBack(uint32_t slot)
+{
+    Slot& s = m_slots[slot];
+    s.prev = m_tail;
+    s.next = kNotResident;
+    if (m_tail != kNotResident) m_slots[m_tail].next = slot; else m_head = slot;
+    m_tail = slot;
+}
+
+void PageCache::Touch(uint32_t slot, uint64_t frame)
+{
+    m_slots[slot].lastUsed = frame;
+    if (m_tail != slot)
+    {
+        Unlink(slot);
+        PushBack(slot);
+    }
+}
+
+uint32_t PageCache::Acquire(uint32_t page, uint64_t frame, uint32_t& evictedPage)
+{
+    evictedPage = kInvalidPage;
+
+    // The list is ordered by last use, so the first unlocked slot is the victim
+    // unless it was already needed this frame, in which case every later one is too.
+    for (uint32_t slot = m_head; slot != kNotResident; slot = m_slots[slot].next)
+    {
+        Slot& s = m_slots[slot];
+        if (s.locked)
+            continue;
+        if (s.page != kInvalidPage && s.lastUsed >= frame)
+            return kNotResident;
+
+        evictedPage = s.page;
+        s.page = page;
+        Touch(slot, frame);
+        return slot;
+    }
+    return kNotResident;
+}
+
+void PageCache::Release(uint32_t slot)
+{
+    Slot& s = m_slots[slot];
+    s.page = kInvalidPage;
+    s.lastUsed = 0;
+    s.locked = false;
+
+    // Free slots go to the front so they are reused before anything is evicted.
+    Unlink(slot);
+    s.next = m_head;
+    if (m_head != kNotResident) m_slots[m_head].prev = slot; else m_tail = slot;
+    m_head = slot;
+}
+
+void PageCache::Lock(uint32_t slot, bool locked)
+{
+    m_slots[slot].locked = locked;
+}
+
+//-------------------------------------------------------------------------------------
+// FeedbackAnalyzer
+//-------------------------------------------------------------------------------------
+void FeedbackAnalyzer::Analyze(const PageTable& table, const uint32_t* feedback, size_t count,
+    std::vector<uint32_t>& residentHits, std::vector<PageRequest>& requests)
+{
+    residentHits.clear();
+    requests.clear();
+    m_counts.clear();
+
+    // Feedback buffers are mostly runs of the same page; skip repeats cheaply.
+    uint32_t previous = kInvalidPage;
+    uint32_t* previousCount = nullptr;
+    for (size_t i = 0; i < count; i++)
+    {
+        const uint32_t page = feedback[i];
+        if (page == previous && previousCount)
+        {
+            (*previousCount)++;
+            continue;
+        }
+        if (!table.IsValid(page))
+            continue;
+
+        previous = page;
+        previousCount = &++m_counts[page];
+    }
+
+    std::unordered_map<uint32_t, uint32_t> missing;
+    for (const auto& entry : m_counts)
+    {
+        const uint32_t resident = table.ResidentAncestor(entry.first);
+        if (resident != kInvalidPage)
+            residentHits.push_back(table.Slot(resident));
+
+        // Request the page and every missing ancestor between it and what is resident.
+        for (uint32_t page = entry.first; page != resident && table.IsValid(page); page = table.Parent(page))
+        {
+            missing[page] += entry.second;
+        }
+    }
+
+    requests.reserve(missing.size());
+    for (const auto& entry : missing)
+    {
+        requests.push_back({ entry.first, entry.second });
+    }
+
+    std::sort(requests.begin(), requests.end(), [](const PageRequest& a, const PageRequest& b)
+    {
+        if (PageMip(a.page) != PageMip(b.page))
+            return PageMip(a.page) > PageMip(b.page);
+        if (a.hits != b.hits)
+            return a.hits > b.hits;
+        return a.page < b.page;
+    });
+}
+
+//-------------------------------------------------------------------------------------
+// PageManager
+//-------------------------------------------------------------------------------------
+PageManager::PageManager(const Desc& desc, uint32_t physicalPages, uint32_t uploadBudget) :
+    m_table(desc),
+    m_cache(physicalPages),
+    m_uploadBudget(uploadBudget)
+{
+}
+
+std::vector<PageUpload> PageManager::PinMipTail()
+{
+    std::vector<PageUpload> uploads;
+    const uint32_t mip = m_table.MipCount() - 1;
+    for (uint32_t y = 0; y < m_table.PagesY(mip); y++)
+    {
+        for (uint32_t x = 0; x < m_table.PagesX(mip); x++)
+        {
+            const uint32_t page = PackPage(mip, x, y);
+            if (m_table.Slot(page) != kNotResident)
+                continue;
+
+            uint32_t evicted;
+            const uint32_t slot = m_cache.Acquire(page, m_frame, evicted);
+            if (slot == kNotResident)
+                return uploads;
+            if (evicted != kInvalidPage)
+                m_table.Unmap(evicted);
+
+            m_cache.Lock(slot, true);
+            m_table.Map(page, slot);
+            uploads.push_back({ page, slot, evicted });
+        }
+    }
+    return uploads;
+}
+
+std::vector<PageUpload> PageManager::Update(const uint32_t* feedback, size_t count)
+{
+    m_frame++;
+    m_stats = Stats();
+
+    m_analyzer.Analyze(m_table, feedback, count, m_residentHits, m_requests);
+    for (uint32_t slot : m_residentHits)
+    {
+        m_cache.Touch(slot, m_frame);
+    }
+
+    // The table is updated as soon as a slot is assigned; the renderer must only
+    // publish it to the GPU once the uploads returned here have been copied.
+    std::vector<PageUpload> uploads;
+    m_stats.requested = static_cast<uint32_t>(m_requests.size());
+    for (const PageRequest& request : m_requests)
+    {
+        if (uploads.size() >= m_uploadBudget)
+            break;
+
+        uint32_t evicted;
+        const uint32_t slot = m_cache.Acquire(request.page, m_frame, evicted);
+        if (slot == kNotResident)
+            break;
+
+        if (evicted != kInvalidPage)
+        {
+            m_table.Unmap(evicted);
+            m_stats.evicted++;
+        }
+        m_table.Map(request.page, slot);
+        uploads.push_back({ request.page, slot, evicted });
+    }
+
+    m_stats.uploaded = static_cast<uint32_t>(uploads.size());
+    m_stats.deferred = m_stats.requested - m_stats.uploaded;
+    return uploads;
+}
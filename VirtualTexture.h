@@ -0,0 +1,177 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// CPU side of sparse virtual texturing. A virtual Texture is split into square
+// pages per mip; only the pages the GPU reports through its feedback buffer are
+// kept in a fixed size physical page cache. This module owns the bookkeeping
+// (page table, LRU cache, feedback analysis, upload budget) and has no graphics
+// API dependencies, so it can be driven with synthetic feedback buffers.
+namespace VirtualTexture
+{
+    // Feedback and page table entries use the same packed page id:
+    // mip in bits 28..31, y in bits 14..27, x in bits 0..13.
+    const uint32_t kInvalidPage = 0xFFFFFFFF;
+    const uint32_t kNotResident = 0xFFFFFFFF;
+
+    // Limits of the packed id. Pages per side stop one short of the field's
+    // range so no page of the last mip packs to kInvalidPage.
+    const uint32_t kMaxMips = 16;
+    const uint32_t kMaxPagesPerSide = 0x3FFF;
+
+    inline uint32_t PackPage(uint32_t mip, uint32_t x, uint32_t y)
+    {
+        return (mip << 28) | ((y & 0x3FFF) << 14) | (x & 0x3FFF);
+    }
+    inline uint32_t PageMip(uint32_t page) { return page >> 28; }
+    inline uint32_t PageX(uint32_t page) { return page & 0x3FFF; }
+    inline uint32_t PageY(uint32_t page) { return (page >> 14) & 0x3FFF; }
+    // The mip field wraps past kMaxMips - 1; PageTable::Parent stops at the
+    // table's last mip instead.
+    inline uint32_t ParentPage(uint32_t page)
+    {
+        return PackPage(PageMip(page) + 1, PageX(page) >> 1, PageY(page) >> 1);
+    }
+
+    struct Desc
+    {
+        uint32_t width;
+        uint32_t height;
+        uint32_t pageSize;      // Texels per page side, 128 for 64KB BC7 / 256 for BC1 tiles.
+        uint32_t mipCount;      // 0 derives the full chain down to a single page.
+    };
+
+    // Maps every virtual page to a physical slot, or kNotResident.
+    class PageTable
+    {
+    public:
+        // Throws std::invalid_argument if desc asks for more than kMaxMips
+        // mips or more than kMaxPagesPerSide pages across.
+        explicit PageTable(const Desc& desc);
+
+        uint32_t MipCount() const { return static_cast<uint32_t>(m_mips.size()); }
+        uint32_t PagesX(uint32_t mip) const { return m_mips[mip].pagesX; }
+        uint32_t PagesY(uint32_t mip) const { return m_mips[mip].pagesY; }
+        bool IsValid(uint32_t page) const;
+
+        // The page one mip coarser, or kInvalidPage for the last mip.
+        uint32_t Parent(uint32_t page) const;
+
+        uint32_t Slot(uint32_t page) const;
+        void Map(uint32_t page, uint32_t slot);
+        void Unmap(uint32_t page);
+
+        // Finest resident page covering the requested one (what the shader falls back to).
+        uint32_t ResidentAncestor(uint32_t page) const;
+
+    private:
+        struct Mip
+        {
+            uint32_t pagesX;
+            uint32_t pagesY;
+            std::vector<uint32_t> slots;
+        };
+        std::vector<Mip> m_mips;
+    };
+
+    // Fixed pool of physical slots recycled in least-recently-used order.
+    class PageCache
+    {
+    public:
+        explicit PageCache(uint32_t slotCount);
+
+        uint32_t SlotCount() const { return static_cast<uint32_t>(m_slots.size()); }
+        uint32_t Page(uint32_t slot) const { return m_slots[slot].page; }
+
+        void Touch(uint32_t slot, uint64_t frame);
+
+        // Hands out a free slot, or evicts the least recently used one not touched
+        // during `frame`. Returns kNotResident when every slot is in use this frame.
+        // evictedPage receives the page that owned the slot (kInvalidPage if none).
+        uint32_t Acquire(uint32_t page, uint64_t frame, uint32_t& evictedPage);
+
+        void Release(uint32_t slot);
+        void Lock(uint32_t slot, bool locked);
+
+    private:
+        struct Slot
+        {
+            uint32_t page = kInvalidPage;
+            uint64_t lastUsed = 0;
+            uint32_t prev = kNotResident;
+            uint32_t next = kNotResident;
+            bool locked = false;
+        };
+
+        void Unlink(uint32_t slot);
+        void PushBack(uint32_t slot);
+
+        std::vector<Slot> m_slots;
+        uint32_t m_head = kNotResident;   // Least recently used.
+        uint32_t m_tail = kNotResident;   // Most recently used.
+    };
+
+    struct PageRequest
+    {
+        uint32_t page;
+        uint32_t hits;
+    };
+
+    // Reduces a feedback buffer to unique missing pages. Coarse mips come first so
+    // the fallback chain is filled before detail, then pages seen by more pixels.
+    class FeedbackAnalyzer
+    {
+    public:
+        void Analyze(const PageTable& table, const uint32_t* feedback, size_t count,
+            std::vector<uint32_t>& residentHits, std::vector<PageRequest>& requests);
+
+    private:
+        std::unordered_map<uint32_t, uint32_t> m_counts;
+    };
+
+    struct PageUpload
+    {
+        uint32_t page;
+        uint32_t slot;
+        uint32_t evictedPage;   // kInvalidPage when the slot was free.
+    };
+
+    struct Stats
+    {
+        uint32_t requested = 0;     // Missing pages found in the last feedback buffer.
+        uint32_t uploaded = 0;      // Pages scheduled for upload this frame.
+        uint32_t deferred = 0;      // Requests left over because of the budget or a full cache.
+        uint32_t evicted = 0;
+    };
+
+    // Ties the pieces together: feed it the readback of frame N, get back the
+    // pages to stream into physical slots within the per-frame upload budget.
+    class PageManager
+    {
+    public:
+        PageManager(const Desc& desc, uint32_t physicalPages, uint32_t uploadBudget);
+
+        const PageTable& Table() const { return m_table; }
+        const Stats& LastStats() const { return m_stats; }
+        void SetUploadBudget(uint32_t pages) { m_uploadBudget = pages; }
+
+        // The coarsest mip is mapped up front and never evicted so sampling
+        // always has something to fall back to.
+        std::vector<PageUpload> PinMipTail();
+
+        std::vector<PageUpload> Update(const uint32_t* feedback, size_t count);
+
+    private:
+        PageTable m_table;
+        PageCache m_cache;
+        FeedbackAnalyzer m_analyzer;
+        std::vector<uint32_t> m_residentHits;
+        std::vector<PageRequest> m_requests;
+        uint32_t m_uploadBudget;
+        uint64_t m_frame = 0;
+        Stats m_stats;
+    };
+}
@@ -23,6 +23,7 @@
 
 #include "stdafx.h"
 #include "WICTextureLoader12.h"
+#include "ImageResampler.h"
 #include <algorithm>
 #include <cassert>
 #include <cfloat>
@@ -343,6 +344,113 @@ namespace
         }
     }
 
+    //---------------------------------------------------------------------------------
+    bool GetResamplerLayout(const WICPixelFormatGUID& guid, ImageResampler::PixelLayout& layout) noexcept
+    {
+        if (memcmp(&guid, &GUID_WICPixelFormat32bppRGBA, sizeof(GUID)) == 0)
+        {
+            layout = ImageResampler::PixelLayout::RGBA8;
+            return true;
+        }
+        if (memcmp(&guid, &GUID_WICPixelFormat32bppBGRA, sizeof(GUID)) == 0)
+        {
+            layout = ImageResampler::PixelLayout::BGRA8;
+            return true;
+        }
+        if (memcmp(&guid, &GUID_WICPixelFormat128bppRGBAFloat, sizeof(GUID)) == 0)
+        {
+            layout = ImageResampler::PixelLayout::RGBA32F;
+            return true;
+        }
+        return false;
+    }
+
+    inline bool IsSRGB(DXGI_FORMAT format) noexcept
+    {
+        return format == DXGI_FORMAT_R8G8B8A8_UNORM_SRGB || format == DXGI_FORMAT_B8G8R8A8_UNORM_SRGB;
+    }
+
+    //---------------------------------------------------------------------------------
+    // Decodes the frame at its native size in the requested WIC format.
+    HRESULT CopyFramePixels(
+        _In_ IWICBitmapFrameDecode* frame,
+        const WICPixelFormatGUID& pixelFormat,
+        const WICPixelFormatGUID& targetFormat,
+        UINT rowPitch,
+        UINT imageSize,
+        _Out_writes_bytes_(imageSize) BYTE* pixels) noexcept
+    {
+        if (memcmp(&pixelFormat, &targetFormat, sizeof(GUID)) == 0)
+            return frame->CopyPixels(nullptr, rowPitch, imageSize, pixels);
+
+        auto pWIC = GetWIC();
+        if (!pWIC)
+            return E_NOINTERFACE;
+
+        ComPtr<IWICFormatConverter> FC;
+        HRESULT hr = pWIC->CreateFormatConverter(FC.GetAddressOf());
+        if (FAILED(hr))
+            return hr;
+
+        BOOL canConvert = FALSE;
+        hr = FC->CanConvert(pixelFormat, targetFormat, &canConvert);
+        if (FAILED(hr) || !canConvert)
+            return E_UNEXPECTED;
+
+        hr = FC->Initialize(frame, targetFormat, WICBitmapDitherTypeErrorDiffusion, nullptr, 0, WICBitmapPaletteTypeMedianCut);
+        if (FAILED(hr))
+            return hr;
+
+        return FC->CopyPixels(nullptr, rowPitch, imageSize, pixels);
+    }
+
+    //---------------------------------------------------------------------------------
+    // Gamma-correct resize through ImageResampler for the 32bpp RGBA/BGRA and
+    // 128bpp float formats; everything else keeps going through IWICBitmapScaler.
+    HRESULT ResampleFrame(
+        _In_ IWICBitmapFrameDecode* frame,
+        const WICPixelFormatGUID& pixelFormat,
+        const WICPixelFormatGUID& targetFormat,
+        bool sRGB,
+        UINT width, UINT height,
+        UINT twidth, UINT theight,
+        size_t rowPitch,
+        _Out_ uint8_t* pixels) noexcept
+    {
+        ImageResampler::PixelLayout layout;
+        if (!GetResamplerLayout(targetFormat, layout))
+            return HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED);
+
+        const uint64_t srcRowBytes = uint64_t(width) * ImageResampler::BytesPerPixel(layout);
+        const uint64_t srcBytes = srcRowBytes * uint64_t(height);
+        if (srcBytes > UINT32_MAX)
+            return HRESULT_FROM_WIN32(ERROR_ARITHMETIC_OVERFLOW);
+
+        std::unique_ptr<uint8_t[]> source(new (std::nothrow) uint8_t[static_cast<size_t>(srcBytes)]);
+        if (!source)
+            return E_OUTOFMEMORY;
+
+        HRESULT hr = CopyFramePixels(frame, pixelFormat, targetFormat,
+            static_cast<UINT>(srcRowBytes), static_cast<UINT>(srcBytes), source.get());
+        if (FAILED(hr))
+            return hr;
+
+        const ImageResampler::ImageView src = { source.get(), width, height, static_cast<size_t>(srcRowBytes), layout, sRGB };
+        const ImageResampler::MutableImageView dst = { pixels, twidth, theight, rowPitch, layout, sRGB };
+
+        try
+        {
+            if (!ImageResampler::Resize(src, dst, ImageResampler::Filter::Mitchell))
+                return E_FAIL;
+        }
+        catch (const std::bad_alloc&)
+        {
+            return E_OUTOFMEMORY;
+        }
+
+        return S_OK;
+    }
+
     //---------------------------------------------------------------------------------
     HRESULT CreateTextureFromWIC(_In_ ID3D12Device* d3dDevice,
         _In_ IWICBitmapFrameDecode* frame,
@@ -516,6 +624,16 @@ namespace
             if (FAILED(hr))
                 return hr;
         }
+        else if ((twidth != width || theight != height)
+            && SUCCEEDED(hr = ResampleFrame(frame, pixelFormat, convertGUID, IsSRGB(format),
+                width, height, twidth, theight, rowPitch, decodedData.get())))
+        {
+            // Resized by ImageResampler
+        }
+        else if (hr == E_OUTOFMEMORY)
+        {
+            return hr;
+        }
         else if (twidth != width || theight != height)
         {
             // Resize
@@ -570,29 +688,34 @@ namespace
         else
         {
             // Format conversion but no resize
-            auto pWIC = GetWIC();
-            if (!pWIC)
-                return E_NOINTERFACE;
-
-            ComPtr<IWICFormatConverter> FC;
-            hr = pWIC->CreateFormatConverter(FC.GetAddressOf());
-            if (FAILED(hr))
-                return hr;
+            ImageResampler::PixelLayout srcLayout, dstLayout;
+            if (GetResamplerLayout(pixelFormat, srcLayout) && GetResamplerLayout(convertGUID, dstLayout)
+                && srcLayout != ImageResampler::PixelLayout::RGBA32F && dstLayout != ImageResampler::PixelLayout::RGBA32F)
+            {
+                // RGBA <-> BGRA only needs a channel swizzle
+                hr = frame->CopyPixels(nullptr, static_cast<UINT>(rowPitch), static_cast<UINT>(imageSize), decodedData.get());
+                if (FAILED(hr))
+                    return hr;
 
-            BOOL canConvert = FALSE;
-            hr = FC->CanConvert(pixelFormat, convertGUID, &canConvert);
-            if (FAILED(hr) || !canConvert)
+                const ImageResampler::ImageView src = { decodedData.get(), twidth, theight, rowPitch, srcLayout, false };
+                const ImageResampler::MutableImageView dst = { decodedData.get(), twidth, theight, rowPitch, dstLayout, false };
+                try
+                {
+                    if (!ImageResampler::Convert(src, dst))
+                        return E_FAIL;
+                }
+                catch (const std::bad_alloc&)
+                {
+                    return E_OUTOFMEMORY;
+                }
+            }
+            else
             {
-                return E_UNEXPECTED;
+                hr = CopyFramePixels(frame, pixelFormat, convertGUID,
+                    static_cast<UINT>(rowPitch), static_cast<UINT>(imageSize), decodedData.get());
+                if (FAILED(hr))
+                    return hr;
             }
-
-            hr = FC->Initialize(frame, convertGUID, WICBitmapDitherTypeErrorDiffusion, nullptr, 0, WICBitmapPaletteTypeMedianCut);
-            if (FAILED(hr))
-                return hr;
-
-            hr = FC->CopyPixels(nullptr, static_cast<UINT>(rowPitch), static_cast<UINT>(imageSize), decodedData.get());
-            if (FAILED(hr))
-                return hr;
         }
 
         // Count the number of mips
@@ -9,11 +9,38 @@
 //
 //*********************************************************
 
+// Pixel shader variants are selected with the feature defines from
+// ShaderPermutation.h. Each is always defined to 0 or 1 by the engine; the
+// defaults below only matter when compiling this file by hand.
+#ifndef TEXTURED
+#define TEXTURED 0
+#endif
+#ifndef METAL
+#define METAL 0
+#endif
+#ifndef SHADOWED
+#define SHADOWED 0
+#endif
+#ifndef NORMAL_MAPPED
+#define NORMAL_MAPPED 0
+#endif
+
 cbuffer SceneConstantBuffer : register(b0)
 {
     float4x4 PV;
     float3 eye;
-    float padding[45];
+    // Shadow cascades; see CascadedShadows.h. cascadeSplits holds the far
+    // view depth of each cascade.
+    float4x4 cascadePV[4];
+    float4 cascadeSplits;
+    float3 toLight;
+    // Cluster grid of the clustered lights; see ClusteredLighting.h.
+    float clusterZScale;
+    float2 clusterTileScale;
+    float clusterZBias;
+    uint clusterTilesX;
+    uint clusterTilesY;
+    uint clusterSlices;
 };
 
 struct VSInput
@@ -30,69 +57,203 @@ struct PSInput
     float2 uv : UV;
     float3 worldPos : W_POSITION;
     float3 eye : EYE;
+    nointerpolation uint material : MATERIAL;
+};
+
+// Per-instance data; see InstanceData in RenderBackend.h. Each draw binds the
+// buffer at its first record, so SV_InstanceID indexes it directly.
+struct InstanceData
+{
+    row_major float3x4 world;
+    uint material;
+    uint3 padding;
+};
+StructuredBuffer<InstanceData> instances : register(t0, space2);
+static const uint DrawMaterial = 0xffffffff;
+
+// Bindless heap slots of the draw's textures, set per draw as root constants.
+cbuffer TextureSlots : register(b1)
+{
+    uint albedoSlot;
+    uint normalSlot;
+    uint shadowMapSlot;
+};
+
+// Clustered lights: each cluster's lights are a range of lightIndices.
+struct ClusterLight
+{
+    float3 position;
+    float range;
+    float3 color;
+    float spotCosAngle;
+    float3 direction;
+    float padding;
 };
+StructuredBuffer<ClusterLight> clusterLights : register(t0, space4);
+StructuredBuffer<uint2> lightClusters : register(t1, space4);
+StructuredBuffer<uint> lightIndices : register(t2, space4);
 
-Texture2D albedoTexture : register(t0);
+// The whole descriptor heap; see D3D12DescriptorHeap. The shadow map is a
+// texture array, so it is read through a second view of the same heap.
+Texture2D g_textures[] : register(t0, space1);
+Texture2DArray g_textureArrays[] : register(t0, space3);
 SamplerState g_sampler : register(s0);
+SamplerComparisonState g_shadowSampler : register(s1);
 
-PSInput VSMain(VSInput vInput)
+static const float kd = 0.4;
+static const float ks = 0.2;
+static const float ka = 0.1;
+static const float lightIntensity = 1.2f;
+static const float3 untexturedAlbedo = float3(0.8, 0.8, 0.8);
+static const float shadowBias = 0.002f;
+
+// Both vertex shaders place vertices through here. precise stops the compiler
+// from fusing or reordering the math differently in each, so the depth
+// prepass and the main pass produce identical depths for the EQUAL test.
+float4 PlaceVertex(float3 pos, InstanceData instance, out float4 worldPos)
+{
+    precise float3 world = mul(instance.world, float4(pos, 1));
+    worldPos = float4(world, 1);
+    precise float4 position = mul(PV, worldPos);
+    return position;
+}
+
+PSInput VSMain(VSInput vInput, uint instanceID : SV_InstanceID)
 {
     PSInput vOut;
 
-    vOut.position = mul(PV, float4(vInput.pos, 1));
-    vOut.normal = vInput.normal;
+    InstanceData instance = instances[instanceID];
+    float4 worldPos;
+    vOut.position = PlaceVertex(vInput.pos, instance, worldPos);
+    // Instances are placed with rotation, translation and uniform scale only.
+    vOut.normal = mul((float3x3)instance.world, vInput.normal);
     vOut.uv = vInput.uv;
-    vOut.worldPos = vInput.pos;
+    vOut.worldPos = worldPos.xyz;
     vOut.eye = eye;
+    vOut.material = instance.material;
 
     return vOut;
 }
 
+// Depth prepass: position only, no pixel shader.
+float4 VSDepth(float3 pos : POSITION, uint instanceID : SV_InstanceID) : SV_POSITION
+{
+    float4 worldPos;
+    return PlaceVertex(pos, instances[instanceID], worldPos);
+}
+
 float convert_sRGB_FromLinear(float theLinearValue) {
     return theLinearValue <= 0.0031308f
         ? theLinearValue * 12.92f
         : pow(theLinearValue, 1.0f / 2.4f) * 1.055f - 0.055f;
 }
 
-float4 PSMain(PSInput vsOut) : SV_TARGET
+#if NORMAL_MAPPED
+// The vertices carry no tangents, so the tangent frame is rebuilt from the
+// screen-space derivatives of position and uv.
+float3 PerturbNormal(float3 n, float3 worldPos, float2 uv)
 {
-    float kd = 0.4;
-    float ks = 0.2;
-    float ka = 0.1;
-    float3 color = albedoTexture.Sample(g_sampler, float2(vsOut.uv.x, 1 - vsOut.uv.y)).rgb;
-    bool metal = false;
-    float lightIntensity = 10.4;
-    
-    float3 l = normalize(float3(6, 9, 4));
-    float3 v = normalize(vsOut.eye - vsOut.worldPos);
-    float3 h = normalize(l + v);
-    
-    float3 diff = kd * saturate(dot(l, vsOut.normal));
-    float3 spec = pow(saturate(dot(vsOut.normal, h)), 32.0f);
-    
-    float3 radiance = color * (diff + ka) + 0 * spec * (metal ? (color * ks) : kd);
-    radiance *= lightIntensity;
-    return float4(color, 1);
+    float3 dp1 = ddx(worldPos);
+    float3 dp2 = ddy(worldPos);
+    float2 duv1 = ddx(uv);
+    float2 duv2 = ddy(uv);
+
+    float3 dp2perp = cross(dp2, n);
+    float3 dp1perp = cross(n, dp1);
+    float3 t = dp2perp * duv1.x + dp1perp * duv2.x;
+    float3 b = dp2perp * duv1.y + dp1perp * duv2.y;
+    float invmax = rsqrt(max(dot(t, t), dot(b, b)));
+
+    float3 tangentNormal = g_textures[normalSlot].Sample(g_sampler, uv).xyz * 2 - 1;
+    return normalize(mul(tangentNormal, float3x3(t * invmax, b * invmax, n)));
+}
+#endif
+
+#if SHADOWED
+// Picks the first cascade whose far split is beyond the pixel; past the
+// last one nothing is shadowed.
+float ShadowFactor(float3 worldPos, float viewDepth)
+{
+    uint cascade = 0;
+    [unroll]
+    for (uint i = 0; i < 3; i++)
+    {
+        cascade += viewDepth > cascadeSplits[i] ? 1 : 0;
+    }
+    if (viewDepth > cascadeSplits[3])
+    {
+        return 1;
+    }
+
+    float4 shadowPos = mul(cascadePV[cascade], float4(worldPos, 1));
+    float3 p = shadowPos.xyz / shadowPos.w;
+    float2 uv = p.xy * float2(0.5, -0.5) + 0.5;
+    return g_textureArrays[shadowMapSlot].SampleCmpLevelZero(g_shadowSampler, float3(uv, cascade), p.z - shadowBias);
+}
+#endif
+
+// Light from the point and spot lights of the pixel's cluster. The slice
+// comes from the view depth as the binner's grid spaces them.
+float3 ClusteredLight(float3 n, float3 worldPos, float3 eyePos, float2 screenPos, float viewDepth)
+{
+    uint2 tile = min(uint2(screenPos * clusterTileScale), uint2(clusterTilesX, clusterTilesY) - 1);
+    uint slice = min((uint)max(floor(log(viewDepth) * clusterZScale + clusterZBias), 0), clusterSlices - 1);
+    uint2 cluster = lightClusters[(slice * clusterTilesY + tile.y) * clusterTilesX + tile.x];
+
+    float3 v = normalize(eyePos - worldPos);
+    float3 result = 0;
+    for (uint i = 0; i < cluster.y; i++)
+    {
+        ClusterLight light = clusterLights[lightIndices[cluster.x + i]];
+        float3 toPoint = light.position - worldPos;
+        float distance = length(toPoint);
+        float3 l = toPoint / max(distance, 1e-4f);
+
+        // Smooth falloff to zero at the range, and a soft cone edge.
+        float falloff = saturate(1 - distance / light.range);
+        falloff *= falloff;
+        if (light.spotCosAngle > -1)
+        {
+            falloff *= smoothstep(light.spotCosAngle, lerp(light.spotCosAngle, 1, 0.2f), dot(-l, light.direction));
+        }
+
+        float3 radiance = kd * saturate(dot(n, l));
+#if METAL
+        radiance += pow(saturate(dot(n, normalize(l + v))), 32.0f) * ks;
+#endif
+        result += radiance * light.color * falloff;
+    }
+    return result;
 }
 
-float4 PSSimpleAlbedo(PSInput vsOut) : SV_TARGET
+float4 PSMain(PSInput vsOut) : SV_TARGET
 {
-    float kd = 0.4;
-    float ks = 0.2;
-    float ka = 0.1;
-    float3 color = float3(0.8, 0.8, 0.8);
-    bool isMetal = false;
-    float lightIntensity = 1.2f;
-
-    float3 l = normalize(float3(6, 9, 4));
+    float2 uv = float2(vsOut.uv.x, 1 - vsOut.uv.y);
+#if TEXTURED
+    uint albedo = vsOut.material != DrawMaterial ? vsOut.material : albedoSlot;
+    float3 color = g_textures[NonUniformResourceIndex(albedo)].Sample(g_sampler, uv).rgb;
+#else
+    float3 color = untexturedAlbedo;
+#endif
+
+    float3 n = normalize(vsOut.normal);
+#if NORMAL_MAPPED
+    n = PerturbNormal(n, vsOut.worldPos, uv);
+#endif
+
+    float3 l = toLight;
+    float3 direct = kd * saturate(dot(l, n));
+#if METAL
     float3 v = normalize(vsOut.eye - vsOut.worldPos);
     float3 h = normalize(l + v);
+    direct += pow(saturate(dot(n, h)), 32.0f) * ks;
+#endif
+#if SHADOWED
+    // SV_POSITION.w is the view depth for a perspective projection.
+    direct *= ShadowFactor(vsOut.worldPos, vsOut.position.w);
+#endif
+    direct += ClusteredLight(n, vsOut.worldPos, vsOut.eye, vsOut.position.xy, vsOut.position.w);
 
-    float3 diff = kd * saturate(dot(l, vsOut.normal));
-    float3 spec = pow(saturate(dot(vsOut.normal, h)), 32.0f);
-
-    float3 radiance = color * (diff + ka) + 0 * spec * (isMetal ? (color * ks) : kd);
-    radiance *= lightIntensity;
-    // color = abs(vsOut.normal);
+    float3 radiance = color * (direct + ka) * lightIntensity;
     return float4(radiance, 1);
-}
\ No newline at end of file
+}